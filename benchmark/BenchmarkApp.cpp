@@ -0,0 +1,458 @@
+#include "BenchmarkApp.h"
+#include <algorithm>
+#include <cmath>
+
+
+// plain diffuse lighting, the benchmark measures the cpu side of the frame
+static const char* s_pVertexShader =
+	"attribute vec3 position;\n"
+	"attribute vec3 normal;\n"
+	"uniform mat4 modelViewProjectionMatrix;\n"
+	"uniform mat4 modelMatrix;\n"
+	"varying vec3 worldNormal;\n"
+	"void main(void)\n"
+	"{\n"
+	"	worldNormal = (modelMatrix * vec4(normal, 0.0)).xyz;\n"
+	"	gl_Position = modelViewProjectionMatrix * vec4(position, 1.0);\n"
+	"}\n";
+
+static const char* s_pFragmentShader =
+	"uniform vec4 materialAmbient;\n"
+	"uniform vec4 materialDiffuse;\n"
+	"uniform vec3 lightDirection;\n"
+	"varying vec3 worldNormal;\n"
+	"void main(void)\n"
+	"{\n"
+	"	float diffuse = max(dot(normalize(worldNormal), -lightDirection), 0.0);\n"
+	"	gl_FragColor = materialAmbient + materialDiffuse * diffuse;\n"
+	"}\n";
+
+
+static const char* GetSimdName(ImageKernels::SIMD simd)
+{
+	static const char* s_pNames[] = { "scalar", "sse2", "avx2" };
+	return s_pNames[simd];
+}
+
+BenchmarkApp::BenchmarkApp(const SETTINGS& settings) :
+	m_Settings(settings),
+	m_uScene(0),
+	m_uFrame(0),
+	m_uSceneFrames(0),
+	m_uFrameBegin(0),
+	m_uProgram(0)
+{
+	m_Samples.visible = 0;
+
+	for (uint32_t nodes = 1000; nodes <= m_Settings.maxNodes && nodes <= 1000000; nodes *= 10)
+	{
+		m_arrScenes.push_back({ nodes, false });
+		m_arrScenes.push_back({ nodes, true });
+	}
+}
+
+
+bool BenchmarkApp::OnCreate()
+{
+	// scope recording would dominate the timings of the large scenes
+	Profiler::SetEnabled(false);
+	m_strRenderer = (const char*)glGetString(GL_RENDERER);
+
+	// cpu only, timed once before the scenes
+	if (m_Settings.kernelImageSize)
+	{
+		m_arrKernelResults = ImageKernels::Benchmark(m_Settings.kernelImageSize, m_Settings.kernelImageSize);
+		for (const auto& kernel : m_arrKernelResults)
+		{
+			char line[128];
+			snprintf(line, sizeof(line), "%-18s %-6s %9.3f ms%s\n",
+				kernel.kernel.c_str(),
+				GetSimdName(kernel.simd),
+				kernel.milliseconds,
+				kernel.matchesReference ? "" : "  MISMATCH");
+			Debug(line);
+		}
+	}
+
+	m_uProgram = GetOpenGLRenderer()->CreateProgramFromSource(s_pVertexShader, s_pFragmentShader);
+	if (!m_uProgram || m_arrScenes.empty())
+	{
+		return false;
+	}
+
+	// same shapes as the game scenes, kept low poly so that large scenes stay cpu bound
+	auto sphere = std::make_shared<Geometry>();
+	sphere->GenSphere(glm::vec3(0.5f), glm::vec3(0.0f), 8, 8);
+	auto torus = std::make_shared<Geometry>();
+	torus->GenTorus(12, 0.4f, 0.15f);
+	auto knot = std::make_shared<Geometry>();
+	knot->GenKnot(32, 6, 0.4f);
+	m_arrGeometries = { sphere, torus, knot };
+
+	const glm::vec4 colors[] =
+	{
+		glm::vec4(1.0f, 0.2f, 0.2f, 1.0f),
+		glm::vec4(0.2f, 1.0f, 0.2f, 1.0f),
+		glm::vec4(0.2f, 0.2f, 1.0f, 1.0f),
+		glm::vec4(1.0f, 1.0f, 1.0f, 1.0f)
+	};
+	for (const auto& color : colors)
+	{
+		auto material = std::make_shared<Material>();
+		material->m_cAmbient = glm::vec4(0.05f, 0.05f, 0.05f, 1.0f);
+		material->m_cDiffuse = color;
+		m_arrMaterials.push_back(material);
+	}
+	return true;
+}
+
+
+void BenchmarkApp::OnDestroy()
+{
+	m_pSceneRoot = nullptr;
+	m_arrGeometries.clear();
+	m_arrMaterials.clear();
+	glDeleteProgram(m_uProgram);
+	m_uProgram = 0;
+}
+
+
+void BenchmarkApp::OnUpdate(float /*frametime*/)
+{
+	// total time of previous frame, the flip is included
+	const uint64_t frameBegin = Timer::GetTicks();
+	if (m_uFrameBegin && m_uFrame > m_Settings.warmupFrames)
+	{
+		m_Samples.total.push_back((frameBegin - m_uFrameBegin) * Timer::GetSecondsPerTick() * 1000.0);
+	}
+	m_uFrameBegin = frameBegin;
+
+	if (m_pSceneRoot && m_uFrame == m_Settings.warmupFrames + m_uSceneFrames)
+	{
+		FinishScene();
+	}
+	if (!m_pSceneRoot)
+	{
+		if (m_uScene == m_arrScenes.size())
+		{
+			Close();
+			return;
+		}
+		BuildScene(m_arrScenes[m_uScene]);
+		m_uFrameBegin = Timer::GetTicks();
+	}
+
+	// fixed timestep, the scenes animate the same on every machine
+	const uint64_t begin = Timer::GetTicks();
+	m_pSceneRoot->Update(1.0f / 60.0f);
+	const uint64_t end = Timer::GetTicks();
+	if (m_uFrame >= m_Settings.warmupFrames)
+	{
+		m_Samples.update.push_back((end - begin) * Timer::GetSecondsPerTick() * 1000.0);
+	}
+}
+
+
+void BenchmarkApp::OnDraw(IRenderer& renderer)
+{
+	renderer.Clear(0.2f, 0.2f, 0.2f, 1.0f);
+	if (!m_pSceneRoot)
+	{
+		return;
+	}
+
+	renderer.SetViewMatrix(m_pCamera->GetViewMatrix());
+	renderer.SetProjectionMatrix(m_pCamera->GetProjectionMatrix());
+
+	const uint64_t cullBegin = Timer::GetTicks();
+	m_DrawQueue.Clear();
+	renderer.SetDrawQueue(&m_DrawQueue);
+	m_pSceneRoot->Render(renderer, 0);
+	renderer.SetDrawQueue(nullptr);
+	const uint64_t cullEnd = Timer::GetTicks();
+
+	glUseProgram(m_uProgram);
+	OpenGLRenderer::SetUniformVec3(m_uProgram, "lightDirection", glm::normalize(glm::vec3(-1.0f, 0.0f, -1.0f)));
+	for (const auto& draw : m_DrawQueue.GetDraws())
+	{
+		DrawQueue::DrawImmediate(renderer, m_uProgram, draw);
+	}
+
+	// wait for the gpu so that the submit time covers the work it caused
+	glFinish();
+	const uint64_t submitEnd = Timer::GetTicks();
+
+	if (m_uFrame >= m_Settings.warmupFrames)
+	{
+		const double millisecondsPerTick = Timer::GetSecondsPerTick() * 1000.0;
+		m_Samples.cull.push_back((cullEnd - cullBegin) * millisecondsPerTick);
+		m_Samples.submit.push_back((submitEnd - cullEnd) * millisecondsPerTick);
+		m_Samples.visible += m_DrawQueue.GetCount();
+	}
+	++m_uFrame;
+}
+
+
+bool BenchmarkApp::OnKeyDown(uint32_t keyCode)
+{
+	if (keyCode == KEY_ESC)
+	{
+		Close();
+		return true;
+	}
+	return false;
+}
+
+
+void BenchmarkApp::BuildScene(const SCENE& scene)
+{
+	// same seed for every run, the scenes must not change between a baseline and a compare
+	srand(scene.nodes + (scene.deep ? 1 : 0));
+
+	// node density of TheApp, 125 nodes in a box of 10 units
+	const float extent = 5.0f * std::cbrt(scene.nodes / 125.0f);
+
+	m_pSceneRoot = std::make_unique<Node>();
+	m_pSceneRoot->SetRotationAxis(glm::vec3(0.0f, 1.0f, 0.0f));
+	m_pSceneRoot->SetRotationSpeed(0.1f);
+
+	// camera at the edge of the box sees a part of it, the rest is culled. It is kept
+	// out of the scenegraph so that it does not rotate with the scene
+	m_pCamera = std::make_unique<CameraNode>();
+	m_pCamera->SetProjectionParams({ 0.61f, GetAspect(), 1.0f, extent * 2.0f });
+	m_pCamera->LookAt(glm::vec3(0.0f, 0.0f, extent), glm::vec3(0.0f, 0.0f, 0.0f));
+
+	std::vector<Node*> nodes;
+	nodes.reserve(scene.nodes);
+	for (uint32_t i = 0; i < scene.nodes; ++i)
+	{
+		auto node = std::make_shared<GeometryNode>(m_arrGeometries[i % m_arrGeometries.size()], m_arrMaterials[i % m_arrMaterials.size()]);
+		node->SetRotationAxis(glm::sphericalRand(1.0f));
+		node->SetRotationSpeed(glm::linearRand(-1.0f, 1.0f));
+
+		if (scene.deep && i > 0)
+		{
+			// binary tree, offsets shrink with depth so the leaves still fill the box
+			const uint32_t depth = (uint32_t)std::log2(i + 1);
+			node->SetPos(glm::linearRand(glm::vec3(-extent), glm::vec3(extent)) * std::pow(0.7f, (float)depth));
+			nodes[(i - 1) / 2]->AddNode(node);
+		}
+		else
+		{
+			node->SetPos(glm::linearRand(glm::vec3(-extent), glm::vec3(extent)));
+			m_pSceneRoot->AddNode(node);
+		}
+		nodes.push_back(node.get());
+	}
+
+	// same amount of work per scene size on any machine, large scenes run fewer frames
+	m_uSceneFrames = scene.nodes <= 10000 ? m_Settings.frames : std::max(10u, (uint32_t)((uint64_t)m_Settings.frames * 10000 / scene.nodes));
+	m_uFrame = 0;
+	m_Samples = SAMPLES();
+	m_Samples.visible = 0;
+}
+
+
+void BenchmarkApp::FinishScene()
+{
+	const SCENE& scene = m_arrScenes[m_uScene];
+
+	RESULT result;
+	result.name = std::string(scene.deep ? "deep_" : "flat_") + std::to_string(scene.nodes);
+	result.nodes = scene.nodes;
+	result.frames = m_uSceneFrames;
+	result.visible = (double)m_Samples.visible / m_uSceneFrames;
+	result.update = GetStat(m_Samples.update);
+	result.cull = GetStat(m_Samples.cull);
+	result.submit = GetStat(m_Samples.submit);
+	result.total = GetStat(m_Samples.total);
+	m_arrResults.push_back(result);
+
+	char line[256];
+	snprintf(line, sizeof(line), "%-14s %8.0f visible  update %8.3f  cull %8.3f  submit %8.3f  total %8.3f ms\n",
+		result.name.c_str(),
+		result.visible,
+		result.update.median,
+		result.cull.median,
+		result.submit.median,
+		result.total.median);
+	Debug(line);
+
+	m_pSceneRoot = nullptr;
+	m_pCamera = nullptr;
+	++m_uScene;
+}
+
+
+BenchmarkApp::STAT BenchmarkApp::GetStat(std::vector<double>& samples)
+{
+	STAT stat = { 0.0, 0.0, 0.0 };
+	if (samples.empty())
+	{
+		return stat;
+	}
+
+	std::sort(samples.begin(), samples.end());
+	for (double sample : samples)
+	{
+		stat.average += sample;
+	}
+	stat.average /= samples.size();
+	stat.median = samples[samples.size() / 2];
+	stat.p95 = samples[std::min(samples.size() - 1, samples.size() * 95 / 100)];
+	return stat;
+}
+
+
+bool BenchmarkApp::Save(const std::string_view& filename) const
+{
+	std::ofstream f(std::string(filename), std::ios::binary);
+	if (!f)
+	{
+		return false;
+	}
+
+	auto stat = [](const char* name, const STAT& s)
+	{
+		char str[128];
+		snprintf(str, sizeof(str), "\"%s\": { \"average\": %.4f, \"median\": %.4f, \"p95\": %.4f }", name, s.average, s.median, s.p95);
+		return std::string(str);
+	};
+
+	f << "{\n\t\"version\": 1,\n\t\"renderer\": \"" << m_strRenderer << "\",\n\t\"results\": [\n";
+	for (size_t i = 0; i < m_arrResults.size(); ++i)
+	{
+		const RESULT& result = m_arrResults[i];
+		char str[256];
+		snprintf(str, sizeof(str), "\t\t{ \"name\": \"%s\", \"nodes\": %u, \"frames\": %u, \"visible\": %.1f, ",
+			result.name.c_str(),
+			result.nodes,
+			result.frames,
+			result.visible);
+		f << str << stat("update", result.update) << ", "
+			<< stat("cull", result.cull) << ", "
+			<< stat("submit", result.submit) << ", "
+			<< stat("total", result.total) << " }"
+			<< (i + 1 < m_arrResults.size() ? ",\n" : "\n");
+	}
+	f << "\t],\n\t\"kernels\": [\n";
+	for (size_t i = 0; i < m_arrKernelResults.size(); ++i)
+	{
+		const ImageKernels::BENCHMARK& kernel = m_arrKernelResults[i];
+		char str[256];
+		snprintf(str, sizeof(str), "\t\t{ \"kernel\": \"%s\", \"simd\": \"%s\", \"milliseconds\": %.4f, \"matchesReference\": %s }",
+			kernel.kernel.c_str(),
+			GetSimdName(kernel.simd),
+			kernel.milliseconds,
+			kernel.matchesReference ? "true" : "false");
+		f << str << (i + 1 < m_arrKernelResults.size() ? ",\n" : "\n");
+	}
+	f << "\t]\n}\n";
+	return (bool)f;
+}
+
+
+bool BenchmarkApp::Load(const std::string_view& filename, std::vector<RESULT>& results)
+{
+	std::ifstream f(std::string(filename), std::ios::binary);
+	if (!f)
+	{
+		return false;
+	}
+
+	// reads the layout Save writes, one scene per line, kernel lines have no name
+	auto read = [](const std::string& line, const std::string& key, size_t from, double& value)
+	{
+		const size_t pos = line.find("\"" + key + "\":", from);
+		if (pos == std::string::npos)
+		{
+			return std::string::npos;
+		}
+		value = atof(line.c_str() + pos + key.size() + 3);
+		return pos;
+	};
+	auto readStat = [&read](const std::string& line, const std::string& key, STAT& stat)
+	{
+		const size_t pos = line.find("\"" + key + "\":");
+		return pos != std::string::npos &&
+			read(line, "average", pos, stat.average) != std::string::npos &&
+			read(line, "median", pos, stat.median) != std::string::npos &&
+			read(line, "p95", pos, stat.p95) != std::string::npos;
+	};
+
+	results.clear();
+	std::string line;
+	while (std::getline(f, line))
+	{
+		const size_t name = line.find("\"name\": \"");
+		if (name == std::string::npos)
+		{
+			continue;
+		}
+
+		RESULT result;
+		const size_t nameBegin = name + 9;
+		result.name = line.substr(nameBegin, line.find('"', nameBegin) - nameBegin);
+
+		double nodes = 0.0;
+		double frames = 0.0;
+		if (read(line, "nodes", 0, nodes) == std::string::npos ||
+			read(line, "frames", 0, frames) == std::string::npos ||
+			read(line, "visible", 0, result.visible) == std::string::npos ||
+			!readStat(line, "update", result.update) ||
+			!readStat(line, "cull", result.cull) ||
+			!readStat(line, "submit", result.submit) ||
+			!readStat(line, "total", result.total))
+		{
+			return false;
+		}
+		result.nodes = (uint32_t)nodes;
+		result.frames = (uint32_t)frames;
+		results.push_back(result);
+	}
+	return !results.empty();
+}
+
+
+uint32_t BenchmarkApp::Compare(const std::vector<RESULT>& baseline, const std::vector<RESULT>& results, float threshold)
+{
+	// medians are compared, an absolute floor keeps timer noise of tiny values from being flagged
+	constexpr double noiseMilliseconds = 0.02;
+
+	uint32_t regressions = 0;
+	for (const auto& result : results)
+	{
+		auto it = std::find_if(baseline.begin(), baseline.end(), [&result](const RESULT& r) { return r.name == result.name; });
+		if (it == baseline.end())
+		{
+			Debug(result.name + ": not in baseline\n");
+			continue;
+		}
+
+		const std::pair<const char*, std::pair<const STAT*, const STAT*>> stats[] =
+		{
+			{ "update", { &it->update, &result.update } },
+			{ "cull", { &it->cull, &result.cull } },
+			{ "submit", { &it->submit, &result.submit } },
+			{ "total", { &it->total, &result.total } }
+		};
+		for (const auto& stat : stats)
+		{
+			const double before = stat.second.first->median;
+			const double after = stat.second.second->median;
+			const bool regressed = after > before * (1.0 + threshold) && after - before > noiseMilliseconds;
+			regressions += regressed ? 1 : 0;
+
+			char line[256];
+			snprintf(line, sizeof(line), "%-14s %-7s %9.3f -> %9.3f ms %+7.1f%%%s\n",
+				result.name.c_str(),
+				stat.first,
+				before,
+				after,
+				before > 0.0 ? (after / before - 1.0) * 100.0 : 0.0,
+				regressed ? "  REGRESSION" : "");
+			Debug(line);
+		}
+	}
+	return regressions;
+}
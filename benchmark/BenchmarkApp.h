@@ -0,0 +1,146 @@
+#pragma once
+#include "../core/include/IApplication.h"
+#include "../core/include/Geometry.h"
+#include "../core/include/Material.h"
+#include "../core/include/GeometryNode.h"
+#include "../core/include/CameraNode.h"
+#include "../core/include/DrawQueue.h"
+#include "../core/include/ImageKernels.h"
+
+
+class BenchmarkApp : public IApplication
+{
+public:
+	/**
+	 * SETTINGS
+	 * what to run, see main.cpp for the matching command line
+	 */
+	struct SETTINGS
+	{
+		SETTINGS() :
+			frames(100),
+			warmupFrames(10),
+			maxNodes(1000000),
+			kernelImageSize(1024)
+		{
+		}
+
+		uint32_t		frames;			// measured frames of scenes up to 10k nodes, larger scenes run fewer, at least 10
+		uint32_t		warmupFrames;	// frames run before measuring each scene
+		uint32_t		maxNodes;		// skip scenes larger than this
+		uint32_t		kernelImageSize;	// width and height of the image the texture import kernels are timed on, 0 skips them
+	};
+
+	/**
+	 * STAT
+	 * distribution of one measurement over the frames of a scene, in milliseconds
+	 */
+	struct STAT
+	{
+		double			average;
+		double			median;
+		double			p95;
+	};
+
+	/**
+	 * RESULT
+	 * measurements of one scene
+	 */
+	struct RESULT
+	{
+		std::string		name;			// layout and node count, e.g. "flat_10000"
+		uint32_t		nodes;
+		uint32_t		frames;
+		double			visible;		// average draws left after culling
+		STAT			update;			// scenegraph update
+		STAT			cull;			// scenegraph traversal, frustum culling and recording of the draws
+		STAT			submit;			// uniforms and draw calls of the visible draws, until the gpu has finished
+		STAT			total;			// whole frame including flip
+	};
+
+	BenchmarkApp(const SETTINGS& settings);
+
+	bool OnCreate() override;
+	void OnDestroy() override;
+
+	void OnUpdate(float frametime) override;
+	void OnDraw(IRenderer& renderer) override;
+
+	bool OnKeyDown(uint32_t keyCode) override;
+
+	inline const std::vector<RESULT>& GetResults() const { return m_arrResults; }
+
+	/**
+	 * GetKernelResults
+	 * @return texture import kernel timings of every instruction set and their check against the scalar reference
+	 */
+	inline const std::vector<ImageKernels::BENCHMARK>& GetKernelResults() const { return m_arrKernelResults; }
+
+	/**
+	 * Save
+	 * write the results as JSON, one scene per line
+	 * @param filename file to write
+	 * @return true if successful
+	 */
+	bool Save(const std::string_view& filename) const;
+
+	/**
+	 * Load
+	 * read results written by Save
+	 * @param filename file to read
+	 * @param results receives the results
+	 * @return true if successful
+	 */
+	static bool Load(const std::string_view& filename, std::vector<RESULT>& results);
+
+	/**
+	 * Compare
+	 * print medians of the results against a baseline and flag the ones that got slower
+	 * @param baseline stored results
+	 * @param results new results
+	 * @param threshold allowed slowdown, 0.1 flags medians more than 10% slower
+	 * @return number of regressions
+	 */
+	static uint32_t Compare(const std::vector<RESULT>& baseline, const std::vector<RESULT>& results, float threshold);
+
+private:
+	struct SCENE
+	{
+		uint32_t		nodes;
+		bool			deep;			// binary tree instead of direct children of the root
+	};
+
+	struct SAMPLES
+	{
+		std::vector<double>		update;
+		std::vector<double>		cull;
+		std::vector<double>		submit;
+		std::vector<double>		total;
+		uint64_t				visible;
+	};
+
+	void BuildScene(const SCENE& scene);
+	void FinishScene();
+	static STAT GetStat(std::vector<double>& samples);
+
+	OpenGLRenderer* GetOpenGLRenderer() { return static_cast<OpenGLRenderer*>(GetRenderer()); }
+
+	SETTINGS					m_Settings;
+	std::vector<SCENE>			m_arrScenes;
+	std::vector<RESULT>			m_arrResults;
+	std::vector<ImageKernels::BENCHMARK>	m_arrKernelResults;
+	std::string					m_strRenderer;
+
+	size_t						m_uScene;
+	uint32_t					m_uFrame;
+	uint32_t					m_uSceneFrames;
+	uint64_t					m_uFrameBegin;
+	SAMPLES						m_Samples;
+
+	GLuint						m_uProgram;
+	std::vector<std::shared_ptr<Geometry>>	m_arrGeometries;
+	std::vector<std::shared_ptr<Material>>	m_arrMaterials;
+	std::unique_ptr<Node>		m_pSceneRoot;
+	std::unique_ptr<CameraNode>	m_pCamera;
+	DrawQueue					m_DrawQueue;
+};
@@ -0,0 +1,100 @@
+#include "BenchmarkApp.h"
+#include <algorithm>
+#include <sstream>
+
+/**
+ * RunBenchmark
+ * options:
+ *   --frames <n>         measured frames per scene, default 100
+ *   --max-nodes <n>      skip scenes with more nodes, default 1000000
+ *   --output <file>      results file, default benchmark.json
+ *   --compare <file>     compare the results against a stored baseline
+ *   --threshold <pct>    allowed slowdown in percent before a result is flagged, default 10
+ *   --kernel-size <n>    size of the image the texture import kernels are timed on, 0 skips them, default 1024
+ * @return 0 if successful, 1 if regressions were found or a simd kernel differs from the scalar reference,
+ * 2 if the benchmark failed to run
+ */
+static int RunBenchmark(const std::vector<std::string>& args)
+{
+	BenchmarkApp::SETTINGS settings;
+	std::string output = "benchmark.json";
+	std::string baselineFile;
+	float threshold = 10.0f;
+	for (size_t i = 0; i + 1 < args.size(); ++i)
+	{
+		if (args[i] == "--frames") settings.frames = (uint32_t)std::max(atoi(args[++i].c_str()), 1);
+		else if (args[i] == "--max-nodes") settings.maxNodes = (uint32_t)std::max(atoi(args[++i].c_str()), 1);
+		else if (args[i] == "--output") output = args[++i];
+		else if (args[i] == "--compare") baselineFile = args[++i];
+		else if (args[i] == "--threshold") threshold = (float)atof(args[++i].c_str());
+		else if (args[i] == "--kernel-size") settings.kernelImageSize = (uint32_t)std::max(atoi(args[++i].c_str()), 0);
+	}
+
+	std::vector<BenchmarkApp::RESULT> baseline;
+	if (!baselineFile.empty() && !BenchmarkApp::Load(baselineFile, baseline))
+	{
+		IApplication::Debug("benchmark: failed to read baseline " + baselineFile + "\n");
+		return 2;
+	}
+
+	// offscreen where the platform supports it, the benchmark farm has no display
+	auto app = std::make_unique<BenchmarkApp>(settings);
+#if defined (_LINUX)
+	IApplication::HEADLESSPARAMS headless;
+	headless.frameCount = 0xFFFFFFFF;
+	const bool created = app->Create(1280, 720, headless);
+#else
+	const bool created = app->Create(1280, 720, "BENCHMARK");
+#endif
+	if (!created)
+	{
+		IApplication::Debug("benchmark: start failed\n");
+		return 2;
+	}
+	app->Run();
+
+	if (!app->Save(output))
+	{
+		IApplication::Debug("benchmark: failed to write " + output + "\n");
+		return 2;
+	}
+	const std::vector<BenchmarkApp::RESULT> results = app->GetResults();
+	const auto& kernels = app->GetKernelResults();
+	const bool kernelsMatch = std::all_of(kernels.begin(), kernels.end(), [](const ImageKernels::BENCHMARK& kernel) { return kernel.matchesReference; });
+	app = nullptr;
+
+	if (!kernelsMatch)
+	{
+		IApplication::Debug("benchmark: simd kernel output differs from the scalar reference\n");
+	}
+
+	if (!baseline.empty())
+	{
+		const uint32_t regressions = BenchmarkApp::Compare(baseline, results, threshold / 100.0f);
+		IApplication::Debug(std::to_string(regressions) + " regressions against " + baselineFile + "\n");
+		return regressions || !kernelsMatch ? 1 : 0;
+	}
+	return kernelsMatch ? 0 : 1;
+}
+
+
+#if defined (_WINDOWS)
+int APIENTRY WinMain(HINSTANCE hInst, HINSTANCE hPrevInst, LPSTR pCmdLine, int nShowCmd)
+{
+	std::vector<std::string> args;
+	std::istringstream stream(pCmdLine ? pCmdLine : "");
+	std::string arg;
+	while (stream >> arg)
+	{
+		args.push_back(arg);
+	}
+	return RunBenchmark(args);
+}
+#endif
+
+#if defined (_LINUX)
+int main(int argc, char** argv)
+{
+	return RunBenchmark(std::vector<std::string>(argv + 1, argv + argc));
+}
+#endif
@@ -0,0 +1,54 @@
+/**
+ * ============================================================================
+ *  Name        : Bloom.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : post effect adding a blurred glow around the bright parts
+ *                of the frame. The bright pass and the separable blur run at
+ *                half resolution in targets of the chain pool.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/PostProcess.h"
+
+class Bloom : public PostEffect
+{
+public:
+	/**
+	 * SETTINGS
+	 * threshold and strength of the glow
+	 */
+	struct SETTINGS
+	{
+		SETTINGS() :
+			threshold(0.75f),
+			intensity(0.6f)
+		{
+		}
+
+		float			threshold;		// brightness above which a pixel glows, 0 - 1
+		float			intensity;		// weight of the glow added to the frame
+	};
+
+	Bloom(const SETTINGS& settings = SETTINGS());
+	~Bloom();
+
+	inline void SetSettings(const SETTINGS& settings) { m_Settings = settings; }
+	inline const SETTINGS& GetSettings() const { return m_Settings; }
+
+	/**
+	 * PostEffect
+	 */
+	const char* GetName() const override { return "bloom"; }
+	FORMATS GetFormats() const override;
+	bool Create(OpenGLRenderer& renderer) override;
+	void Release() override;
+	void Render(OpenGLRenderer& renderer, PostProcess& chain, const RenderTargetPool::TARGET& input, const RenderTargetPool::TARGET& output) override;
+
+private:
+	SETTINGS			m_Settings;
+	GLuint				m_uBrightProgram;
+	GLuint				m_uBlurProgram;
+	GLuint				m_uCompositeProgram;
+};
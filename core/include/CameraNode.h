@@ -71,6 +71,21 @@ public:
 	 */
 	inline void SetProjectionMatrix(const glm::mat4& m) { m_mProjection = m;  }
 
+	/**
+	 * SetJitter
+	 * offset the projection by a fraction of a pixel, temporal upscaling samples a different
+	 * position inside the pixels every frame. The jitter is kept when projection params change.
+	 * @param pixels offset in pixels, zero disables the jitter
+	 * @param viewportSize size of the viewport in pixels
+	 */
+	void SetJitter(const glm::vec2& pixels, const glm::ivec2& viewportSize);
+
+	/**
+	 * GetUnjitteredProjectionMatrix
+	 * @return projection matrix without the jitter, motion vectors are computed with it
+	 */
+	inline glm::mat4 GetUnjitteredProjectionMatrix() const { return glm::translate(glm::mat4(1.0f), glm::vec3(-m_vJitter, 0.0f)) * m_mProjection; }
+
 	/**
 	 * GetViewMatrix
 	 * @return camera view matrix
@@ -88,6 +103,7 @@ public:
 protected:
 	// camera matrices
 	glm::mat4				m_mProjection;
+	glm::vec2				m_vJitter;			// normalized device coordinates
 
 	//	projection parameters
 	float					m_fFov;
@@ -0,0 +1,175 @@
+/**
+ * ============================================================================
+ *  Name        : ClusteredLighting.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : clustered forward shading for many point lights. The view
+ *                frustum is split into screen tiles and exponential depth
+ *                slices, worker threads assign the lights to the clusters
+ *                they touch and the fragment shader only loops over the
+ *                lights of its own cluster. Lights, cluster ranges and the
+ *                light index list live in storage buffers.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/OpenGLRenderer.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+class ClusteredLighting
+{
+public:
+	/**
+	 * LIGHT
+	 * point light in world space
+	 */
+	struct LIGHT
+	{
+		glm::vec3		position;
+		float			radius;			// distance where the light fades out completely
+		glm::vec3		color;
+		float			intensity;
+	};
+
+	// light layout of the shader (std430)
+	struct LIGHTDATA
+	{
+		glm::vec4		positionRadius;	// world space position, radius
+		glm::vec4		color;			// rgb = color * intensity
+	};
+
+	struct STATS
+	{
+		uint32_t		lights;					// lights submitted
+		uint32_t		visibleLights;			// lights touching at least one depth slice
+		uint32_t		lightIndices;			// light references over all clusters
+		uint32_t		maxClusterLights;		// lights in the fullest cluster
+		uint32_t		droppedLights;			// references dropped because a cluster was full
+		float			assignMilliseconds;		// cpu time of the last Update
+	};
+
+	ClusteredLighting();
+	~ClusteredLighting();
+
+	/**
+	 * IsSupported
+	 * @return true if current context has storage buffers (GL 4.3)
+	 */
+	static bool IsSupported();
+
+	/**
+	 * Create
+	 * create the buffers and the worker threads
+	 * @param tilesX, tilesY number of screen tiles
+	 * @param slices number of depth slices
+	 * @param maxClusterLights max lights per cluster, extra lights are dropped
+	 * @param workerCount threads assigning lights besides the calling thread, 0xFFFFFFFF for one per extra core
+	 * @return true if successful
+	 */
+	bool Create(uint32_t tilesX = 16, uint32_t tilesY = 9, uint32_t slices = 24, uint32_t maxClusterLights = 128, uint32_t workerCount = 0xFFFFFFFF);
+
+	/**
+	 * Release
+	 * stop the workers and delete the buffers
+	 */
+	void Release();
+
+	/**
+	 * GetLights
+	 * @return light list, edit freely between Update calls
+	 */
+	inline std::vector<LIGHT>& GetLights() { return m_arrLights; }
+	inline const std::vector<LIGHT>& GetLights() const { return m_arrLights; }
+
+	/**
+	 * Update
+	 * assign the lights to the clusters of current view and projection of the renderer
+	 * and upload the buffers. Call once per frame after the camera is set.
+	 * @param renderer renderer with the camera matrices
+	 * @param width, height size of the viewport in pixels
+	 */
+	void Update(IRenderer& renderer, int32_t width, int32_t height);
+
+	/**
+	 * Bind
+	 * bind the buffers to storage buffer bindings 1, 2 and 3 and set the cluster uniforms
+	 * of a program compiled with the CLUSTERED_LIGHTS feature
+	 * @param program handle to shader program
+	 */
+	void Bind(GLuint program) const;
+
+	inline const STATS& GetStats() const { return m_Stats; }
+
+private:
+	struct AABB
+	{
+		glm::vec3		min;
+		glm::vec3		max;
+	};
+
+	// view space bounds of a visible light and the clusters they can touch
+	struct VIEWLIGHT
+	{
+		glm::vec3		position;
+		float			radius;
+		uint32_t		index;
+		int32_t			tileMin[2];
+		int32_t			tileMax[2];
+		int32_t			sliceMin;
+		int32_t			sliceMax;
+	};
+
+	// assignment output of one depth slice, written by one thread
+	struct SLICE
+	{
+		std::vector<std::vector<uint32_t>>	clusterLights;	// light indices per tile
+		uint32_t							dropped;
+	};
+
+	void BuildClusters(const glm::mat4& projection);
+	void CullLights(const glm::mat4& view, const glm::mat4& projection);
+	void AssignSlices();
+	void AssignSlice(uint32_t slice);
+	void WorkerThread();
+	void Upload();
+	float GetSliceDepth(uint32_t slice) const;
+
+	uint32_t							m_uTilesX;
+	uint32_t							m_uTilesY;
+	uint32_t							m_uSlices;
+	uint32_t							m_uMaxClusterLights;
+	float								m_fNear;
+	float								m_fFar;
+	glm::mat4							m_mProjection;		// projection the clusters were built for
+	glm::mat4							m_mView;
+	glm::vec2							m_vViewportSize;
+
+	std::vector<LIGHT>					m_arrLights;
+	std::vector<VIEWLIGHT>				m_arrViewLights;
+	std::vector<AABB>					m_arrClusters;		// view space bounds, tile x fastest, then tile y, then slice
+	std::vector<SLICE>					m_arrSlices;
+
+	// cpu copies of the buffers
+	std::vector<LIGHTDATA>				m_arrLightData;
+	std::vector<GLuint>					m_arrClusterData;	// offset and count per cluster
+	std::vector<GLuint>					m_arrIndexData;
+
+	GLuint								m_LightBuffer;
+	GLuint								m_ClusterBuffer;
+	GLuint								m_IndexBuffer;
+
+	// workers pick slices from a shared counter, the calling thread works too
+	std::vector<std::thread>			m_arrWorkers;
+	std::mutex							m_Mutex;
+	std::condition_variable				m_Condition;
+	std::condition_variable				m_DoneCondition;
+	uint64_t							m_uGeneration;
+	std::atomic<uint32_t>				m_uNextSlice;
+	uint32_t							m_uBusyWorkers;
+	bool								m_bQuit;
+
+	STATS								m_Stats;
+};
@@ -0,0 +1,96 @@
+/**
+ * ============================================================================
+ *  Name        : CompressedTexture.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : block compressed texture with a full mip chain, stored in a
+ *                small .btx container file
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/OpenGLRenderer.h"
+
+class CompressedTexture
+{
+public:
+	/**
+	 * .btx file layout, all values little endian:
+	 * HEADER, followed by levelCount times { uint32_t size; uint8_t data[size]; }
+	 */
+	struct HEADER
+	{
+		uint32_t		magic;			// 'BTX1'
+		uint32_t		format;			// GL compressed internal format
+		uint32_t		width;			// width of level 0 in pixels
+		uint32_t		height;			// height of level 0 in pixels
+		uint32_t		levelCount;		// number of mip levels in file
+	};
+
+	static constexpr uint32_t MAGIC = 0x31585442;
+
+	CompressedTexture();
+	~CompressedTexture();
+
+	/**
+	 * Create
+	 * compress rgba8 image and its mip chain
+	 * @param rgba source pixels, 4 bytes per pixel
+	 * @param width width of the image in pixels
+	 * @param height height of the image in pixels
+	 * @param format GL_COMPRESSED_RGBA_S3TC_DXT1_EXT or GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+	 * @param maxLevel highest mip level to generate, 0 for no mipmaps
+	 * @return true if succesful
+	 */
+	bool Create(const uint8_t* rgba, int32_t width, int32_t height, GLenum format, int32_t maxLevel = 1000);
+
+	/**
+	 * Load
+	 * @param filename .btx file to load
+	 * @return true if succesful
+	 */
+	bool Load(const std::string_view& filename);
+
+	/**
+	 * Save
+	 * @param filename .btx file to write
+	 * @return true if succesful
+	 */
+	bool Save(const std::string_view& filename) const;
+
+	void Clear();
+
+	/**
+	 * IsFormatSupported
+	 * @param format compressed format
+	 * @return true if current context can sample the format
+	 */
+	static bool IsFormatSupported(GLenum format);
+
+	/**
+	 * GetMaxLevelCount
+	 * @param width width of level 0 in pixels
+	 * @param height height of level 0 in pixels
+	 * @return number of levels in a full mip chain
+	 */
+	static uint32_t GetMaxLevelCount(int32_t width, int32_t height);
+
+	inline GLenum GetFormat() const { return m_eFormat; }
+	inline int32_t GetWidth() const { return m_iWidth; }
+	inline int32_t GetHeight() const { return m_iHeight; }
+	inline int32_t GetLevelCount() const { return (int32_t)m_arrLevels.size(); }
+	inline const std::vector<uint8_t>& GetLevel(int32_t level) const { return m_arrLevels[level]; }
+	inline bool IsEmpty() const { return m_arrLevels.empty(); }
+
+	/**
+	 * GetDataSize
+	 * @return total compressed size of all levels in bytes
+	 */
+	size_t GetDataSize() const;
+
+private:
+	GLenum								m_eFormat;
+	int32_t								m_iWidth;
+	int32_t								m_iHeight;
+	std::vector<std::vector<uint8_t>>	m_arrLevels;
+};
@@ -0,0 +1,122 @@
+/**
+ * ============================================================================
+ *  Name        : DeferredShading.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : deferred shading path. The geometry pass writes a packed
+ *                G-buffer with multiple render targets, lights are then
+ *                accumulated as screen space rectangles that only shade
+ *                the pixels inside their radius, all in one draw call.
+ *                G-buffer layout:
+ *                  0 RGBA8     albedo, specular intensity
+ *                  1 RGB10_A2  octahedral normal, log2 specular power / 10
+ *                  2 RGBA16F   light accumulation, starts with ambient + emissive
+ *                  depth       24 bit + 8 bit stencil, view position is rebuilt
+ *                              from it, matches the scene depth buffers for copies
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/ClusteredLighting.h"
+
+class DeferredShading
+{
+public:
+	DeferredShading();
+	~DeferredShading();
+
+	/**
+	 * IsSupported
+	 * @return true if current context supports float render targets and glDrawBuffers (GL 3.0)
+	 */
+	static bool IsSupported();
+
+	/**
+	 * Create
+	 * compile the programs, the G-buffer is allocated on first use
+	 * @param renderer renderer to create the programs with
+	 * @return true if successful
+	 */
+	bool Create(OpenGLRenderer& renderer);
+
+	/**
+	 * Release
+	 * delete the G-buffer and the programs
+	 */
+	void Release();
+
+	/**
+	 * BeginGeometryPass
+	 * bind and clear the G-buffer, resized to the given size if needed.
+	 * Draw the scene with GetGeometryProgram after this, materials are set with Material::SetToProgram
+	 * as in the forward path.
+	 * @param width, height size of the G-buffer in pixels
+	 * @param clearColor color of the pixels no geometry covers
+	 * @return true if the G-buffer is ready
+	 */
+	bool BeginGeometryPass(int32_t width, int32_t height, const glm::vec4& clearColor);
+
+	/**
+	 * GetGeometryProgram
+	 * @return program writing the G-buffer, uses the attributes and uniforms of DrawQueue::DrawImmediate and texture01
+	 */
+	inline GLuint GetGeometryProgram() const { return m_uGeometryProgram; }
+
+	/**
+	 * RenderLights
+	 * add the directional light and the point lights to the light accumulation target
+	 * @param renderer renderer with the camera matrices
+	 * @param lightDirection direction the white directional light travels
+	 * @param lights point lights, same list as the clustered forward path uses
+	 */
+	void RenderLights(IRenderer& renderer, const glm::vec3& lightDirection, const std::vector<ClusteredLighting::LIGHT>& lights);
+
+	/**
+	 * CopyDepth
+	 * copy the G-buffer depth into the default framebuffer of the renderer, so that
+	 * passes after the resolve are depth tested against the scene
+	 * @param renderer renderer to present with
+	 */
+	void CopyDepth(OpenGLRenderer& renderer);
+
+	/**
+	 * Resolve
+	 * draw the light accumulation to the default framebuffer of the renderer
+	 * @param renderer renderer to present with
+	 */
+	void Resolve(OpenGLRenderer& renderer);
+
+	/**
+	 * GetLightCount
+	 * @return point lights drawn by the last RenderLights, lights outside the view are skipped
+	 */
+	inline uint32_t GetLightCount() const { return m_uLightCount; }
+
+private:
+	// one corner of a light rectangle
+	struct LIGHTVERTEX
+	{
+		glm::vec2		position;			// normalized device coordinates
+		glm::vec4		positionRadius;		// view space, radius 0 for the directional light
+		glm::vec4		color;
+	};
+
+	bool CreateTargets(int32_t width, int32_t height);
+	void ReleaseTargets();
+	void AddLightRect(const glm::vec2& min, const glm::vec2& max, const glm::vec4& positionRadius, const glm::vec4& color);
+
+	GLuint						m_uGeometryProgram;
+	GLuint						m_uLightProgram;
+	GLuint						m_uResolveProgram;
+
+	glm::ivec2					m_vSize;
+	GLuint						m_uFramebuffer;			// all targets and depth, geometry pass
+	GLuint						m_uLightFramebuffer;	// light accumulation only, depth is sampled
+	GLuint						m_uAlbedo;
+	GLuint						m_uNormal;
+	GLuint						m_uLighting;
+	GLuint						m_uDepth;
+
+	std::vector<LIGHTVERTEX>	m_arrLightVertices;
+	uint32_t					m_uLightCount;
+};
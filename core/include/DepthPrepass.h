@@ -0,0 +1,129 @@
+/**
+ * ============================================================================
+ *  Name        : DepthPrepass.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : optional depth only pre-pass for opaque draws. The pre-pass
+ *                lays down depth with a position only vertex stream and a
+ *                trivial shader, the main pass then tests with GL_EQUAL so
+ *                every visible sample runs the full fragment shader once.
+ *                Occlusion queries count the samples of both passes to show
+ *                whether the pre-pass pays off for a scene.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/DrawQueue.h"
+#include <unordered_map>
+
+// forward declarations
+class MultiDrawIndirect;
+
+class DepthPrepass
+{
+public:
+	/**
+	 * STATS
+	 * sample counts of a frame some frames back, queries are never waited for.
+	 * With the pre-pass on, overdraw tells how many full shades it saves per visible sample,
+	 * compare shadedPerSample with it on and off together with the gpu time of the passes.
+	 */
+	struct STATS
+	{
+		uint32_t		draws;			// draws in the pre-pass, 0 when disabled
+		uint64_t		depthSamples;	// samples passing the depth test in the pre-pass
+		uint64_t		shadedSamples;	// samples passing the depth test in the main pass, each one fully shaded
+		uint64_t		screenSamples;	// samples of the viewport
+		float			overdraw;		// fragments the main pass would shade per visible sample without the pre-pass, 0 when disabled
+		float			shadedPerSample;// fragments the main pass did shade per screen sample
+	};
+
+	DepthPrepass();
+	~DepthPrepass();
+
+	/**
+	 * IsSupported
+	 * @return true if current context supports the occlusion queries of the statistics,
+	 * the pre-pass itself works without them
+	 */
+	static bool IsSupported();
+
+	/**
+	 * Create
+	 * compile the depth only programs
+	 * @param renderer renderer to create the programs with
+	 * @param multiDraw true to also compile the program of the multi draw indirect path
+	 * @return true if successful
+	 */
+	bool Create(OpenGLRenderer& renderer, bool multiDraw);
+
+	/**
+	 * Release
+	 * delete the programs, position buffers and queries
+	 */
+	void Release();
+
+	/**
+	 * SetEnabled
+	 * turn the pre-pass on or off, statistics of the main pass are gathered either way
+	 * @param enabled true to draw the pre-pass
+	 */
+	inline void SetEnabled(bool enabled) { m_bEnabled = enabled; }
+	inline bool IsEnabled() const { return m_bEnabled; }
+
+	/**
+	 * Render
+	 * start the frame statistics and, when enabled, draw the depth of the queue with color writes off.
+	 * Call once per frame after the depth buffer is cleared, queue should be sorted front to back.
+	 * @param renderer renderer with the camera matrices
+	 * @param queue opaque draws of the frame
+	 * @param multiDraw multi draw path to submit with, nullptr for the per draw path
+	 */
+	void Render(IRenderer& renderer, const DrawQueue& queue, MultiDrawIndirect* multiDraw);
+
+	/**
+	 * BeginMainPass, EndMainPass
+	 * surround the shaded draws of the same queue. Depth test is GL_EQUAL without depth writes
+	 * while the pre-pass is enabled, default depth state is restored at the end.
+	 */
+	void BeginMainPass();
+	void EndMainPass();
+
+	inline const STATS& GetStats() const { return m_Stats; }
+
+private:
+	// position only copy of a geometry
+	struct POSITIONS
+	{
+		std::shared_ptr<Geometry>	geometry;		// keeps the map key alive
+		GLuint						buffer;
+		bool						used;			// drawn in the current pre-pass, evicted otherwise
+	};
+
+	struct FRAME
+	{
+		GLuint			queries[2];		// pre-pass, main pass
+		uint32_t		draws;
+		uint64_t		screenSamples;
+		bool			prepass;		// pre-pass query was issued
+		bool			pending;		// main pass query was issued, not yet read
+	};
+
+	GLuint GetPositionBuffer(const std::shared_ptr<Geometry>& geometry);
+	void EvictPositionBuffers();
+	void Collect(FRAME& frame);
+
+	bool											m_bEnabled;
+	bool											m_bDepthWritten;	// pre-pass was drawn this frame
+
+	GLuint											m_uProgram;
+	GLint											m_iPositionAttrib;
+	GLint											m_iMatrixUniform;
+	GLuint											m_uMultiDrawProgram;
+
+	std::unordered_map<const Geometry*, POSITIONS>	m_mapPositions;
+
+	std::vector<FRAME>								m_arrFrames;
+	uint64_t										m_uFrame;
+	STATS											m_Stats;
+};
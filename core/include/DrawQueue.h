@@ -0,0 +1,81 @@
+/**
+ * ============================================================================
+ *  Name        : DrawQueue.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : list of recorded draws for deferred submission
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/OpenGLRenderer.h"
+
+// forward declarations
+class Geometry;
+struct Material;
+
+class DrawQueue
+{
+public:
+	struct DRAW
+	{
+		std::shared_ptr<Geometry>	geometry;
+		const Material*				material;
+		glm::mat4					worldMatrix;
+		glm::mat4					previousWorldMatrix;	// world matrix of the previous frame, for motion vectors
+	};
+
+	/**
+	 * Add
+	 * record a draw into the queue
+	 * @param geometry geometry to draw
+	 * @param material material of the draw, may be nullptr
+	 * @param worldMatrix world matrix of the draw
+	 */
+	void Add(const std::shared_ptr<Geometry>& geometry, const Material* material, const glm::mat4& worldMatrix);
+
+	/**
+	 * Add
+	 * record a moving draw into the queue
+	 * @param geometry geometry to draw
+	 * @param material material of the draw, may be nullptr
+	 * @param worldMatrix world matrix of the draw
+	 * @param previousWorldMatrix world matrix of the draw in the previous frame
+	 */
+	void Add(const std::shared_ptr<Geometry>& geometry, const Material* material, const glm::mat4& worldMatrix, const glm::mat4& previousWorldMatrix);
+
+	/**
+	 * Clear
+	 * remove all recorded draws, allocated memory is kept for the next frame
+	 */
+	inline void Clear() { m_arrDraws.clear(); }
+
+	inline auto& GetDraws() { return m_arrDraws; }
+	inline const auto& GetDraws() const { return m_arrDraws; }
+	inline size_t GetCount() const { return m_arrDraws.size(); }
+	inline bool IsEmpty() const { return m_arrDraws.empty(); }
+
+	/**
+	 * DrawImmediate
+	 * draw one geometry with the classic per draw path: attributes, uniforms and a draw call
+	 * @param renderer renderer to use
+	 * @param program handle to shader program
+	 * @param draw draw to submit
+	 */
+	static void DrawImmediate(IRenderer& renderer, GLuint program, const DRAW& draw);
+
+	/**
+	 * SortFrontToBack
+	 * order the draws by the view depth of their bounding box center, nearest first,
+	 * so that hidden fragments fail the depth test early
+	 * @param viewMatrix camera view matrix
+	 */
+	void SortFrontToBack(const glm::mat4& viewMatrix);
+
+private:
+	std::vector<DRAW>							m_arrDraws;
+
+	// scratch memory of the sort, kept for the next frame
+	std::vector<std::pair<float, uint32_t>>		m_arrSortKeys;
+	std::vector<DRAW>							m_arrSorted;
+};
@@ -0,0 +1,161 @@
+/**
+ * ============================================================================
+ *  Name        : DynamicResolution.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : renders the frame into an offscreen target whose resolution
+ *                follows the measured gpu frame time, then upscales it to the
+ *                window. The target is allocated for the largest scale and
+ *                the frame is drawn into its lower left corner, so changing
+ *                the scale never reallocates.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/OpenGLRenderer.h"
+
+// forward declarations
+class TemporalUpscaler;
+
+class DynamicResolution
+{
+public:
+	/**
+	 * SETTINGS
+	 * scale bounds and the frame time controller
+	 */
+	struct SETTINGS
+	{
+		SETTINGS() :
+			minScale(0.5f),
+			maxScale(1.0f),
+			targetMilliseconds(16.0f),
+			headroom(0.85f),
+			maxStep(0.1f),
+			settleFrames(4)
+		{
+		}
+
+		float			minScale;			// smallest scale of the window width and height
+		float			maxScale;			// largest scale, above 1 supersamples
+		float			targetMilliseconds;	// gpu frame time budget
+		float			headroom;			// scale grows only when frame time is below this fraction of the budget
+		float			maxStep;			// largest scale change of one adjustment
+		uint32_t		settleFrames;		// frames after a change before the next one, measurements lag behind
+	};
+
+	DynamicResolution();
+	~DynamicResolution();
+
+	/**
+	 * IsSupported
+	 * @return true if current context supports framebuffer objects
+	 */
+	static bool IsSupported();
+
+	/**
+	 * Create
+	 * compile the upscale program, the target is allocated on first BeginFrame
+	 * @param renderer renderer to create the program with
+	 * @param settings scale bounds and controller settings
+	 * @return true if successful
+	 */
+	bool Create(OpenGLRenderer& renderer, const SETTINGS& settings = SETTINGS());
+
+	/**
+	 * Release
+	 * delete the target, the queries and the program
+	 */
+	void Release();
+
+	/**
+	 * SetSettings
+	 * change the scale bounds or the controller, current scale is clamped to the new bounds
+	 * @param settings new settings
+	 */
+	void SetSettings(const SETTINGS& settings);
+	inline const SETTINGS& GetSettings() const { return m_Settings; }
+
+	/**
+	 * BeginFrame
+	 * adjust the scale from the frame times measured so far, bind the target and set the viewport
+	 * to the render size. Target is reallocated only when the window size changes.
+	 * @param width, height window size in pixels
+	 */
+	void BeginFrame(int32_t width, int32_t height);
+
+	/**
+	 * Present
+	 * upscale the rendered area to the window, temporally when enabled and bilinear otherwise
+	 * @param renderer renderer to draw with
+	 * @param framebuffer window framebuffer
+	 */
+	void Present(OpenGLRenderer& renderer, GLuint framebuffer);
+
+	/**
+	 * SetTemporalUpscaling
+	 * reconstruct the window resolution frame from jittered frames instead of filtering the current one.
+	 * The camera must apply TemporalUpscaler::GetJitter and the frame must render motion vectors.
+	 * @param renderer renderer to create the upscaler with
+	 * @param enabled true to enable
+	 * @return true if temporal upscaling is enabled
+	 */
+	bool SetTemporalUpscaling(OpenGLRenderer& renderer, bool enabled);
+	inline TemporalUpscaler* GetTemporalUpscaler() const { return m_pTemporalUpscaler.get(); }
+
+	inline GLuint GetFramebuffer() const { return m_uFramebuffer; }
+	inline GLuint GetTexture() const { return m_uColor; }
+	inline GLuint GetDepthBuffer() const { return m_uDepth; }
+	inline const glm::ivec2& GetTargetSize() const { return m_vTargetSize; }
+
+	/**
+	 * GetRenderSize
+	 * @return size of the area the frame is rendered to in pixels
+	 */
+	inline const glm::ivec2& GetRenderSize() const { return m_vRenderSize; }
+
+	/**
+	 * GetScale
+	 * @return current scale of the window width and height
+	 */
+	inline float GetScale() const { return m_fScale; }
+
+	/**
+	 * GetFrameMilliseconds
+	 * @return smoothed frame time the controller works on, gpu time when timer queries are supported
+	 */
+	inline float GetFrameMilliseconds() const { return m_fFrameMilliseconds; }
+
+private:
+	struct FRAME
+	{
+		GLuint			queries[2];		// begin and end timestamp
+		bool			pending;
+	};
+
+	bool CreateTarget(int32_t width, int32_t height);
+	void ReleaseTarget();
+	void Measure();
+	void UpdateScale(float milliseconds);
+	void Draw(OpenGLRenderer& renderer, GLuint texture, const glm::vec2& uvScale, const glm::vec2& uvMax);
+
+	SETTINGS			m_Settings;
+	GLuint				m_uProgram;
+	std::unique_ptr<TemporalUpscaler>	m_pTemporalUpscaler;
+
+	glm::ivec2			m_vWindowSize;
+	glm::ivec2			m_vTargetSize;
+	glm::ivec2			m_vRenderSize;
+	GLuint				m_uFramebuffer;
+	GLuint				m_uColor;
+	GLuint				m_uDepth;
+
+	float				m_fScale;
+	float				m_fFrameMilliseconds;
+	uint32_t			m_uSettle;
+
+	// gpu timestamps of the frames in flight, cpu time between frames without timer queries
+	std::vector<FRAME>	m_arrFrames;
+	uint64_t			m_uFrame;
+	uint64_t			m_uLastTicks;
+};
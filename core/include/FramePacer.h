@@ -0,0 +1,111 @@
+/**
+ * ============================================================================
+ *  Name        : FramePacer.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : limits how many frames the cpu may queue ahead of the gpu.
+ *                Every frame is fenced after the swap and the next frame
+ *                starts only when the oldest fence allows it, keeping input
+ *                latency to the set number of frames. Optionally the camera
+ *                input is latched once more right before the frame is drawn.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/OpenGLRenderer.h"
+#include <algorithm>
+#include <deque>
+#include <functional>
+
+class FramePacer
+{
+public:
+	/**
+	 * SETTINGS
+	 * frames in flight and late latching
+	 */
+	struct SETTINGS
+	{
+		SETTINGS() :
+			maxFramesInFlight(2),
+			lateLatch(false)
+		{
+		}
+
+		uint32_t		maxFramesInFlight;	// frames submitted but not finished by the gpu, 1 waits for every frame
+		bool			lateLatch;			// pump input and call the latch function just before the frame is drawn
+	};
+
+	/**
+	 * STATS
+	 * time the cpu was blocked waiting for the gpu
+	 */
+	struct STATS
+	{
+		float			waitLastFrame;		// seconds cpu waited for the gpu before the current frame
+		float			waitAverage;		// seconds, rolling average over recent frames
+		float			waitMax;			// seconds, longest single wait
+		float			waitTotal;			// seconds cpu has waited for the gpu in total
+		uint32_t		framesInFlight;		// frames still queued when the current frame started
+		uint64_t		frames;
+	};
+
+	FramePacer();
+	~FramePacer();
+
+	/**
+	 * IsSupported
+	 * @return true if current context supports sync objects
+	 */
+	static bool IsSupported();
+
+	/**
+	 * Create
+	 * @param settings frames in flight and late latching
+	 * @return true if successful
+	 */
+	bool Create(const SETTINGS& settings = SETTINGS());
+
+	/**
+	 * Release
+	 * delete the fences of the frames in flight
+	 */
+	void Release();
+
+	inline void SetSettings(const SETTINGS& settings) { m_Settings = settings; m_Settings.maxFramesInFlight = std::max(settings.maxFramesInFlight, 1u); }
+	inline const SETTINGS& GetSettings() const { return m_Settings; }
+
+	/**
+	 * SetLateLatch
+	 * function that reads the newest input into the camera, called before the frame is drawn
+	 * when late latching is enabled
+	 * @param latch function to call, empty to remove
+	 */
+	inline void SetLateLatch(const std::function<void()>& latch) { m_fnLateLatch = latch; }
+
+	/**
+	 * LateLatch
+	 * called by the application after input has been pumped, right before OnDraw
+	 */
+	void LateLatch();
+
+	/**
+	 * EndFrame
+	 * fence the frame after it has been swapped. Called by the renderer.
+	 */
+	void EndFrame();
+
+	/**
+	 * Wait
+	 * block until less than maxFramesInFlight frames are queued. Called by the renderer after EndFrame.
+	 */
+	void Wait();
+
+	inline const STATS& GetStats() const { return m_Stats; }
+
+private:
+	SETTINGS				m_Settings;
+	std::function<void()>	m_fnLateLatch;
+	std::deque<GLsync>		m_arrFences;		// oldest first
+	STATS					m_Stats;
+};
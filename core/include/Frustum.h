@@ -0,0 +1,130 @@
+/**
+ * ============================================================================
+ *  Name        : Frustum.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : view frustum planes for visibility culling
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../glm-master/glm/glm.hpp"
+#include <cfloat>
+#include <cstdint>
+
+struct Frustum
+{
+	Frustum()
+	{
+		for (auto& plane : m_vPlanes)
+		{
+			plane = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+	}
+
+	/**
+	 * Set
+	 * extract the frustum planes from a view-projection matrix
+	 * @param m view-projection matrix
+	 */
+	inline void Set(const glm::mat4& m)
+	{
+		const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+		const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+		const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+		const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+		m_vPlanes[0] = row3 + row0;		// left
+		m_vPlanes[1] = row3 - row0;		// right
+		m_vPlanes[2] = row3 + row1;		// bottom
+		m_vPlanes[3] = row3 - row1;		// top
+		m_vPlanes[4] = row3 + row2;		// near
+		m_vPlanes[5] = row3 - row2;		// far
+
+		for (auto& plane : m_vPlanes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+	}
+
+	/**
+	 * IsSphereVisible
+	 * @param center center of the sphere in world space
+	 * @param radius radius of the sphere
+	 * @return true if sphere is at least partially inside the frustum
+	 */
+	inline bool IsSphereVisible(const glm::vec3& center, float radius) const
+	{
+		for (const auto& plane : m_vPlanes)
+		{
+			if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	 * IsBoundsVisible
+	 * test the bounding sphere of a local box, its radius is scaled by the largest axis scale
+	 * @param boundsMin local box minimum
+	 * @param boundsMax local box maximum
+	 * @param world local to world matrix
+	 * @return true if the sphere is at least partially inside the frustum
+	 */
+	inline bool IsBoundsVisible(const glm::vec3& boundsMin, const glm::vec3& boundsMax, const glm::mat4& world) const
+	{
+		const glm::vec3 center((boundsMin + boundsMax) * 0.5f);
+		const float radius = glm::length(boundsMax - center);
+		const float scale = glm::sqrt(glm::max(glm::max(
+			glm::dot(glm::vec3(world[0]), glm::vec3(world[0])),
+			glm::dot(glm::vec3(world[1]), glm::vec3(world[1]))),
+			glm::dot(glm::vec3(world[2]), glm::vec3(world[2]))));
+
+		return IsSphereVisible(glm::vec3(world * glm::vec4(center, 1.0f)), radius * scale);
+	}
+
+	/**
+	 * GetDepthRange
+	 * @param projection glm perspective matrix
+	 * @return distance of the near plane in x, far plane in y
+	 */
+	static inline glm::vec2 GetDepthRange(const glm::mat4& projection)
+	{
+		return glm::vec2(
+			projection[3][2] / (projection[2][2] - 1.0f),
+			projection[3][2] / (projection[2][2] + 1.0f));
+	}
+
+	/**
+	 * GetSphereRect
+	 * normalized device coordinate bounds of the box around a view space sphere.
+	 * The sphere must be in front of the near plane
+	 * @param projection projection matrix
+	 * @param center center of the sphere in view space
+	 * @param radius radius of the sphere
+	 * @param ndcMin bounds minimum, not clamped to the screen
+	 * @param ndcMax bounds maximum, not clamped to the screen
+	 * @return false if the bounds are outside the screen
+	 */
+	static inline bool GetSphereRect(const glm::mat4& projection, const glm::vec3& center, float radius, glm::vec2& ndcMin, glm::vec2& ndcMax)
+	{
+		ndcMin = glm::vec2(FLT_MAX);
+		ndcMax = glm::vec2(-FLT_MAX);
+		for (uint32_t corner = 0; corner < 8; ++corner)
+		{
+			const glm::vec3 offset(
+				corner & 1 ? radius : -radius,
+				corner & 2 ? radius : -radius,
+				corner & 4 ? radius : -radius);
+			const glm::vec4 clip(projection * glm::vec4(center + offset, 1.0f));
+			const glm::vec2 ndc(glm::vec2(clip) / clip.w);
+			ndcMin = glm::min(ndcMin, ndc);
+			ndcMax = glm::max(ndcMax, ndc);
+		}
+		return ndcMax.x >= -1.0f && ndcMax.y >= -1.0f && ndcMin.x <= 1.0f && ndcMin.y <= 1.0f;
+	}
+
+	glm::vec4		m_vPlanes[6];
+};
@@ -0,0 +1,57 @@
+/**
+ * ============================================================================
+ *  Name        : Fxaa.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : single pass post-process anti-aliasing in the style of FXAA.
+ *                Edges are found from the luma contrast of the neighbourhood,
+ *                searched along their direction and the pixel is blended
+ *                across them by its distance to the edge end. Costs one pass
+ *                over the final frame instead of multiplying the samples of
+ *                every pass like MSAA.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/PostProcess.h"
+
+class Fxaa : public PostEffect
+{
+public:
+	/**
+	 * SETTINGS
+	 * edge detection and blending
+	 */
+	struct SETTINGS
+	{
+		SETTINGS() :
+			contrastThreshold(0.0312f),
+			relativeThreshold(0.063f),
+			subpixelBlending(0.75f)
+		{
+		}
+
+		float			contrastThreshold;	// smallest luma contrast filtered, skips dark noise
+		float			relativeThreshold;	// contrast relative to the brightest neighbour filtered
+		float			subpixelBlending;	// strength of the blur of single pixel features, 0 - 1
+	};
+
+	Fxaa(const SETTINGS& settings = SETTINGS());
+	~Fxaa();
+
+	inline void SetSettings(const SETTINGS& settings) { m_Settings = settings; }
+	inline const SETTINGS& GetSettings() const { return m_Settings; }
+
+	/**
+	 * PostEffect
+	 */
+	const char* GetName() const override { return "fxaa"; }
+	FORMATS GetFormats() const override;
+	bool Create(OpenGLRenderer& renderer) override;
+	void Release() override;
+	void Render(OpenGLRenderer& renderer, PostProcess& chain, const RenderTargetPool::TARGET& input, const RenderTargetPool::TARGET& output) override;
+
+private:
+	SETTINGS			m_Settings;
+	GLuint				m_uProgram;
+};
@@ -101,6 +101,16 @@ public:
 	 */
 	void GenKnot(uint32_t slices, uint32_t stacks, float radius);
 
+	/**
+	 * SetData
+	 * take ownership of prebuilt vertices and indices, e.g. merged batches.
+	 * Index buffer is created when indices are given
+	 * @param vertices vertex data
+	 * @param indices 32 bit indices, or empty for non-indexed geometry
+	 * @param mode primitive type to draw with
+	 */
+	void SetData(std::vector<VERTEX>&& vertices, std::vector<uint32_t>&& indices, GLenum mode = GL_TRIANGLES);
+
 	// Not implemented
 	//bool LoadObj(const std::string_view& filename);
 
@@ -110,23 +120,37 @@ public:
 	void Draw(IRenderer& renderer) const;
 
 	static std::vector<Geometry::VERTEX> GenSphereVertices(const glm::vec3& radius, const glm::vec3& offset, uint32_t rings, uint32_t segments);
-	static std::vector<Geometry::VERTEX> GenCubeVertices(const glm::vec3& size, const glm::vec3& offset, GLuint& indexBuffer, size_t& indexCount);
+	static std::vector<Geometry::VERTEX> GenCubeVertices(const glm::vec3& size, const glm::vec3& offset, std::vector<uint32_t>& indices);
 	static std::vector<Geometry::VERTEX> GenQuadVertices(const glm::vec2& size, const glm::vec3& offset);
-	static std::vector<Geometry::VERTEX> GenTorusVertices(uint32_t segments, float radius, float fatness, GLuint& indexBuffer, size_t& indexCount);
-	static std::vector<Geometry::VERTEX> GenKnotVertices(uint32_t slices, uint32_t stacks, float radius, GLuint& indexBuffer, size_t& indexCount);
+	static std::vector<Geometry::VERTEX> GenTorusVertices(uint32_t segments, float radius, float fatness, std::vector<uint32_t>& indices);
+	static std::vector<Geometry::VERTEX> GenKnotVertices(uint32_t slices, uint32_t stacks, float radius, std::vector<uint32_t>& indices);
 
 	inline VERTEX* GetData() { return m_arrVertices.data(); }
 	inline const VERTEX* GetData() const { return m_arrVertices.data(); }
 	inline size_t GetVertexCount() const { return m_arrVertices.size(); }
+	inline const uint32_t* GetIndices() const { return m_arrIndices.data(); }
 	inline GLuint GetIndexBuffer() const { return m_IndexBuffer; }
 	inline size_t GetIndexCount() const { return m_uIndexCount; }
+	inline GLenum GetDrawMode() const { return m_eDrawMode; }
+
+	/**
+	 * GetBoundsMin, GetBoundsMax
+	 * @return local space axis aligned bounding box of the vertices
+	 */
+	inline const glm::vec3& GetBoundsMin() const { return m_vBoundsMin; }
+	inline const glm::vec3& GetBoundsMax() const { return m_vBoundsMax; }
 
 private:
 	static glm::vec3 EvaluateTrefoil(float s, float t);
+	void CreateIndexBuffer();
+	void UpdateBounds();
 
 	std::vector<VERTEX>			m_arrVertices;
+	std::vector<uint32_t>		m_arrIndices;
 	GLenum						m_eDrawMode;
 	GLuint						m_IndexBuffer;
 	size_t						m_uIndexCount;
+	glm::vec3					m_vBoundsMin;
+	glm::vec3					m_vBoundsMax;
 };
 
@@ -32,6 +32,17 @@ public:
 	 */
 	void Render(IRenderer& renderer, GLuint program) override;
 
+	/**
+	 * IsVisible
+	 * test the geometry bounds against the view frustum
+	 * @param frustum view frustum
+	 * @param world world matrix of the node
+	 * @return true if geometry may be visible
+	 */
+	bool IsVisible(const Frustum& frustum, const glm::mat4& world) const;
+
+	const std::shared_ptr<Geometry>& GetGeometry() const { return m_pGeometry; }
+	const std::shared_ptr<Material>& GetMaterial() const { return m_pMaterial; }
 	void SetGeometry(const std::shared_ptr<Geometry>& geometry) { m_pGeometry = geometry; }
 	void SetMaterial(const std::shared_ptr<Material>& material) { m_pMaterial = material; }
 
@@ -0,0 +1,169 @@
+/**
+ * ============================================================================
+ *  Name        : GpuProfiler.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : scoped gpu timing with GL_TIMESTAMP queries. Queries of a
+ *                frame are read back frames later so that reading never
+ *                stalls, results are averaged over a window of frames and
+ *                reported together with the cpu time of the same scopes.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/OpenGLRenderer.h"
+#include <map>
+
+class GpuProfiler
+{
+public:
+	/**
+	 * TIMING
+	 * aggregated results of a scope, keyed by its path of nested scope names
+	 */
+	struct TIMING
+	{
+		std::string				name;
+		uint32_t				depth;				// nesting level, frame scope is 0
+		float					gpuMilliseconds;	// last frame
+		float					cpuMilliseconds;	// last frame
+		float					gpuAverage;			// rolling average over the window in milliseconds
+		float					cpuAverage;			// rolling average over the window in milliseconds
+		uint32_t				sampleCount;		// frames the scope has been recorded in
+
+		std::vector<float>		gpuSamples;
+		std::vector<float>		cpuSamples;
+	};
+
+	/**
+	 * SCOPE
+	 * times the lifetime of the object, profiler may be nullptr
+	 */
+	class SCOPE
+	{
+	public:
+		SCOPE(GpuProfiler* profiler, const std::string_view& name) :
+			m_pProfiler(profiler)
+		{
+			if (m_pProfiler)
+			{
+				m_pProfiler->Begin(name);
+			}
+		}
+		~SCOPE()
+		{
+			if (m_pProfiler)
+			{
+				m_pProfiler->End();
+			}
+		}
+
+	private:
+		GpuProfiler*	m_pProfiler;
+	};
+
+	GpuProfiler();
+	~GpuProfiler();
+
+	/**
+	 * IsSupported
+	 * @return true if current context supports timestamp queries
+	 */
+	static bool IsSupported();
+
+	/**
+	 * Create
+	 * allocate the query pools
+	 * @param frameLatency number of frames queries are kept before reading them, at least 2
+	 * @param maxScopes max number of scopes recorded per frame, extra scopes are ignored
+	 * @param window number of frames in the rolling average
+	 * @return true if successful
+	 */
+	bool Create(uint32_t frameLatency = 3, uint32_t maxScopes = 256, uint32_t window = 60);
+
+	/**
+	 * Release
+	 * delete the queries and results
+	 */
+	void Release();
+
+	/**
+	 * BeginFrame
+	 * read back the oldest frame if its queries are available, then open the frame scope
+	 */
+	void BeginFrame();
+
+	/**
+	 * EndFrame
+	 * close the frame scope
+	 */
+	void EndFrame();
+
+	/**
+	 * Begin, End
+	 * open and close a nested scope
+	 * @param name name of the scope
+	 */
+	void Begin(const std::string_view& name);
+	void End();
+
+	/**
+	 * GetTimings
+	 * @return aggregated timings keyed by scope path, e.g. "frame/scene"
+	 */
+	inline const std::map<std::string, TIMING>& GetTimings() const { return m_mapTimings; }
+
+	/**
+	 * GetDroppedFrames
+	 * @return frames whose queries were not available when their slot was reused
+	 */
+	inline uint32_t GetDroppedFrames() const { return m_uDroppedFrames; }
+
+	/**
+	 * GetJson
+	 * @return timings as JSON, times in milliseconds
+	 */
+	std::string GetJson() const;
+
+	/**
+	 * Export
+	 * write GetJson to a file
+	 * @param filename file to write
+	 * @return true if successful
+	 */
+	bool Export(const std::string_view& filename) const;
+
+	/**
+	 * PrintTimings
+	 * write averaged timings to debug output
+	 */
+	void PrintTimings() const;
+
+private:
+	struct SCOPEDATA
+	{
+		std::string		path;
+		uint32_t		depth;
+		uint64_t		cpuBegin;
+		uint64_t		cpuEnd;
+	};
+
+	struct FRAME
+	{
+		std::vector<GLuint>		queries;		// begin and end timestamp per scope
+		std::vector<SCOPEDATA>	scopes;
+		bool					pending;		// queries issued, not yet read
+	};
+
+	void Collect(FRAME& frame);
+	void AddSample(const SCOPEDATA& scope, float gpuMilliseconds);
+
+	std::vector<FRAME>				m_arrFrames;
+	std::vector<size_t>				m_arrStack;			// open scopes of current frame
+	std::map<std::string, TIMING>	m_mapTimings;
+	uint64_t						m_uFrame;
+	uint32_t						m_uMaxScopes;
+	uint32_t						m_uWindow;
+	uint32_t						m_uDroppedFrames;
+	bool							m_bInFrame;
+};
@@ -31,6 +31,7 @@
 
 // include timer component and renderer interface
 #include "Timer.h"
+#include "Profiler.h"
 #include "IRenderer.h"
 
 // define some common keycodes
@@ -41,6 +42,8 @@
 #define KEY_UP		VK_UP
 #define KEY_DOWN	VK_DOWN
 #define KEY_SPACE	VK_SPACE
+#define KEY_P		'P'
+#define KEY_A		'A'
 
 #elif defined (_LINUX)
 #define KEY_ESC		XK_Escape
@@ -48,7 +51,9 @@
 #define KEY_RIGHT	XK_Right
 #define KEY_UP		XK_Up
 #define KEY_DOWN	XK_Down
-#define KEY_SPACE	XK_Space
+#define KEY_SPACE	XK_space
+#define KEY_P		XK_P
+#define KEY_A		XK_A
 
 #endif
 
@@ -56,6 +61,24 @@
 class IApplication
 {
 public:
+	/**
+	 * HEADLESSPARAMS
+	 * settings of an offscreen run without a window or display, see Create
+	 */
+	struct HEADLESSPARAMS
+	{
+		HEADLESSPARAMS() :
+			frameCount(300),
+			timestep(1.0f / 60.0f),
+			readback(false)
+		{
+		}
+
+		uint32_t		frameCount;		// frames rendered before Run returns
+		float			timestep;		// fixed frametime passed to OnUpdate, in seconds
+		bool			readback;		// read back the color buffer of the last frame, see GetReadback
+	};
+
 	IApplication();
 	~IApplication();
 
@@ -69,6 +92,18 @@ public:
 	 */
 	bool Create(int32_t resX, int32_t resY, const std::string& title);
 
+	/**
+	 * Create
+	 * initialize the application layer without a window. Renderer draws into an offscreen
+	 * framebuffer of the given resolution and Run renders a fixed number of frames with a
+	 * fixed timestep. Currently supported on linux only.
+	 * @param resX horizontal resolution of the offscreen framebuffer in pixels
+	 * @param resY vertical resolution of the offscreen framebuffer in pixels
+	 * @param headless frame count, timestep and readback settings
+	 * @return true if successful, false otherwise
+	 */
+	bool Create(int32_t resX, int32_t resY, const HEADLESSPARAMS& headless);
+
 	/**
 	 * Run
 	 * enter into app main loop. This function will not return until app has been terminated.
@@ -114,6 +149,20 @@ public:
 	 */
 	void SetActive(bool set);
 
+	/**
+	 * SetTargetFrameRate
+	 * limit the frame rate of the windowed main loop. The time left of the frame is slept
+	 * and the last moment spun, sleeping alone wakes up too late for precise frame times.
+	 * @param framesPerSecond frames per second to run at, 0 for unlimited
+	 */
+	inline void SetTargetFrameRate(float framesPerSecond) { m_fTargetFrameRate = framesPerSecond; m_uNextFrameTicks = 0; }
+
+	/**
+	 * GetTargetFrameRate
+	 * @return frames per second the main loop is limited to, 0 if unlimited
+	 */
+	inline float GetTargetFrameRate() const { return m_fTargetFrameRate; }
+
 	/**
 	 * Close
 	 * close the app
@@ -157,6 +206,26 @@ public:
 	 */
 	inline float GetAspect() const { return (float)m_iWidth / (float)m_iHeight; }
 
+	/**
+	 * IsHeadless
+	 * @return true if app was created without a window
+	 */
+	inline bool IsHeadless() const { return m_bHeadless; }
+
+	/**
+	 * GetReadback
+	 * @return RGBA8 pixels of the last headless frame, rows bottom up, empty if readback was not requested
+	 */
+	inline const std::vector<uint8_t>& GetReadback() const { return m_arrReadback; }
+
+	/**
+	 * SaveReadback
+	 * write the readback pixels to an uncompressed 32 bit TGA file
+	 * @param filename file to write
+	 * @return true if successful
+	 */
+	bool SaveReadback(const std::string_view& filename) const;
+
 	/**
 	 * IsKeyDown
 	 * @param osKeyCode os-dependent key code
@@ -248,6 +317,15 @@ protected:
 #endif
 
 private:
+	// update, late latch, draw and flip of one frame, shared by the run loops
+	void RunFrame(float timestep);
+
+	// pump the input that arrived during the frame and let the frame pacer latch it, before OnDraw
+	void LateLatch();
+
+	// wait until the next frame is due when a target frame rate is set
+	void LimitFrameRate();
+
 #if defined (_WINDOWS)
 	static HWND MakeWindow(int32_t width, int32_t height, const std::string& title);
 	static long WINAPI WndProc(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
@@ -257,6 +335,9 @@ private:
 
 #if defined (_LINUX)
 	static Window MakeWindow(int32_t width, int32_t height, const char* title);
+	void RunHeadless();
+	void DrainEvents();
+	void WaitEvents();
     static bool ProcessEvents(XEvent* evnt);
     static KeySym PreprocessKeyEvent(XEvent* evnt);
 
@@ -266,15 +347,23 @@ private:
     static XSetWindowAttributes		m_WindowAttributes;
     static Atom						m_CloseAtom;
     static uint8_t                  m_uKeyboard[65536];
+    bool                            m_bQuit;
+    bool                            m_bMinimized;
 #endif
 
 	static IApplication*			m_pApp;
 	bool							m_bActive;
 	Timer							m_Timer;
+	float							m_fTargetFrameRate;
+	uint64_t						m_uNextFrameTicks;
 
 	int32_t							m_iWidth;
 	int32_t							m_iHeight;
 
+	bool							m_bHeadless;
+	HEADLESSPARAMS					m_HeadlessParams;
+	std::vector<uint8_t>			m_arrReadback;
+
 	std::unique_ptr<IRenderer>		m_pRenderer;
 };
 
@@ -14,13 +14,45 @@
 #include "../glm-master/glm/gtc/random.hpp"
 #include <string_view>
 
+#include "Frustum.h"
+
+// forward declarations
+class DrawQueue;
+
 class IRenderer
 {
 public:
+	/**
+	 * RENDERPATH
+	 * how the app shades the scene, materials and lights are the same for both
+	 */
+	enum RENDERPATH
+	{
+		RENDERPATH_FORWARD,
+		RENDERPATH_DEFERRED
+	};
+
+	/**
+	 * ANTIALIASING
+	 * edge smoothing of the frame. MSAA multiplies the samples of every pass and resolves them once,
+	 * POST filters the luma edges of the final frame in a single pass.
+	 */
+	enum ANTIALIASING
+	{
+		ANTIALIASING_OFF,
+		ANTIALIASING_MSAA2,
+		ANTIALIASING_MSAA4,
+		ANTIALIASING_MSAA8,
+		ANTIALIASING_POST
+	};
+
 	IRenderer() :
 		m_mView(1.0f),
 		m_mProjection(1.0f),
-		m_vLightPosition(0.0f, 1.0f, 0.0f)
+		m_vLightPosition(0.0f, 1.0f, 0.0f),
+		m_pDrawQueue(nullptr),
+		m_eRenderPath(RENDERPATH_FORWARD),
+		m_eAntialiasing(ANTIALIASING_OFF)
 	{
 		m_mShadowBias = glm::mat4(
 			0.5, 0.0, 0.0, 0.0,
@@ -71,13 +103,42 @@ public:
 	 */
 	virtual bool SetTexture(uint32_t program, uint32_t texture, int32_t slot, const std::string_view& uniformName) = 0;
 
+	/**
+	 * SetRenderPath
+	 * select forward or deferred shading, e.g. per level
+	 * @param path render path to use
+	 * @return true if the path is supported and selected, forward is kept otherwise
+	 */
+	virtual bool SetRenderPath(RENDERPATH path)
+	{
+		m_eRenderPath = RENDERPATH_FORWARD;
+		return path == RENDERPATH_FORWARD;
+	}
+	RENDERPATH GetRenderPath() const { return m_eRenderPath; }
+
+	/**
+	 * SetAntialiasing
+	 * select the anti-aliasing mode, can be changed at any time
+	 * @param mode mode to use
+	 * @return true if the mode is supported and selected, anti-aliasing is off otherwise
+	 */
+	virtual bool SetAntialiasing(ANTIALIASING mode)
+	{
+		m_eAntialiasing = ANTIALIASING_OFF;
+		return mode == ANTIALIASING_OFF;
+	}
+	ANTIALIASING GetAntialiasing() const { return m_eAntialiasing; }
+
 	// access to view and projection
 	glm::mat4& GetViewMatrix() { return m_mView; }
 	glm::mat4& GetProjectionMatrix() { return m_mProjection; }
 	const glm::mat4& GetViewMatrix() const { return m_mView; }
 	const glm::mat4& GetProjectionMatrix() const { return m_mProjection; }
-	void SetViewMatrix(const glm::mat4& m) { m_mView = m; }
-	void SetProjectionMatrix(const glm::mat4& m) { m_mProjection = m; }
+	void SetViewMatrix(const glm::mat4& m) { m_mView = m; m_Frustum.Set(m_mProjection * m_mView); }
+	void SetProjectionMatrix(const glm::mat4& m) { m_mProjection = m; m_Frustum.Set(m_mProjection * m_mView); }
+
+	// view frustum, updated when view or projection is set
+	const Frustum& GetFrustum() const { return m_Frustum; }
 
 	// shadow bias
 	const glm::mat4& GetShadowBiasMatrix() const { return m_mShadowBias; }
@@ -88,14 +149,29 @@ public:
 	void SetLightPos(const glm::vec3& lightPos) { m_vLightPosition = lightPos; }
 	void SetLightPos(float x, float y, float z) { m_vLightPosition = glm::vec3(x, y, z); }
 
+	/**
+	 * SetDrawQueue
+	 * when a draw queue is set, scene nodes record their draws into it instead of drawing immediately
+	 * @param queue queue to record into, or nullptr to draw immediately
+	 */
+	void SetDrawQueue(DrawQueue* queue) { m_pDrawQueue = queue; }
+	DrawQueue* GetDrawQueue() { return m_pDrawQueue; }
+
 
 protected:
 	// view and projection matrices
 	glm::mat4		m_mView;
 	glm::mat4		m_mProjection;
+	Frustum			m_Frustum;
 
 	// lights & shadows
 	glm::mat4		m_mShadowBias;
 	glm::vec3		m_vLightPosition;
+
+	// active draw queue
+	DrawQueue*		m_pDrawQueue;
+
+	RENDERPATH		m_eRenderPath;
+	ANTIALIASING	m_eAntialiasing;
 };
 
@@ -0,0 +1,122 @@
+/**
+ * ============================================================================
+ *  Name        : ImageKernels.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : image processing kernels for texture import. Each kernel has
+ *                a scalar reference path and SSE2 / AVX2 paths selected at
+ *                runtime, large images are processed in parallel over rows.
+ *                Images are rgba8 with tightly packed rows.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ImageKernels
+{
+public:
+	enum SIMD
+	{
+		SIMD_NONE,		// scalar reference implementation
+		SIMD_SSE2,
+		SIMD_AVX2
+	};
+
+	struct BENCHMARK
+	{
+		std::string		kernel;
+		SIMD			simd;
+		double			milliseconds;		// average time of one call
+		bool			matchesReference;	// output is identical to SIMD_NONE
+	};
+
+	/**
+	 * GetSupportedSimd
+	 * @return best instruction set supported by the cpu and the build
+	 */
+	static SIMD GetSupportedSimd();
+
+	/**
+	 * SetSimd
+	 * select the code path, clamped to the supported level
+	 * @param simd instruction set to use
+	 */
+	static void SetSimd(SIMD simd);
+	static SIMD GetSimd();
+
+	/**
+	 * SetThreadCount
+	 * @param count max number of threads used by a kernel call, 0 for hardware concurrency
+	 */
+	static void SetThreadCount(uint32_t count);
+
+	/**
+	 * PremultiplyAlpha
+	 * multiply color channels by alpha, color * alpha / 255 rounded down
+	 * @param rgba pixels to modify in place
+	 */
+	static void PremultiplyAlpha(uint8_t* rgba, int32_t width, int32_t height);
+
+	/**
+	 * SrgbToLinear
+	 * convert srgb encoded colors to linear floats, alpha is scaled to 0...1
+	 * @param rgba source pixels
+	 * @param dst receives width * height * 4 floats
+	 */
+	static void SrgbToLinear(const uint8_t* rgba, float* dst, int32_t width, int32_t height);
+
+	/**
+	 * Swizzle
+	 * reorder channels in place
+	 * @param rgba pixels to modify in place
+	 * @param order source channel index of each destination channel, e.g. { 2, 1, 0, 3 } for bgra
+	 */
+	static void Swizzle(uint8_t* rgba, int32_t width, int32_t height, const uint8_t order[4]);
+
+	/**
+	 * DownsampleBox
+	 * 2x2 box filter to the next mip level, odd edges repeat the last texel
+	 * @param src source pixels
+	 * @param dst receives max(width / 2, 1) x max(height / 2, 1) pixels
+	 */
+	static void DownsampleBox(const uint8_t* src, int32_t width, int32_t height, std::vector<uint8_t>& dst);
+
+	/**
+	 * DownsampleKaiser
+	 * 8 tap separable Kaiser windowed sinc filter to the next mip level.
+	 * Sharper than the box filter with less aliasing
+	 * @param src source pixels
+	 * @param dst receives max(width / 2, 1) x max(height / 2, 1) pixels
+	 */
+	static void DownsampleKaiser(const uint8_t* src, int32_t width, int32_t height, std::vector<uint8_t>& dst);
+
+	/**
+	 * PackRGB565
+	 * truncate rgba8 to 16 bit rgb565, alpha is dropped
+	 * @param rgba source pixels
+	 * @param dst receives width * height pixels
+	 */
+	static void PackRGB565(const uint8_t* rgba, uint16_t* dst, int32_t width, int32_t height);
+
+	/**
+	 * PackRGB8
+	 * drop the alpha channel
+	 * @param rgba source pixels
+	 * @param dst receives width * height * 3 bytes
+	 */
+	static void PackRGB8(const uint8_t* rgba, uint8_t* dst, int32_t width, int32_t height);
+
+	/**
+	 * Benchmark
+	 * time every kernel with every supported instruction set on a random
+	 * image and compare the output to the scalar reference
+	 * @param width width of the test image
+	 * @param height height of the test image
+	 * @param iterations number of calls to average
+	 * @return one result per kernel and instruction set
+	 */
+	static std::vector<BENCHMARK> Benchmark(int32_t width, int32_t height, int32_t iterations = 10);
+};
@@ -13,9 +13,34 @@
 
 struct Material
 {
+	/**
+	 * FEATURE
+	 * shader features a material can use, bits of the shader permutation key.
+	 * Shaders declare the features they implement with "#pragma feature <name>"
+	 */
+	enum FEATURE : uint64_t
+	{
+		FEATURE_SPECULAR		= 1 << 0,
+		FEATURE_EMISSIVE		= 1 << 1
+	};
+	static constexpr uint32_t FEATURE_COUNT = 2;
+
 	Material();
 
-	void SetToProgram(GLuint program);
+	void SetToProgram(GLuint program) const;
+
+	/**
+	 * GetFeatures
+	 * @return FEATURE bits the material properties need
+	 */
+	uint64_t GetFeatures() const;
+
+	/**
+	 * GetFeatureName
+	 * @param index bit index of the feature
+	 * @return name of the feature used in shaders, or nullptr if index is out of range
+	 */
+	static const char* GetFeatureName(uint32_t index);
 
 	glm::vec4		m_cAmbient;
 	glm::vec4		m_cDiffuse;
@@ -0,0 +1,126 @@
+/**
+ * ============================================================================
+ *  Name        : MultiDrawIndirect.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : submits a draw queue with a single glMultiDrawElementsIndirect
+ *                per draw mode. All geometry lives in shared vertex and index
+ *                buffers, per draw data is fetched in shader with gl_DrawIDARB.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/DrawQueue.h"
+#include <unordered_map>
+
+class MultiDrawIndirect
+{
+public:
+	// command layout defined by GL_ARB_draw_indirect
+	struct DrawElementsIndirectCommand
+	{
+		GLuint		count;
+		GLuint		instanceCount;
+		GLuint		firstIndex;
+		GLint		baseVertex;
+		GLuint		baseInstance;
+	};
+
+	// per draw data, must match the DrawData struct of the shader (std430)
+	struct DRAWDATA
+	{
+		glm::mat4	modelMatrix;
+		glm::vec4	materialAmbient;
+		glm::vec4	materialDiffuse;
+		glm::vec4	materialSpecular;
+		glm::vec4	materialEmissive;
+		glm::vec4	materialParams;		// x = specular power
+	};
+
+	MultiDrawIndirect();
+	~MultiDrawIndirect();
+
+	/**
+	 * IsSupported
+	 * @return true if current context has everything required by the multi draw path:
+	 * GL 4.3 (multi draw indirect, storage buffers) and GL_ARB_shader_draw_parameters
+	 */
+	static bool IsSupported();
+
+	/**
+	 * Create
+	 * create the shared buffers
+	 * @return true if multi draw path is available, false if Submit falls back to per draw path
+	 */
+	bool Create();
+
+	/**
+	 * Submit
+	 * draw all recorded draws of the queue. On multi draw path, program must be built from
+	 * a multi draw shader that reads DrawData[drawOffset + gl_DrawIDARB] from storage buffer binding 0.
+	 * On fallback path program is used as with GeometryNode::Render.
+	 * Programs without normal and uv attributes read a position only vertex stream.
+	 * @param renderer renderer to use
+	 * @param queue recorded draws
+	 * @param program handle to shader program
+	 */
+	void Submit(IRenderer& renderer, const DrawQueue& queue, GLuint program);
+
+	/**
+	 * Unregister
+	 * remove a geometry from the shared buffers, the ranges of the other geometry are
+	 * compacted. Geometry that is only referenced by this object is removed by Submit.
+	 * @param geometry geometry to remove, ignored if not registered
+	 */
+	void Unregister(const Geometry* geometry);
+
+	/**
+	 * IsEnabled
+	 * @return true if multi draw path is in use
+	 */
+	inline bool IsEnabled() const { return m_bEnabled; }
+
+	/**
+	 * GetDrawCount / GetDrawCallCount
+	 * @return number of draws and number of GL draw calls issued by the previous Submit
+	 */
+	inline uint32_t GetDrawCount() const { return m_uDrawCount; }
+	inline uint32_t GetDrawCallCount() const { return m_uDrawCallCount; }
+
+private:
+	struct MESH
+	{
+		GLuint		firstIndex;
+		GLuint		indexCount;
+		GLint		baseVertex;
+		GLuint		vertexCount;
+	};
+
+	const MESH& Register(const std::shared_ptr<Geometry>& geometry);
+	void EvictUnused();
+	void UploadGeometry();
+	void Release();
+
+	bool												m_bEnabled;
+	bool												m_bGeometryDirty;
+
+	GLuint												m_VertexBuffer;
+	GLuint												m_PositionBuffer;	// positions of m_VertexBuffer packed, for depth only passes
+	GLuint												m_IndexBuffer;
+	GLuint												m_CommandBuffer;
+	GLuint												m_DrawDataBuffer;
+
+	// cpu copies of the shared buffers, buffers are rebuilt when geometry is added or removed
+	std::vector<uint8_t>								m_arrVertexData;
+	std::vector<glm::vec3>								m_arrPositionData;
+	std::vector<uint32_t>								m_arrIndexData;
+	std::unordered_map<const Geometry*, MESH>			m_mapMeshes;
+	std::vector<std::shared_ptr<Geometry>>				m_arrGeometries;
+
+	// per frame data sorted by draw mode, used when the stream buffer is full or missing
+	std::vector<DrawElementsIndirectCommand>			m_arrCommands;
+	std::vector<DRAWDATA>								m_arrDrawData;
+
+	uint32_t											m_uDrawCount;
+	uint32_t											m_uDrawCallCount;
+};
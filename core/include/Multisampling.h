@@ -0,0 +1,69 @@
+/**
+ * ============================================================================
+ *  Name        : Multisampling.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : multisampled offscreen target the frame is rendered to when
+ *                MSAA is selected. The window itself is single sampled, the
+ *                samples are resolved explicitly once per frame so the cost
+ *                shows up as its own pass and the rest of the frame (upscale,
+ *                post effects) works on single sampled targets.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/OpenGLRenderer.h"
+
+class Multisampling
+{
+public:
+	Multisampling();
+	~Multisampling();
+
+	/**
+	 * IsSupported
+	 * @return true if current context supports multisampled renderbuffers and blits
+	 */
+	static bool IsSupported();
+
+	/**
+	 * Create
+	 * @param samples samples per pixel, clamped to GL_MAX_SAMPLES. The target is allocated on first BeginFrame.
+	 * @return true if successful
+	 */
+	bool Create(int32_t samples);
+
+	/**
+	 * Release
+	 * delete the target
+	 */
+	void Release();
+
+	/**
+	 * BeginFrame
+	 * bind the target, it is reallocated only when the size changes. Viewport is not changed.
+	 * @param width, height size of the target, the size of the single sampled target it resolves into
+	 */
+	void BeginFrame(int32_t width, int32_t height);
+
+	/**
+	 * Resolve
+	 * average the samples of the rendered area into a single sampled framebuffer
+	 * @param framebuffer framebuffer to resolve into
+	 * @param size rendered area in pixels, from the lower left corner
+	 */
+	void Resolve(GLuint framebuffer, const glm::ivec2& size);
+
+	inline GLuint GetFramebuffer() const { return m_uFramebuffer; }
+	inline int32_t GetSamples() const { return m_iSamples; }
+
+private:
+	bool CreateTarget(int32_t width, int32_t height);
+	void ReleaseTarget();
+
+	int32_t				m_iSamples;
+	glm::ivec2			m_vSize;
+	GLuint				m_uFramebuffer;
+	GLuint				m_uColor;
+	GLuint				m_uDepth;
+};
@@ -100,11 +100,18 @@ public:
 	 */
 	inline glm::mat4 GetWorldMatrix() const { return (m_pParent) ? m_pParent->GetWorldMatrix() * m_mModel : m_mModel; }
 
+	/**
+	 * GetPreviousWorldMatrix
+	 * @return world matrix of the previous frame, model matrices are stored at the start of Update
+	 */
+	inline glm::mat4 GetPreviousWorldMatrix() const { return (m_pParent) ? m_pParent->GetPreviousWorldMatrix() * m_mPreviousModel : m_mPreviousModel; }
+
 	/**
 	 * GetVelocity
 	 * @return reference to node velocity vector
 	 */
 	inline auto& GetVelocity() { return m_vVelocity; }
+	inline const auto& GetVelocity() const { return m_vVelocity; }
 
 	/**
 	 * SetVelocity
@@ -183,6 +190,7 @@ public:
 
 protected:
 	glm::mat4									m_mModel;
+	glm::mat4									m_mPreviousModel;	// model matrix the previous frame was drawn with
 	Node*										m_pParent;
 	std::vector<std::shared_ptr<Node>>			m_arrNodes;
 
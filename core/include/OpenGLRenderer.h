@@ -18,10 +18,39 @@
 #endif
 #include "./GL/myGL.h"
 
+// forward declarations
+class StreamBuffer;
+class CompressedTexture;
+class ProgramCache;
+class GpuProfiler;
+class DeferredShading;
+class DynamicResolution;
+class PostProcess;
+class Multisampling;
+class Fxaa;
+class FramePacer;
 
 class OpenGLRenderer : public IRenderer
 {
 public:
+	struct TEXTUREPARAMS
+	{
+		TEXTUREPARAMS() :
+			wrap(GL_CLAMP_TO_EDGE),
+			mipmaps(true),
+			maxLevel(1000),
+			anisotropy(8.0f),
+			compression(0)
+		{
+		}
+
+		GLenum			wrap;			// GL_CLAMP_TO_EDGE, GL_REPEAT or GL_MIRRORED_REPEAT
+		bool			mipmaps;		// build full mip chain and sample trilinear
+		int32_t			maxLevel;		// highest mip level to build and sample
+		float			anisotropy;		// max anisotropy, clamped to driver limit. 1 disables
+		GLenum			compression;	// 0, GL_COMPRESSED_RGBA_S3TC_DXT1_EXT or GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+	};
+
 	OpenGLRenderer();
 	~OpenGLRenderer();
 
@@ -60,6 +89,25 @@ public:
 	 */
 	bool SetTexture(GLuint program, GLuint texture, int32_t slot, const std::string_view& uniformName) override;
 
+	/**
+	 * SetRenderPath (from IRenderer)
+	 * deferred path creates the G-buffer programs, forward path releases them
+	 * @param path render path to use
+	 * @return true if the path is supported and selected
+	 */
+	bool SetRenderPath(RENDERPATH path) override;
+
+	/**
+	 * SetAntialiasing (from IRenderer)
+	 * MSAA renders into a multisampled target resolved in Flip, the window is never multisampled.
+	 * POST appends an FXAA style effect to the post-processing chain, enabling the chain if needed.
+	 * Cost shows in the gpu profiler as the "resolve" scope, or the "fxaa" scope inside "post",
+	 * plus the extra samples in the passes of the frame.
+	 * @param mode mode to use
+	 * @return true if the mode is supported and selected
+	 */
+	bool SetAntialiasing(ANTIALIASING mode) override;
+
 	/**
 	 * SetUniformXXX helpers
 	 * @param program program to set the uniform into
@@ -76,6 +124,15 @@ public:
 		}
 		return location != -1;
 	}
+	static inline bool SetUniformVec2(GLuint program, const char* name, const glm::vec2& v)
+	{
+		const GLint location = glGetUniformLocation(program, name);
+		if (location != -1)
+		{
+			glUniform2fv(location, 1, &v.x);
+		}
+		return location != -1;
+	}
 	static inline bool SetUniformVec3(GLuint program, const char* name, const glm::vec3& v)
 	{
 		const GLint location = glGetUniformLocation(program, name);
@@ -117,11 +174,38 @@ public:
 
 	/**
 	 * CreateTexture
-	 * create opengl texture handle from image file
+	 * create opengl texture handle from image file. Builds full mip chain
+	 * with glGenerateMipmap, or with a cpu box filter on older drivers.
+	 * A .btx file is uploaded as is. Other images are block compressed when
+	 * params request it, the result is cached next to the image as <filename>.btx
 	 * @param filename file to load
+	 * @param params wrap, mipmap, filtering and compression options
 	 * @return opengl texture handle, or 0 if failed
 	 */
-	GLuint CreateTexture(const std::string_view& filename);
+	GLuint CreateTexture(const std::string_view& filename, const TEXTUREPARAMS& params = TEXTUREPARAMS());
+
+	/**
+	 * CreateTexture
+	 * create opengl texture handle from block compressed mip chain
+	 * @param texture compressed texture to upload
+	 * @param params wrap, mipmap and filtering options
+	 * @return opengl texture handle, or 0 if failed
+	 */
+	GLuint CreateTexture(const CompressedTexture& texture, const TEXTUREPARAMS& params = TEXTUREPARAMS());
+
+	/**
+	 * GetMaxAnisotropy
+	 * @return max supported anisotropy, or 1 if anisotropic filtering is not supported
+	 */
+	static float GetMaxAnisotropy();
+
+	/**
+	 * SetTextureParams
+	 * set filtering and wrap modes of the texture bound to GL_TEXTURE_2D
+	 * @param params wrap and filtering options
+	 * @param maxLevel highest mip level of the texture, 0 disables mipmap filtering
+	 */
+	static void SetTextureParams(const TEXTUREPARAMS& params, int32_t maxLevel);
 
 	/**
 	 * CreateVertexShader
@@ -160,9 +244,62 @@ public:
 	 * Link opengl program from vertex and fragment shader
 	 * @param vertexShader
 	 * @param fragmentShader
+	 * @param retrievable set GL_PROGRAM_BINARY_RETRIEVABLE_HINT before linking
+	 * @return opengl program handle, or 0 if failed
+	 */
+	GLuint CreateProgram(GLuint vertexShader, GLuint fragmentShader, bool retrievable = false);
+
+	/**
+	 * CreateProgramFromSource
+	 * create opengl program from shader sources. Program is loaded from the
+	 * program cache when it has a binary for the same sources, defines and
+	 * driver, otherwise it is compiled and its binary is stored to the cache.
+	 * @param vertexShader vertex shader source code
+	 * @param fragmentShader fragment shader source code
+	 * @param defines preprocessor lines injected into both shaders, e.g. "#define SPECULAR 1\n"
 	 * @return opengl program handle, or 0 if failed
 	 */
-	GLuint CreateProgram(GLuint vertexShader, GLuint fragmentShader);
+	GLuint CreateProgramFromSource(const std::string_view& vertexShader, const std::string_view& fragmentShader, const std::string_view& defines = "");
+
+	/**
+	 * CreateProgramFromFiles
+	 * create opengl program from shader source files, see CreateProgramFromSource
+	 * @param vertexShaderFile vertex shader source file
+	 * @param fragmentShaderFile fragment shader source file
+	 * @param defines preprocessor lines injected into both shaders
+	 * @return opengl program handle, or 0 if failed
+	 */
+	GLuint CreateProgramFromFiles(const std::string_view& vertexShaderFile, const std::string_view& fragmentShaderFile, const std::string_view& defines = "");
+
+	/**
+	 * SetProgramCacheDirectory
+	 * enable caching of linked program binaries. Call after Create.
+	 * @param directory cache directory, empty disables the cache
+	 * @return true if cache is enabled
+	 */
+	bool SetProgramCacheDirectory(const std::string_view& directory);
+
+	/**
+	 * GetProgramCache
+	 * @return program binary cache with hit and miss statistics, nullptr if not enabled
+	 */
+	inline ProgramCache* GetProgramCache() { return m_pProgramCache.get(); }
+
+	/**
+	 * InsertDefines
+	 * inject preprocessor lines into shader source after the #version directive
+	 * @param source shader source code
+	 * @param defines preprocessor lines to inject
+	 * @return shader source with the defines
+	 */
+	static std::string InsertDefines(const std::string_view& source, const std::string_view& defines);
+
+	/**
+	 * LoadTextFile
+	 * @param filename file to load
+	 * @return contents of the file, empty if it can not be read
+	 */
+	static std::string LoadTextFile(const std::string_view& filename);
 
 	/**
 	 * PrintShaderError/PrintProgramError
@@ -173,6 +310,117 @@ public:
 	void PrintShaderError(GLuint shader);
 	void PrintProgramError(GLuint program);
 
+	/**
+	 * GetStreamBuffer
+	 * @return ring buffer for dynamic per frame data, fenced by Flip. nullptr if not available.
+	 */
+	inline StreamBuffer* GetStreamBuffer() { return m_pStreamBuffer.get(); }
+
+	/**
+	 * SetGpuProfiling
+	 * enable timer query profiling, frames are delimited by Flip
+	 * @param enable true to enable, false to release the profiler
+	 * @return true if profiling is enabled
+	 */
+	bool SetGpuProfiling(bool enable);
+
+	/**
+	 * GetGpuProfiler
+	 * @return gpu profiler to add scopes to, nullptr if profiling is not enabled
+	 */
+	inline GpuProfiler* GetGpuProfiler() { return m_pGpuProfiler.get(); }
+
+	/**
+	 * GetDeferredShading
+	 * @return G-buffer and light passes of the deferred path, nullptr when forward path is selected
+	 */
+	inline DeferredShading* GetDeferredShading() { return m_pDeferredShading.get(); }
+
+	/**
+	 * SetDynamicResolution
+	 * render the frames into an offscreen target whose resolution follows the gpu frame time,
+	 * Flip upscales it to the window
+	 * @param enable true to enable, false to render at window resolution
+	 * @return true if dynamic resolution is enabled
+	 */
+	bool SetDynamicResolution(bool enable);
+
+	/**
+	 * GetDynamicResolution
+	 * @return scale controller and target to configure, nullptr if not enabled
+	 */
+	inline DynamicResolution* GetDynamicResolution() { return m_pDynamicResolution.get(); }
+
+	/**
+	 * SetPostProcessing
+	 * run a chain of post effects on the finished frame in Flip, after the dynamic resolution upscale
+	 * @param enable true to enable, false to release the chain and its targets
+	 * @return true if post-processing is enabled
+	 */
+	bool SetPostProcessing(bool enable);
+
+	/**
+	 * GetPostProcess
+	 * @return chain to add the effects to, nullptr if not enabled
+	 */
+	inline PostProcess* GetPostProcess() { return m_pPostProcess.get(); }
+
+	/**
+	 * SetFramePacing
+	 * fence every frame in Flip and block there while the gpu is more than the set number of frames behind
+	 * @param enable true to enable, false to let the driver queue frames
+	 * @return true if frame pacing is enabled
+	 */
+	bool SetFramePacing(bool enable);
+
+	/**
+	 * GetFramePacer
+	 * @return frames in flight, late latching and wait times, nullptr if not enabled
+	 */
+	inline FramePacer* GetFramePacer() { return m_pFramePacer.get(); }
+
+	/**
+	 * SetSwapInterval
+	 * number of vertical blanks the swap waits for, WGL_EXT_swap_control / GLX_EXT_swap_control
+	 * @param interval 0 for no vsync, 1 to sync every frame to the display
+	 * @return true if the interval was set, false if not supported or headless
+	 */
+	bool SetSwapInterval(int32_t interval);
+
+	/**
+	 * GetRenderSize
+	 * @return size the frame is rendered at in pixels, the window size unless dynamic resolution is enabled
+	 */
+	glm::ivec2 GetRenderSize() const;
+
+	/**
+	 * GetDefaultFramebuffer
+	 * @return framebuffer the frame is rendered to: the multisampled target with MSAA, the dynamic
+	 * resolution target when enabled, offscreen framebuffer in headless mode, 0 otherwise.
+	 * Bind this instead of 0 when returning from render to texture.
+	 */
+	GLuint GetDefaultFramebuffer() const;
+
+	/**
+	 * ReadPixels
+	 * read the color buffer of the default framebuffer
+	 * @param pixels receives RGBA8 pixels of the app resolution, rows bottom up
+	 */
+	void ReadPixels(std::vector<uint8_t>& pixels);
+
+	/**
+	 * GetVersion
+	 * @return OpenGL version of the current context as major * 10 + minor, e.g. 43 for 4.3
+	 */
+	static int32_t GetVersion();
+
+	/**
+	 * HasExtension
+	 * @param name name of the extension, e.g. "GL_ARB_shader_draw_parameters"
+	 * @return true if current context supports the extension
+	 */
+	static bool HasExtension(const std::string_view& name);
+
 	/**
 	 * InitFunctions
 	 * static helper to get OpenGL function pointers after context has been created
@@ -181,6 +429,27 @@ public:
 
 private:
 	bool SetDefaultSettings();
+	bool CreateFramebuffer(int32_t width, int32_t height);
+	void BeginMultisampling();
+
+#if defined (_LINUX)
+	bool CreateHeadlessContext();
+#endif
+
+	std::unique_ptr<StreamBuffer>	m_pStreamBuffer;
+	std::unique_ptr<ProgramCache>	m_pProgramCache;
+	std::unique_ptr<GpuProfiler>	m_pGpuProfiler;
+	std::unique_ptr<DeferredShading>	m_pDeferredShading;
+	std::unique_ptr<DynamicResolution>	m_pDynamicResolution;
+	std::unique_ptr<PostProcess>	m_pPostProcess;
+	std::unique_ptr<Multisampling>	m_pMultisampling;
+	std::shared_ptr<Fxaa>			m_pFxaa;
+	std::unique_ptr<FramePacer>		m_pFramePacer;
+
+	// offscreen default framebuffer of headless mode
+	GLuint			m_uFramebuffer;
+	GLuint			m_uColorBuffer;
+	GLuint			m_uDepthBuffer;
 
 #if defined (_WINDOWS)
 	HDC				m_Context;
@@ -189,6 +458,8 @@ private:
 
 #if defined (_LINUX)
 	void*			m_Context;
+	void*			m_EglDisplay;		// headless mode only
+	void*			m_EglSurface;		// pbuffer when surfaceless contexts are not supported
 #endif
 };
 
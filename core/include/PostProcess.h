@@ -0,0 +1,172 @@
+/**
+ * ============================================================================
+ *  Name        : PostProcess.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : chain of full screen effects run on the finished frame.
+ *                Effects declare the format they read and the format and
+ *                size they write, the chain checks neighbours against each
+ *                other when they are added and allocates every intermediate
+ *                from a RenderTargetPool, recycling an effect's input as soon
+ *                as the effect has read it. The last effect writes straight
+ *                to the window when its output is the window size.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/RenderTargetPool.h"
+
+// forward declarations
+class PostProcess;
+
+class PostEffect
+{
+public:
+	/**
+	 * FORMATS
+	 * what the effect reads and writes
+	 */
+	struct FORMATS
+	{
+		GLenum			input;			// internal format expected from the previous effect or the scene, 0 accepts any
+		GLenum			output;			// internal format written, 0 writes the format of the input
+		float			scale;			// output size relative to the input size
+	};
+
+	virtual ~PostEffect() = default;
+
+	/**
+	 * GetName
+	 * @return name of the gpu profiler scope of the effect
+	 */
+	virtual const char* GetName() const = 0;
+
+	/**
+	 * GetFormats
+	 * @return formats and scale of the effect, must not change after the effect is added
+	 */
+	virtual FORMATS GetFormats() const = 0;
+
+	/**
+	 * Create
+	 * compile the programs, called when the effect is added to a chain
+	 * @param renderer renderer to create the programs with
+	 * @return true if successful
+	 */
+	virtual bool Create(OpenGLRenderer& renderer) = 0;
+
+	/**
+	 * Release
+	 * delete the programs
+	 */
+	virtual void Release() = 0;
+
+	/**
+	 * Render
+	 * read the input and write the output. Output framebuffer is bound with the viewport of its size,
+	 * depth test and culling are off. Intermediate targets are acquired from the pool of the chain
+	 * and recycled before returning.
+	 * @param renderer renderer to draw with
+	 * @param chain chain the effect runs in
+	 * @param input output of the previous effect or the scene
+	 * @param output target to write, its texture is 0 when it is the window
+	 */
+	virtual void Render(OpenGLRenderer& renderer, PostProcess& chain, const RenderTargetPool::TARGET& input, const RenderTargetPool::TARGET& output) = 0;
+};
+
+
+class PostProcess
+{
+public:
+	PostProcess();
+	~PostProcess();
+
+	/**
+	 * IsSupported
+	 * @return true if current context supports the render target pool
+	 */
+	static bool IsSupported();
+
+	/**
+	 * Create
+	 * compile the copy program of the chain
+	 * @param renderer renderer to create the program with
+	 * @return true if successful
+	 */
+	bool Create(OpenGLRenderer& renderer);
+
+	/**
+	 * Release
+	 * release the effects, the pool and the program
+	 */
+	void Release();
+
+	/**
+	 * Add
+	 * create the effect and append it to the chain
+	 * @param renderer renderer to create the effect with
+	 * @param effect effect to add
+	 * @return false if the effect can not read the output of the previous one or can not be created
+	 */
+	bool Add(OpenGLRenderer& renderer, const std::shared_ptr<PostEffect>& effect);
+
+	/**
+	 * Remove
+	 * release the effect and remove it from the chain, its targets are freed by the pool over time
+	 * @param effect effect to remove
+	 */
+	void Remove(const std::shared_ptr<PostEffect>& effect);
+
+	inline bool IsEmpty() const { return m_arrEffects.empty(); }
+	inline const std::vector<std::shared_ptr<PostEffect>>& GetEffects() const { return m_arrEffects; }
+	inline RenderTargetPool& GetPool() { return m_Pool; }
+
+	/**
+	 * BeginFrame
+	 * acquire the scene target, the frame is drawn or copied into it before Render
+	 * @param size window size in pixels
+	 * @return framebuffer of the scene target, 0 if it can not be created
+	 */
+	GLuint BeginFrame(const glm::ivec2& size);
+
+	/**
+	 * Render
+	 * run the effects on the scene target and write the result to the window
+	 * @param renderer renderer to draw with
+	 * @param framebuffer window framebuffer
+	 */
+	void Render(OpenGLRenderer& renderer, GLuint framebuffer);
+
+	/**
+	 * GetVertexShader
+	 * @return vertex shader of the full screen triangle, outUv is 0 - 1 over the output
+	 */
+	static const char* GetVertexShader();
+
+	/**
+	 * SetInput
+	 * bind a target to a sampler, with the uniforms <name>Scale and <name>Max to sample the rendered
+	 * corner with min(outUv * <name>Scale, <name>Max) and <name>Texel with the size of a texel
+	 * @param renderer renderer to bind with
+	 * @param program program of the effect
+	 * @param name name of the sampler uniform
+	 * @param target target to sample
+	 * @param slot texture slot
+	 */
+	static void SetInput(OpenGLRenderer& renderer, GLuint program, const char* name, const RenderTargetPool::TARGET& target, int32_t slot);
+
+	/**
+	 * DrawFullscreen
+	 * draw the full screen triangle with attribute position of the program
+	 * @param program current program
+	 */
+	static void DrawFullscreen(GLuint program);
+
+private:
+	GLuint										m_uCopyProgram;
+	std::vector<std::shared_ptr<PostEffect>>	m_arrEffects;
+	RenderTargetPool							m_Pool;
+
+	RenderTargetPool::TARGET*					m_pScene;
+	glm::ivec2									m_vSize;
+};
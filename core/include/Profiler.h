@@ -0,0 +1,179 @@
+/**
+ * ============================================================================
+ *  Name        : Profiler.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : hierarchical cpu profiler. Scopes are timed with
+ *                Timer::GetTicks and written into per thread ring buffers
+ *                without locking, the frame boundary collects them into
+ *                per name summaries and a history of frames that can be
+ *                exported as Chrome / Perfetto trace JSON.
+ *                Define PROFILER_ENABLED as 0 to compile all macros out.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "Timer.h"
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if !defined (PROFILER_ENABLED)
+#define PROFILER_ENABLED 1
+#endif
+
+class Profiler
+{
+public:
+	/**
+	 * EVENT
+	 * one completed scope
+	 */
+	struct EVENT
+	{
+		const char*		name;			// static string, only the pointer is stored
+		uint64_t		begin;			// Timer::GetTicks
+		uint64_t		end;			// Timer::GetTicks
+		uint32_t		depth;			// nesting level in its thread
+		uint32_t		thread;			// index of the recording thread
+	};
+
+	/**
+	 * SUMMARY
+	 * totals of all scopes with the same name in a frame
+	 */
+	struct SUMMARY
+	{
+		std::string_view	name;
+		uint32_t			calls;					// last frame
+		double				milliseconds;			// inclusive time in last frame
+		double				averageMilliseconds;	// rolling average over frames
+	};
+
+	/**
+	 * SCOPE
+	 * times its own lifetime, use through PROFILE_SCOPE
+	 */
+	class SCOPE
+	{
+	public:
+		inline SCOPE(const char* name) :
+			m_pName(IsEnabled() ? name : nullptr),
+			m_uBegin(0)
+		{
+			if (m_pName)
+			{
+				m_uBegin = Timer::GetTicks();
+				++s_uDepth;
+			}
+		}
+		inline ~SCOPE()
+		{
+			if (m_pName)
+			{
+				--s_uDepth;
+				Record(m_pName, m_uBegin, Timer::GetTicks(), s_uDepth);
+			}
+		}
+
+	private:
+		const char*		m_pName;
+		uint64_t		m_uBegin;
+	};
+
+	/**
+	 * BeginFrame
+	 * mark start of a frame. Call from the main thread
+	 */
+	static void BeginFrame();
+
+	/**
+	 * EndFrame
+	 * collect the events of all threads into the frame and update the summaries.
+	 * Call from the main thread
+	 */
+	static void EndFrame();
+
+	/**
+	 * SetEnabled
+	 * pause or resume recording at runtime
+	 * @param enabled true to record scopes
+	 */
+	static void SetEnabled(bool enabled);
+	static inline bool IsEnabled() { return s_bEnabled.load(std::memory_order_relaxed); }
+
+	/**
+	 * SetThreadName
+	 * name the calling thread in the exported trace
+	 * @param name thread name
+	 */
+	static void SetThreadName(const std::string_view& name);
+
+	/**
+	 * SetFrameHistory
+	 * @param frames number of completed frames kept for export
+	 */
+	static void SetFrameHistory(uint32_t frames);
+
+	/**
+	 * GetSummary
+	 * @return per name totals of last frame, sorted by time
+	 */
+	static const std::vector<SUMMARY>& GetSummary();
+
+	/**
+	 * GetDroppedEvents
+	 * @return events lost because a thread buffer was full before it was collected
+	 */
+	static uint64_t GetDroppedEvents();
+
+	/**
+	 * GetChromeTrace
+	 * @return kept frames as Chrome trace event JSON, loadable in chrome://tracing and Perfetto
+	 */
+	static std::string GetChromeTrace();
+
+	/**
+	 * ExportChromeTrace
+	 * write GetChromeTrace to a file
+	 * @param filename file to write
+	 * @return true if successful
+	 */
+	static bool ExportChromeTrace(const std::string_view& filename);
+
+	/**
+	 * PrintSummary
+	 * write the summary of last frame to debug output
+	 */
+	static void PrintSummary();
+
+	/**
+	 * Clear
+	 * drop kept frames and summaries
+	 */
+	static void Clear();
+
+private:
+	static void Record(const char* name, uint64_t begin, uint64_t end, uint32_t depth);
+
+	static std::atomic<bool>			s_bEnabled;
+	static thread_local uint32_t		s_uDepth;
+};
+
+
+#if PROFILER_ENABLED
+#define PROFILER_CONCAT_(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_(a, b)
+#define PROFILE_SCOPE(name) Profiler::SCOPE PROFILER_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_BEGIN_FRAME() Profiler::BeginFrame()
+#define PROFILE_END_FRAME() Profiler::EndFrame()
+#define PROFILE_THREAD_NAME(name) Profiler::SetThreadName(name)
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_BEGIN_FRAME()
+#define PROFILE_END_FRAME()
+#define PROFILE_THREAD_NAME(name)
+#endif
@@ -0,0 +1,116 @@
+/**
+ * ============================================================================
+ *  Name        : ProgramCache.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : on disk cache of linked program binaries. Binaries are
+ *                stored with glGetProgramBinary and keyed by a hash of the
+ *                shader sources, defines and the driver identification, so
+ *                a driver update or source change never loads a stale binary.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/OpenGLRenderer.h"
+
+class ProgramCache
+{
+public:
+	struct STATS
+	{
+		uint32_t	hits;			// programs loaded from a cached binary
+		uint32_t	misses;			// programs compiled from source
+		uint32_t	rejected;		// cached binaries the driver refused, also counted as misses
+		uint32_t	writes;			// binaries written to the cache
+	};
+
+	ProgramCache();
+	~ProgramCache();
+
+	/**
+	 * IsSupported
+	 * @return true if current context can retrieve and load program binaries
+	 */
+	static bool IsSupported();
+
+	/**
+	 * Create
+	 * start caching into a directory, it is created when missing
+	 * @param directory cache directory
+	 * @return true if successful, false if binaries are not supported or directory can not be created
+	 */
+	bool Create(const std::string_view& directory);
+
+	/**
+	 * GetKey
+	 * @param vertexShader vertex shader source
+	 * @param fragmentShader fragment shader source
+	 * @param defines preprocessor defines injected into both shaders
+	 * @return hash of the sources, defines and the driver identification
+	 */
+	uint64_t GetKey(const std::string_view& vertexShader, const std::string_view& fragmentShader, const std::string_view& defines) const;
+
+	/**
+	 * Load
+	 * create a program from cached binary
+	 * @param key program key from GetKey
+	 * @return linked program, or 0 if there is no binary or the driver rejects it
+	 */
+	GLuint Load(uint64_t key);
+
+	/**
+	 * Store
+	 * write binary of a linked program to the cache. Program should be linked
+	 * with GL_PROGRAM_BINARY_RETRIEVABLE_HINT set.
+	 * @param key program key from GetKey
+	 * @param program linked program
+	 * @return true if the binary was written
+	 */
+	bool Store(uint64_t key, GLuint program);
+
+	/**
+	 * CountMiss
+	 * record a program that was compiled from source
+	 */
+	inline void CountMiss() { ++m_Stats.misses; }
+
+	/**
+	 * GetStats
+	 * @return hit and miss counts since Create
+	 */
+	inline const STATS& GetStats() const { return m_Stats; }
+
+	/**
+	 * PrintStats
+	 * write hit and miss counts to debug output
+	 */
+	void PrintStats() const;
+
+	/**
+	 * Hash
+	 * 64 bit FNV-1a hash
+	 * @param data bytes to hash
+	 * @param size number of bytes
+	 * @param seed previous hash value to continue from
+	 * @return hash value
+	 */
+	static uint64_t Hash(const void* data, size_t size, uint64_t seed = 14695981039346656037ULL);
+
+private:
+	struct HEADER
+	{
+		uint32_t	magic;
+		GLenum		format;
+		uint32_t	length;
+		uint32_t	reserved;
+		uint64_t	key;
+	};
+
+	static constexpr uint32_t MAGIC = 0x31434250;		// 'PBC1'
+
+	std::string GetFilename(uint64_t key) const;
+
+	std::string		m_strDirectory;
+	uint64_t		m_uDriverHash;
+	STATS			m_Stats;
+};
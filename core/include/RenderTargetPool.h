@@ -0,0 +1,142 @@
+/**
+ * ============================================================================
+ *  Name        : RenderTargetPool.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : transient color targets handed out by descriptor. A target
+ *                recycled by one pass is handed to the next pass asking for a
+ *                compatible descriptor, in the same frame or a later one, so
+ *                passes whose lifetimes do not overlap share the memory.
+ *                Sizes are rounded up to a granularity and the pass renders
+ *                into the lower left corner, resizing the window reuses the
+ *                targets it has until the rounded size changes.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/OpenGLRenderer.h"
+
+class RenderTargetPool
+{
+public:
+	// allocated sizes are multiples of this
+	static constexpr int32_t SIZE_GRANULARITY = 128;
+
+	/**
+	 * DESC
+	 * what a pass asks for
+	 */
+	struct DESC
+	{
+		DESC() :
+			size(0),
+			format(GL_RGBA8),
+			filter(GL_LINEAR)
+		{
+		}
+
+		DESC(const glm::ivec2& size, GLenum format = GL_RGBA8, GLenum filter = GL_LINEAR) :
+			size(size),
+			format(format),
+			filter(filter)
+		{
+		}
+
+		glm::ivec2		size;			// pixels the pass renders
+		GLenum			format;			// internal format, e.g. GL_RGBA8 or GL_RGBA16F
+		GLenum			filter;			// GL_LINEAR or GL_NEAREST
+	};
+
+	/**
+	 * TARGET
+	 * texture and framebuffer of a target, owned by the pool
+	 */
+	struct TARGET
+	{
+		DESC			desc;			// descriptor of the current user
+		glm::ivec2		allocatedSize;
+		GLuint			texture;
+		GLuint			framebuffer;
+		bool			used;
+		uint64_t		lastFrame;		// last frame it was acquired
+
+		/**
+		 * GetUvScale, GetUvMax
+		 * @return scale from 0 - 1 to the rendered corner, and the largest uv the bilinear filter
+		 * stays inside the rendered corner with
+		 */
+		inline glm::vec2 GetUvScale() const { return glm::vec2(desc.size) / glm::vec2(allocatedSize); }
+		inline glm::vec2 GetUvMax() const { return (glm::vec2(desc.size) - 0.5f) / glm::vec2(allocatedSize); }
+	};
+
+	/**
+	 * STATS
+	 * allocation counts, frame values are those of the last EndFrame
+	 */
+	struct STATS
+	{
+		uint32_t		targets;			// targets allocated now
+		uint64_t		bytes;				// memory of the allocated targets
+		uint64_t		allocations;		// targets created since the pool was created
+		uint32_t		frameAcquires;		// targets handed out in the frame
+		uint32_t		frameAllocations;	// targets created in the frame
+	};
+
+	RenderTargetPool();
+	~RenderTargetPool();
+
+	/**
+	 * IsSupported
+	 * @return true if current context supports framebuffer objects
+	 */
+	static bool IsSupported();
+
+	/**
+	 * Release
+	 * delete all targets, none may be in use
+	 */
+	void Release();
+
+	/**
+	 * Acquire
+	 * hand out a free target of the same format and rounded size, or create one
+	 * @param desc size, format and filter
+	 * @return target for exclusive use until recycled, nullptr if it can not be created
+	 */
+	TARGET* Acquire(const DESC& desc);
+
+	/**
+	 * Recycle
+	 * give the target back, its contents may be overwritten by the next Acquire
+	 * @param target target from Acquire, nullptr is ignored
+	 */
+	void Recycle(TARGET* target);
+
+	/**
+	 * EndFrame
+	 * update the statistics and delete the targets no pass asked for in a while
+	 */
+	void EndFrame();
+
+	/**
+	 * SetMaxIdleFrames
+	 * @param frames frames a free target is kept without being acquired
+	 */
+	inline void SetMaxIdleFrames(uint32_t frames) { m_uMaxIdleFrames = frames; }
+
+	inline const STATS& GetStats() const { return m_Stats; }
+
+private:
+	static glm::ivec2 GetAllocatedSize(const glm::ivec2& size);
+	static uint32_t GetBytesPerPixel(GLenum format);
+
+	TARGET* Create(const DESC& desc);
+	void Delete(TARGET& target);
+
+	std::vector<std::unique_ptr<TARGET>>	m_arrTargets;
+	uint64_t								m_uFrame;
+	uint32_t								m_uMaxIdleFrames;
+	uint32_t								m_uFrameAcquires;
+	uint32_t								m_uFrameAllocations;
+	STATS									m_Stats;
+};
@@ -0,0 +1,176 @@
+/**
+ * ============================================================================
+ *  Name        : ResourceCache.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : deduplicating cache of textures, shaders and programs keyed
+ *                by normalized path and load options. Resources are shared
+ *                and reference counted, unused ones are evicted explicitly
+ *                or least recently used first when over the memory budget.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/OpenGLRenderer.h"
+#include "../include/ShaderCompiler.h"
+#include "../include/TextureStreamer.h"
+#include <unordered_map>
+
+class ResourceCache
+{
+public:
+	enum TYPE
+	{
+		TYPE_TEXTURE,
+		TYPE_VERTEX_SHADER,
+		TYPE_FRAGMENT_SHADER,
+		TYPE_PROGRAM
+	};
+
+	/**
+	 * RESOURCE
+	 * shared GL object, deleted when the last reference is released.
+	 * Must be released on the GL thread
+	 */
+	struct RESOURCE
+	{
+		RESOURCE(TYPE _type, GLuint _handle, const std::string& _key) :
+			type(_type),
+			handle(_handle),
+			key(_key),
+			vramBytes(0),
+			lastUsed(0)
+		{
+		}
+		~RESOURCE();
+
+		TYPE							type;
+		GLuint							handle;
+		std::string						key;
+		size_t							vramBytes;		// estimated video memory of the object
+		uint64_t						lastUsed;		// cache access counter value of last use
+
+		// program still compiling, handle is 0 until it is ready
+		std::shared_ptr<ShaderCompiler::PROGRAM>	pending;
+		inline bool IsPending() const { return pending != nullptr; }
+	};
+	typedef std::shared_ptr<RESOURCE> HANDLE;
+
+	ResourceCache(OpenGLRenderer& renderer);
+	~ResourceCache();
+
+	/**
+	 * SetTextureStreamer
+	 * load uncompressed textures in the background. GetTexture returns at once with the
+	 * placeholder of the streamer, the cache keeps the texture alive until it is resident
+	 * @param streamer created streamer, nullptr to load textures synchronously
+	 */
+	void SetTextureStreamer(TextureStreamer* streamer);
+
+	/**
+	 * GetTexture
+	 * @param filename image file to load
+	 * @param params load options, part of the cache key
+	 * @return shared texture, or nullptr if loading failed
+	 */
+	HANDLE GetTexture(const std::string_view& filename, const OpenGLRenderer::TEXTUREPARAMS& params = OpenGLRenderer::TEXTUREPARAMS());
+
+	/**
+	 * GetVertexShader, GetFragmentShader
+	 * @param filename shader source file
+	 * @return shared shader, or nullptr if compiling failed
+	 */
+	HANDLE GetVertexShader(const std::string_view& filename);
+	HANDLE GetFragmentShader(const std::string_view& filename);
+
+	/**
+	 * GetProgram
+	 * @param vertexShaderFile vertex shader source file
+	 * @param fragmentShaderFile fragment shader source file
+	 * @param async submit to the batch compiler and return at once. Handle of
+	 *        the program is 0 while IsPending, and stays 0 if building fails
+	 * @param defines preprocessor lines injected into both shaders, part of the cache key
+	 * @return shared program, or nullptr if failed. Uses the renderer program binary cache when enabled
+	 */
+	HANDLE GetProgram(const std::string_view& vertexShaderFile, const std::string_view& fragmentShaderFile, bool async = false, const std::string_view& defines = "");
+
+	/**
+	 * Update
+	 * poll programs submitted with async GetProgram and textures still streaming. Call once per frame
+	 * @param timeBudget seconds to spend on blocking status queries when parallel compile is not supported
+	 * @return number of programs still pending
+	 */
+	size_t Update(float timeBudget = 0.004f);
+
+	/**
+	 * Evict
+	 * drop the cache reference of a resource, the GL object is deleted when
+	 * the last outside reference is released
+	 * @param resource resource to evict
+	 */
+	void Evict(const HANDLE& resource);
+
+	/**
+	 * EvictUnused
+	 * delete all resources nobody outside the cache references
+	 * @return number of evicted resources
+	 */
+	size_t EvictUnused();
+
+	/**
+	 * SetBudget
+	 * evict unused resources least recently used first while the total
+	 * estimated video memory is above the budget
+	 * @param bytes memory budget, 0 disables automatic eviction
+	 */
+	void SetBudget(size_t bytes);
+
+	/**
+	 * Clear
+	 * drop all cache references
+	 */
+	void Clear();
+
+	/**
+	 * GetVramUsage
+	 * @return estimated video memory of all cached resources in bytes
+	 */
+	size_t GetVramUsage() const;
+
+	/**
+	 * GetResources
+	 * @return all cached resources keyed by type, path and options
+	 */
+	const std::unordered_map<std::string, HANDLE>& GetResources() const { return m_mapResources; }
+
+	/**
+	 * PrintStats
+	 * write every resource with its reference count and memory to debug output
+	 */
+	void PrintStats() const;
+
+	/**
+	 * NormalizePath
+	 * unify separators, remove "." and resolve ".." components. Case is
+	 * folded on Windows where the file system is case insensitive
+	 * @param path path to normalize
+	 * @return normalized path
+	 */
+	static std::string NormalizePath(const std::string_view& path);
+
+private:
+	HANDLE Find(const std::string& key);
+	HANDLE Insert(const HANDLE& resource);
+	HANDLE GetShader(TYPE type, const std::string_view& filename);
+	void Trim();
+	static size_t GetTextureSize(GLuint texture);
+
+	OpenGLRenderer&								m_Renderer;
+	std::unordered_map<std::string, HANDLE>		m_mapResources;
+	ShaderCompiler								m_Compiler;
+	std::vector<HANDLE>							m_arrPending;
+	TextureStreamer*							m_pTextureStreamer;
+	std::vector<HANDLE>							m_arrStreaming;		// textures not yet resident
+	uint64_t									m_uAccessCounter;
+	size_t										m_uBudget;
+};
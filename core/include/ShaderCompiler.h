@@ -0,0 +1,142 @@
+/**
+ * ============================================================================
+ *  Name        : ShaderCompiler.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : batch shader compiler. All shaders and programs are submitted
+ *                up front and their status is polled once per frame, so the
+ *                driver can compile them on its own threads when
+ *                GL_KHR_parallel_shader_compile is available.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/OpenGLRenderer.h"
+
+class ShaderCompiler
+{
+public:
+	enum STATE
+	{
+		STATE_COMPILING,
+		STATE_LINKING,
+		STATE_READY,
+		STATE_FAILED
+	};
+
+	/**
+	 * PROGRAM
+	 * program being built. Handle is valid once state is STATE_READY, from
+	 * then on the program is owned by the caller
+	 */
+	struct PROGRAM
+	{
+		PROGRAM(const std::string_view& _name) :
+			handle(0),
+			state(STATE_COMPILING),
+			name(_name),
+			vertexShader(0),
+			fragmentShader(0),
+			key(0)
+		{
+		}
+
+		GLuint			handle;
+		STATE			state;
+		std::string		name;				// used in error messages
+		GLuint			vertexShader;
+		GLuint			fragmentShader;
+		uint64_t		key;				// program cache key
+	};
+
+	struct STATS
+	{
+		uint32_t	submitted;			// programs submitted since construction
+		uint32_t	cached;				// programs loaded from the program cache
+		uint32_t	ready;				// programs linked successfully
+		uint32_t	failed;				// programs that failed to compile or link
+	};
+
+	ShaderCompiler(OpenGLRenderer& renderer);
+	~ShaderCompiler();
+
+	/**
+	 * IsParallelSupported
+	 * @return true if completion status can be polled without blocking
+	 */
+	static bool IsParallelSupported();
+
+	/**
+	 * SetThreadCount
+	 * @param count max number of driver compiler threads, 0xFFFFFFFF lets the driver decide
+	 */
+	static void SetThreadCount(uint32_t count);
+
+	/**
+	 * Submit
+	 * start compiling a program. Program is ready at once when the program cache has it
+	 * @param vertexShader vertex shader source code
+	 * @param fragmentShader fragment shader source code
+	 * @param defines preprocessor lines injected into both shaders
+	 * @param name name used in error messages
+	 * @return program being built
+	 */
+	std::shared_ptr<PROGRAM> Submit(const std::string_view& vertexShader, const std::string_view& fragmentShader, const std::string_view& defines = "", const std::string_view& name = "");
+
+	/**
+	 * SubmitFiles
+	 * start compiling a program from shader source files, see Submit
+	 * @param vertexShaderFile vertex shader source file
+	 * @param fragmentShaderFile fragment shader source file
+	 * @param defines preprocessor lines injected into both shaders
+	 * @return program being built, state is STATE_FAILED if files could not be read
+	 */
+	std::shared_ptr<PROGRAM> SubmitFiles(const std::string_view& vertexShaderFile, const std::string_view& fragmentShaderFile, const std::string_view& defines = "");
+
+	/**
+	 * Update
+	 * link programs whose shaders have compiled and finish linked programs.
+	 * With parallel compile status is polled without blocking. Without it,
+	 * programs are finished in submission order until the time budget is used.
+	 * At least one program is linked and finished per call
+	 * @param timeBudget seconds to spend on linking and blocking status queries
+	 * @return number of programs still pending
+	 */
+	size_t Update(float timeBudget = 0.004f);
+
+	/**
+	 * Finish
+	 * block until all submitted programs are ready or failed
+	 */
+	void Finish();
+
+	/**
+	 * Release
+	 * delete all pending shaders and programs, their state becomes STATE_FAILED
+	 */
+	void Release();
+
+	/**
+	 * GetPendingCount
+	 * @return number of programs still compiling or linking
+	 */
+	inline size_t GetPendingCount() const { return m_arrPending.size(); }
+
+	/**
+	 * GetStats
+	 * @return program counts since construction
+	 */
+	inline const STATS& GetStats() const { return m_Stats; }
+
+private:
+	bool IsShaderComplete(GLuint shader) const;
+	bool IsProgramComplete(GLuint program) const;
+	void Link(PROGRAM& program);
+	void Complete(PROGRAM& program);
+	void RemoveFinished();
+
+	OpenGLRenderer&							m_Renderer;
+	std::vector<std::shared_ptr<PROGRAM>>	m_arrPending;
+	bool									m_bParallel;
+	STATS									m_Stats;
+};
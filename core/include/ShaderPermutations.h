@@ -0,0 +1,104 @@
+/**
+ * ============================================================================
+ *  Name        : ShaderPermutations.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : specialized variants of a shader pair. Shader sources declare
+ *                their optional features with "#pragma feature <name>", each
+ *                variant is compiled on demand with a #define per enabled
+ *                feature and cached by a 64 bit feature key. Programs are
+ *                built and shared through the resource cache.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/ResourceCache.h"
+#include "../include/DrawQueue.h"
+#include <unordered_map>
+#include <map>
+
+// forward declarations
+struct Material;
+
+class ShaderPermutations
+{
+public:
+	ShaderPermutations(ResourceCache& resources);
+	~ShaderPermutations();
+
+	/**
+	 * Load
+	 * read the shader sources and their feature declarations. Features named
+	 * like Material features share their key bits, other features get bits from 32 up
+	 * @param vertexShaderFile vertex shader source file
+	 * @param fragmentShaderFile fragment shader source file
+	 * @return true if successful
+	 */
+	bool Load(const std::string_view& vertexShaderFile, const std::string_view& fragmentShaderFile);
+
+	/**
+	 * Release
+	 * drop the references to all permutations, the cache deletes unused programs
+	 */
+	void Release();
+
+	/**
+	 * GetKey
+	 * @param material material to draw, may be nullptr
+	 * @return key of the permutation matching the material, features the shader does not declare are dropped
+	 */
+	uint64_t GetKey(const Material* material) const;
+
+	/**
+	 * GetFeatureBit
+	 * @param name feature name declared in the shader
+	 * @return key bit of the feature, or 0 if the shader does not declare it
+	 */
+	uint64_t GetFeatureBit(const std::string_view& name) const;
+
+	/**
+	 * GetDefines
+	 * @param key permutation key
+	 * @return "#define <name> 1" line for every enabled feature
+	 */
+	std::string GetDefines(uint64_t key) const;
+
+	/**
+	 * GetProgram
+	 * get the program of a permutation, compiling it on first use. Compiling
+	 * progresses in ResourceCache::Update
+	 * @param key permutation key
+	 * @param wait block until the permutation is built
+	 * @return program handle, or 0 while compiling or if building failed
+	 */
+	GLuint GetProgram(uint64_t key, bool wait = false);
+
+	/**
+	 * GetState
+	 * @param key permutation key
+	 * @return build state of the permutation, STATE_FAILED if it has not been requested
+	 */
+	ShaderCompiler::STATE GetState(uint64_t key) const;
+
+	/**
+	 * Sort
+	 * group recorded draws by the permutation their materials select
+	 * @param queue recorded draws
+	 * @param groups draw queues keyed by permutation, cleared queues are kept for reuse
+	 */
+	void Sort(const DrawQueue& queue, std::map<uint64_t, DrawQueue>& groups) const;
+
+	inline size_t GetPermutationCount() const { return m_mapPrograms.size(); }
+	inline uint64_t GetFeatureMask() const { return m_uFeatureMask; }
+
+private:
+	void ParseFeatures(const std::string& source);
+
+	ResourceCache&												m_Resources;
+	std::string													m_strVertexShaderFile;
+	std::string													m_strFragmentShaderFile;
+	std::string													m_strName;
+	std::map<std::string, uint64_t>								m_mapFeatures;		// feature name to key bit
+	uint64_t													m_uFeatureMask;		// all declared features
+	std::unordered_map<uint64_t, ResourceCache::HANDLE>			m_mapPrograms;		// nullptr when building failed
+};
@@ -0,0 +1,160 @@
+/**
+ * ============================================================================
+ *  Name        : ShadowMap.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : cascaded shadow maps for the directional light. Static
+ *                casters are rendered into a cached atlas that is refreshed
+ *                per cascade only when the light turns or the cascade moves
+ *                out of its cached bounds. Every frame the cached depth is
+ *                copied to the sampled atlas and only the dynamic casters
+ *                are drawn on top.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/DrawQueue.h"
+
+// forward declarations
+class Node;
+
+class ShadowMap
+{
+public:
+	static constexpr uint32_t MAX_CASCADES = 4;
+
+	/**
+	 * SETTINGS
+	 * cascade layout and caching thresholds
+	 */
+	struct SETTINGS
+	{
+		SETTINGS() :
+			resolution(1024),
+			cascades(MAX_CASCADES),
+			distance(100.0f),
+			splitLambda(0.75f),
+			cacheMargin(0.25f),
+			casterDistance(100.0f),
+			lightAngle(0.01f)
+		{
+		}
+
+		uint32_t		resolution;		// texels per cascade side, cascades are packed 2 per row into one atlas
+		uint32_t		cascades;		// 1 - MAX_CASCADES
+		float			distance;		// shadow distance from the camera, clamped to the far plane
+		float			splitLambda;	// 0 = uniform splits, 1 = logarithmic splits
+		float			cacheMargin;	// cached cascades cover this much extra radius before static casters are drawn again
+		float			casterDistance;	// distance towards the light where casters outside the view still cast
+		float			lightAngle;		// light direction change in radians that redraws the static casters
+	};
+
+	struct STATS
+	{
+		uint32_t		staticCascades;	// cascades whose static casters were drawn last frame
+		uint32_t		staticDraws;
+		uint32_t		dynamicDraws;
+	};
+
+	ShadowMap();
+	~ShadowMap();
+
+	/**
+	 * IsSupported
+	 * @return true if current context supports framebuffer objects and blits
+	 */
+	static bool IsSupported();
+
+	/**
+	 * Create
+	 * create the cached and the sampled depth atlases and the depth only program
+	 * @param renderer renderer to create the program with
+	 * @param settings cascade layout
+	 * @return true if successful
+	 */
+	bool Create(OpenGLRenderer& renderer, const SETTINGS& settings = SETTINGS());
+
+	/**
+	 * Release
+	 * delete the textures, framebuffers and the program
+	 */
+	void Release();
+
+	/**
+	 * SetStaticCasters
+	 * record the geometry nodes under root as static casters, world matrices are captured now.
+	 * Call again when the static scene changes.
+	 * @param root root of the static nodes
+	 */
+	void SetStaticCasters(const Node& root);
+
+	/**
+	 * Update
+	 * fit the cascades to current camera of the renderer and check which cached cascades are still valid.
+	 * Call once per frame after the camera is set.
+	 * @param renderer renderer with the camera matrices and the shadow bias
+	 * @param lightDirection direction the light travels
+	 */
+	void Update(const IRenderer& renderer, const glm::vec3& lightDirection);
+
+	/**
+	 * Render
+	 * refresh the invalid static cascades, copy the static depth to the sampled atlas and draw the
+	 * dynamic casters into it. Binds the default framebuffer and restores the viewport when done.
+	 * @param renderer renderer to draw with
+	 * @param dynamicRoot root of the moving nodes, may be nullptr
+	 */
+	void Render(OpenGLRenderer& renderer, const Node* dynamicRoot);
+
+	/**
+	 * Bind
+	 * set the atlas and the cascade uniforms of a program compiled with the SHADOWS feature
+	 * @param renderer renderer to bind the texture with
+	 * @param program handle to shader program
+	 * @param slot texture slot of the shadow atlas
+	 */
+	void Bind(IRenderer& renderer, GLuint program, int32_t slot) const;
+
+	inline GLuint GetTexture() const { return m_uTexture; }
+	inline const STATS& GetStats() const { return m_Stats; }
+
+private:
+	struct CASCADE
+	{
+		float			splitFar;		// view depth where the next cascade starts
+		glm::vec3		center;			// bounding sphere of the view frustum slice, world space
+		float			radius;
+
+		// bounds the cached static depth was drawn for
+		glm::vec3		cachedCenter;
+		float			cachedRadius;
+		glm::vec3		cachedLightDirection;
+		bool			valid;
+
+		glm::mat4		viewProjection;	// world to light clip space
+		glm::mat4		shadowMatrix;	// world to atlas texture coordinates and depth
+	};
+
+	void FitCascade(CASCADE& cascade, const IRenderer& renderer, uint32_t index) const;
+	glm::ivec4 GetViewport(uint32_t cascade) const;
+	void DrawCasters(IRenderer& renderer, const DrawQueue& casters, uint32_t cascade, uint32_t& drawCount) const;
+	static void CollectCasters(const Node& node, DrawQueue& casters);
+
+	SETTINGS					m_Settings;
+	glm::ivec2					m_vAtlasSize;
+	glm::vec3					m_vLightDirection;
+	glm::vec4					m_vDepthPlane;		// camera forward plane, dot with a world position gives view depth
+	CASCADE						m_arrCascades[MAX_CASCADES];
+
+	DrawQueue					m_StaticCasters;
+	DrawQueue					m_DynamicCasters;
+
+	GLuint						m_uProgram;
+	GLint						m_iPositionAttrib;
+	GLuint						m_uStaticFramebuffer;
+	GLuint						m_uStaticDepth;		// cached static casters, renderbuffer
+	GLuint						m_uFramebuffer;
+	GLuint						m_uTexture;			// static + dynamic casters, sampled with depth compare
+
+	STATS						m_Stats;
+};
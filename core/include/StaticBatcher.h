@@ -0,0 +1,61 @@
+/**
+ * ============================================================================
+ *  Name        : StaticBatcher.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : merges static geometry nodes sharing a material into
+ *                pre-transformed batches with 32 bit indices
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/Geometry.h"
+#include <map>
+
+// forward declarations
+class Node;
+class GeometryNode;
+struct Material;
+
+class StaticBatcher
+{
+public:
+	struct STATS
+	{
+		uint32_t		drawsBefore;
+		uint32_t		drawsAfter;
+		size_t			vertexCount;
+		size_t			indexCount;
+	};
+
+	/**
+	 * Batch
+	 * replace static children of the root with merged geometry nodes. A child
+	 * is merged when its whole subtree consists of plain nodes and geometry
+	 * nodes without velocity or rotation speed, other children are kept and
+	 * batched recursively in their own space.
+	 * @param root root of the static subtree, its own geometry is not merged
+	 * @param maxVerticesPerBatch split batches above this size for finer culling
+	 * @return draw counts before and after batching
+	 */
+	static STATS Batch(Node& root, size_t maxVerticesPerBatch = 65536);
+
+	/**
+	 * IsStatic
+	 * @param node node to test
+	 * @return true if the node and all its children can be merged
+	 */
+	static bool IsStatic(const Node& node);
+
+private:
+	struct BATCH
+	{
+		std::vector<Geometry::VERTEX>	vertices;
+		std::vector<uint32_t>			indices;
+	};
+	typedef std::map<std::shared_ptr<Material>, std::vector<BATCH>> BATCHMAP;
+
+	static void BatchChildren(Node& root, size_t maxVerticesPerBatch, STATS& stats);
+	static void Collect(Node& node, const glm::mat4& matrix, size_t maxVerticesPerBatch, BATCHMAP& batches, STATS& stats);
+	static void Append(BATCH& batch, const Geometry& geometry, const glm::mat4& matrix);
+};
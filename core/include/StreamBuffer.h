@@ -0,0 +1,103 @@
+/**
+ * ============================================================================
+ *  Name        : StreamBuffer.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : ring buffer allocator for dynamic per frame data. Uses a
+ *                persistently mapped buffer fenced per frame, falls back to
+ *                glBufferSubData uploads on drivers without buffer storage.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/OpenGLRenderer.h"
+
+class StreamBuffer
+{
+public:
+	struct ALLOCATION
+	{
+		void*		data;		// cpu pointer to write into, nullptr if allocation failed
+		GLintptr	offset;		// offset of the allocation in the buffer
+		GLsizeiptr	size;		// size of the allocation in bytes
+	};
+
+	struct STATS
+	{
+		size_t		bytesLastFrame;			// bytes allocated during previous frame
+		size_t		peakBytesPerFrame;		// largest number of bytes allocated in a frame
+		float		fenceWaitLastFrame;		// seconds cpu waited for the gpu at the beginning of current frame
+		float		fenceWaitTotal;			// seconds cpu has waited for the gpu in total
+		uint32_t	failedAllocations;		// allocations that did not fit into the frame region
+	};
+
+	StreamBuffer();
+	~StreamBuffer();
+
+	/**
+	 * Create
+	 * create the buffer, it is split into one region per frame in flight
+	 * @param size total size of the buffer in bytes
+	 * @param framesInFlight number of frames cpu can write ahead of the gpu
+	 * @return true if successful
+	 */
+	bool Create(size_t size, uint32_t framesInFlight = 3);
+
+	/**
+	 * Release
+	 * release the buffer and fences
+	 */
+	void Release();
+
+	/**
+	 * Allocate
+	 * allocate memory from the region of the current frame. Memory is valid until the end of frame.
+	 * @param bytes number of bytes to allocate
+	 * @param alignment alignment of the allocation offset, 256 is enough for any buffer binding
+	 * @return allocation, data is nullptr if current frame region is full
+	 */
+	ALLOCATION Allocate(size_t bytes, size_t alignment = 256);
+
+	/**
+	 * Flush
+	 * make written allocation visible to the gpu. No-op for persistently mapped buffer,
+	 * on fallback path this uploads the data with glBufferSubData.
+	 * @param allocation allocation to flush
+	 */
+	void Flush(const ALLOCATION& allocation);
+
+	/**
+	 * BeginFrame
+	 * move to the next frame region, waits for the gpu if the region is still in use
+	 */
+	void BeginFrame();
+
+	/**
+	 * EndFrame
+	 * fence the current frame region
+	 */
+	void EndFrame();
+
+	inline GLuint GetBuffer() const { return m_Buffer; }
+	inline bool IsPersistent() const { return m_pMapped != nullptr; }
+	inline const STATS& GetStats() const { return m_Stats; }
+
+	/**
+	 * IsPersistentMappingSupported
+	 * @return true if current context supports GL_ARB_buffer_storage
+	 */
+	static bool IsPersistentMappingSupported();
+
+private:
+	GLuint						m_Buffer;
+	uint8_t*					m_pMapped;
+	std::vector<uint8_t>		m_arrShadow;
+
+	size_t						m_uRegionSize;
+	uint32_t					m_uFramesInFlight;
+	uint32_t					m_uRegion;
+	size_t						m_uHead;
+	std::vector<GLsync>			m_arrFences;
+
+	STATS						m_Stats;
+};
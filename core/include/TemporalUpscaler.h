@@ -0,0 +1,117 @@
+/**
+ * ============================================================================
+ *  Name        : TemporalUpscaler.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : temporal reconstruction of the dynamic resolution frame.
+ *                The projection is jittered inside the pixels every frame,
+ *                motion vectors of the draws reproject the full resolution
+ *                history, which is clamped to the neighbourhood of the new
+ *                samples and blended with them.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/DrawQueue.h"
+
+class TemporalUpscaler
+{
+public:
+	TemporalUpscaler();
+	~TemporalUpscaler();
+
+	/**
+	 * IsSupported
+	 * @return true if current context supports float render targets (GL 3.0)
+	 */
+	static bool IsSupported();
+
+	/**
+	 * Create
+	 * compile the programs, targets are allocated on first BeginFrame
+	 * @param renderer renderer to create the programs with
+	 * @return true if successful
+	 */
+	bool Create(OpenGLRenderer& renderer);
+
+	/**
+	 * Release
+	 * delete the targets and the programs
+	 */
+	void Release();
+
+	/**
+	 * Reset
+	 * drop the history, e.g. when the camera cuts to a new view
+	 */
+	inline void Reset() { m_bHistoryValid = false; }
+
+	/**
+	 * SetFeedback
+	 * @param feedback weight of the history in the blend, 0 - 1
+	 */
+	inline void SetFeedback(float feedback) { m_fFeedback = glm::clamp(feedback, 0.0f, 1.0f); }
+	inline float GetFeedback() const { return m_fFeedback; }
+
+	/**
+	 * GetJitter
+	 * @return sub pixel offset of the current frame in render pixels, -0.5 - 0.5, see CameraNode::SetJitter
+	 */
+	inline const glm::vec2& GetJitter() const { return m_vJitter; }
+
+	/**
+	 * BeginFrame
+	 * pick the jitter of the frame and resize the targets. Called by DynamicResolution.
+	 * @param depthBuffer depth renderbuffer of the scene target, shared by the motion vectors
+	 * @param targetSize allocated size of the scene target
+	 * @param renderSize area of the scene target the frame is rendered to
+	 * @param windowSize output size
+	 */
+	void BeginFrame(GLuint depthBuffer, const glm::ivec2& targetSize, const glm::ivec2& renderSize, const glm::ivec2& windowSize);
+
+	/**
+	 * RenderMotionVectors
+	 * write the screen motion of the draws after the scene has been drawn, depth tested against it.
+	 * Pixels no draw covers move with the camera only, queue may be empty.
+	 * @param renderer renderer with the jittered camera matrices, scene target bound
+	 * @param queue draws of the frame with their previous world matrices
+	 * @param projectionMatrix projection without the jitter
+	 */
+	void RenderMotionVectors(IRenderer& renderer, const DrawQueue& queue, const glm::mat4& projectionMatrix);
+
+	/**
+	 * Resolve
+	 * reconstruct the full resolution frame into the history
+	 * @param renderer renderer to draw with
+	 * @param sceneTexture color of the scene target
+	 * @return full resolution texture to present
+	 */
+	GLuint Resolve(OpenGLRenderer& renderer, GLuint sceneTexture);
+
+private:
+	bool CreateTargets();
+	void ReleaseTargets();
+	static float Halton(uint32_t index, uint32_t base);
+
+	GLuint				m_uMotionProgram;
+	GLuint				m_uResolveProgram;
+
+	GLuint				m_uDepthBuffer;			// not owned
+	glm::ivec2			m_vTargetSize;
+	glm::ivec2			m_vRenderSize;
+	glm::ivec2			m_vWindowSize;
+
+	GLuint				m_uMotionFramebuffer;
+	GLuint				m_uMotion;				// RG16F, target size
+	GLuint				m_arrHistoryFramebuffers[2];
+	GLuint				m_arrHistory[2];		// window size, ping-pong
+	uint32_t			m_uHistoryIndex;
+	bool				m_bHistoryValid;
+	bool				m_bMotionValid;			// motion vectors were drawn this frame
+
+	float				m_fFeedback;
+	uint32_t			m_uJitterIndex;
+	glm::vec2			m_vJitter;
+	glm::mat4			m_mViewProjection;		// without jitter
+	glm::mat4			m_mPreviousViewProjection;
+};
@@ -0,0 +1,64 @@
+/**
+ * ============================================================================
+ *  Name        : TextureCompressor.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : cpu BC1 (DXT1) and BC3 (DXT5) block compression encoder,
+ *                SSE2 accelerated where available
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/OpenGLRenderer.h"
+
+class TextureCompressor
+{
+public:
+	/**
+	 * IsSupportedFormat
+	 * @param format GL_COMPRESSED_RGBA_S3TC_DXT1_EXT or GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+	 * @return true if encoder can produce the format
+	 */
+	static bool IsSupportedFormat(GLenum format);
+
+	/**
+	 * GetBlockSize
+	 * @param format compressed format
+	 * @return bytes per 4x4 block, 8 for BC1 and 16 for BC3
+	 */
+	static size_t GetBlockSize(GLenum format);
+
+	/**
+	 * GetCompressedSize
+	 * @param width width of the image in pixels
+	 * @param height height of the image in pixels
+	 * @param format compressed format
+	 * @return size of the compressed image in bytes
+	 */
+	static size_t GetCompressedSize(int32_t width, int32_t height, GLenum format);
+
+	/**
+	 * Compress
+	 * compress rgba8 image. Partial edge blocks repeat the last row and column
+	 * @param rgba source pixels, 4 bytes per pixel
+	 * @param width width of the image in pixels
+	 * @param height height of the image in pixels
+	 * @param format GL_COMPRESSED_RGBA_S3TC_DXT1_EXT or GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+	 * @param dst receives the compressed blocks
+	 * @return true if succesful
+	 */
+	static bool Compress(const uint8_t* rgba, int32_t width, int32_t height, GLenum format, std::vector<uint8_t>& dst);
+
+	/**
+	 * EncodeBC1Block, EncodeBC3Block
+	 * encode single 4x4 block of rgba8 pixels
+	 * @param block 16 pixels in row order
+	 * @param dst 8 (BC1) or 16 (BC3) bytes of output
+	 */
+	static void EncodeBC1Block(const uint8_t* block, uint8_t* dst);
+	static void EncodeBC3Block(const uint8_t* block, uint8_t* dst);
+
+private:
+	static void EncodeColorBlock(const uint8_t* block, uint8_t* dst);
+	static void EncodeAlphaBlock(const uint8_t* block, uint8_t* dst);
+};
@@ -0,0 +1,120 @@
+/**
+ * ============================================================================
+ *  Name        : TextureStreamer.h
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : asynchronous texture loader. Worker threads decode images and
+ *                build mip chains, the GL thread uploads them coarse levels
+ *                first through a pool of pixel buffer objects, limited by a
+ *                per frame byte budget.
+ * ============================================================================
+**/
+
+#pragma once
+
+#include "../include/OpenGLRenderer.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+class TextureStreamer
+{
+public:
+	struct STATS
+	{
+		size_t		bytesUploadedLastFrame;		// bytes uploaded during last Update
+		size_t		bytesUploadedTotal;			// bytes uploaded since Create
+		uint32_t	pendingTextures;			// textures still decoding or uploading
+		uint32_t	residentTextures;			// textures fully uploaded
+		uint32_t	failedTextures;				// textures that failed to decode
+	};
+
+	TextureStreamer();
+	~TextureStreamer();
+
+	/**
+	 * Create
+	 * start the worker threads and create the upload buffers. Call from the GL thread
+	 * @param workerCount number of decoding threads
+	 * @param uploadBudget max bytes to upload per Update call
+	 * @param pboCount number of pixel buffer objects to rotate through
+	 * @return true if succesful
+	 */
+	bool Create(uint32_t workerCount = 2, size_t uploadBudget = 8 * 1024 * 1024, uint32_t pboCount = 4);
+
+	/**
+	 * Release
+	 * stop the workers and drop pending uploads. Created textures are owned by the caller
+	 */
+	void Release();
+
+	/**
+	 * Load
+	 * queue an image for loading. Returns at once with a texture holding a 1x1
+	 * grey placeholder, the image replaces it level by level from the coarsest mip.
+	 * The texture must stay alive until it is resident or the streamer is released
+	 * @param filename image file to load
+	 * @param params wrap, mipmap and filtering options. Compression is not streamed
+	 * @return opengl texture handle, or 0 if streamer is not created
+	 */
+	GLuint Load(const std::string_view& filename, const OpenGLRenderer::TEXTUREPARAMS& params = OpenGLRenderer::TEXTUREPARAMS());
+
+	/**
+	 * Update
+	 * upload decoded levels within the byte budget. Call once per frame from the GL thread
+	 */
+	void Update();
+
+	/**
+	 * IsResident
+	 * @param texture handle returned by Load
+	 * @return true if all levels of the texture are uploaded
+	 */
+	bool IsResident(GLuint texture) const;
+
+	/**
+	 * IsIdle
+	 * @return true if nothing is decoding or waiting for upload
+	 */
+	bool IsIdle() const;
+
+	const STATS& GetStats() const { return m_Stats; }
+
+private:
+	struct LEVEL
+	{
+		int32_t					width;
+		int32_t					height;
+		std::vector<uint8_t>	pixels;
+	};
+
+	struct JOB
+	{
+		GLuint							texture;
+		std::string						filename;
+		OpenGLRenderer::TEXTUREPARAMS	params;
+		std::vector<LEVEL>				levels;			// finest level first
+		int32_t							uploadLevel;	// level being uploaded, counts down to 0
+		int32_t							uploadRow;		// next row of the level to upload
+		bool							failed;
+	};
+
+	void WorkerThread();
+	static void Decode(JOB& job);
+	size_t UploadRows(JOB& job, size_t budget);
+
+	std::vector<std::thread>				m_arrWorkers;
+	mutable std::mutex						m_Mutex;
+	std::condition_variable					m_Condition;
+	bool									m_bQuit;
+
+	std::deque<std::shared_ptr<JOB>>		m_arrDecodeQueue;	// waiting for a worker
+	std::deque<std::shared_ptr<JOB>>		m_arrUploadQueue;	// decoded, waiting for upload
+	std::vector<GLuint>						m_arrPending;		// textures not yet resident
+	std::shared_ptr<JOB>					m_pCurrentUpload;	// job being uploaded by GL thread
+
+	std::vector<GLuint>						m_arrPixelBuffers;
+	size_t									m_uNextPixelBuffer;
+	size_t									m_uUploadBudget;
+	STATS									m_Stats;
+};
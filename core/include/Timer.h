@@ -39,6 +39,12 @@ public:
 	 */
 	static uint64_t GetTicks();
 
+	/**
+	 * GetSecondsPerTick
+	 * @return duration of one GetTicks tick in seconds
+	 */
+	static double GetSecondsPerTick();
+
 private:
 	double		m_dRateToSeconds;
 	uint64_t	m_uStartClock;
@@ -0,0 +1,170 @@
+/**
+ * ============================================================================
+ *  Name        : Bloom.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : post effect adding a blurred glow around the bright parts
+ * ============================================================================
+**/
+
+#include "../include/Bloom.h"
+
+
+// 2x2 box downsample with the threshold, the half size target is filtered bilinearly
+static const char* s_pBrightFragmentShader =
+	"uniform sampler2D source;\n"
+	"uniform vec2 sourceScale;\n"
+	"uniform vec2 sourceMax;\n"
+	"uniform vec2 sourceTexel;\n"
+	"uniform float threshold;\n"
+	"varying vec2 outUv;\n"
+	"void main(void)\n"
+	"{\n"
+	"	vec2 uv = outUv * sourceScale;\n"
+	"	vec3 color = texture2D(source, min(uv - sourceTexel * 0.5, sourceMax)).rgb;\n"
+	"	color += texture2D(source, min(uv + vec2(sourceTexel.x, -sourceTexel.y) * 0.5, sourceMax)).rgb;\n"
+	"	color += texture2D(source, min(uv + vec2(-sourceTexel.x, sourceTexel.y) * 0.5, sourceMax)).rgb;\n"
+	"	color += texture2D(source, min(uv + sourceTexel * 0.5, sourceMax)).rgb;\n"
+	"	color *= 0.25;\n"
+	"	gl_FragColor = vec4(max(color - threshold, 0.0) / max(1.0 - threshold, 0.001), 1.0);\n"
+	"}\n";
+
+// 9 tap gaussian in 5 bilinear fetches
+static const char* s_pBlurFragmentShader =
+	"uniform sampler2D source;\n"
+	"uniform vec2 sourceScale;\n"
+	"uniform vec2 sourceMax;\n"
+	"uniform vec2 sourceTexel;\n"
+	"uniform vec2 direction;\n"
+	"varying vec2 outUv;\n"
+	"void main(void)\n"
+	"{\n"
+	"	vec2 uv = outUv * sourceScale;\n"
+	"	vec2 step1 = direction * sourceTexel * 1.3846153846;\n"
+	"	vec2 step2 = direction * sourceTexel * 3.2307692308;\n"
+	"	vec3 color = texture2D(source, min(uv, sourceMax)).rgb * 0.2270270270;\n"
+	"	color += texture2D(source, min(uv + step1, sourceMax)).rgb * 0.3162162162;\n"
+	"	color += texture2D(source, max(uv - step1, vec2(0.0))).rgb * 0.3162162162;\n"
+	"	color += texture2D(source, min(uv + step2, sourceMax)).rgb * 0.0702702703;\n"
+	"	color += texture2D(source, max(uv - step2, vec2(0.0))).rgb * 0.0702702703;\n"
+	"	gl_FragColor = vec4(color, 1.0);\n"
+	"}\n";
+
+static const char* s_pCompositeFragmentShader =
+	"uniform sampler2D scene;\n"
+	"uniform vec2 sceneScale;\n"
+	"uniform vec2 sceneMax;\n"
+	"uniform sampler2D glow;\n"
+	"uniform vec2 glowScale;\n"
+	"uniform vec2 glowMax;\n"
+	"uniform float intensity;\n"
+	"varying vec2 outUv;\n"
+	"void main(void)\n"
+	"{\n"
+	"	vec3 color = texture2D(scene, min(outUv * sceneScale, sceneMax)).rgb;\n"
+	"	color += texture2D(glow, min(outUv * glowScale, glowMax)).rgb * intensity;\n"
+	"	gl_FragColor = vec4(color, 1.0);\n"
+	"}\n";
+
+
+Bloom::Bloom(const SETTINGS& settings) :
+	m_Settings(settings),
+	m_uBrightProgram(0),
+	m_uBlurProgram(0),
+	m_uCompositeProgram(0)
+{
+}
+
+
+Bloom::~Bloom()
+{
+	Release();
+}
+
+
+PostEffect::FORMATS Bloom::GetFormats() const
+{
+	// reads and writes the frame at its own format and size
+	return { 0, 0, 1.0f };
+}
+
+
+bool Bloom::Create(OpenGLRenderer& renderer)
+{
+	Release();
+	m_uBrightProgram = renderer.CreateProgramFromSource(PostProcess::GetVertexShader(), s_pBrightFragmentShader);
+	m_uBlurProgram = renderer.CreateProgramFromSource(PostProcess::GetVertexShader(), s_pBlurFragmentShader);
+	m_uCompositeProgram = renderer.CreateProgramFromSource(PostProcess::GetVertexShader(), s_pCompositeFragmentShader);
+	if (!m_uBrightProgram || !m_uBlurProgram || !m_uCompositeProgram)
+	{
+		Release();
+		return false;
+	}
+	return true;
+}
+
+
+void Bloom::Release()
+{
+	for (GLuint* program : { &m_uBrightProgram, &m_uBlurProgram, &m_uCompositeProgram })
+	{
+		if (*program)
+		{
+			glDeleteProgram(*program);
+			*program = 0;
+		}
+	}
+}
+
+
+void Bloom::Render(OpenGLRenderer& renderer, PostProcess& chain, const RenderTargetPool::TARGET& input, const RenderTargetPool::TARGET& output)
+{
+	PROFILE_SCOPE("Bloom::Render");
+
+	RenderTargetPool& pool = chain.GetPool();
+	const RenderTargetPool::DESC desc(glm::max(input.desc.size / 2, glm::ivec2(1)), input.desc.format);
+
+	// bright pass, horizontal and vertical blur, the vertical one reuses the bright target
+	RenderTargetPool::TARGET* bright = pool.Acquire(desc);
+	RenderTargetPool::TARGET* horizontal = pool.Acquire(desc);
+	if (bright && horizontal)
+	{
+		glViewport(0, 0, desc.size.x, desc.size.y);
+		glBindFramebuffer(GL_FRAMEBUFFER, bright->framebuffer);
+		glUseProgram(m_uBrightProgram);
+		PostProcess::SetInput(renderer, m_uBrightProgram, "source", input, 0);
+		OpenGLRenderer::SetUniformFloat(m_uBrightProgram, "threshold", m_Settings.threshold);
+		PostProcess::DrawFullscreen(m_uBrightProgram);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, horizontal->framebuffer);
+		glUseProgram(m_uBlurProgram);
+		PostProcess::SetInput(renderer, m_uBlurProgram, "source", *bright, 0);
+		OpenGLRenderer::SetUniformVec2(m_uBlurProgram, "direction", glm::vec2(1.0f, 0.0f));
+		PostProcess::DrawFullscreen(m_uBlurProgram);
+
+		// bright pass has been consumed, its target stays acquired for the vertical blur
+		RenderTargetPool::TARGET* vertical = bright;
+		glBindFramebuffer(GL_FRAMEBUFFER, vertical->framebuffer);
+		PostProcess::SetInput(renderer, m_uBlurProgram, "source", *horizontal, 0);
+		OpenGLRenderer::SetUniformVec2(m_uBlurProgram, "direction", glm::vec2(0.0f, 1.0f));
+		PostProcess::DrawFullscreen(m_uBlurProgram);
+		pool.Recycle(horizontal);
+
+		glBindFramebuffer(GL_FRAMEBUFFER, output.framebuffer);
+		glViewport(0, 0, output.desc.size.x, output.desc.size.y);
+		glUseProgram(m_uCompositeProgram);
+		PostProcess::SetInput(renderer, m_uCompositeProgram, "scene", input, 0);
+		PostProcess::SetInput(renderer, m_uCompositeProgram, "glow", *vertical, 1);
+		OpenGLRenderer::SetUniformFloat(m_uCompositeProgram, "intensity", m_Settings.intensity);
+		PostProcess::DrawFullscreen(m_uCompositeProgram);
+		pool.Recycle(vertical);
+		return;
+	}
+
+	// no memory for the glow, pass the frame through
+	pool.Recycle(bright);
+	pool.Recycle(horizontal);
+	glUseProgram(m_uCompositeProgram);
+	PostProcess::SetInput(renderer, m_uCompositeProgram, "scene", input, 0);
+	OpenGLRenderer::SetUniformFloat(m_uCompositeProgram, "intensity", 0.0f);
+	PostProcess::DrawFullscreen(m_uCompositeProgram);
+}
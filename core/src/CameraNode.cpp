@@ -9,12 +9,14 @@
 #include "../include/CameraNode.h"
 
 
-CameraNode::CameraNode()
+CameraNode::CameraNode() :
+	m_vJitter(0.0f)
 {
 	SetProjectionParams(glm::half_pi<float>(), 1.0f, 1.0f, 500.0f);
 }
 
-CameraNode::CameraNode(float fov, float aspect, float nearplane, float farplane)
+CameraNode::CameraNode(float fov, float aspect, float nearplane, float farplane) :
+	m_vJitter(0.0f)
 {
 	SetProjectionParams(fov, aspect, nearplane, farplane);
 }
@@ -34,7 +36,7 @@ void CameraNode::Render(IRenderer& renderer, GLuint program)
 
 void CameraNode::SetProjectionParams(float fov, float aspect, float nearplane, float farplane)
 {
-	m_mProjection = glm::perspective(fov, aspect, nearplane, farplane);
+	m_mProjection = glm::translate(glm::mat4(1.0f), glm::vec3(m_vJitter, 0.0f)) * glm::perspective(fov, aspect, nearplane, farplane);
 
 	m_fFov = fov;
 	m_fAspect = aspect;
@@ -43,6 +45,15 @@ void CameraNode::SetProjectionParams(float fov, float aspect, float nearplane, f
 }
 
 
+void CameraNode::SetJitter(const glm::vec2& pixels, const glm::ivec2& viewportSize)
+{
+	// translate in clip space after the projection, every depth moves by the same fraction of a pixel
+	const glm::vec2 jitter(pixels * 2.0f / glm::vec2(glm::max(viewportSize, glm::ivec2(1))));
+	m_mProjection = glm::translate(glm::mat4(1.0f), glm::vec3(jitter - m_vJitter, 0.0f)) * m_mProjection;
+	m_vJitter = jitter;
+}
+
+
 glm::vec4 CameraNode::GetProjectionParams() const
 {
 	return glm::vec4(m_fFov, m_fAspect, m_fNearplane, m_fFarplane);
@@ -0,0 +1,410 @@
+/**
+ * ============================================================================
+ *  Name        : ClusteredLighting.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : clustered forward shading for many point lights
+ * ============================================================================
+**/
+
+#include "../include/ClusteredLighting.h"
+#include "../include/Timer.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+
+ClusteredLighting::ClusteredLighting() :
+	m_uTilesX(0),
+	m_uTilesY(0),
+	m_uSlices(0),
+	m_uMaxClusterLights(0),
+	m_fNear(0.0f),
+	m_fFar(0.0f),
+	m_mProjection(0.0f),
+	m_mView(1.0f),
+	m_vViewportSize(1.0f),
+	m_LightBuffer(0),
+	m_ClusterBuffer(0),
+	m_IndexBuffer(0),
+	m_uGeneration(0),
+	m_uNextSlice(0),
+	m_uBusyWorkers(0),
+	m_bQuit(false),
+	m_Stats()
+{
+}
+
+
+ClusteredLighting::~ClusteredLighting()
+{
+	Release();
+}
+
+
+bool ClusteredLighting::IsSupported()
+{
+	return glBindBufferBase &&
+		OpenGLRenderer::GetVersion() >= 43;
+}
+
+
+bool ClusteredLighting::Create(uint32_t tilesX, uint32_t tilesY, uint32_t slices, uint32_t maxClusterLights, uint32_t workerCount)
+{
+	Release();
+	if (!IsSupported())
+	{
+		IApplication::Debug("ClusteredLighting: storage buffers not supported\n");
+		return false;
+	}
+
+	m_uTilesX = std::max(tilesX, 1u);
+	m_uTilesY = std::max(tilesY, 1u);
+	m_uSlices = std::max(slices, 1u);
+	m_uMaxClusterLights = std::max(maxClusterLights, 1u);
+	m_mProjection = glm::mat4(0.0f);
+
+	m_arrClusters.resize(m_uTilesX * m_uTilesY * m_uSlices);
+	m_arrSlices.resize(m_uSlices);
+	for (auto& slice : m_arrSlices)
+	{
+		slice.clusterLights.resize(m_uTilesX * m_uTilesY);
+		slice.dropped = 0;
+	}
+
+	GLuint buffers[3];
+	glGenBuffers(3, buffers);
+	m_LightBuffer = buffers[0];
+	m_ClusterBuffer = buffers[1];
+	m_IndexBuffer = buffers[2];
+
+	if (workerCount == 0xFFFFFFFF)
+	{
+		workerCount = std::max(std::thread::hardware_concurrency(), 1u) - 1;
+	}
+	m_bQuit = false;
+	for (uint32_t i = 0; i < std::min(workerCount, m_uSlices - 1); ++i)
+	{
+		m_arrWorkers.emplace_back(&ClusteredLighting::WorkerThread, this);
+	}
+	return true;
+}
+
+
+void ClusteredLighting::Release()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_bQuit = true;
+	}
+	m_Condition.notify_all();
+	for (auto& worker : m_arrWorkers)
+	{
+		worker.join();
+	}
+	m_arrWorkers.clear();
+
+	// workers of the next Create start from generation 0 and wait for the first AssignSlices
+	m_uGeneration = 0;
+	m_uNextSlice = 0;
+	m_uBusyWorkers = 0;
+
+	if (m_LightBuffer)
+	{
+		const GLuint buffers[3] = { m_LightBuffer, m_ClusterBuffer, m_IndexBuffer };
+		glDeleteBuffers(3, buffers);
+		m_LightBuffer = 0;
+		m_ClusterBuffer = 0;
+		m_IndexBuffer = 0;
+	}
+
+	m_arrClusters.clear();
+	m_arrSlices.clear();
+	m_arrViewLights.clear();
+}
+
+
+void ClusteredLighting::Update(IRenderer& renderer, int32_t width, int32_t height)
+{
+	if (!m_LightBuffer)
+	{
+		return;
+	}
+
+	const uint64_t begin = Timer::GetTicks();
+
+	// cluster bounds depend only on the projection
+	const glm::mat4& projection = renderer.GetProjectionMatrix();
+	if (projection != m_mProjection)
+	{
+		BuildClusters(projection);
+	}
+	m_mView = renderer.GetViewMatrix();
+	m_vViewportSize = glm::vec2((float)std::max(width, 1), (float)std::max(height, 1));
+
+	CullLights(m_mView, projection);
+	AssignSlices();
+	Upload();
+
+	m_Stats.lights = (uint32_t)m_arrLights.size();
+	m_Stats.visibleLights = (uint32_t)m_arrViewLights.size();
+	m_Stats.assignMilliseconds = (float)((Timer::GetTicks() - begin) * Timer::GetSecondsPerTick() * 1000.0);
+}
+
+
+void ClusteredLighting::Bind(GLuint program) const
+{
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_LightBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, m_ClusterBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, m_IndexBuffer);
+
+	// slice = log(depth) * scale + bias
+	const float logRange = std::log(m_fFar / m_fNear);
+	const glm::vec4 params(
+		m_uSlices / logRange,
+		-(float)m_uSlices * std::log(m_fNear) / logRange,
+		m_uTilesX / m_vViewportSize.x,
+		m_uTilesY / m_vViewportSize.y);
+
+	OpenGLRenderer::SetUniformMatrix4(program, "clusterViewMatrix", m_mView);
+	OpenGLRenderer::SetUniformVec4(program, "clusterParams", params);
+	OpenGLRenderer::SetUniformVec4(program, "clusterGrid", glm::vec4((float)m_uTilesX, (float)m_uTilesY, (float)m_uSlices, 0.0f));
+}
+
+
+float ClusteredLighting::GetSliceDepth(uint32_t slice) const
+{
+	// exponential slices keep clusters roughly cubic along the view
+	return m_fNear * std::pow(m_fFar / m_fNear, (float)slice / m_uSlices);
+}
+
+
+void ClusteredLighting::BuildClusters(const glm::mat4& projection)
+{
+	m_mProjection = projection;
+
+	const glm::vec2 depthRange(Frustum::GetDepthRange(projection));
+	m_fNear = depthRange.x;
+	m_fFar = depthRange.y;
+
+	// view space rays through the tile corners, off-center projections are handled as well
+	const glm::mat4 inverseProjection(glm::inverse(projection));
+	std::vector<glm::vec3> rays((m_uTilesX + 1) * (m_uTilesY + 1));
+	for (uint32_t y = 0; y <= m_uTilesY; ++y)
+	{
+		for (uint32_t x = 0; x <= m_uTilesX; ++x)
+		{
+			const glm::vec4 ndc(-1.0f + 2.0f * x / m_uTilesX, -1.0f + 2.0f * y / m_uTilesY, -1.0f, 1.0f);
+			const glm::vec4 point(inverseProjection * ndc);
+			rays[y * (m_uTilesX + 1) + x] = glm::vec3(point) / -point.z;
+		}
+	}
+
+	for (uint32_t slice = 0; slice < m_uSlices; ++slice)
+	{
+		const float depths[2] = { GetSliceDepth(slice), GetSliceDepth(slice + 1) };
+		for (uint32_t y = 0; y < m_uTilesY; ++y)
+		{
+			for (uint32_t x = 0; x < m_uTilesX; ++x)
+			{
+				AABB& box = m_arrClusters[(slice * m_uTilesY + y) * m_uTilesX + x];
+				box.min = glm::vec3(FLT_MAX);
+				box.max = glm::vec3(-FLT_MAX);
+				for (uint32_t corner = 0; corner < 4; ++corner)
+				{
+					const glm::vec3& ray = rays[(y + corner / 2) * (m_uTilesX + 1) + x + corner % 2];
+					for (float depth : depths)
+					{
+						box.min = glm::min(box.min, ray * depth);
+						box.max = glm::max(box.max, ray * depth);
+					}
+				}
+			}
+		}
+	}
+}
+
+
+void ClusteredLighting::CullLights(const glm::mat4& view, const glm::mat4& projection)
+{
+	m_arrViewLights.clear();
+	const float sliceScale = m_uSlices / std::log(m_fFar / m_fNear);
+	auto getSlice = [this, sliceScale](float depth)
+	{
+		return glm::clamp((int32_t)(std::log(depth / m_fNear) * sliceScale), 0, (int32_t)m_uSlices - 1);
+	};
+
+	for (uint32_t i = 0; i < (uint32_t)m_arrLights.size(); ++i)
+	{
+		const LIGHT& light = m_arrLights[i];
+		VIEWLIGHT viewLight;
+		viewLight.position = glm::vec3(view * glm::vec4(light.position, 1.0f));
+		viewLight.radius = light.radius;
+		viewLight.index = i;
+
+		const float depth = -viewLight.position.z;
+		if (depth + light.radius < m_fNear || depth - light.radius > m_fFar || light.intensity <= 0.0f)
+		{
+			continue;
+		}
+		viewLight.sliceMin = getSlice(std::max(depth - light.radius, m_fNear));
+		viewLight.sliceMax = getSlice(std::min(depth + light.radius, m_fFar));
+
+		// screen bounds of the box around the sphere, a sphere crossing the near plane covers the whole screen
+		glm::vec2 ndcMin(-1.0f);
+		glm::vec2 ndcMax(1.0f);
+		if (depth - light.radius > m_fNear && !Frustum::GetSphereRect(projection, viewLight.position, light.radius, ndcMin, ndcMax))
+		{
+			continue;
+		}
+
+		const glm::vec2 tiles((float)m_uTilesX, (float)m_uTilesY);
+		const glm::ivec2 tileMin(glm::clamp(glm::ivec2(glm::floor((ndcMin * 0.5f + 0.5f) * tiles)), glm::ivec2(0), glm::ivec2(tiles) - 1));
+		const glm::ivec2 tileMax(glm::clamp(glm::ivec2(glm::floor((ndcMax * 0.5f + 0.5f) * tiles)), glm::ivec2(0), glm::ivec2(tiles) - 1));
+		viewLight.tileMin[0] = tileMin.x;
+		viewLight.tileMin[1] = tileMin.y;
+		viewLight.tileMax[0] = tileMax.x;
+		viewLight.tileMax[1] = tileMax.y;
+		m_arrViewLights.push_back(viewLight);
+	}
+}
+
+
+void ClusteredLighting::AssignSlices()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_uNextSlice = 0;
+		m_uBusyWorkers = (uint32_t)m_arrWorkers.size();
+		++m_uGeneration;
+	}
+	m_Condition.notify_all();
+
+	uint32_t slice;
+	while ((slice = m_uNextSlice++) < m_uSlices)
+	{
+		AssignSlice(slice);
+	}
+
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_DoneCondition.wait(lock, [this]() { return m_uBusyWorkers == 0; });
+}
+
+
+void ClusteredLighting::AssignSlice(uint32_t slice)
+{
+	SLICE& output = m_arrSlices[slice];
+	for (auto& lights : output.clusterLights)
+	{
+		lights.clear();
+	}
+	output.dropped = 0;
+
+	const AABB* clusters = &m_arrClusters[slice * m_uTilesY * m_uTilesX];
+	for (const auto& light : m_arrViewLights)
+	{
+		if ((int32_t)slice < light.sliceMin || (int32_t)slice > light.sliceMax)
+		{
+			continue;
+		}
+
+		const float radiusSquared = light.radius * light.radius;
+		for (int32_t y = light.tileMin[1]; y <= light.tileMax[1]; ++y)
+		{
+			for (int32_t x = light.tileMin[0]; x <= light.tileMax[0]; ++x)
+			{
+				// sphere against the cluster box
+				const uint32_t tile = y * m_uTilesX + x;
+				const glm::vec3 closest(glm::clamp(light.position, clusters[tile].min, clusters[tile].max));
+				const glm::vec3 delta(closest - light.position);
+				if (glm::dot(delta, delta) > radiusSquared)
+				{
+					continue;
+				}
+
+				auto& lights = output.clusterLights[tile];
+				if (lights.size() < m_uMaxClusterLights)
+				{
+					lights.push_back(light.index);
+				}
+				else
+				{
+					++output.dropped;
+				}
+			}
+		}
+	}
+}
+
+
+void ClusteredLighting::WorkerThread()
+{
+	uint64_t generation = 0;
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Condition.wait(lock, [this, generation]() { return m_bQuit || m_uGeneration != generation; });
+			if (m_bQuit)
+			{
+				return;
+			}
+			generation = m_uGeneration;
+		}
+
+		uint32_t slice;
+		while ((slice = m_uNextSlice++) < m_uSlices)
+		{
+			AssignSlice(slice);
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (--m_uBusyWorkers == 0)
+		{
+			m_DoneCondition.notify_one();
+		}
+	}
+}
+
+
+void ClusteredLighting::Upload()
+{
+	m_arrLightData.resize(std::max(m_arrLights.size(), (size_t)1));
+	for (size_t i = 0; i < m_arrLights.size(); ++i)
+	{
+		const LIGHT& light = m_arrLights[i];
+		m_arrLightData[i].positionRadius = glm::vec4(light.position, light.radius);
+		m_arrLightData[i].color = glm::vec4(light.color * light.intensity, 1.0f);
+	}
+
+	// slices are concatenated in cluster order, tile x fastest
+	m_arrClusterData.resize(m_arrClusters.size() * 2);
+	m_arrIndexData.clear();
+	m_Stats.maxClusterLights = 0;
+	m_Stats.droppedLights = 0;
+	size_t cluster = 0;
+	for (const auto& slice : m_arrSlices)
+	{
+		for (const auto& lights : slice.clusterLights)
+		{
+			m_arrClusterData[cluster * 2] = (GLuint)m_arrIndexData.size();
+			m_arrClusterData[cluster * 2 + 1] = (GLuint)lights.size();
+			m_arrIndexData.insert(m_arrIndexData.end(), lights.begin(), lights.end());
+			m_Stats.maxClusterLights = std::max(m_Stats.maxClusterLights, (uint32_t)lights.size());
+			++cluster;
+		}
+		m_Stats.droppedLights += slice.dropped;
+	}
+	m_Stats.lightIndices = (uint32_t)m_arrIndexData.size();
+	if (m_arrIndexData.empty())
+	{
+		m_arrIndexData.push_back(0);
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_LightBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_arrLightData.size() * sizeof(LIGHTDATA), m_arrLightData.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_ClusterBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_arrClusterData.size() * sizeof(GLuint), m_arrClusterData.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_IndexBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, m_arrIndexData.size() * sizeof(GLuint), m_arrIndexData.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
@@ -0,0 +1,179 @@
+/**
+ * ============================================================================
+ *  Name        : CompressedTexture.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : block compressed texture with a full mip chain, stored in a
+ *                small .btx container file
+ * ============================================================================
+**/
+
+#include "../include/CompressedTexture.h"
+#include "../include/TextureCompressor.h"
+#include "../include/ImageKernels.h"
+#include <algorithm>
+
+
+CompressedTexture::CompressedTexture() :
+	m_eFormat(0),
+	m_iWidth(0),
+	m_iHeight(0)
+{
+}
+
+
+CompressedTexture::~CompressedTexture()
+{
+}
+
+
+void CompressedTexture::Clear()
+{
+	m_eFormat = 0;
+	m_iWidth = 0;
+	m_iHeight = 0;
+	m_arrLevels.clear();
+}
+
+
+bool CompressedTexture::IsFormatSupported(GLenum format)
+{
+	return TextureCompressor::IsSupportedFormat(format) &&
+		OpenGLRenderer::HasExtension("GL_EXT_texture_compression_s3tc");
+}
+
+
+bool CompressedTexture::Create(const uint8_t* rgba, int32_t width, int32_t height, GLenum format, int32_t maxLevel)
+{
+	Clear();
+	if (!TextureCompressor::IsSupportedFormat(format))
+	{
+		return false;
+	}
+
+	m_eFormat = format;
+	m_iWidth = width;
+	m_iHeight = height;
+
+	std::vector<uint8_t> level;
+	std::vector<uint8_t> next;
+	const uint8_t* src = rgba;
+	for (int32_t i = 0; i <= maxLevel; ++i)
+	{
+		m_arrLevels.emplace_back();
+		if (!TextureCompressor::Compress(src, width, height, format, m_arrLevels.back()))
+		{
+			Clear();
+			return false;
+		}
+
+		if (width == 1 && height == 1)
+		{
+			break;
+		}
+
+		ImageKernels::DownsampleBox(src, width, height, next);
+		width = std::max(width >> 1, 1);
+		height = std::max(height >> 1, 1);
+		level.swap(next);
+		src = level.data();
+	}
+	return true;
+}
+
+
+bool CompressedTexture::Load(const std::string_view& filename)
+{
+	Clear();
+
+	std::ifstream f(filename.data(), std::ios::binary);
+	if (!f)
+	{
+		return false;
+	}
+
+	HEADER header;
+	if (!f.read((char*)&header, sizeof(header)) ||
+		header.magic != MAGIC ||
+		!TextureCompressor::IsSupportedFormat(header.format) ||
+		(int32_t)header.width <= 0 ||
+		(int32_t)header.height <= 0 ||
+		!header.levelCount ||
+		header.levelCount > GetMaxLevelCount((int32_t)header.width, (int32_t)header.height))
+	{
+		IApplication::Debug("CompressedTexture: invalid file ");
+		IApplication::Debug(filename.data());
+		return false;
+	}
+
+	m_eFormat = header.format;
+	m_iWidth = (int32_t)header.width;
+	m_iHeight = (int32_t)header.height;
+	m_arrLevels.resize(header.levelCount);
+
+	for (uint32_t i = 0; i < header.levelCount; ++i)
+	{
+		const size_t expected = TextureCompressor::GetCompressedSize(std::max(m_iWidth >> i, 1), std::max(m_iHeight >> i, 1), m_eFormat);
+		uint32_t size = 0;
+		if (!f.read((char*)&size, sizeof(size)) || size != expected)
+		{
+			Clear();
+			return false;
+		}
+
+		m_arrLevels[i].resize(size);
+		if (!f.read((char*)m_arrLevels[i].data(), size))
+		{
+			Clear();
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool CompressedTexture::Save(const std::string_view& filename) const
+{
+	if (IsEmpty())
+	{
+		return false;
+	}
+
+	std::ofstream f(filename.data(), std::ios::binary);
+	if (!f)
+	{
+		return false;
+	}
+
+	const HEADER header = { MAGIC, m_eFormat, (uint32_t)m_iWidth, (uint32_t)m_iHeight, (uint32_t)m_arrLevels.size() };
+	f.write((const char*)&header, sizeof(header));
+	for (const auto& level : m_arrLevels)
+	{
+		const uint32_t size = (uint32_t)level.size();
+		f.write((const char*)&size, sizeof(size));
+		f.write((const char*)level.data(), size);
+	}
+	return (bool)f;
+}
+
+
+uint32_t CompressedTexture::GetMaxLevelCount(int32_t width, int32_t height)
+{
+	// floor(log2(max(width, height))) + 1
+	uint32_t count = 1;
+	for (int32_t size = std::max(width, height); size > 1; size >>= 1)
+	{
+		++count;
+	}
+	return count;
+}
+
+
+size_t CompressedTexture::GetDataSize() const
+{
+	size_t size = 0;
+	for (const auto& level : m_arrLevels)
+	{
+		size += level.size();
+	}
+	return size;
+}
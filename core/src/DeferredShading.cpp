@@ -0,0 +1,472 @@
+/**
+ * ============================================================================
+ *  Name        : DeferredShading.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : deferred shading path
+ * ============================================================================
+**/
+
+#include "../include/DeferredShading.h"
+#include <algorithm>
+#include <cstddef>
+
+
+// G-buffer writer, same inputs as the forward phong shader
+static const char* s_pGeometryVertexShader =
+	"attribute vec3 position;\n"
+	"attribute vec3 normal;\n"
+	"attribute vec2 uv;\n"
+	"uniform mat4 modelViewProjectionMatrix;\n"
+	"uniform mat4 modelMatrix;\n"
+	"varying vec2 outUv;\n"
+	"varying vec3 worldNormal;\n"
+	"void main(void)\n"
+	"{\n"
+	"	outUv = uv;\n"
+	"	worldNormal = (modelMatrix * vec4(normal, 0.0)).xyz;\n"
+	"	gl_Position = modelViewProjectionMatrix * vec4(position, 1.0);\n"
+	"}\n";
+
+static const char* s_pGeometryFragmentShader =
+	"uniform sampler2D texture01;\n"
+	"uniform vec4 materialAmbient;\n"
+	"uniform vec4 materialDiffuse;\n"
+	"uniform vec4 materialSpecular;\n"
+	"uniform vec4 materialEmissive;\n"
+	"uniform float specularPower;\n"
+	"varying vec2 outUv;\n"
+	"varying vec3 worldNormal;\n"
+	"vec2 EncodeNormal(vec3 n)\n"
+	"{\n"
+	"	n /= abs(n.x) + abs(n.y) + abs(n.z);\n"
+	"	vec2 signs = vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);\n"
+	"	vec2 e = n.z >= 0.0 ? n.xy : (1.0 - abs(n.yx)) * signs;\n"
+	"	return e * 0.5 + 0.5;\n"
+	"}\n"
+	"void main(void)\n"
+	"{\n"
+	"	vec4 albedo = texture2D(texture01, outUv) * materialDiffuse;\n"
+	"	float specular = specularPower > 0.9 ? max(max(materialSpecular.r, materialSpecular.g), materialSpecular.b) : 0.0;\n"
+	"	gl_FragData[0] = vec4(albedo.rgb, clamp(specular, 0.0, 1.0));\n"
+	"	gl_FragData[1] = vec4(EncodeNormal(normalize(worldNormal)), log2(max(specularPower, 1.0)) / 10.0, 0.0);\n"
+	"	gl_FragData[2] = materialAmbient + materialEmissive;\n"
+	"}\n";
+
+// one rectangle per light, the light values are the same on all corners
+static const char* s_pLightVertexShader =
+	"attribute vec2 position;\n"
+	"attribute vec4 lightPositionRadius;\n"
+	"attribute vec4 lightColor;\n"
+	"varying vec4 outPositionRadius;\n"
+	"varying vec4 outColor;\n"
+	"void main(void)\n"
+	"{\n"
+	"	outPositionRadius = lightPositionRadius;\n"
+	"	outColor = lightColor;\n"
+	"	gl_Position = vec4(position, 0.0, 1.0);\n"
+	"}\n";
+
+static const char* s_pLightFragmentShader =
+	"uniform sampler2D gbufferAlbedo;\n"
+	"uniform sampler2D gbufferNormal;\n"
+	"uniform sampler2D gbufferDepth;\n"
+	"uniform mat4 inverseProjectionMatrix;\n"
+	"uniform mat3 viewNormalMatrix;\n"
+	"uniform vec2 texelSize;\n"
+	"varying vec4 outPositionRadius;\n"
+	"varying vec4 outColor;\n"
+	"vec3 DecodeNormal(vec2 e)\n"
+	"{\n"
+	"	e = e * 2.0 - 1.0;\n"
+	"	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));\n"
+	"	if (n.z < 0.0)\n"
+	"	{\n"
+	"		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);\n"
+	"	}\n"
+	"	return normalize(n);\n"
+	"}\n"
+	"void main(void)\n"
+	"{\n"
+	"	vec2 uv = gl_FragCoord.xy * texelSize;\n"
+	"	float depth = texture2D(gbufferDepth, uv).r;\n"
+	"	if (depth == 1.0)\n"
+	"	{\n"
+	"		discard;\n"
+	"	}\n"
+	"	vec4 view = inverseProjectionMatrix * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);\n"
+	"	vec3 position = view.xyz / view.w;\n"
+	"	vec3 toLight = outPositionRadius.xyz;\n"
+	"	float falloff = 1.0;\n"
+	"	if (outPositionRadius.w > 0.0)\n"
+	"	{\n"
+	"		toLight -= position;\n"
+	"		float radiusSquared = outPositionRadius.w * outPositionRadius.w;\n"
+	"		float distanceSquared = dot(toLight, toLight);\n"
+	"		if (distanceSquared >= radiusSquared)\n"
+	"		{\n"
+	"			discard;\n"
+	"		}\n"
+	"		falloff = 1.0 - distanceSquared / radiusSquared;\n"
+	"		falloff *= falloff;\n"
+	"		toLight *= inversesqrt(max(distanceSquared, 0.00000001));\n"
+	"	}\n"
+	"	vec4 albedo = texture2D(gbufferAlbedo, uv);\n"
+	"	vec4 normalData = texture2D(gbufferNormal, uv);\n"
+	"	vec3 normal = viewNormalMatrix * DecodeNormal(normalData.xy);\n"
+	"	float diffuse = max(dot(normal, toLight), 0.0) * falloff;\n"
+	"	float specular = pow(max(dot(normalize(-position), reflect(-toLight, normal)), 0.0), exp2(normalData.z * 10.0)) * albedo.a;\n"
+	"	gl_FragColor = vec4(outColor.rgb * (albedo.rgb + specular) * diffuse, 0.0);\n"
+	"}\n";
+
+static const char* s_pResolveVertexShader =
+	"attribute vec2 position;\n"
+	"varying vec2 outUv;\n"
+	"void main(void)\n"
+	"{\n"
+	"	outUv = position * 0.5 + 0.5;\n"
+	"	gl_Position = vec4(position, 0.0, 1.0);\n"
+	"}\n";
+
+static const char* s_pResolveFragmentShader =
+	"uniform sampler2D lighting;\n"
+	"varying vec2 outUv;\n"
+	"void main(void)\n"
+	"{\n"
+	"	gl_FragColor = vec4(texture2D(lighting, outUv).rgb, 1.0);\n"
+	"}\n";
+
+
+DeferredShading::DeferredShading() :
+	m_uGeometryProgram(0),
+	m_uLightProgram(0),
+	m_uResolveProgram(0),
+	m_vSize(0),
+	m_uFramebuffer(0),
+	m_uLightFramebuffer(0),
+	m_uAlbedo(0),
+	m_uNormal(0),
+	m_uLighting(0),
+	m_uDepth(0),
+	m_uLightCount(0)
+{
+}
+
+
+DeferredShading::~DeferredShading()
+{
+	Release();
+}
+
+
+bool DeferredShading::IsSupported()
+{
+	return glDrawBuffers && glGenFramebuffers &&
+		OpenGLRenderer::GetVersion() >= 30;
+}
+
+
+bool DeferredShading::Create(OpenGLRenderer& renderer)
+{
+	Release();
+	if (!IsSupported())
+	{
+		IApplication::Debug("DeferredShading: multiple float render targets not supported\n");
+		return false;
+	}
+
+	m_uGeometryProgram = renderer.CreateProgramFromSource(s_pGeometryVertexShader, s_pGeometryFragmentShader);
+	m_uLightProgram = renderer.CreateProgramFromSource(s_pLightVertexShader, s_pLightFragmentShader);
+	m_uResolveProgram = renderer.CreateProgramFromSource(s_pResolveVertexShader, s_pResolveFragmentShader);
+	if (!m_uGeometryProgram || !m_uLightProgram || !m_uResolveProgram)
+	{
+		Release();
+		return false;
+	}
+	return true;
+}
+
+
+void DeferredShading::Release()
+{
+	ReleaseTargets();
+
+	const GLuint programs[] = { m_uGeometryProgram, m_uLightProgram, m_uResolveProgram };
+	for (GLuint program : programs)
+	{
+		if (program)
+		{
+			glDeleteProgram(program);
+		}
+	}
+	m_uGeometryProgram = 0;
+	m_uLightProgram = 0;
+	m_uResolveProgram = 0;
+}
+
+
+bool DeferredShading::CreateTargets(int32_t width, int32_t height)
+{
+	ReleaseTargets();
+
+	struct TARGET
+	{
+		GLuint*		texture;
+		GLint		internalFormat;
+		GLenum		format;
+		GLenum		type;
+	};
+	const TARGET targets[] =
+	{
+		{ &m_uAlbedo, GL_RGBA8, GL_RGBA, GL_UNSIGNED_BYTE },
+		{ &m_uNormal, GL_RGB10_A2, GL_RGBA, GL_UNSIGNED_INT_2_10_10_10_REV },
+		{ &m_uLighting, GL_RGBA16F, GL_RGBA, GL_HALF_FLOAT },
+		{ &m_uDepth, GL_DEPTH24_STENCIL8, GL_DEPTH_STENCIL, GL_UNSIGNED_INT_24_8 }
+	};
+	for (const auto& target : targets)
+	{
+		glGenTextures(1, target.texture);
+		glBindTexture(GL_TEXTURE_2D, *target.texture);
+		glTexImage2D(GL_TEXTURE_2D, 0, target.internalFormat, width, height, 0, target.format, target.type, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	GLuint framebuffers[2];
+	glGenFramebuffers(2, framebuffers);
+	m_uFramebuffer = framebuffers[0];
+	m_uLightFramebuffer = framebuffers[1];
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_uAlbedo, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT1, GL_TEXTURE_2D, m_uNormal, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT2, GL_TEXTURE_2D, m_uLighting, 0);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_uDepth, 0);
+	const GLenum drawBuffers[3] = { GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2 };
+	glDrawBuffers(3, drawBuffers);
+	bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+	// lights read the depth, it must not be attached while they draw
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uLightFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_uLighting, 0);
+	complete &= glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+	if (!complete)
+	{
+		IApplication::Debug("DeferredShading: incomplete G-buffer\n");
+		ReleaseTargets();
+		return false;
+	}
+
+	m_vSize = glm::ivec2(width, height);
+	return true;
+}
+
+
+void DeferredShading::ReleaseTargets()
+{
+	if (m_uFramebuffer)
+	{
+		const GLuint framebuffers[2] = { m_uFramebuffer, m_uLightFramebuffer };
+		glDeleteFramebuffers(2, framebuffers);
+		m_uFramebuffer = 0;
+		m_uLightFramebuffer = 0;
+	}
+	if (m_uAlbedo)
+	{
+		const GLuint textures[4] = { m_uAlbedo, m_uNormal, m_uLighting, m_uDepth };
+		glDeleteTextures(4, textures);
+		m_uAlbedo = 0;
+		m_uNormal = 0;
+		m_uLighting = 0;
+		m_uDepth = 0;
+	}
+	m_vSize = glm::ivec2(0);
+}
+
+
+bool DeferredShading::BeginGeometryPass(int32_t width, int32_t height, const glm::vec4& clearColor)
+{
+	PROFILE_SCOPE("DeferredShading::BeginGeometryPass");
+
+	if (!m_uGeometryProgram || width <= 0 || height <= 0)
+	{
+		return false;
+	}
+	if (m_vSize != glm::ivec2(width, height) && !CreateTargets(width, height))
+	{
+		return false;
+	}
+
+	// targets the lights do not touch keep the clear color too, they are never read there
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uFramebuffer);
+	glViewport(0, 0, width, height);
+	glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	return true;
+}
+
+
+void DeferredShading::AddLightRect(const glm::vec2& min, const glm::vec2& max, const glm::vec4& positionRadius, const glm::vec4& color)
+{
+	const glm::vec2 corners[6] =
+	{
+		min, glm::vec2(max.x, min.y), max,
+		min, max, glm::vec2(min.x, max.y)
+	};
+	for (const auto& corner : corners)
+	{
+		m_arrLightVertices.push_back({ corner, positionRadius, color });
+	}
+}
+
+
+void DeferredShading::RenderLights(IRenderer& renderer, const glm::vec3& lightDirection, const std::vector<ClusteredLighting::LIGHT>& lights)
+{
+	PROFILE_SCOPE("DeferredShading::RenderLights");
+
+	m_uLightCount = 0;
+	if (!m_uLightFramebuffer)
+	{
+		return;
+	}
+
+	// the last geometry pass draw left its client arrays enabled
+	for (const char* name : { "position", "normal", "uv" })
+	{
+		const GLint location = glGetAttribLocation(m_uGeometryProgram, name);
+		if (location != -1)
+		{
+			glDisableVertexAttribArray(location);
+		}
+	}
+
+	const glm::mat4& view = renderer.GetViewMatrix();
+	const glm::mat4& projection = renderer.GetProjectionMatrix();
+	const glm::vec2 depthRange(Frustum::GetDepthRange(projection));
+	const float nearPlane = depthRange.x;
+	const float farPlane = depthRange.y;
+
+	// directional light covers the screen, point lights cover the projection of their bounds
+	m_arrLightVertices.clear();
+	AddLightRect(glm::vec2(-1.0f), glm::vec2(1.0f), glm::vec4(glm::mat3(view) * -glm::normalize(lightDirection), 0.0f), glm::vec4(1.0f));
+	for (const auto& light : lights)
+	{
+		const glm::vec3 position(view * glm::vec4(light.position, 1.0f));
+		const float depth = -position.z;
+		if (depth + light.radius < nearPlane || depth - light.radius > farPlane || light.intensity <= 0.0f || light.radius <= 0.0f)
+		{
+			continue;
+		}
+
+		glm::vec2 rectMin(-1.0f);
+		glm::vec2 rectMax(1.0f);
+		if (depth - light.radius > nearPlane)
+		{
+			glm::vec2 ndcMin;
+			glm::vec2 ndcMax;
+			if (!Frustum::GetSphereRect(projection, position, light.radius, ndcMin, ndcMax))
+			{
+				continue;
+			}
+			rectMin = glm::max(ndcMin, glm::vec2(-1.0f));
+			rectMax = glm::min(ndcMax, glm::vec2(1.0f));
+		}
+
+		AddLightRect(rectMin, rectMax, glm::vec4(position, light.radius), glm::vec4(light.color * light.intensity, 1.0f));
+		++m_uLightCount;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uLightFramebuffer);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_CULL_FACE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+
+	const GLuint program = m_uLightProgram;
+	glUseProgram(program);
+	renderer.SetTexture(program, m_uAlbedo, 0, "gbufferAlbedo");
+	renderer.SetTexture(program, m_uNormal, 1, "gbufferNormal");
+	renderer.SetTexture(program, m_uDepth, 2, "gbufferDepth");
+	glActiveTexture(GL_TEXTURE0);
+	OpenGLRenderer::SetUniformMatrix4(program, "inverseProjectionMatrix", glm::inverse(projection));
+	OpenGLRenderer::SetUniformMatrix3(program, "viewNormalMatrix", glm::mat3(view));
+	const GLint texelSize = glGetUniformLocation(program, "texelSize");
+	glUniform2f(texelSize, 1.0f / m_vSize.x, 1.0f / m_vSize.y);
+
+	// all lights in one draw from client memory
+	const GLint attribs[3] =
+	{
+		glGetAttribLocation(program, "position"),
+		glGetAttribLocation(program, "lightPositionRadius"),
+		glGetAttribLocation(program, "lightColor")
+	};
+	const uint8_t* vertices = (const uint8_t*)m_arrLightVertices.data();
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glEnableVertexAttribArray(attribs[0]);
+	glEnableVertexAttribArray(attribs[1]);
+	glEnableVertexAttribArray(attribs[2]);
+	glVertexAttribPointer(attribs[0], 2, GL_FLOAT, GL_FALSE, sizeof(LIGHTVERTEX), vertices + offsetof(LIGHTVERTEX, position));
+	glVertexAttribPointer(attribs[1], 4, GL_FLOAT, GL_FALSE, sizeof(LIGHTVERTEX), vertices + offsetof(LIGHTVERTEX, positionRadius));
+	glVertexAttribPointer(attribs[2], 4, GL_FLOAT, GL_FALSE, sizeof(LIGHTVERTEX), vertices + offsetof(LIGHTVERTEX, color));
+	glDrawArrays(GL_TRIANGLES, 0, (GLsizei)m_arrLightVertices.size());
+	glDisableVertexAttribArray(attribs[0]);
+	glDisableVertexAttribArray(attribs[1]);
+	glDisableVertexAttribArray(attribs[2]);
+
+	glDisable(GL_BLEND);
+	glEnable(GL_CULL_FACE);
+	glEnable(GL_DEPTH_TEST);
+}
+
+
+void DeferredShading::CopyDepth(OpenGLRenderer& renderer)
+{
+	PROFILE_SCOPE("DeferredShading::CopyDepth");
+
+	const GLuint framebuffer = renderer.GetDefaultFramebuffer();
+	if (!m_uFramebuffer || !framebuffer)
+	{
+		return;
+	}
+
+	// same format as the depth stencil buffers of the scene targets, a multisampled target gets the value in every sample
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_uFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+	glBlitFramebuffer(0, 0, m_vSize.x, m_vSize.y, 0, 0, m_vSize.x, m_vSize.y, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+
+void DeferredShading::Resolve(OpenGLRenderer& renderer)
+{
+	PROFILE_SCOPE("DeferredShading::Resolve");
+
+	glBindFramebuffer(GL_FRAMEBUFFER, renderer.GetDefaultFramebuffer());
+	if (!m_uLighting)
+	{
+		return;
+	}
+
+	// drawn instead of blitted, the default framebuffer may be multisampled
+	glViewport(0, 0, m_vSize.x, m_vSize.y);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_CULL_FACE);
+
+	const GLuint program = m_uResolveProgram;
+	glUseProgram(program);
+	renderer.SetTexture(program, m_uLighting, 0, "lighting");
+
+	static const float triangle[6] = { -1.0f, -1.0f, 3.0f, -1.0f, -1.0f, 3.0f };
+	const GLint position = glGetAttribLocation(program, "position");
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glEnableVertexAttribArray(position);
+	glVertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, 0, triangle);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glDisableVertexAttribArray(position);
+
+	glEnable(GL_CULL_FACE);
+	glEnable(GL_DEPTH_TEST);
+}
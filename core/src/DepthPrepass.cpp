@@ -0,0 +1,349 @@
+/**
+ * ============================================================================
+ *  Name        : DepthPrepass.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : optional depth only pre-pass for opaque draws
+ * ============================================================================
+**/
+
+#include "../include/DepthPrepass.h"
+#include "../include/Geometry.h"
+#include "../include/MultiDrawIndirect.h"
+#include <algorithm>
+
+
+// per draw path, position is computed exactly as in the shaders drawn with DrawQueue::DrawImmediate.
+// Invariance keeps the depth of both passes bit exact for the GL_EQUAL test, phongshader.vert declares it too
+static const char* s_pDepthVertexShader =
+	"#version 120\n"
+	"attribute vec3 position;\n"
+	"uniform mat4 modelViewProjectionMatrix;\n"
+	"invariant gl_Position;\n"
+	"void main(void)\n"
+	"{\n"
+	"	gl_Position = modelViewProjectionMatrix * vec4(position, 1.0);\n"
+	"}\n";
+
+static const char* s_pDepthFragmentShader =
+	"void main(void)\n"
+	"{\n"
+	"	gl_FragColor = vec4(1.0);\n"
+	"}\n";
+
+// multi draw path, must match the position of phongshader_mdi.vert
+static const char* s_pMultiDrawDepthVertexShader =
+	"#version 430\n"
+	"#extension GL_ARB_shader_draw_parameters : require\n"
+	"struct DrawData\n"
+	"{\n"
+	"	mat4 modelMatrix;\n"
+	"	vec4 materialAmbient;\n"
+	"	vec4 materialDiffuse;\n"
+	"	vec4 materialSpecular;\n"
+	"	vec4 materialEmissive;\n"
+	"	vec4 materialParams;\n"
+	"};\n"
+	"layout(std430, binding = 0) readonly buffer DrawDataBuffer\n"
+	"{\n"
+	"	DrawData draws[];\n"
+	"};\n"
+	"in vec3 position;\n"
+	"uniform mat4 viewProjectionMatrix;\n"
+	"uniform int drawOffset;\n"
+	"invariant gl_Position;\n"
+	"void main(void)\n"
+	"{\n"
+	"	mat4 modelMatrix = draws[drawOffset + gl_DrawIDARB].modelMatrix;\n"
+	"	vec4 worldPosition = modelMatrix * vec4(position, 1.0);\n"
+	"	gl_Position = viewProjectionMatrix * worldPosition;\n"
+	"}\n";
+
+static const char* s_pMultiDrawDepthFragmentShader =
+	"#version 430\n"
+	"void main(void)\n"
+	"{\n"
+	"}\n";
+
+// frames the sample queries are kept before reading them
+static constexpr uint32_t FRAME_LATENCY = 3;
+
+
+DepthPrepass::DepthPrepass() :
+	m_bEnabled(true),
+	m_bDepthWritten(false),
+	m_uProgram(0),
+	m_iPositionAttrib(-1),
+	m_iMatrixUniform(-1),
+	m_uMultiDrawProgram(0),
+	m_uFrame(0),
+	m_Stats()
+{
+}
+
+
+DepthPrepass::~DepthPrepass()
+{
+	Release();
+}
+
+
+bool DepthPrepass::IsSupported()
+{
+	return glGenQueries &&
+		glBeginQuery &&
+		glEndQuery &&
+		glGetQueryObjectiv &&
+		glGetQueryObjectuiv;
+}
+
+
+bool DepthPrepass::Create(OpenGLRenderer& renderer, bool multiDraw)
+{
+	Release();
+
+	m_uProgram = renderer.CreateProgramFromSource(s_pDepthVertexShader, s_pDepthFragmentShader);
+	if (!m_uProgram)
+	{
+		return false;
+	}
+	m_iPositionAttrib = glGetAttribLocation(m_uProgram, "position");
+	m_iMatrixUniform = glGetUniformLocation(m_uProgram, "modelViewProjectionMatrix");
+
+	if (multiDraw)
+	{
+		m_uMultiDrawProgram = renderer.CreateProgramFromSource(s_pMultiDrawDepthVertexShader, s_pMultiDrawDepthFragmentShader);
+		if (!m_uMultiDrawProgram)
+		{
+			IApplication::Debug("DepthPrepass: multi draw program failed, using per draw path\n");
+		}
+	}
+
+	// statistics are optional
+	if (IsSupported())
+	{
+		m_arrFrames.resize(FRAME_LATENCY);
+		for (auto& frame : m_arrFrames)
+		{
+			frame = {};
+			glGenQueries(2, frame.queries);
+		}
+	}
+	else
+	{
+		IApplication::Debug("DepthPrepass: occlusion queries not supported, no statistics\n");
+	}
+	return true;
+}
+
+
+void DepthPrepass::Release()
+{
+	for (auto& frame : m_arrFrames)
+	{
+		glDeleteQueries(2, frame.queries);
+	}
+	m_arrFrames.clear();
+
+	for (auto& it : m_mapPositions)
+	{
+		glDeleteBuffers(1, &it.second.buffer);
+	}
+	m_mapPositions.clear();
+
+	if (m_uProgram)
+	{
+		glDeleteProgram(m_uProgram);
+		m_uProgram = 0;
+	}
+	if (m_uMultiDrawProgram)
+	{
+		glDeleteProgram(m_uMultiDrawProgram);
+		m_uMultiDrawProgram = 0;
+	}
+	m_iPositionAttrib = -1;
+	m_iMatrixUniform = -1;
+	m_bDepthWritten = false;
+	m_uFrame = 0;
+	m_Stats = {};
+}
+
+
+GLuint DepthPrepass::GetPositionBuffer(const std::shared_ptr<Geometry>& geometry)
+{
+	auto it = m_mapPositions.find(geometry.get());
+	if (it != m_mapPositions.end())
+	{
+		it->second.used = true;
+		return it->second.buffer;
+	}
+
+	// 12 bytes per vertex instead of 32, indices are shared with the geometry
+	std::vector<glm::vec3> positions(geometry->GetVertexCount());
+	const Geometry::VERTEX* vertices = geometry->GetData();
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		positions[i] = glm::vec3(vertices[i].x, vertices[i].y, vertices[i].z);
+	}
+
+	POSITIONS data = { geometry, 0, true };
+	glGenBuffers(1, &data.buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, data.buffer);
+	glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+	return m_mapPositions.emplace(geometry.get(), data).first->second.buffer;
+}
+
+
+void DepthPrepass::EvictPositionBuffers()
+{
+	// geometry that was not drawn this frame has left the scene or moved to the multi draw path
+	for (auto it = m_mapPositions.begin(); it != m_mapPositions.end();)
+	{
+		if (it->second.used)
+		{
+			it->second.used = false;
+			++it;
+		}
+		else
+		{
+			glDeleteBuffers(1, &it->second.buffer);
+			it = m_mapPositions.erase(it);
+		}
+	}
+}
+
+
+void DepthPrepass::Render(IRenderer& renderer, const DrawQueue& queue, MultiDrawIndirect* multiDraw)
+{
+	PROFILE_SCOPE("DepthPrepass::Render");
+
+	// the slot is reused, read its results if the gpu has finished them
+	FRAME* frame = nullptr;
+	if (!m_arrFrames.empty())
+	{
+		frame = &m_arrFrames[m_uFrame++ % m_arrFrames.size()];
+		if (frame->pending)
+		{
+			Collect(*frame);
+		}
+
+		GLint viewport[4] = { 0, 0, 0, 0 };
+		GLint samples = 0;
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		glGetIntegerv(GL_SAMPLES, &samples);
+		frame->screenSamples = (uint64_t)viewport[2] * (uint64_t)viewport[3] * (uint64_t)std::max(samples, 1);
+		frame->draws = 0;
+		frame->prepass = false;
+		frame->pending = false;
+	}
+
+	m_bDepthWritten = false;
+	if (!m_bEnabled || queue.IsEmpty() || !m_uProgram)
+	{
+		return;
+	}
+
+	if (frame)
+	{
+		glBeginQuery(GL_SAMPLES_PASSED, frame->queries[0]);
+		frame->prepass = true;
+		frame->draws = (uint32_t)queue.GetCount();
+	}
+
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_TRUE);
+	glDepthFunc(GL_LEQUAL);
+
+	if (multiDraw && multiDraw->IsEnabled() && m_uMultiDrawProgram)
+	{
+		// shared position stream of the multi draw buffers, selected by the missing normal and uv
+		glUseProgram(m_uMultiDrawProgram);
+		multiDraw->Submit(renderer, queue, m_uMultiDrawProgram);
+	}
+	else
+	{
+		// same matrix product as DrawImmediate, GL_EQUAL needs bit exact depth
+		const glm::mat4 viewProjection(renderer.GetProjectionMatrix() * renderer.GetViewMatrix());
+
+		glUseProgram(m_uProgram);
+		glEnableVertexAttribArray(m_iPositionAttrib);
+		for (const auto& draw : queue.GetDraws())
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, GetPositionBuffer(draw.geometry));
+			glVertexAttribPointer(m_iPositionAttrib, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (const void*)0);
+
+			const glm::mat4 modelViewProjectionMatrix(viewProjection * draw.worldMatrix);
+			glUniformMatrix4fv(m_iMatrixUniform, 1, GL_FALSE, &modelViewProjectionMatrix[0][0]);
+			draw.geometry->Draw(renderer);
+		}
+
+		// rest of the engine uses client side vertex arrays
+		glDisableVertexAttribArray(m_iPositionAttrib);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	}
+	EvictPositionBuffers();
+
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	if (frame)
+	{
+		glEndQuery(GL_SAMPLES_PASSED);
+	}
+	m_bDepthWritten = true;
+}
+
+
+void DepthPrepass::BeginMainPass()
+{
+	if (m_bDepthWritten)
+	{
+		// only the nearest fragment of each sample passes, depth is final already
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+	}
+
+	if (!m_arrFrames.empty() && m_uFrame)
+	{
+		FRAME& frame = m_arrFrames[(m_uFrame - 1) % m_arrFrames.size()];
+		glBeginQuery(GL_SAMPLES_PASSED, frame.queries[1]);
+		frame.pending = true;
+	}
+}
+
+
+void DepthPrepass::EndMainPass()
+{
+	if (!m_arrFrames.empty() && m_uFrame)
+	{
+		glEndQuery(GL_SAMPLES_PASSED);
+	}
+
+	glDepthFunc(GL_LEQUAL);
+	glDepthMask(GL_TRUE);
+}
+
+
+void DepthPrepass::Collect(FRAME& frame)
+{
+	// main pass query is issued last, a frame that is not done yet is skipped instead of waited for
+	GLint available = 0;
+	glGetQueryObjectiv(frame.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+	{
+		return;
+	}
+
+	GLuint depthSamples = 0;
+	GLuint shadedSamples = 0;
+	if (frame.prepass)
+	{
+		glGetQueryObjectuiv(frame.queries[0], GL_QUERY_RESULT, &depthSamples);
+	}
+	glGetQueryObjectuiv(frame.queries[1], GL_QUERY_RESULT, &shadedSamples);
+
+	m_Stats.draws = frame.draws;
+	m_Stats.depthSamples = depthSamples;
+	m_Stats.shadedSamples = shadedSamples;
+	m_Stats.screenSamples = frame.screenSamples;
+	m_Stats.overdraw = frame.prepass && shadedSamples ? (float)depthSamples / (float)shadedSamples : 0.0f;
+	m_Stats.shadedPerSample = frame.screenSamples ? (float)shadedSamples / (float)frame.screenSamples : 0.0f;
+}
@@ -0,0 +1,69 @@
+/**
+ * ============================================================================
+ *  Name        : DrawQueue.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : list of recorded draws for deferred submission
+ * ============================================================================
+**/
+
+#include "../include/DrawQueue.h"
+#include "../include/Geometry.h"
+#include "../include/Material.h"
+#include <algorithm>
+
+
+void DrawQueue::Add(const std::shared_ptr<Geometry>& geometry, const Material* material, const glm::mat4& worldMatrix)
+{
+	m_arrDraws.push_back({ geometry, material, worldMatrix, worldMatrix });
+}
+
+
+void DrawQueue::Add(const std::shared_ptr<Geometry>& geometry, const Material* material, const glm::mat4& worldMatrix, const glm::mat4& previousWorldMatrix)
+{
+	m_arrDraws.push_back({ geometry, material, worldMatrix, previousWorldMatrix });
+}
+
+
+void DrawQueue::DrawImmediate(IRenderer& renderer, GLuint program, const DRAW& draw)
+{
+	draw.geometry->SetAttribs(program);
+
+	// set model matrix to shader uniform
+	OpenGLRenderer::SetUniformMatrix4(program, "modelMatrix", draw.worldMatrix);
+
+	// set model-view-projection matrix to shader uniform
+	const glm::mat4 modelViewProjectionMatrix(renderer.GetProjectionMatrix() * renderer.GetViewMatrix() * draw.worldMatrix);
+	OpenGLRenderer::SetUniformMatrix4(program, "modelViewProjectionMatrix", modelViewProjectionMatrix);
+
+	if (draw.material)
+	{
+		draw.material->SetToProgram(program);
+	}
+
+	draw.geometry->Draw(renderer);
+}
+
+
+void DrawQueue::SortFrontToBack(const glm::mat4& viewMatrix)
+{
+	// view space looks down -z, the key grows with the distance
+	m_arrSortKeys.resize(m_arrDraws.size());
+	for (size_t i = 0; i < m_arrDraws.size(); ++i)
+	{
+		const DRAW& draw = m_arrDraws[i];
+		const glm::vec3 center((draw.geometry->GetBoundsMin() + draw.geometry->GetBoundsMax()) * 0.5f);
+		const glm::vec4 viewPosition(viewMatrix * (draw.worldMatrix * glm::vec4(center, 1.0f)));
+		m_arrSortKeys[i] = { -viewPosition.z, (uint32_t)i };
+	}
+
+	// keys are sorted instead of the draws, equal depths keep their recorded order
+	std::stable_sort(m_arrSortKeys.begin(), m_arrSortKeys.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+	m_arrSorted.clear();
+	m_arrSorted.reserve(m_arrDraws.size());
+	for (const auto& key : m_arrSortKeys)
+	{
+		m_arrSorted.push_back(std::move(m_arrDraws[key.second]));
+	}
+	m_arrDraws.swap(m_arrSorted);
+}
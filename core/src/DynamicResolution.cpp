@@ -0,0 +1,374 @@
+/**
+ * ============================================================================
+ *  Name        : DynamicResolution.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : offscreen scene target scaled by gpu frame time feedback
+ * ============================================================================
+**/
+
+#include "../include/DynamicResolution.h"
+#include "../include/GpuProfiler.h"
+#include "../include/TemporalUpscaler.h"
+#include "../include/Timer.h"
+#include <algorithm>
+#include <cmath>
+
+
+static const char* s_pUpscaleVertexShader =
+	"attribute vec2 position;\n"
+	"uniform vec2 uvScale;\n"
+	"varying vec2 outUv;\n"
+	"void main(void)\n"
+	"{\n"
+	"	outUv = (position * 0.5 + 0.5) * uvScale;\n"
+	"	gl_Position = vec4(position, 0.0, 1.0);\n"
+	"}\n";
+
+// texels outside the rendered area hold older frames, the filter must not reach them
+static const char* s_pUpscaleFragmentShader =
+	"uniform sampler2D scene;\n"
+	"uniform vec2 uvMax;\n"
+	"varying vec2 outUv;\n"
+	"void main(void)\n"
+	"{\n"
+	"	gl_FragColor = vec4(texture2D(scene, min(outUv, uvMax)).rgb, 1.0);\n"
+	"}\n";
+
+// frames the timestamps are kept before reading them
+static constexpr uint32_t FRAME_LATENCY = 3;
+
+
+DynamicResolution::DynamicResolution() :
+	m_uProgram(0),
+	m_vWindowSize(0),
+	m_vTargetSize(0),
+	m_vRenderSize(0),
+	m_uFramebuffer(0),
+	m_uColor(0),
+	m_uDepth(0),
+	m_fScale(1.0f),
+	m_fFrameMilliseconds(0.0f),
+	m_uSettle(0),
+	m_uFrame(0),
+	m_uLastTicks(0)
+{
+}
+
+
+DynamicResolution::~DynamicResolution()
+{
+	Release();
+}
+
+
+bool DynamicResolution::IsSupported()
+{
+	return glGenFramebuffers && glGenRenderbuffers &&
+		(OpenGLRenderer::GetVersion() >= 30 || OpenGLRenderer::HasExtension("GL_ARB_framebuffer_object"));
+}
+
+
+bool DynamicResolution::Create(OpenGLRenderer& renderer, const SETTINGS& settings)
+{
+	Release();
+	if (!IsSupported())
+	{
+		IApplication::Debug("DynamicResolution: framebuffer objects not supported\n");
+		return false;
+	}
+
+	m_uProgram = renderer.CreateProgramFromSource(s_pUpscaleVertexShader, s_pUpscaleFragmentShader);
+	if (!m_uProgram)
+	{
+		return false;
+	}
+
+	SetSettings(settings);
+	m_fScale = m_Settings.maxScale;
+
+	// gpu time when timestamps are available, the frame may wait for vsync on the cpu
+	if (GpuProfiler::IsSupported())
+	{
+		m_arrFrames.resize(FRAME_LATENCY);
+		for (auto& frame : m_arrFrames)
+		{
+			glGenQueries(2, frame.queries);
+			frame.pending = false;
+		}
+	}
+	return true;
+}
+
+
+void DynamicResolution::Release()
+{
+	m_pTemporalUpscaler = nullptr;
+	ReleaseTarget();
+	for (auto& frame : m_arrFrames)
+	{
+		glDeleteQueries(2, frame.queries);
+	}
+	m_arrFrames.clear();
+
+	if (m_uProgram)
+	{
+		glDeleteProgram(m_uProgram);
+		m_uProgram = 0;
+	}
+	m_vWindowSize = glm::ivec2(0);
+	m_vRenderSize = glm::ivec2(0);
+	m_fFrameMilliseconds = 0.0f;
+	m_uSettle = 0;
+	m_uFrame = 0;
+	m_uLastTicks = 0;
+}
+
+
+void DynamicResolution::SetSettings(const SETTINGS& settings)
+{
+	const float maxScale = m_Settings.maxScale;
+	m_Settings = settings;
+	m_Settings.minScale = glm::clamp(m_Settings.minScale, 0.1f, 2.0f);
+	m_Settings.maxScale = glm::clamp(m_Settings.maxScale, m_Settings.minScale, 2.0f);
+	m_Settings.headroom = glm::clamp(m_Settings.headroom, 0.1f, 1.0f);
+	m_fScale = glm::clamp(m_fScale, m_Settings.minScale, m_Settings.maxScale);
+
+	// target size depends on the largest scale
+	if (m_Settings.maxScale != maxScale)
+	{
+		m_vWindowSize = glm::ivec2(0);
+	}
+}
+
+
+bool DynamicResolution::SetTemporalUpscaling(OpenGLRenderer& renderer, bool enabled)
+{
+	if (!enabled)
+	{
+		m_pTemporalUpscaler = nullptr;
+		return false;
+	}
+	if (!m_pTemporalUpscaler)
+	{
+		m_pTemporalUpscaler = std::make_unique<TemporalUpscaler>();
+		if (!m_pTemporalUpscaler->Create(renderer))
+		{
+			m_pTemporalUpscaler = nullptr;
+			return false;
+		}
+	}
+	return true;
+}
+
+
+bool DynamicResolution::CreateTarget(int32_t width, int32_t height)
+{
+	ReleaseTarget();
+
+	glGenTextures(1, &m_uColor);
+	glBindTexture(GL_TEXTURE_2D, m_uColor);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenRenderbuffers(1, &m_uDepth);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_uDepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_uFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_uColor, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_uDepth);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_uDepth);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		IApplication::Debug("DynamicResolution: framebuffer is incomplete\n");
+		ReleaseTarget();
+		return false;
+	}
+
+	m_vTargetSize = glm::ivec2(width, height);
+	return true;
+}
+
+
+void DynamicResolution::ReleaseTarget()
+{
+	if (m_uFramebuffer)
+	{
+		glDeleteFramebuffers(1, &m_uFramebuffer);
+		m_uFramebuffer = 0;
+	}
+	if (m_uDepth)
+	{
+		glDeleteRenderbuffers(1, &m_uDepth);
+		m_uDepth = 0;
+	}
+	if (m_uColor)
+	{
+		glDeleteTextures(1, &m_uColor);
+		m_uColor = 0;
+	}
+	m_vTargetSize = glm::ivec2(0);
+}
+
+
+void DynamicResolution::BeginFrame(int32_t width, int32_t height)
+{
+	PROFILE_SCOPE("DynamicResolution::BeginFrame");
+
+	Measure();
+
+	// window resize is the only reallocation, the target fits the largest scale
+	width = std::max(width, 1);
+	height = std::max(height, 1);
+	if (m_vWindowSize != glm::ivec2(width, height))
+	{
+		m_vWindowSize = glm::ivec2(width, height);
+		CreateTarget(std::max((int32_t)std::ceil(width * m_Settings.maxScale), 1),
+			std::max((int32_t)std::ceil(height * m_Settings.maxScale), 1));
+	}
+
+	m_vRenderSize = glm::clamp(glm::ivec2(glm::vec2(m_vWindowSize) * m_fScale + 0.5f), glm::ivec2(1), glm::max(m_vTargetSize, glm::ivec2(1)));
+	if (m_pTemporalUpscaler)
+	{
+		m_pTemporalUpscaler->BeginFrame(m_uDepth, m_vTargetSize, m_vRenderSize, m_vWindowSize);
+	}
+
+	if (!m_arrFrames.empty())
+	{
+		FRAME& frame = m_arrFrames[m_uFrame % m_arrFrames.size()];
+		glQueryCounter(frame.queries[0], GL_TIMESTAMP);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uFramebuffer);
+	glViewport(0, 0, m_vRenderSize.x, m_vRenderSize.y);
+}
+
+
+void DynamicResolution::Present(OpenGLRenderer& renderer, GLuint framebuffer)
+{
+	PROFILE_SCOPE("DynamicResolution::Present");
+
+	if (m_uColor)
+	{
+		// the resolved history is already at window resolution
+		const GLuint history = m_pTemporalUpscaler ? m_pTemporalUpscaler->Resolve(renderer, m_uColor) : 0;
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glViewport(0, 0, m_vWindowSize.x, m_vWindowSize.y);
+		if (history)
+		{
+			Draw(renderer, history, glm::vec2(1.0f), glm::vec2(1.0f));
+		}
+		else
+		{
+			const glm::vec2 targetSize(m_vTargetSize);
+			Draw(renderer, m_uColor, glm::vec2(m_vRenderSize) / targetSize, (glm::vec2(m_vRenderSize) - 0.5f) / targetSize);
+		}
+	}
+	else
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glViewport(0, 0, m_vWindowSize.x, m_vWindowSize.y);
+	}
+
+	if (!m_arrFrames.empty())
+	{
+		FRAME& frame = m_arrFrames[m_uFrame % m_arrFrames.size()];
+		glQueryCounter(frame.queries[1], GL_TIMESTAMP);
+		frame.pending = true;
+	}
+	++m_uFrame;
+}
+
+
+void DynamicResolution::Draw(OpenGLRenderer& renderer, GLuint texture, const glm::vec2& uvScale, const glm::vec2& uvMax)
+{
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_CULL_FACE);
+
+	const GLuint program = m_uProgram;
+	glUseProgram(program);
+	renderer.SetTexture(program, texture, 0, "scene");
+	OpenGLRenderer::SetUniformVec2(program, "uvScale", uvScale);
+	OpenGLRenderer::SetUniformVec2(program, "uvMax", uvMax);
+
+	static const float triangle[6] = { -1.0f, -1.0f, 3.0f, -1.0f, -1.0f, 3.0f };
+	const GLint position = glGetAttribLocation(program, "position");
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glEnableVertexAttribArray(position);
+	glVertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, 0, triangle);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glDisableVertexAttribArray(position);
+
+	glEnable(GL_CULL_FACE);
+	glEnable(GL_DEPTH_TEST);
+}
+
+
+void DynamicResolution::Measure()
+{
+	if (m_arrFrames.empty())
+	{
+		// cpu time from frame to frame
+		const uint64_t ticks = Timer::GetTicks();
+		if (m_uLastTicks)
+		{
+			UpdateScale((float)((ticks - m_uLastTicks) * Timer::GetSecondsPerTick() * 1000.0));
+		}
+		m_uLastTicks = ticks;
+		return;
+	}
+
+	// the slot is reused, read it if the gpu has finished it, never wait
+	FRAME& frame = m_arrFrames[m_uFrame % m_arrFrames.size()];
+	if (!frame.pending)
+	{
+		return;
+	}
+	frame.pending = false;
+
+	GLint available = 0;
+	glGetQueryObjectiv(frame.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (available)
+	{
+		GLuint64 begin = 0;
+		GLuint64 end = 0;
+		glGetQueryObjectui64v(frame.queries[0], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(frame.queries[1], GL_QUERY_RESULT, &end);
+		UpdateScale(end > begin ? (float)((end - begin) / 1000000.0) : 0.0f);
+	}
+}
+
+
+void DynamicResolution::UpdateScale(float milliseconds)
+{
+	m_fFrameMilliseconds = m_fFrameMilliseconds > 0.0f ? glm::mix(m_fFrameMilliseconds, milliseconds, 0.25f) : milliseconds;
+	if (m_uSettle)
+	{
+		--m_uSettle;
+		return;
+	}
+
+	// no change inside the band between the headroom and the budget
+	const float target = m_Settings.targetMilliseconds;
+	const float low = target * m_Settings.headroom;
+	if (m_fFrameMilliseconds <= 0.0f || (m_fFrameMilliseconds <= target && m_fFrameMilliseconds >= low))
+	{
+		return;
+	}
+
+	// fragment cost follows the pixel count, aim at the middle of the band
+	const float desired = m_fScale * std::sqrt((target + low) * 0.5f / m_fFrameMilliseconds);
+	const float scale = glm::clamp(glm::clamp(desired, m_fScale - m_Settings.maxStep, m_fScale + m_Settings.maxStep),
+		m_Settings.minScale, m_Settings.maxScale);
+	if (std::fabs(scale - m_fScale) > 0.005f)
+	{
+		m_fScale = scale;
+		m_uSettle = m_Settings.settleFrames;
+	}
+}
@@ -0,0 +1,110 @@
+/**
+ * ============================================================================
+ *  Name        : FramePacer.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : limits how many frames the cpu may queue ahead of the gpu
+ * ============================================================================
+**/
+
+#include "../include/FramePacer.h"
+
+
+FramePacer::FramePacer() :
+	m_Stats()
+{
+}
+
+
+FramePacer::~FramePacer()
+{
+	Release();
+}
+
+
+bool FramePacer::IsSupported()
+{
+	return glFenceSync && glClientWaitSync && glDeleteSync;
+}
+
+
+bool FramePacer::Create(const SETTINGS& settings)
+{
+	Release();
+	if (!IsSupported())
+	{
+		IApplication::Debug("FramePacer: sync objects not supported\n");
+		return false;
+	}
+
+	SetSettings(settings);
+	m_Stats = STATS();
+	return true;
+}
+
+
+void FramePacer::Release()
+{
+	for (GLsync fence : m_arrFences)
+	{
+		glDeleteSync(fence);
+	}
+	m_arrFences.clear();
+}
+
+
+void FramePacer::LateLatch()
+{
+	if (m_Settings.lateLatch && m_fnLateLatch)
+	{
+		PROFILE_SCOPE("FramePacer::LateLatch");
+		m_fnLateLatch();
+	}
+}
+
+
+void FramePacer::EndFrame()
+{
+	if (IsSupported())
+	{
+		m_arrFences.push_back(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+	}
+}
+
+
+void FramePacer::Wait()
+{
+	PROFILE_SCOPE("FramePacer::Wait");
+
+	// frames the gpu has already finished do not count
+	while (!m_arrFences.empty() && glClientWaitSync(m_arrFences.front(), 0, 0) != GL_TIMEOUT_EXPIRED)
+	{
+		glDeleteSync(m_arrFences.front());
+		m_arrFences.pop_front();
+	}
+
+	float wait = 0.0f;
+	if (m_arrFences.size() >= m_Settings.maxFramesInFlight)
+	{
+		// block on the oldest frames until there is room for the next one
+		const uint64_t start = Timer::GetTicks();
+		while (m_arrFences.size() >= m_Settings.maxFramesInFlight)
+		{
+			GLsync fence = m_arrFences.front();
+			GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			while (result == GL_TIMEOUT_EXPIRED)
+			{
+				result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+			}
+			glDeleteSync(fence);
+			m_arrFences.pop_front();
+		}
+		wait = (float)((double)(Timer::GetTicks() - start) * Timer::GetSecondsPerTick());
+	}
+
+	m_Stats.waitLastFrame = wait;
+	m_Stats.waitAverage = m_Stats.frames ? glm::mix(m_Stats.waitAverage, wait, 0.05f) : wait;
+	m_Stats.waitMax = std::max(m_Stats.waitMax, wait);
+	m_Stats.waitTotal += wait;
+	m_Stats.framesInFlight = (uint32_t)m_arrFences.size();
+	++m_Stats.frames;
+}
@@ -0,0 +1,177 @@
+/**
+ * ============================================================================
+ *  Name        : Fxaa.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : single pass post-process anti-aliasing in the style of FXAA
+ * ============================================================================
+**/
+
+#include "../include/Fxaa.h"
+
+
+static const char* s_pFragmentShader =
+	"uniform sampler2D source;\n"
+	"uniform vec2 sourceScale;\n"
+	"uniform vec2 sourceMax;\n"
+	"uniform vec2 sourceTexel;\n"
+	"uniform float contrastThreshold;\n"
+	"uniform float relativeThreshold;\n"
+	"uniform float subpixelBlending;\n"
+	"varying vec2 outUv;\n"
+	"float Luma(vec2 uv)\n"
+	"{\n"
+	"	return dot(texture2D(source, clamp(uv, vec2(0.0), sourceMax)).rgb, vec3(0.299, 0.587, 0.114));\n"
+	"}\n"
+	"void main(void)\n"
+	"{\n"
+	"	vec2 uv = outUv * sourceScale;\n"
+	"	vec2 t = sourceTexel;\n"
+	"	vec3 center = texture2D(source, min(uv, sourceMax)).rgb;\n"
+	"	float m = dot(center, vec3(0.299, 0.587, 0.114));\n"
+	"	float n = Luma(uv + vec2(0.0, t.y));\n"
+	"	float s = Luma(uv - vec2(0.0, t.y));\n"
+	"	float e = Luma(uv + vec2(t.x, 0.0));\n"
+	"	float w = Luma(uv - vec2(t.x, 0.0));\n"
+	"	float highest = max(max(max(n, s), max(e, w)), m);\n"
+	"	float lowest = min(min(min(n, s), min(e, w)), m);\n"
+	"	float contrast = highest - lowest;\n"
+	"	if (contrast < max(contrastThreshold, relativeThreshold * highest))\n"
+	"	{\n"
+	"		gl_FragColor = vec4(center, 1.0);\n"
+	"		return;\n"
+	"	}\n"
+	"	float ne = Luma(uv + t);\n"
+	"	float nw = Luma(uv + vec2(-t.x, t.y));\n"
+	"	float se = Luma(uv + vec2(t.x, -t.y));\n"
+	"	float sw = Luma(uv - t);\n"
+
+	// single pixel features are blurred by their contrast to the neighbourhood average
+	"	float average = (2.0 * (n + s + e + w) + ne + nw + se + sw) / 12.0;\n"
+	"	float subpixel = smoothstep(0.0, 1.0, clamp(abs(average - m) / contrast, 0.0, 1.0));\n"
+	"	float subpixelBlend = subpixel * subpixel * subpixelBlending;\n"
+
+	// blend across the edge, towards the neighbour with the larger gradient
+	"	float horizontal = 2.0 * abs(n + s - 2.0 * m) + abs(ne + se - 2.0 * e) + abs(nw + sw - 2.0 * w);\n"
+	"	float vertical = 2.0 * abs(e + w - 2.0 * m) + abs(ne + nw - 2.0 * n) + abs(se + sw - 2.0 * s);\n"
+	"	bool isHorizontal = horizontal >= vertical;\n"
+	"	float positiveLuma = isHorizontal ? n : e;\n"
+	"	float negativeLuma = isHorizontal ? s : w;\n"
+	"	float positiveGradient = abs(positiveLuma - m);\n"
+	"	float negativeGradient = abs(negativeLuma - m);\n"
+	"	float stepLength = isHorizontal ? t.y : t.x;\n"
+	"	float oppositeLuma = positiveLuma;\n"
+	"	float gradient = positiveGradient;\n"
+	"	if (positiveGradient < negativeGradient)\n"
+	"	{\n"
+	"		stepLength = -stepLength;\n"
+	"		oppositeLuma = negativeLuma;\n"
+	"		gradient = negativeGradient;\n"
+	"	}\n"
+
+	// walk along the edge in both directions until the luma leaves the edge
+	"	vec2 edgeUv = uv;\n"
+	"	vec2 edgeStep;\n"
+	"	if (isHorizontal)\n"
+	"	{\n"
+	"		edgeUv.y += stepLength * 0.5;\n"
+	"		edgeStep = vec2(t.x, 0.0);\n"
+	"	}\n"
+	"	else\n"
+	"	{\n"
+	"		edgeUv.x += stepLength * 0.5;\n"
+	"		edgeStep = vec2(0.0, t.y);\n"
+	"	}\n"
+	"	float edgeLuma = (m + oppositeLuma) * 0.5;\n"
+	"	float gradientThreshold = gradient * 0.25;\n"
+	"	vec2 positiveUv = edgeUv + edgeStep;\n"
+	"	float positiveDelta = Luma(positiveUv) - edgeLuma;\n"
+	"	bool positiveEnd = abs(positiveDelta) >= gradientThreshold;\n"
+	"	vec2 negativeUv = edgeUv - edgeStep;\n"
+	"	float negativeDelta = Luma(negativeUv) - edgeLuma;\n"
+	"	bool negativeEnd = abs(negativeDelta) >= gradientThreshold;\n"
+	"	for (int i = 1; i < 10; ++i)\n"
+	"	{\n"
+	"		float scale = i < 4 ? 1.0 : (i < 8 ? 2.0 : 4.0);\n"
+	"		if (!positiveEnd)\n"
+	"		{\n"
+	"			positiveUv += edgeStep * scale;\n"
+	"			positiveDelta = Luma(positiveUv) - edgeLuma;\n"
+	"			positiveEnd = abs(positiveDelta) >= gradientThreshold;\n"
+	"		}\n"
+	"		if (!negativeEnd)\n"
+	"		{\n"
+	"			negativeUv -= edgeStep * scale;\n"
+	"			negativeDelta = Luma(negativeUv) - edgeLuma;\n"
+	"			negativeEnd = abs(negativeDelta) >= gradientThreshold;\n"
+	"		}\n"
+	"	}\n"
+	"	float positiveDistance = isHorizontal ? positiveUv.x - uv.x : positiveUv.y - uv.y;\n"
+	"	float negativeDistance = isHorizontal ? uv.x - negativeUv.x : uv.y - negativeUv.y;\n"
+	"	float shortest = min(positiveDistance, negativeDistance);\n"
+	"	bool deltaSign = positiveDistance <= negativeDistance ? positiveDelta >= 0.0 : negativeDelta >= 0.0;\n"
+
+	// the end the pixel is nearest to decides, only pixels on the darker or brighter side of it blend
+	"	float edgeBlend = deltaSign == (m - edgeLuma >= 0.0) ? 0.0 : 0.5 - shortest / (positiveDistance + negativeDistance);\n"
+	"	float blend = max(subpixelBlend, edgeBlend);\n"
+	"	if (isHorizontal)\n"
+	"	{\n"
+	"		uv.y += stepLength * blend;\n"
+	"	}\n"
+	"	else\n"
+	"	{\n"
+	"		uv.x += stepLength * blend;\n"
+	"	}\n"
+	"	gl_FragColor = vec4(texture2D(source, clamp(uv, vec2(0.0), sourceMax)).rgb, 1.0);\n"
+	"}\n";
+
+
+Fxaa::Fxaa(const SETTINGS& settings) :
+	m_Settings(settings),
+	m_uProgram(0)
+{
+}
+
+
+Fxaa::~Fxaa()
+{
+	Release();
+}
+
+
+PostEffect::FORMATS Fxaa::GetFormats() const
+{
+	// luma of the displayed colors, runs on the 8 bit frame
+	return { GL_RGBA8, 0, 1.0f };
+}
+
+
+bool Fxaa::Create(OpenGLRenderer& renderer)
+{
+	Release();
+	m_uProgram = renderer.CreateProgramFromSource(PostProcess::GetVertexShader(), s_pFragmentShader);
+	return m_uProgram != 0;
+}
+
+
+void Fxaa::Release()
+{
+	if (m_uProgram)
+	{
+		glDeleteProgram(m_uProgram);
+		m_uProgram = 0;
+	}
+}
+
+
+void Fxaa::Render(OpenGLRenderer& renderer, PostProcess& /*chain*/, const RenderTargetPool::TARGET& input, const RenderTargetPool::TARGET& /*output*/)
+{
+	PROFILE_SCOPE("Fxaa::Render");
+
+	const GLuint program = m_uProgram;
+	glUseProgram(program);
+	PostProcess::SetInput(renderer, program, "source", input, 0);
+	OpenGLRenderer::SetUniformFloat(program, "contrastThreshold", m_Settings.contrastThreshold);
+	OpenGLRenderer::SetUniformFloat(program, "relativeThreshold", m_Settings.relativeThreshold);
+	OpenGLRenderer::SetUniformFloat(program, "subpixelBlending", m_Settings.subpixelBlending);
+	PostProcess::DrawFullscreen(program);
+}
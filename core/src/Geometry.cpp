@@ -7,6 +7,7 @@
 **/
 
 #include "../include/Geometry.h"
+#include <limits>
 
 #define TINYOBJLOADER_IMPLEMENTATION
 //#define TINYOBJLOADER_USE_MAPBOX_EARCUT
@@ -16,7 +17,9 @@
 Geometry::Geometry() :
 	m_IndexBuffer(0),
 	m_uIndexCount(0),
-	m_eDrawMode(GL_TRIANGLES)
+	m_eDrawMode(GL_TRIANGLES),
+	m_vBoundsMin(0.0f),
+	m_vBoundsMax(0.0f)
 {
 }
 
@@ -30,12 +33,15 @@ Geometry::~Geometry()
 void Geometry::Clear()
 {
 	m_arrVertices.clear();
+	m_arrIndices.clear();
 	if (m_IndexBuffer)
 	{
 		glDeleteBuffers(1, &m_IndexBuffer);
 		m_IndexBuffer = 0;
 	}
 	m_uIndexCount = 0;
+	m_vBoundsMin = glm::vec3(0.0f);
+	m_vBoundsMax = glm::vec3(0.0f);
 }
 
 
@@ -44,14 +50,17 @@ void Geometry::GenSphere(const glm::vec3& radius, const glm::vec3& offset, uint3
 	Clear();
 	m_arrVertices = GenSphereVertices(radius, offset, rings, segments);
 	m_eDrawMode = GL_TRIANGLE_STRIP;
+	UpdateBounds();
 }
 
 
 void Geometry::GenCube(const glm::vec3& size, const glm::vec3& offset)
 {
 	Clear();
-	m_arrVertices = GenCubeVertices(size, offset, m_IndexBuffer, m_uIndexCount);
+	m_arrVertices = GenCubeVertices(size, offset, m_arrIndices);
+	CreateIndexBuffer();
 	m_eDrawMode = GL_TRIANGLES;
+	UpdateBounds();
 }
 
 
@@ -60,22 +69,38 @@ void Geometry::GenQuad(const glm::vec2& size, const glm::vec3& offset)
 	Clear();
 	m_arrVertices = GenQuadVertices(size, offset);
 	m_eDrawMode = GL_TRIANGLES;
+	UpdateBounds();
 }
 
 
 void Geometry::GenTorus(uint32_t segments, float radius, float fatness)
 {
 	Clear();
-	m_arrVertices = GenTorusVertices(segments, radius, fatness, m_IndexBuffer, m_uIndexCount);
+	m_arrVertices = GenTorusVertices(segments, radius, fatness, m_arrIndices);
+	CreateIndexBuffer();
 	m_eDrawMode = GL_TRIANGLES;
+	UpdateBounds();
 }
 
 
 void Geometry::GenKnot(uint32_t slices, uint32_t stacks, float radius)
 {
 	Clear();
-	m_arrVertices = GenKnotVertices(slices, stacks, radius, m_IndexBuffer, m_uIndexCount);
+	m_arrVertices = GenKnotVertices(slices, stacks, radius, m_arrIndices);
+	CreateIndexBuffer();
 	m_eDrawMode = GL_TRIANGLES;
+	UpdateBounds();
+}
+
+
+void Geometry::SetData(std::vector<VERTEX>&& vertices, std::vector<uint32_t>&& indices, GLenum mode)
+{
+	Clear();
+	m_arrVertices = std::move(vertices);
+	m_arrIndices = std::move(indices);
+	CreateIndexBuffer();
+	m_eDrawMode = mode;
+	UpdateBounds();
 }
 
 
@@ -178,6 +203,39 @@ void Geometry::Draw(IRenderer& renderer) const
 }
 
 
+void Geometry::CreateIndexBuffer()
+{
+	// keep the cpu copy of the indices, shared buffers and batching need them
+	m_uIndexCount = m_arrIndices.size();
+	if (m_uIndexCount)
+	{
+		glGenBuffers(1, &m_IndexBuffer);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_uIndexCount * sizeof(uint32_t), m_arrIndices.data(), GL_STATIC_DRAW);
+	}
+}
+
+
+void Geometry::UpdateBounds()
+{
+	if (m_arrVertices.empty())
+	{
+		m_vBoundsMin = glm::vec3(0.0f);
+		m_vBoundsMax = glm::vec3(0.0f);
+		return;
+	}
+
+	m_vBoundsMin = glm::vec3(std::numeric_limits<float>::max());
+	m_vBoundsMax = glm::vec3(-std::numeric_limits<float>::max());
+	for (const auto& v : m_arrVertices)
+	{
+		const glm::vec3 pos(v.x, v.y, v.z);
+		m_vBoundsMin = glm::min(m_vBoundsMin, pos);
+		m_vBoundsMax = glm::max(m_vBoundsMax, pos);
+	}
+}
+
+
 std::vector<Geometry::VERTEX> Geometry::GenSphereVertices(const glm::vec3& radius, const glm::vec3& offset, uint32_t rings, uint32_t segments)
 {
 	std::vector<VERTEX> vertices;
@@ -216,7 +274,7 @@ std::vector<Geometry::VERTEX> Geometry::GenSphereVertices(const glm::vec3& radiu
 }
 
 
-std::vector<Geometry::VERTEX> Geometry::GenCubeVertices(const glm::vec3& size, const glm::vec3& offset, GLuint& indexBuffer, size_t& indexCount)
+std::vector<Geometry::VERTEX> Geometry::GenCubeVertices(const glm::vec3& size, const glm::vec3& offset, std::vector<uint32_t>& indices)
 {
 	// cube normals
 	std::vector<VERTEX> vertices;
@@ -279,7 +337,7 @@ std::vector<Geometry::VERTEX> Geometry::GenCubeVertices(const glm::vec3& size, c
 
 
 	// create indices to cube object
-	uint32_t indices[36];
+	indices.resize(36);
 
 	for (int32_t i=0, j=0; i<21; i+=4, j+=6)
 	{
@@ -291,11 +349,6 @@ std::vector<Geometry::VERTEX> Geometry::GenCubeVertices(const glm::vec3& size, c
 		indices[j + 5] = (i + 3);
 	}
 
-	glGenBuffers(1, &indexBuffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, 36*4, indices, GL_STATIC_DRAW);
-
-	indexCount = 36;
 	return vertices;
 }
 
@@ -338,12 +391,11 @@ std::vector<Geometry::VERTEX> Geometry::GenQuadVertices(const glm::vec2& size, c
 std::vector<Geometry::VERTEX> Geometry::GenTorusVertices(uint32_t segments,
 	float radius,
 	float fatness,
-	GLuint& indexBuffer,
-	size_t& indexCount)
+	std::vector<uint32_t>& indices)
 {
 	std::vector<VERTEX> vertices;
 	const size_t vertexCount = segments * segments;
-	indexCount = (segments - 1) * (segments - 1) * 6;
+	const size_t indexCount = (segments - 1) * (segments - 1) * 6;
 	vertices.resize(vertexCount);
 
 	size_t index;
@@ -384,7 +436,6 @@ std::vector<Geometry::VERTEX> Geometry::GenTorusVertices(uint32_t segments,
 		}
 	}
 
-	std::vector<uint32_t> indices;
 	indices.resize(indexCount);
 
 	index = 0;
@@ -403,9 +454,6 @@ std::vector<Geometry::VERTEX> Geometry::GenTorusVertices(uint32_t segments,
 		}
 	}
 
-	glGenBuffers(1, &indexBuffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * 4, indices.data(), GL_STATIC_DRAW);
 	return vertices;
 }
 
@@ -413,12 +461,11 @@ std::vector<Geometry::VERTEX> Geometry::GenTorusVertices(uint32_t segments,
 std::vector<Geometry::VERTEX> Geometry::GenKnotVertices(uint32_t slices,
 	uint32_t stacks,
 	float radius,
-	GLuint& indexBuffer,
-	size_t& indexCount)
+	std::vector<uint32_t>& indices)
 {
 	std::vector<VERTEX> vertices;
 	const size_t vertexCount = slices * stacks;
-	indexCount = vertexCount * 6;
+	const size_t indexCount = vertexCount * 6;
 
 	vertices.resize(vertexCount);
 
@@ -451,7 +498,6 @@ std::vector<Geometry::VERTEX> Geometry::GenKnotVertices(uint32_t slices,
         }
     }
 
-	std::vector<uint32_t> indices;
 	indices.resize(indexCount);
     uint32_t* pIndex = indices.data();
 
@@ -471,9 +517,6 @@ std::vector<Geometry::VERTEX> Geometry::GenKnotVertices(uint32_t slices,
         n += (uint32_t)stacks;
     }
 
-	glGenBuffers(1, &indexBuffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexCount * 4, indices.data(), GL_STATIC_DRAW);
 	return vertices;
 }
 
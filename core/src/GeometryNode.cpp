@@ -10,30 +10,40 @@
 #include "../include/GeometryNode.h"
 #include "../include/Geometry.h"
 #include "../include/Material.h"
+#include "../include/DrawQueue.h"
 
 
 void GeometryNode::Render(IRenderer& renderer, GLuint program)
 {
-	if (m_pGeometry)
-	{
-		m_pGeometry->SetAttribs(program);
-
-		// set model matrix to shader uniform
-		const glm::mat4 worldMatrix(GetWorldMatrix());
-		OpenGLRenderer::SetUniformMatrix4(program, "modelMatrix", worldMatrix);
+	PROFILE_SCOPE("GeometryNode::Render");
 
-		// set model-view-projection matrix to shader uniform
-		const glm::mat4 modelViewProjectionMatrix(renderer.GetProjectionMatrix() * renderer.GetViewMatrix() * worldMatrix);
-		OpenGLRenderer::SetUniformMatrix4(program, "modelViewProjectionMatrix", modelViewProjectionMatrix);
+	const glm::mat4 world(GetWorldMatrix());
+	if (m_pGeometry && IsVisible(renderer.GetFrustum(), world))
+	{
+		const DrawQueue::DRAW draw = { m_pGeometry, m_pMaterial.get(), world, GetPreviousWorldMatrix() };
 
-		if (m_pMaterial)
+		DrawQueue* queue = renderer.GetDrawQueue();
+		if (queue)
 		{
-			m_pMaterial->SetToProgram(program);
+			// record the draw, queue owner submits it later
+			queue->Add(draw.geometry, draw.material, draw.worldMatrix, draw.previousWorldMatrix);
+		}
+		else
+		{
+			DrawQueue::DrawImmediate(renderer, program, draw);
 		}
-
-		m_pGeometry->Draw(renderer);
 	}
 
 	Node::Render(renderer, program);
 }
 
+
+bool GeometryNode::IsVisible(const Frustum& frustum, const glm::mat4& world) const
+{
+	if (!m_pGeometry->GetVertexCount())
+	{
+		return false;
+	}
+
+	return frustum.IsBoundsVisible(m_pGeometry->GetBoundsMin(), m_pGeometry->GetBoundsMax(), world);
+}
@@ -0,0 +1,288 @@
+/**
+ * ============================================================================
+ *  Name        : GpuProfiler.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : scoped gpu timing with GL_TIMESTAMP queries
+ * ============================================================================
+**/
+
+#include "../include/GpuProfiler.h"
+#include <algorithm>
+
+
+GpuProfiler::GpuProfiler() :
+	m_uFrame(0),
+	m_uMaxScopes(0),
+	m_uWindow(0),
+	m_uDroppedFrames(0),
+	m_bInFrame(false)
+{
+}
+
+
+GpuProfiler::~GpuProfiler()
+{
+	Release();
+}
+
+
+bool GpuProfiler::IsSupported()
+{
+	return glGenQueries &&
+		glQueryCounter &&
+		glGetQueryObjectiv &&
+		glGetQueryObjectui64v &&
+		(OpenGLRenderer::GetVersion() >= 33 || OpenGLRenderer::HasExtension("GL_ARB_timer_query"));
+}
+
+
+bool GpuProfiler::Create(uint32_t frameLatency, uint32_t maxScopes, uint32_t window)
+{
+	Release();
+	if (!IsSupported())
+	{
+		IApplication::Debug("GpuProfiler: timer queries not supported\n");
+		return false;
+	}
+
+	// timestamps instead of GL_TIME_ELAPSED, elapsed queries can not be nested
+	m_uMaxScopes = std::max(maxScopes, 1u);
+	m_uWindow = std::max(window, 1u);
+	m_arrFrames.resize(std::max(frameLatency, 2u));
+	for (auto& frame : m_arrFrames)
+	{
+		frame.queries.resize(m_uMaxScopes * 2);
+		glGenQueries((GLsizei)frame.queries.size(), frame.queries.data());
+		frame.scopes.reserve(m_uMaxScopes);
+		frame.pending = false;
+	}
+	return true;
+}
+
+
+void GpuProfiler::Release()
+{
+	for (auto& frame : m_arrFrames)
+	{
+		glDeleteQueries((GLsizei)frame.queries.size(), frame.queries.data());
+	}
+	m_arrFrames.clear();
+	m_arrStack.clear();
+	m_mapTimings.clear();
+	m_uFrame = 0;
+	m_uDroppedFrames = 0;
+	m_bInFrame = false;
+}
+
+
+void GpuProfiler::BeginFrame()
+{
+	if (m_arrFrames.empty())
+	{
+		return;
+	}
+	if (m_bInFrame)
+	{
+		EndFrame();
+	}
+
+	// the slot is reused, read its results if the gpu has finished them
+	FRAME& frame = m_arrFrames[m_uFrame % m_arrFrames.size()];
+	if (frame.pending)
+	{
+		Collect(frame);
+	}
+	frame.scopes.clear();
+	frame.pending = false;
+
+	m_bInFrame = true;
+	Begin("frame");
+}
+
+
+void GpuProfiler::EndFrame()
+{
+	if (!m_bInFrame)
+	{
+		return;
+	}
+
+	// close scopes left open
+	while (!m_arrStack.empty())
+	{
+		End();
+	}
+
+	m_arrFrames[m_uFrame % m_arrFrames.size()].pending = true;
+	m_bInFrame = false;
+	++m_uFrame;
+}
+
+
+void GpuProfiler::Begin(const std::string_view& name)
+{
+	if (!m_bInFrame)
+	{
+		return;
+	}
+
+	FRAME& frame = m_arrFrames[m_uFrame % m_arrFrames.size()];
+	if (frame.scopes.size() >= m_uMaxScopes)
+	{
+		// over the limit, keep the stack balanced
+		m_arrStack.push_back(SIZE_MAX);
+		return;
+	}
+
+	SCOPEDATA scope;
+	scope.path = m_arrStack.empty() ? std::string(name) : frame.scopes[m_arrStack.back()].path + "/" + std::string(name);
+	scope.depth = (uint32_t)m_arrStack.size();
+	scope.cpuBegin = Timer::GetTicks();
+	scope.cpuEnd = scope.cpuBegin;
+
+	glQueryCounter(frame.queries[frame.scopes.size() * 2], GL_TIMESTAMP);
+	m_arrStack.push_back(frame.scopes.size());
+	frame.scopes.push_back(std::move(scope));
+}
+
+
+void GpuProfiler::End()
+{
+	if (!m_bInFrame || m_arrStack.empty())
+	{
+		return;
+	}
+
+	const size_t index = m_arrStack.back();
+	m_arrStack.pop_back();
+	if (index == SIZE_MAX)
+	{
+		return;
+	}
+
+	FRAME& frame = m_arrFrames[m_uFrame % m_arrFrames.size()];
+	glQueryCounter(frame.queries[index * 2 + 1], GL_TIMESTAMP);
+	frame.scopes[index].cpuEnd = Timer::GetTicks();
+}
+
+
+void GpuProfiler::Collect(FRAME& frame)
+{
+	if (frame.scopes.empty())
+	{
+		return;
+	}
+
+	// queries complete in order, the frame scope end timestamp is issued last
+	GLint available = 0;
+	glGetQueryObjectiv(frame.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+	{
+		++m_uDroppedFrames;
+		return;
+	}
+
+	for (size_t i = 0; i < frame.scopes.size(); ++i)
+	{
+		GLuint64 begin = 0;
+		GLuint64 end = 0;
+		glGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+		AddSample(frame.scopes[i], end > begin ? (float)((end - begin) / 1000000.0) : 0.0f);
+	}
+}
+
+
+void GpuProfiler::AddSample(const SCOPEDATA& scope, float gpuMilliseconds)
+{
+	TIMING& timing = m_mapTimings[scope.path];
+	if (timing.gpuSamples.empty())
+	{
+		const size_t separator = scope.path.rfind('/');
+		timing.name = separator == std::string::npos ? scope.path : scope.path.substr(separator + 1);
+		timing.depth = scope.depth;
+		timing.sampleCount = 0;
+		timing.gpuSamples.resize(m_uWindow, 0.0f);
+		timing.cpuSamples.resize(m_uWindow, 0.0f);
+	}
+
+	// a scope recorded several times in a frame gets one sample per recording
+	const float cpuMilliseconds = (float)((scope.cpuEnd - scope.cpuBegin) * Timer::GetSecondsPerTick() * 1000.0);
+	const uint32_t slot = timing.sampleCount % m_uWindow;
+	timing.gpuSamples[slot] = gpuMilliseconds;
+	timing.cpuSamples[slot] = cpuMilliseconds;
+	timing.gpuMilliseconds = gpuMilliseconds;
+	timing.cpuMilliseconds = cpuMilliseconds;
+	++timing.sampleCount;
+
+	const uint32_t count = std::min(timing.sampleCount, m_uWindow);
+	float gpuSum = 0.0f;
+	float cpuSum = 0.0f;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		gpuSum += timing.gpuSamples[i];
+		cpuSum += timing.cpuSamples[i];
+	}
+	timing.gpuAverage = gpuSum / count;
+	timing.cpuAverage = cpuSum / count;
+}
+
+
+std::string GpuProfiler::GetJson() const
+{
+	std::string json = "{\n\t\"frames\": " + std::to_string(m_uFrame) +
+		",\n\t\"droppedFrames\": " + std::to_string(m_uDroppedFrames) +
+		",\n\t\"timings\": [";
+
+	bool first = true;
+	for (const auto& it : m_mapTimings)
+	{
+		const TIMING& timing = it.second;
+		char line[512];
+		snprintf(line, sizeof(line),
+			"%s\n\t\t{ \"path\": \"%s\", \"name\": \"%s\", \"depth\": %u, \"samples\": %u, "
+			"\"gpuMs\": %.4f, \"cpuMs\": %.4f, \"gpuAverageMs\": %.4f, \"cpuAverageMs\": %.4f }",
+			first ? "" : ",",
+			it.first.c_str(),
+			timing.name.c_str(),
+			timing.depth,
+			timing.sampleCount,
+			timing.gpuMilliseconds,
+			timing.cpuMilliseconds,
+			timing.gpuAverage,
+			timing.cpuAverage);
+		json += line;
+		first = false;
+	}
+	json += "\n\t]\n}\n";
+	return json;
+}
+
+
+bool GpuProfiler::Export(const std::string_view& filename) const
+{
+	std::ofstream f(std::string(filename), std::ios::binary);
+	if (!f)
+	{
+		return false;
+	}
+	const std::string json = GetJson();
+	f.write(json.data(), json.size());
+	return (bool)f;
+}
+
+
+void GpuProfiler::PrintTimings() const
+{
+	for (const auto& it : m_mapTimings)
+	{
+		const TIMING& timing = it.second;
+		char line[256];
+		snprintf(line, sizeof(line), "%*s%-32s gpu %8.3f ms  cpu %8.3f ms\n",
+			(int)timing.depth * 2, "",
+			timing.name.c_str(),
+			timing.gpuAverage,
+			timing.cpuAverage);
+		IApplication::Debug(line);
+	}
+}
@@ -13,6 +13,7 @@
 
 // include all your renderers
 #include "../include/OpenGLRenderer.h"
+#include "../include/FramePacer.h"
 
 #include <X11/Xlib.h>
 #include <X11/Xos.h>
@@ -22,6 +23,9 @@
 #include <X11/Xatom.h>
 #include <X11/keysym.h>
 
+#include <poll.h>
+#include <time.h>
+
 
 #if defined (_LINUX)
 
@@ -36,12 +40,20 @@ uint8_t                  IApplication::m_uKeyboard[65536];
 
 
 IApplication::IApplication() :
-    m_bActive(false)
+    m_bQuit(false),
+    m_bMinimized(false),
+    m_bActive(false),
+    m_fTargetFrameRate(0.0f),
+    m_uNextFrameTicks(0),
+    m_iWidth(0),
+    m_iHeight(0),
+    m_bHeadless(false)
 {
 	m_pApp = this;
 
-    m_pDisplay = XOpenDisplay(NULL);
-    m_iScreen = DefaultScreen(m_pDisplay);
+    // display is opened in Create, headless runs do not have one
+    m_pDisplay = nullptr;
+    m_iScreen = 0;
 	memset(m_uKeyboard, 0, 65536);
 }
 
@@ -54,6 +66,14 @@ IApplication::~IApplication()
 
 bool IApplication::Create(int resX, int resY, const std::string& title)
 {
+    m_pDisplay = XOpenDisplay(NULL);
+    if (!m_pDisplay)
+    {
+        Debug("IApplication: XOpenDisplay failed, use headless mode when there is no display\n");
+        return false;
+    }
+    m_iScreen = DefaultScreen(m_pDisplay);
+
 	m_Window = MakeWindow(resX, resY, title.c_str());
 	if (m_Window)
 	{
@@ -85,6 +105,29 @@ bool IApplication::Create(int resX, int resY, const std::string& title)
 }
 
 
+bool IApplication::Create(int32_t resX, int32_t resY, const HEADLESSPARAMS& headless)
+{
+	m_bHeadless = true;
+	m_HeadlessParams = headless;
+	m_iWidth = resX;
+	m_iHeight = resY;
+
+	// renderer creates an egl context and an offscreen framebuffer of the app size
+	m_pRenderer = std::make_unique<OpenGLRenderer>();
+	if (!m_pRenderer->Create())
+	{
+		return false;
+	}
+
+	if (OnCreate())
+	{
+		SetActive(true);
+		return true;
+	}
+	return false;
+}
+
+
 bool IApplication::ProcessEvents(XEvent* evnt)
 {
     IApplication* pApp = IApplication::GetApp();
@@ -152,6 +195,16 @@ bool IApplication::ProcessEvents(XEvent* evnt)
         pApp->SetActive(false);
         break;
 
+    case UnmapNotify:
+        pApp->m_bMinimized = true;
+        break;
+
+    case MapNotify:
+        // frame time does not include the time spent minimized
+        pApp->m_bMinimized = false;
+        pApp->m_Timer.BeginTimer();
+        break;
+
     case Expose:
         break;
 
@@ -183,7 +236,7 @@ bool IApplication::ProcessEvents(XEvent* evnt)
         {
             pApp->m_iWidth = evnt->xconfigure.width;
             pApp->m_iHeight = evnt->xconfigure.height;
-            pApp->m_pRenderer->SetViewport(0, 0, pApp->m_iWidth, pApp->m_iHeight);
+            pApp->m_pRenderer->SetViewport({ 0, 0, pApp->m_iWidth, pApp->m_iHeight });
             pApp->OnScreenSizeChanged(pApp->m_iWidth, pApp->m_iHeight);
         }
         break;
@@ -233,40 +286,227 @@ void IApplication::SetActive(bool set)
 void IApplication::Close()
 {
 	m_Window = 0;
+	m_bQuit = true;
 }
 
 
 void IApplication::Run()
 {
-    // run the application
-    XEvent event;
-    bool bGotMsg = false;
+    if (m_bHeadless)
+    {
+        RunHeadless();
+        return;
+    }
 
+    // run the application
     while (m_Window)
     {
-        bGotMsg = false;
-        if (XPending(m_pDisplay))
+        DrainEvents();
+        if (!m_Window)
         {
-            XNextEvent(m_pDisplay, &event);
-            bGotMsg = true;
+            break;
         }
 
-        if (bGotMsg)
+        // nothing to show, do not spin while minimized or in the background
+        if (!IsActive() || m_bMinimized)
         {
-            ProcessEvents(&event);
+            WaitEvents();
+            continue;
         }
-        else
-        {
+
+		PROFILE_BEGIN_FRAME();
+		{
+			PROFILE_SCOPE("IApplication::Run");
 			m_Timer.EndTimer();
 			m_Timer.BeginTimer();
+			RunFrame(m_Timer.GetElapsedSeconds());
+			LimitFrameRate();
+		}
+		PROFILE_END_FRAME();
+    }
+	OnDestroy();
+    m_pRenderer = nullptr;
+}
 
-			OnUpdate(m_Timer.GetElapsedSeconds());
-			OnDraw(*m_pRenderer);
-			m_pRenderer->Flip();
+
+void IApplication::RunFrame(float timestep)
+{
+	{
+		PROFILE_SCOPE("IApplication::OnUpdate");
+		OnUpdate(timestep);
+	}
+	LateLatch();
+	{
+		PROFILE_SCOPE("IApplication::OnDraw");
+		OnDraw(*m_pRenderer);
+	}
+	m_pRenderer->Flip();
+}
+
+
+void IApplication::DrainEvents()
+{
+    PROFILE_SCOPE("IApplication::DrainEvents");
+
+    // everything received before the frame, events arriving meanwhile wait for the next one
+    XPending(m_pDisplay);
+    while (m_Window && XEventsQueued(m_pDisplay, QueuedAlready) > 0)
+    {
+        XEvent event;
+        XNextEvent(m_pDisplay, &event);
+
+        // a burst of pointer motion is handled as its last position, order to other events is kept
+        if (event.type == MotionNotify)
+        {
+            XEvent next;
+            while (XEventsQueued(m_pDisplay, QueuedAlready) > 0 &&
+                XPeekEvent(m_pDisplay, &next) && next.type == MotionNotify)
+            {
+                XNextEvent(m_pDisplay, &event);
+            }
         }
+        ProcessEvents(&event);
+    }
+}
+
+
+void IApplication::WaitEvents()
+{
+    // sleep on the x connection until the server sends something
+    XFlush(m_pDisplay);
+    if (!XEventsQueued(m_pDisplay, QueuedAlready))
+    {
+        pollfd connection = { ConnectionNumber(m_pDisplay), POLLIN, 0 };
+        poll(&connection, 1, -1);
+    }
+}
+
+
+void IApplication::LimitFrameRate()
+{
+    if (m_fTargetFrameRate <= 0.0f)
+    {
+        return;
+    }
+
+    PROFILE_SCOPE("IApplication::LimitFrameRate");
+
+    const double secondsPerTick = Timer::GetSecondsPerTick();
+    const uint64_t frameTicks = (uint64_t)(1.0 / ((double)m_fTargetFrameRate * secondsPerTick));
+    const uint64_t spinTicks = (uint64_t)(0.001 / secondsPerTick);
+    uint64_t now = Timer::GetTicks();
+
+    // a frame that ran over starts the schedule again instead of rushing the next ones
+    if (m_uNextFrameTicks == 0 || now > m_uNextFrameTicks + frameTicks)
+    {
+        m_uNextFrameTicks = now + frameTicks;
+    }
+
+    // sleep wakes up late by up to the scheduler latency, the last millisecond is spun
+    if (m_uNextFrameTicks > now + spinTicks)
+    {
+        const uint64_t sleepNanoseconds = (uint64_t)((double)(m_uNextFrameTicks - now - spinTicks) * secondsPerTick * 1000000000.0);
+        const timespec duration = { (time_t)(sleepNanoseconds / 1000000000), (long)(sleepNanoseconds % 1000000000) };
+        clock_nanosleep(CLOCK_MONOTONIC, 0, &duration, nullptr);
+    }
+    while (Timer::GetTicks() < m_uNextFrameTicks)
+    {
     }
+    m_uNextFrameTicks += frameTicks;
+}
+
+
+void IApplication::LateLatch()
+{
+	FramePacer* pacer = static_cast<OpenGLRenderer*>(m_pRenderer.get())->GetFramePacer();
+	if (!pacer || !pacer->GetSettings().lateLatch)
+	{
+		return;
+	}
+
+	// only input, the rest of the events stay queued for the next frame
+	if (!m_bHeadless)
+	{
+		XEvent event;
+		while (XCheckWindowEvent(m_pDisplay, m_Window, KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask | PointerMotionMask, &event))
+		{
+			ProcessEvents(&event);
+		}
+	}
+	pacer->LateLatch();
+}
+
+
+void IApplication::RunHeadless()
+{
+	// fixed timestep keeps runs reproducible, frames are rendered as fast as possible
+	Timer timer;
+	timer.BeginTimer();
+
+	uint32_t frame = 0;
+	for (; frame < m_HeadlessParams.frameCount && !m_bQuit; ++frame)
+	{
+		PROFILE_BEGIN_FRAME();
+		{
+			PROFILE_SCOPE("IApplication::Run");
+			m_Timer.EndTimer();
+			m_Timer.BeginTimer();
+			RunFrame(m_HeadlessParams.timestep);
+		}
+		PROFILE_END_FRAME();
+	}
+
+	if (m_HeadlessParams.readback)
+	{
+		static_cast<OpenGLRenderer*>(m_pRenderer.get())->ReadPixels(m_arrReadback);
+	}
+
+	timer.EndTimer();
+	char line[128];
+	snprintf(line, sizeof(line), "IApplication: %u headless frames in %.3f s, %.3f ms per frame\n",
+		frame,
+		timer.GetElapsedSeconds(),
+		frame ? timer.GetElapsedSeconds() * 1000.0f / frame : 0.0f);
+	Debug(line);
+
 	OnDestroy();
-    m_pRenderer = nullptr;
+	m_pRenderer = nullptr;
+}
+
+
+bool IApplication::SaveReadback(const std::string_view& filename) const
+{
+	if (m_arrReadback.size() != (size_t)m_iWidth * m_iHeight * 4)
+	{
+		return false;
+	}
+
+	std::ofstream f(std::string(filename), std::ios::binary);
+	if (!f)
+	{
+		return false;
+	}
+
+	// uncompressed true color tga, rows bottom up like the gl readback
+	const uint8_t header[18] =
+	{
+		0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+		(uint8_t)(m_iWidth & 0xff), (uint8_t)(m_iWidth >> 8),
+		(uint8_t)(m_iHeight & 0xff), (uint8_t)(m_iHeight >> 8),
+		32, 8
+	};
+	f.write((const char*)header, sizeof(header));
+
+	std::vector<uint8_t> bgra(m_arrReadback.size());
+	for (size_t i = 0; i < bgra.size(); i += 4)
+	{
+		bgra[i + 0] = m_arrReadback[i + 2];
+		bgra[i + 1] = m_arrReadback[i + 1];
+		bgra[i + 2] = m_arrReadback[i + 0];
+		bgra[i + 3] = m_arrReadback[i + 3];
+	}
+	f.write((const char*)bgra.data(), bgra.size());
+	return (bool)f;
 }
 
 
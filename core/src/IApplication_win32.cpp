@@ -10,6 +10,7 @@
 
 // include all your renderers
 #include "../include/OpenGLRenderer.h"
+#include "../include/FramePacer.h"
 
 #if defined (_WINDOWS)
 
@@ -19,8 +20,11 @@ IApplication* IApplication::m_pApp = nullptr;
 IApplication::IApplication() :
 	m_Window(nullptr),
 	m_bActive(false),
+	m_fTargetFrameRate(0.0f),
+	m_uNextFrameTicks(0),
 	m_iWidth(0),
-	m_iHeight(0)
+	m_iHeight(0),
+	m_bHeadless(false)
 {
 	m_pApp = this;
 }
@@ -65,6 +69,19 @@ bool IApplication::Create(int32_t resX, int32_t resY, const std::string& title)
 }
 
 
+bool IApplication::Create(int32_t resX, int32_t resY, const HEADLESSPARAMS& headless)
+{
+	Debug("IApplication: headless mode is not supported on windows\n");
+	return false;
+}
+
+
+bool IApplication::SaveReadback(const std::string_view& filename) const
+{
+	return false;
+}
+
+
 bool IApplication::OnEvent(UINT message, WPARAM wParam, LPARAM lParam)
 {
 	switch (message)
@@ -179,12 +196,15 @@ void IApplication::Run()
 
 		if (msg.message != WM_QUIT)
 		{
-			m_Timer.EndTimer();
-			m_Timer.BeginTimer();
-
-			OnUpdate(m_Timer.GetElapsedSeconds());
-			OnDraw(*m_pRenderer);
-			m_pRenderer->Flip();
+			PROFILE_BEGIN_FRAME();
+			{
+				PROFILE_SCOPE("IApplication::Run");
+				m_Timer.EndTimer();
+				m_Timer.BeginTimer();
+				RunFrame(m_Timer.GetElapsedSeconds());
+				LimitFrameRate();
+			}
+			PROFILE_END_FRAME();
 		}
 	}
 
@@ -193,6 +213,74 @@ void IApplication::Run()
 }
 
 
+void IApplication::RunFrame(float timestep)
+{
+	{
+		PROFILE_SCOPE("IApplication::OnUpdate");
+		OnUpdate(timestep);
+	}
+	LateLatch();
+	{
+		PROFILE_SCOPE("IApplication::OnDraw");
+		OnDraw(*m_pRenderer);
+	}
+	m_pRenderer->Flip();
+}
+
+
+void IApplication::LateLatch()
+{
+	FramePacer* pacer = static_cast<OpenGLRenderer*>(m_pRenderer.get())->GetFramePacer();
+	if (!pacer || !pacer->GetSettings().lateLatch)
+	{
+		return;
+	}
+
+	// only input, the rest of the messages stay queued for the next frame
+	MSG msg;
+	while (::PeekMessage(&msg, m_Window, WM_MOUSEFIRST, WM_MOUSELAST, PM_REMOVE) ||
+		::PeekMessage(&msg, m_Window, WM_KEYFIRST, WM_KEYLAST, PM_REMOVE))
+	{
+		::TranslateMessage(&msg);
+		::DispatchMessage(&msg);
+	}
+	pacer->LateLatch();
+}
+
+
+void IApplication::LimitFrameRate()
+{
+	if (m_fTargetFrameRate <= 0.0f)
+	{
+		return;
+	}
+
+	PROFILE_SCOPE("IApplication::LimitFrameRate");
+
+	const double secondsPerTick = Timer::GetSecondsPerTick();
+	const uint64_t frameTicks = (uint64_t)(1.0 / ((double)m_fTargetFrameRate * secondsPerTick));
+	const uint64_t spinTicks = (uint64_t)(0.002 / secondsPerTick);
+	const uint64_t now = Timer::GetTicks();
+
+	// a frame that ran over starts the schedule again instead of rushing the next ones
+	if (m_uNextFrameTicks == 0 || now > m_uNextFrameTicks + frameTicks)
+	{
+		m_uNextFrameTicks = now + frameTicks;
+	}
+
+	// Sleep granularity is the scheduler tick, sleep a millisecond at a time and spin the rest
+	while (Timer::GetTicks() + spinTicks < m_uNextFrameTicks)
+	{
+		::Sleep(1);
+	}
+	while (Timer::GetTicks() < m_uNextFrameTicks)
+	{
+		::YieldProcessor();
+	}
+	m_uNextFrameTicks += frameTicks;
+}
+
+
 HWND IApplication::MakeWindow(int32_t width, int32_t height, const std::string& title)
 {
 	HINSTANCE hInst = ::GetModuleHandle(nullptr);
@@ -0,0 +1,797 @@
+/**
+ * ============================================================================
+ *  Name        : ImageKernels.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : image processing kernels for texture import. Each kernel has
+ *                a scalar reference path and SSE2 / AVX2 paths selected at
+ *                runtime, large images are processed in parallel over rows.
+ *                Images are rgba8 with tightly packed rows.
+ * ============================================================================
+**/
+
+#include "../include/ImageKernels.h"
+#include "../include/Timer.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+#if defined (_M_X64) || defined (__x86_64__) || defined (__SSE2__) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGEKERNELS_SSE2
+#include <emmintrin.h>
+#if defined (_MSC_VER)
+#define IMAGEKERNELS_AVX2
+#define AVX2_FUNCTION
+#include <immintrin.h>
+#include <intrin.h>
+#elif defined (__GNUC__) || defined (__clang__)
+#define IMAGEKERNELS_AVX2
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+#endif
+
+
+namespace
+{
+	ImageKernels::SIMD& CurrentSimd()
+	{
+		static ImageKernels::SIMD simd = ImageKernels::GetSupportedSimd();
+		return simd;
+	}
+
+	std::atomic<uint32_t> g_uThreadCount(0);
+
+	/**
+	 * ParallelRows
+	 * split rows into one range per thread, small images run on the calling thread
+	 */
+	template<typename FUNC>
+	void ParallelRows(int32_t rows, size_t bytesPerRow, const FUNC& func)
+	{
+		constexpr size_t minBytesPerThread = 256 * 1024;
+		const uint32_t setThreads = g_uThreadCount.load(std::memory_order_relaxed);
+		const uint32_t maxThreads = setThreads ? setThreads : std::max(std::thread::hardware_concurrency(), 1u);
+		const size_t threadCount = std::min({ (size_t)maxThreads, (size_t)std::max(rows, 1), rows * bytesPerRow / minBytesPerThread });
+		if (threadCount <= 1)
+		{
+			func(0, rows);
+			return;
+		}
+
+		std::vector<std::thread> threads;
+		const int32_t rowsPerThread = (int32_t)((rows + threadCount - 1) / threadCount);
+		for (int32_t begin = rowsPerThread; begin < rows; begin += rowsPerThread)
+		{
+			threads.emplace_back(func, begin, std::min(begin + rowsPerThread, rows));
+		}
+		func(0, std::min(rowsPerThread, rows));
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+	}
+
+	// color * alpha / 255 rounded down, exact for all 8 bit inputs without division
+	inline uint8_t MulDiv255(uint32_t color, uint32_t alpha)
+	{
+		const uint32_t p = color * alpha;
+		return (uint8_t)((p + 1 + (p >> 8)) >> 8);
+	}
+
+	const float* GetKaiserWeights()
+	{
+		// 8 taps at source offsets -3.5 ... 3.5 around the center of the output
+		// texel. Half band sinc windowed by Kaiser (beta 4, radius 4).
+		// Built once by the first caller, the row threads may ask at the same time
+		static const std::array<float, 8> weights = []()
+		{
+			auto besselI0 = [](double x)
+			{
+				double sum = 1.0;
+				double term = 1.0;
+				for (int32_t k = 1; k < 20; ++k)
+				{
+					term *= (x / (2.0 * k)) * (x / (2.0 * k));
+					sum += term;
+				}
+				return sum;
+			};
+
+			constexpr double beta = 4.0;
+			constexpr double radius = 4.0;
+			const double pi = 3.14159265358979323846;
+			double total = 0.0;
+			double w[8];
+			for (int32_t k = 0; k < 8; ++k)
+			{
+				const double d = k - 3.5;
+				const double t = d * 0.5;
+				const double sinc = sin(pi * t) / (pi * t);
+				const double window = besselI0(beta * sqrt(1.0 - (d / radius) * (d / radius))) / besselI0(beta);
+				w[k] = sinc * window;
+				total += w[k];
+			}
+
+			std::array<float, 8> normalized;
+			for (int32_t k = 0; k < 8; ++k)
+			{
+				normalized[k] = (float)(w[k] / total);
+			}
+			return normalized;
+		}();
+		return weights.data();
+	}
+
+	inline uint8_t ToByte(float value)
+	{
+		return (uint8_t)std::min(std::max((int32_t)std::nearbyint(value), 0), 255);
+	}
+
+	//
+	// scalar reference implementations
+	//
+	void PremultiplyScalar(uint8_t* p, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i, p += 4)
+		{
+			const uint32_t alpha = p[3];
+			p[0] = MulDiv255(p[0], alpha);
+			p[1] = MulDiv255(p[1], alpha);
+			p[2] = MulDiv255(p[2], alpha);
+		}
+	}
+
+	void SwizzleScalar(uint8_t* p, size_t count, const uint8_t order[4])
+	{
+		for (size_t i = 0; i < count; ++i, p += 4)
+		{
+			const uint8_t src[4] = { p[0], p[1], p[2], p[3] };
+			p[0] = src[order[0]];
+			p[1] = src[order[1]];
+			p[2] = src[order[2]];
+			p[3] = src[order[3]];
+		}
+	}
+
+	void BoxRowScalar(const uint8_t* row0, const uint8_t* row1, int32_t width, int32_t x, int32_t dstWidth, uint8_t* out)
+	{
+		for (; x < dstWidth; ++x)
+		{
+			const int32_t x0 = std::min(x * 2, width - 1) * 4;
+			const int32_t x1 = std::min(x * 2 + 1, width - 1) * 4;
+			for (int32_t c = 0; c < 4; ++c)
+			{
+				out[x * 4 + c] = (uint8_t)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) >> 2);
+			}
+		}
+	}
+
+	void KaiserRowScalar(const uint8_t* row, int32_t width, int32_t dstWidth, float* out)
+	{
+		const float* weights = GetKaiserWeights();
+		for (int32_t x = 0; x < dstWidth; ++x)
+		{
+			for (int32_t c = 0; c < 4; ++c)
+			{
+				float sum = 0.0f;
+				for (int32_t k = 0; k < 8; ++k)
+				{
+					const int32_t sx = std::min(std::max(x * 2 - 3 + k, 0), width - 1);
+					sum += (float)row[sx * 4 + c] * weights[k];
+				}
+				out[x * 4 + c] = sum;
+			}
+		}
+	}
+
+	void KaiserColumnScalar(const float* const* rows, int32_t dstWidth, uint8_t* out)
+	{
+		const float* weights = GetKaiserWeights();
+		for (int32_t i = 0; i < dstWidth * 4; ++i)
+		{
+			float sum = 0.0f;
+			for (int32_t k = 0; k < 8; ++k)
+			{
+				sum += rows[k][i] * weights[k];
+			}
+			out[i] = ToByte(sum);
+		}
+	}
+
+	void Pack565Scalar(const uint8_t* p, uint16_t* dst, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i, p += 4)
+		{
+			dst[i] = (uint16_t)(((p[0] >> 3) << 11) | ((p[1] >> 2) << 5) | (p[2] >> 3));
+		}
+	}
+
+	void PackRGB8Scalar(const uint8_t* p, uint8_t* dst, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i, p += 4, dst += 3)
+		{
+			dst[0] = p[0];
+			dst[1] = p[1];
+			dst[2] = p[2];
+		}
+	}
+
+#if defined (IMAGEKERNELS_SSE2)
+	//
+	// SSE2
+	//
+	inline __m128i MulDiv255SSE2(__m128i p)
+	{
+		return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(p, _mm_set1_epi16(1)), _mm_srli_epi16(p, 8)), 8);
+	}
+
+	void PremultiplySSE2(uint8_t* p, size_t count)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i alphaMask = _mm_set1_epi32((int)0xff000000);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4, p += 16)
+		{
+			const __m128i px = _mm_loadu_si128((const __m128i*)p);
+			__m128i lo = _mm_unpacklo_epi8(px, zero);
+			__m128i hi = _mm_unpackhi_epi8(px, zero);
+			const __m128i alo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			const __m128i ahi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			lo = MulDiv255SSE2(_mm_mullo_epi16(lo, alo));
+			hi = MulDiv255SSE2(_mm_mullo_epi16(hi, ahi));
+			const __m128i result = _mm_or_si128(_mm_andnot_si128(alphaMask, _mm_packus_epi16(lo, hi)), _mm_and_si128(alphaMask, px));
+			_mm_storeu_si128((__m128i*)p, result);
+		}
+		PremultiplyScalar(p, count - i);
+	}
+
+	void SwizzleSSE2(uint8_t* p, size_t count, const uint8_t order[4])
+	{
+		const __m128i byteMask = _mm_set1_epi32(0xff);
+		__m128i shiftRight[4];
+		__m128i shiftLeft[4];
+		for (int32_t c = 0; c < 4; ++c)
+		{
+			shiftRight[c] = _mm_cvtsi32_si128(order[c] * 8);
+			shiftLeft[c] = _mm_cvtsi32_si128(c * 8);
+		}
+
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4, p += 16)
+		{
+			const __m128i px = _mm_loadu_si128((const __m128i*)p);
+			__m128i result = _mm_setzero_si128();
+			for (int32_t c = 0; c < 4; ++c)
+			{
+				const __m128i channel = _mm_and_si128(_mm_srl_epi32(px, shiftRight[c]), byteMask);
+				result = _mm_or_si128(result, _mm_sll_epi32(channel, shiftLeft[c]));
+			}
+			_mm_storeu_si128((__m128i*)p, result);
+		}
+		SwizzleScalar(p, count - i, order);
+	}
+
+	void BoxRowSSE2(const uint8_t* row0, const uint8_t* row1, int32_t width, int32_t dstWidth, uint8_t* out)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i two = _mm_set1_epi16(2);
+		int32_t x = 0;
+		for (; x + 2 <= dstWidth; x += 2)
+		{
+			const __m128i a = _mm_loadu_si128((const __m128i*)(row0 + x * 8));
+			const __m128i b = _mm_loadu_si128((const __m128i*)(row1 + x * 8));
+			const __m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+			const __m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+			const __m128i sumLo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+			const __m128i sumHi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+			const __m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(sumLo, sumHi), two), 2);
+			_mm_storel_epi64((__m128i*)(out + x * 4), _mm_packus_epi16(sum, sum));
+		}
+		BoxRowScalar(row0, row1, width, x, dstWidth, out);
+	}
+
+	inline __m128 LoadPixelSSE2(const uint8_t* p)
+	{
+		int32_t packed;
+		memcpy(&packed, p, 4);
+		const __m128i zero = _mm_setzero_si128();
+		return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero));
+	}
+
+	void KaiserRowSSE2(const uint8_t* row, int32_t width, int32_t dstWidth, float* out)
+	{
+		const float* weights = GetKaiserWeights();
+		__m128 w[8];
+		for (int32_t k = 0; k < 8; ++k)
+		{
+			w[k] = _mm_set1_ps(weights[k]);
+		}
+
+		for (int32_t x = 0; x < dstWidth; ++x)
+		{
+			__m128 sum = _mm_setzero_ps();
+			for (int32_t k = 0; k < 8; ++k)
+			{
+				const int32_t sx = std::min(std::max(x * 2 - 3 + k, 0), width - 1);
+				sum = _mm_add_ps(sum, _mm_mul_ps(LoadPixelSSE2(row + sx * 4), w[k]));
+			}
+			_mm_storeu_ps(out + x * 4, sum);
+		}
+	}
+
+	void KaiserColumnSSE2(const float* const* rows, int32_t dstWidth, uint8_t* out)
+	{
+		const float* weights = GetKaiserWeights();
+		__m128 w[8];
+		for (int32_t k = 0; k < 8; ++k)
+		{
+			w[k] = _mm_set1_ps(weights[k]);
+		}
+
+		for (int32_t i = 0; i < dstWidth * 4; i += 4)
+		{
+			__m128 sum = _mm_setzero_ps();
+			for (int32_t k = 0; k < 8; ++k)
+			{
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(rows[k] + i), w[k]));
+			}
+			const __m128i ints = _mm_cvtps_epi32(sum);
+			const __m128i words = _mm_packs_epi32(ints, ints);
+			const int32_t packed = _mm_cvtsi128_si32(_mm_packus_epi16(words, words));
+			memcpy(out + i, &packed, 4);
+		}
+	}
+
+	inline __m128i Pack565LanesSSE2(__m128i px)
+	{
+		const __m128i r = _mm_slli_epi32(_mm_and_si128(px, _mm_set1_epi32(0xf8)), 8);
+		const __m128i g = _mm_slli_epi32(_mm_and_si128(_mm_srli_epi32(px, 8), _mm_set1_epi32(0xfc)), 3);
+		const __m128i b = _mm_and_si128(_mm_srli_epi32(px, 19), _mm_set1_epi32(0x1f));
+		// sign extend so the signed pack keeps all 16 bits
+		return _mm_srai_epi32(_mm_slli_epi32(_mm_or_si128(_mm_or_si128(r, g), b), 16), 16);
+	}
+
+	void Pack565SSE2(const uint8_t* p, uint16_t* dst, size_t count)
+	{
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8, p += 32)
+		{
+			const __m128i a = Pack565LanesSSE2(_mm_loadu_si128((const __m128i*)p));
+			const __m128i b = Pack565LanesSSE2(_mm_loadu_si128((const __m128i*)(p + 16)));
+			_mm_storeu_si128((__m128i*)(dst + i), _mm_packs_epi32(a, b));
+		}
+		Pack565Scalar(p, dst + i, count - i);
+	}
+#endif
+
+#if defined (IMAGEKERNELS_AVX2)
+	//
+	// AVX2
+	//
+	AVX2_FUNCTION void PremultiplyAVX2(uint8_t* p, size_t count)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i one = _mm256_set1_epi16(1);
+		const __m256i alphaMask = _mm256_set1_epi32((int)0xff000000);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8, p += 32)
+		{
+			const __m256i px = _mm256_loadu_si256((const __m256i*)p);
+			__m256i lo = _mm256_unpacklo_epi8(px, zero);
+			__m256i hi = _mm256_unpackhi_epi8(px, zero);
+			const __m256i alo = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(lo, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			const __m256i ahi = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(hi, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			lo = _mm256_mullo_epi16(lo, alo);
+			hi = _mm256_mullo_epi16(hi, ahi);
+			lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(lo, one), _mm256_srli_epi16(lo, 8)), 8);
+			hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(hi, one), _mm256_srli_epi16(hi, 8)), 8);
+			const __m256i result = _mm256_or_si256(_mm256_andnot_si256(alphaMask, _mm256_packus_epi16(lo, hi)), _mm256_and_si256(alphaMask, px));
+			_mm256_storeu_si256((__m256i*)p, result);
+		}
+		PremultiplySSE2(p, count - i);
+	}
+
+	AVX2_FUNCTION void SwizzleAVX2(uint8_t* p, size_t count, const uint8_t order[4])
+	{
+		alignas(32) uint8_t indices[32];
+		for (int32_t i = 0; i < 32; ++i)
+		{
+			indices[i] = (uint8_t)((i & ~3) + order[i & 3]);
+		}
+		const __m256i mask = _mm256_load_si256((const __m256i*)indices);
+
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8, p += 32)
+		{
+			_mm256_storeu_si256((__m256i*)p, _mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)p), mask));
+		}
+		SwizzleScalar(p, count - i, order);
+	}
+
+	AVX2_FUNCTION void BoxRowAVX2(const uint8_t* row0, const uint8_t* row1, int32_t width, int32_t dstWidth, uint8_t* out)
+	{
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i two = _mm256_set1_epi16(2);
+		int32_t x = 0;
+		for (; x + 4 <= dstWidth; x += 4)
+		{
+			const __m256i a = _mm256_loadu_si256((const __m256i*)(row0 + x * 8));
+			const __m256i b = _mm256_loadu_si256((const __m256i*)(row1 + x * 8));
+			const __m256i lo = _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero));
+			const __m256i hi = _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero));
+			const __m256i sumLo = _mm256_add_epi16(lo, _mm256_srli_si256(lo, 8));
+			const __m256i sumHi = _mm256_add_epi16(hi, _mm256_srli_si256(hi, 8));
+			const __m256i sum = _mm256_srli_epi16(_mm256_add_epi16(_mm256_unpacklo_epi64(sumLo, sumHi), two), 2);
+			// each lane holds two output pixels in its low half
+			const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(sum, sum), _MM_SHUFFLE(3, 1, 2, 0));
+			_mm_storeu_si128((__m128i*)(out + x * 4), _mm256_castsi256_si128(packed));
+		}
+		BoxRowScalar(row0, row1, width, x, dstWidth, out);
+	}
+
+	AVX2_FUNCTION void Pack565AVX2(const uint8_t* p, uint16_t* dst, size_t count)
+	{
+		const __m256i redMask = _mm256_set1_epi32(0xf8);
+		const __m256i greenMask = _mm256_set1_epi32(0xfc);
+		const __m256i blueMask = _mm256_set1_epi32(0x1f);
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16, p += 64)
+		{
+			__m256i v[2];
+			for (int32_t j = 0; j < 2; ++j)
+			{
+				const __m256i px = _mm256_loadu_si256((const __m256i*)(p + j * 32));
+				const __m256i r = _mm256_slli_epi32(_mm256_and_si256(px, redMask), 8);
+				const __m256i g = _mm256_slli_epi32(_mm256_and_si256(_mm256_srli_epi32(px, 8), greenMask), 3);
+				const __m256i b = _mm256_and_si256(_mm256_srli_epi32(px, 19), blueMask);
+				v[j] = _mm256_srai_epi32(_mm256_slli_epi32(_mm256_or_si256(_mm256_or_si256(r, g), b), 16), 16);
+			}
+			const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(v[0], v[1]), _MM_SHUFFLE(3, 1, 2, 0));
+			_mm256_storeu_si256((__m256i*)(dst + i), packed);
+		}
+		Pack565SSE2(p, dst + i, count - i);
+	}
+
+	AVX2_FUNCTION void PackRGB8AVX2(const uint8_t* p, uint8_t* dst, size_t count)
+	{
+		// drop every fourth byte within each lane, then close the gap between the lanes
+		const __m256i shuffle = _mm256_setr_epi8(
+			0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+			0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+		const __m256i compact = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+		size_t i = 0;
+		for (; i + 8 <= count; i += 8, p += 32, dst += 24)
+		{
+			const __m256i rgb = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(_mm256_loadu_si256((const __m256i*)p), shuffle), compact);
+			_mm_storeu_si128((__m128i*)dst, _mm256_castsi256_si128(rgb));
+			_mm_storel_epi64((__m128i*)(dst + 16), _mm256_extracti128_si256(rgb, 1));
+		}
+		PackRGB8Scalar(p, dst, count - i);
+	}
+#endif
+}
+
+
+ImageKernels::SIMD ImageKernels::GetSupportedSimd()
+{
+	static const SIMD supported = []()
+	{
+		SIMD detected = SIMD_NONE;
+#if defined (IMAGEKERNELS_SSE2)
+		detected = SIMD_SSE2;
+#if defined (IMAGEKERNELS_AVX2) && defined (_MSC_VER)
+		int32_t info[4];
+		__cpuid(info, 0);
+		if (info[0] >= 7)
+		{
+			// avx needs os support for saving the ymm registers
+			__cpuid(info, 1);
+			const bool osxsave = (info[2] & (1 << 27)) != 0;
+			const bool avx = (info[2] & (1 << 28)) != 0;
+			if (osxsave && avx && (_xgetbv(0) & 6) == 6)
+			{
+				__cpuidex(info, 7, 0);
+				if (info[1] & (1 << 5))
+				{
+					detected = SIMD_AVX2;
+				}
+			}
+		}
+#elif defined (IMAGEKERNELS_AVX2)
+		__builtin_cpu_init();
+		if (__builtin_cpu_supports("avx2"))
+		{
+			detected = SIMD_AVX2;
+		}
+#endif
+#endif
+		return detected;
+	}();
+	return supported;
+}
+
+
+void ImageKernels::SetSimd(SIMD simd)
+{
+	CurrentSimd() = std::min(simd, GetSupportedSimd());
+}
+
+
+ImageKernels::SIMD ImageKernels::GetSimd()
+{
+	return CurrentSimd();
+}
+
+
+void ImageKernels::SetThreadCount(uint32_t count)
+{
+	g_uThreadCount = count;
+}
+
+
+void ImageKernels::PremultiplyAlpha(uint8_t* rgba, int32_t width, int32_t height)
+{
+	const SIMD simd = GetSimd();
+	ParallelRows(height, (size_t)width * 4, [=](int32_t begin, int32_t end)
+	{
+		uint8_t* p = rgba + (size_t)begin * width * 4;
+		const size_t count = (size_t)(end - begin) * width;
+		switch (simd)
+		{
+#if defined (IMAGEKERNELS_AVX2)
+		case SIMD_AVX2: PremultiplyAVX2(p, count); break;
+#endif
+#if defined (IMAGEKERNELS_SSE2)
+		case SIMD_SSE2: PremultiplySSE2(p, count); break;
+#endif
+		default: PremultiplyScalar(p, count); break;
+		}
+	});
+}
+
+
+void ImageKernels::SrgbToLinear(const uint8_t* rgba, float* dst, int32_t width, int32_t height)
+{
+	// a 256 entry table beats evaluating the curve with any instruction set
+	static const std::array<float, 256> table = []()
+	{
+		std::array<float, 256> table;
+		for (int32_t i = 0; i < 256; ++i)
+		{
+			const float c = i / 255.0f;
+			table[i] = (c <= 0.04045f) ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+		}
+		return table;
+	}();
+
+	ParallelRows(height, (size_t)width * 4, [=](int32_t begin, int32_t end)
+	{
+		const size_t first = (size_t)begin * width * 4;
+		const size_t last = (size_t)end * width * 4;
+		for (size_t i = first; i < last; i += 4)
+		{
+			dst[i] = table[rgba[i]];
+			dst[i + 1] = table[rgba[i + 1]];
+			dst[i + 2] = table[rgba[i + 2]];
+			dst[i + 3] = rgba[i + 3] / 255.0f;
+		}
+	});
+}
+
+
+void ImageKernels::Swizzle(uint8_t* rgba, int32_t width, int32_t height, const uint8_t order[4])
+{
+	const SIMD simd = GetSimd();
+	const uint8_t channels[4] = { (uint8_t)(order[0] & 3), (uint8_t)(order[1] & 3), (uint8_t)(order[2] & 3), (uint8_t)(order[3] & 3) };
+	ParallelRows(height, (size_t)width * 4, [=, &channels](int32_t begin, int32_t end)
+	{
+		uint8_t* p = rgba + (size_t)begin * width * 4;
+		const size_t count = (size_t)(end - begin) * width;
+		switch (simd)
+		{
+#if defined (IMAGEKERNELS_AVX2)
+		case SIMD_AVX2: SwizzleAVX2(p, count, channels); break;
+#endif
+#if defined (IMAGEKERNELS_SSE2)
+		case SIMD_SSE2: SwizzleSSE2(p, count, channels); break;
+#endif
+		default: SwizzleScalar(p, count, channels); break;
+		}
+	});
+}
+
+
+void ImageKernels::DownsampleBox(const uint8_t* src, int32_t width, int32_t height, std::vector<uint8_t>& dst)
+{
+	const int32_t dstWidth = std::max(width >> 1, 1);
+	const int32_t dstHeight = std::max(height >> 1, 1);
+	dst.resize((size_t)dstWidth * dstHeight * 4);
+	uint8_t* out = dst.data();
+
+	// vector paths need two source columns per output texel
+	const SIMD simd = (width > 1) ? GetSimd() : SIMD_NONE;
+	ParallelRows(dstHeight, (size_t)width * 8, [=](int32_t begin, int32_t end)
+	{
+		for (int32_t y = begin; y < end; ++y)
+		{
+			const uint8_t* row0 = src + (size_t)std::min(y * 2, height - 1) * width * 4;
+			const uint8_t* row1 = src + (size_t)std::min(y * 2 + 1, height - 1) * width * 4;
+			uint8_t* row = out + (size_t)y * dstWidth * 4;
+			switch (simd)
+			{
+#if defined (IMAGEKERNELS_AVX2)
+			case SIMD_AVX2: BoxRowAVX2(row0, row1, width, dstWidth, row); break;
+#endif
+#if defined (IMAGEKERNELS_SSE2)
+			case SIMD_SSE2: BoxRowSSE2(row0, row1, width, dstWidth, row); break;
+#endif
+			default: BoxRowScalar(row0, row1, width, 0, dstWidth, row); break;
+			}
+		}
+	});
+}
+
+
+void ImageKernels::DownsampleKaiser(const uint8_t* src, int32_t width, int32_t height, std::vector<uint8_t>& dst)
+{
+	const int32_t dstWidth = std::max(width >> 1, 1);
+	const int32_t dstHeight = std::max(height >> 1, 1);
+	dst.resize((size_t)dstWidth * dstHeight * 4);
+	uint8_t* out = dst.data();
+
+	// horizontal pass into a float image, then vertical pass. AVX2 uses the
+	// SSE2 path, a texel is exactly one 4 wide float vector
+	const bool vector = GetSimd() != SIMD_NONE;
+	std::vector<float> horizontal((size_t)dstWidth * height * 4);
+	float* tmp = horizontal.data();
+
+	ParallelRows(height, (size_t)width * 4, [=](int32_t begin, int32_t end)
+	{
+		for (int32_t y = begin; y < end; ++y)
+		{
+			const uint8_t* row = src + (size_t)y * width * 4;
+			float* rowOut = tmp + (size_t)y * dstWidth * 4;
+#if defined (IMAGEKERNELS_SSE2)
+			if (vector)
+			{
+				KaiserRowSSE2(row, width, dstWidth, rowOut);
+				continue;
+			}
+#endif
+			KaiserRowScalar(row, width, dstWidth, rowOut);
+		}
+	});
+
+	ParallelRows(dstHeight, (size_t)dstWidth * 32 * 8, [=](int32_t begin, int32_t end)
+	{
+		for (int32_t y = begin; y < end; ++y)
+		{
+			const float* rows[8];
+			for (int32_t k = 0; k < 8; ++k)
+			{
+				rows[k] = tmp + (size_t)std::min(std::max(y * 2 - 3 + k, 0), height - 1) * dstWidth * 4;
+			}
+			uint8_t* rowOut = out + (size_t)y * dstWidth * 4;
+#if defined (IMAGEKERNELS_SSE2)
+			if (vector)
+			{
+				KaiserColumnSSE2(rows, dstWidth, rowOut);
+				continue;
+			}
+#endif
+			KaiserColumnScalar(rows, dstWidth, rowOut);
+		}
+	});
+}
+
+
+void ImageKernels::PackRGB565(const uint8_t* rgba, uint16_t* dst, int32_t width, int32_t height)
+{
+	const SIMD simd = GetSimd();
+	ParallelRows(height, (size_t)width * 4, [=](int32_t begin, int32_t end)
+	{
+		const uint8_t* p = rgba + (size_t)begin * width * 4;
+		uint16_t* out = dst + (size_t)begin * width;
+		const size_t count = (size_t)(end - begin) * width;
+		switch (simd)
+		{
+#if defined (IMAGEKERNELS_AVX2)
+		case SIMD_AVX2: Pack565AVX2(p, out, count); break;
+#endif
+#if defined (IMAGEKERNELS_SSE2)
+		case SIMD_SSE2: Pack565SSE2(p, out, count); break;
+#endif
+		default: Pack565Scalar(p, out, count); break;
+		}
+	});
+}
+
+
+void ImageKernels::PackRGB8(const uint8_t* rgba, uint8_t* dst, int32_t width, int32_t height)
+{
+	// SSE2 has no byte shuffle, it uses the scalar path
+	const SIMD simd = GetSimd();
+	ParallelRows(height, (size_t)width * 4, [=](int32_t begin, int32_t end)
+	{
+		const uint8_t* p = rgba + (size_t)begin * width * 4;
+		uint8_t* out = dst + (size_t)begin * width * 3;
+		const size_t count = (size_t)(end - begin) * width;
+#if defined (IMAGEKERNELS_AVX2)
+		if (simd == SIMD_AVX2)
+		{
+			PackRGB8AVX2(p, out, count);
+			return;
+		}
+#endif
+		PackRGB8Scalar(p, out, count);
+	});
+}
+
+
+std::vector<ImageKernels::BENCHMARK> ImageKernels::Benchmark(int32_t width, int32_t height, int32_t iterations)
+{
+	const size_t pixelCount = (size_t)width * height;
+
+	// deterministic noise with every alpha value present
+	std::vector<uint8_t> source(pixelCount * 4);
+	uint32_t seed = 0x12345678;
+	for (auto& byte : source)
+	{
+		seed = seed * 1664525 + 1013904223;
+		byte = (uint8_t)(seed >> 24);
+	}
+
+	struct KERNEL
+	{
+		const char*		name;
+		void			(*run)(const std::vector<uint8_t>& src, int32_t width, int32_t height, std::vector<uint8_t>& out);
+	};
+	static const KERNEL kernels[] =
+	{
+		{ "PremultiplyAlpha", [](const std::vector<uint8_t>& src, int32_t w, int32_t h, std::vector<uint8_t>& out)
+			{ out = src; ImageKernels::PremultiplyAlpha(out.data(), w, h); } },
+		{ "SrgbToLinear", [](const std::vector<uint8_t>& src, int32_t w, int32_t h, std::vector<uint8_t>& out)
+			{ out.resize(src.size() * sizeof(float)); ImageKernels::SrgbToLinear(src.data(), (float*)out.data(), w, h); } },
+		{ "Swizzle", [](const std::vector<uint8_t>& src, int32_t w, int32_t h, std::vector<uint8_t>& out)
+			{ static const uint8_t bgra[4] = { 2, 1, 0, 3 }; out = src; ImageKernels::Swizzle(out.data(), w, h, bgra); } },
+		{ "DownsampleBox", [](const std::vector<uint8_t>& src, int32_t w, int32_t h, std::vector<uint8_t>& out)
+			{ ImageKernels::DownsampleBox(src.data(), w, h, out); } },
+		{ "DownsampleKaiser", [](const std::vector<uint8_t>& src, int32_t w, int32_t h, std::vector<uint8_t>& out)
+			{ ImageKernels::DownsampleKaiser(src.data(), w, h, out); } },
+		{ "PackRGB565", [](const std::vector<uint8_t>& src, int32_t w, int32_t h, std::vector<uint8_t>& out)
+			{ out.resize(src.size() / 2); ImageKernels::PackRGB565(src.data(), (uint16_t*)out.data(), w, h); } },
+		{ "PackRGB8", [](const std::vector<uint8_t>& src, int32_t w, int32_t h, std::vector<uint8_t>& out)
+			{ out.resize(src.size() / 4 * 3); ImageKernels::PackRGB8(src.data(), out.data(), w, h); } },
+	};
+
+	const SIMD previous = GetSimd();
+	std::vector<BENCHMARK> results;
+	std::vector<uint8_t> reference;
+	std::vector<uint8_t> output;
+	for (const auto& kernel : kernels)
+	{
+		for (int32_t simd = SIMD_NONE; simd <= GetSupportedSimd(); ++simd)
+		{
+			SetSimd((SIMD)simd);
+			kernel.run(source, width, height, output);
+
+			const uint64_t start = Timer::GetTicks();
+			for (int32_t i = 0; i < iterations; ++i)
+			{
+				kernel.run(source, width, height, output);
+			}
+			const double seconds = (Timer::GetTicks() - start) * Timer::GetSecondsPerTick();
+
+			if (simd == SIMD_NONE)
+			{
+				reference = output;
+			}
+			results.push_back({ kernel.name, (SIMD)simd, seconds * 1000.0 / std::max(iterations, 1), output == reference });
+		}
+	}
+	SetSimd(previous);
+	return results;
+}
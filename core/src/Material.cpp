@@ -19,7 +19,7 @@ Material::Material() :
 }
 
 
-void Material::SetToProgram(GLuint program)
+void Material::SetToProgram(GLuint program) const
 {
 	OpenGLRenderer::SetUniformVec4(program, "materialAmbient", m_cAmbient);
 	OpenGLRenderer::SetUniformVec4(program, "materialDiffuse", m_cDiffuse);
@@ -29,3 +29,27 @@ void Material::SetToProgram(GLuint program)
 }
 
 
+uint64_t Material::GetFeatures() const
+{
+	uint64_t features = 0;
+	if (m_fSpecularPower > 0.9f && m_cSpecular != glm::vec4(0.0f))
+	{
+		features |= FEATURE_SPECULAR;
+	}
+	if (m_cEmissive != glm::vec4(0.0f))
+	{
+		features |= FEATURE_EMISSIVE;
+	}
+	return features;
+}
+
+
+const char* Material::GetFeatureName(uint32_t index)
+{
+	static const char* names[FEATURE_COUNT] =
+	{
+		"SPECULAR",
+		"EMISSIVE"
+	};
+	return index < FEATURE_COUNT ? names[index] : nullptr;
+}
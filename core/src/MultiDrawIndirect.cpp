@@ -0,0 +1,346 @@
+/**
+ * ============================================================================
+ *  Name        : MultiDrawIndirect.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : submits a draw queue with a single glMultiDrawElementsIndirect
+ *                per draw mode. All geometry lives in shared vertex and index
+ *                buffers, per draw data is fetched in shader with gl_DrawIDARB.
+ * ============================================================================
+**/
+
+#include "../include/MultiDrawIndirect.h"
+#include "../include/Geometry.h"
+#include "../include/Material.h"
+#include "../include/StreamBuffer.h"
+#include <algorithm>
+
+
+MultiDrawIndirect::MultiDrawIndirect() :
+	m_bEnabled(false),
+	m_bGeometryDirty(false),
+	m_VertexBuffer(0),
+	m_PositionBuffer(0),
+	m_IndexBuffer(0),
+	m_CommandBuffer(0),
+	m_DrawDataBuffer(0),
+	m_uDrawCount(0),
+	m_uDrawCallCount(0)
+{
+}
+
+
+MultiDrawIndirect::~MultiDrawIndirect()
+{
+	Release();
+}
+
+
+bool MultiDrawIndirect::IsSupported()
+{
+	return glMultiDrawElementsIndirect &&
+		glBindBufferBase &&
+		glBufferSubData &&
+		OpenGLRenderer::GetVersion() >= 43 &&
+		OpenGLRenderer::HasExtension("GL_ARB_shader_draw_parameters");
+}
+
+
+bool MultiDrawIndirect::Create()
+{
+	Release();
+
+	m_bEnabled = IsSupported();
+	if (!m_bEnabled)
+	{
+		IApplication::Debug("MultiDrawIndirect: not supported, using per draw path\n");
+		return false;
+	}
+
+	GLuint buffers[5];
+	glGenBuffers(5, buffers);
+	m_VertexBuffer = buffers[0];
+	m_IndexBuffer = buffers[1];
+	m_CommandBuffer = buffers[2];
+	m_DrawDataBuffer = buffers[3];
+	m_PositionBuffer = buffers[4];
+	return true;
+}
+
+
+void MultiDrawIndirect::Release()
+{
+	if (m_VertexBuffer)
+	{
+		const GLuint buffers[5] = { m_VertexBuffer, m_IndexBuffer, m_CommandBuffer, m_DrawDataBuffer, m_PositionBuffer };
+		glDeleteBuffers(5, buffers);
+		m_VertexBuffer = 0;
+		m_PositionBuffer = 0;
+		m_IndexBuffer = 0;
+		m_CommandBuffer = 0;
+		m_DrawDataBuffer = 0;
+	}
+
+	m_arrVertexData.clear();
+	m_arrPositionData.clear();
+	m_arrIndexData.clear();
+	m_mapMeshes.clear();
+	m_arrGeometries.clear();
+	m_bEnabled = false;
+}
+
+
+const MultiDrawIndirect::MESH& MultiDrawIndirect::Register(const std::shared_ptr<Geometry>& geometry)
+{
+	auto it = m_mapMeshes.find(geometry.get());
+	if (it != m_mapMeshes.end())
+	{
+		return it->second;
+	}
+
+	MESH mesh;
+	mesh.firstIndex = (GLuint)m_arrIndexData.size();
+	mesh.baseVertex = (GLint)(m_arrVertexData.size() / Geometry::VERTEX::GetStride());
+
+	// append the vertices
+	const uint8_t* vertices = (const uint8_t*)geometry->GetData();
+	mesh.vertexCount = (GLuint)geometry->GetVertexCount();
+	m_arrVertexData.insert(m_arrVertexData.end(), vertices, vertices + geometry->GetVertexCount() * Geometry::VERTEX::GetStride());
+
+	// append the indices, non-indexed geometry gets a sequential index list
+	if (geometry->GetIndexCount())
+	{
+		m_arrIndexData.insert(m_arrIndexData.end(), geometry->GetIndices(), geometry->GetIndices() + geometry->GetIndexCount());
+	}
+	else
+	{
+		for (uint32_t i = 0; i < (uint32_t)geometry->GetVertexCount(); ++i)
+		{
+			m_arrIndexData.push_back(i);
+		}
+	}
+	mesh.indexCount = (GLuint)m_arrIndexData.size() - mesh.firstIndex;
+
+	// keep the geometry alive, the map is keyed by its address
+	m_arrGeometries.push_back(geometry);
+	m_bGeometryDirty = true;
+
+	return m_mapMeshes.emplace(geometry.get(), mesh).first->second;
+}
+
+
+void MultiDrawIndirect::Unregister(const Geometry* geometry)
+{
+	auto it = m_mapMeshes.find(geometry);
+	if (it == m_mapMeshes.end())
+	{
+		return;
+	}
+	const MESH mesh = it->second;
+	m_mapMeshes.erase(it);
+
+	// close the gap, indices are relative to the base vertex so only the ranges of later meshes move
+	const size_t stride = Geometry::VERTEX::GetStride();
+	m_arrVertexData.erase(m_arrVertexData.begin() + mesh.baseVertex * stride, m_arrVertexData.begin() + (mesh.baseVertex + mesh.vertexCount) * stride);
+	m_arrIndexData.erase(m_arrIndexData.begin() + mesh.firstIndex, m_arrIndexData.begin() + mesh.firstIndex + mesh.indexCount);
+	for (auto& other : m_mapMeshes)
+	{
+		if (other.second.baseVertex > mesh.baseVertex)
+		{
+			other.second.baseVertex -= (GLint)mesh.vertexCount;
+		}
+		if (other.second.firstIndex > mesh.firstIndex)
+		{
+			other.second.firstIndex -= mesh.indexCount;
+		}
+	}
+
+	m_arrGeometries.erase(std::find_if(m_arrGeometries.begin(), m_arrGeometries.end(),
+		[geometry](const std::shared_ptr<Geometry>& registered) { return registered.get() == geometry; }));
+	m_bGeometryDirty = true;
+}
+
+
+void MultiDrawIndirect::EvictUnused()
+{
+	// geometry released by the scene is only kept alive by the list
+	for (size_t i = m_arrGeometries.size(); i-- > 0;)
+	{
+		if (m_arrGeometries[i].use_count() == 1)
+		{
+			Unregister(m_arrGeometries[i].get());
+		}
+	}
+}
+
+
+void MultiDrawIndirect::UploadGeometry()
+{
+	glBindBuffer(GL_ARRAY_BUFFER, m_VertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, m_arrVertexData.size(), m_arrVertexData.data(), GL_STATIC_DRAW);
+
+	// same vertices without normals and uvs, base vertices stay valid
+	const size_t vertexCount = m_arrVertexData.size() / Geometry::VERTEX::GetStride();
+	const Geometry::VERTEX* vertices = (const Geometry::VERTEX*)m_arrVertexData.data();
+	m_arrPositionData.resize(vertexCount);
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		m_arrPositionData[i] = glm::vec3(vertices[i].x, vertices[i].y, vertices[i].z);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, m_PositionBuffer);
+	glBufferData(GL_ARRAY_BUFFER, m_arrPositionData.size() * sizeof(glm::vec3), m_arrPositionData.data(), GL_STATIC_DRAW);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_arrIndexData.size() * sizeof(uint32_t), m_arrIndexData.data(), GL_STATIC_DRAW);
+	m_bGeometryDirty = false;
+}
+
+
+void MultiDrawIndirect::Submit(IRenderer& renderer, const DrawQueue& queue, GLuint program)
+{
+	const auto& draws = queue.GetDraws();
+	m_uDrawCount = (uint32_t)draws.size();
+	m_uDrawCallCount = 0;
+
+	if (!m_bEnabled)
+	{
+		// fall back to one draw call per draw
+		for (const auto& draw : draws)
+		{
+			DrawQueue::DrawImmediate(renderer, program, draw);
+		}
+		m_uDrawCallCount = m_uDrawCount;
+		return;
+	}
+
+	if (draws.empty())
+	{
+		return;
+	}
+	EvictUnused();
+
+	// per frame data is written straight into the renderer stream buffer when it has room,
+	// otherwise into cpu arrays that are uploaded with glBufferData
+	StreamBuffer* stream = static_cast<OpenGLRenderer&>(renderer).GetStreamBuffer();
+	StreamBuffer::ALLOCATION commandAllocation = { nullptr, 0, 0 };
+	StreamBuffer::ALLOCATION drawDataAllocation = { nullptr, 0, 0 };
+	if (stream)
+	{
+		commandAllocation = stream->Allocate(draws.size() * sizeof(DrawElementsIndirectCommand));
+		drawDataAllocation = stream->Allocate(draws.size() * sizeof(DRAWDATA));
+	}
+
+	const bool streamed = commandAllocation.data && drawDataAllocation.data;
+	if (!streamed)
+	{
+		m_arrCommands.resize(draws.size());
+		m_arrDrawData.resize(draws.size());
+	}
+	auto* commands = streamed ? (DrawElementsIndirectCommand*)commandAllocation.data : m_arrCommands.data();
+	auto* drawData = streamed ? (DRAWDATA*)drawDataAllocation.data : m_arrDrawData.data();
+
+	// build commands and per draw data, one multi draw per primitive mode
+	static constexpr GLenum drawModes[] = { GL_TRIANGLES, GL_TRIANGLE_STRIP };
+	size_t groupStart[2] = { 0, 0 };
+	size_t groupCount[2] = { 0, 0 };
+
+	const Material defaultMaterial;
+	size_t count = 0;
+	for (size_t group = 0; group < 2; ++group)
+	{
+		groupStart[group] = count;
+		for (const auto& draw : draws)
+		{
+			if (draw.geometry->GetDrawMode() != drawModes[group])
+			{
+				continue;
+			}
+
+			const MESH& mesh = Register(draw.geometry);
+			commands[count] = { mesh.indexCount, 1, mesh.firstIndex, mesh.baseVertex, 0 };
+
+			const Material& material = draw.material ? *draw.material : defaultMaterial;
+			DRAWDATA& data = drawData[count];
+			data.modelMatrix = draw.worldMatrix;
+			data.materialAmbient = material.m_cAmbient;
+			data.materialDiffuse = material.m_cDiffuse;
+			data.materialSpecular = material.m_cSpecular;
+			data.materialEmissive = material.m_cEmissive;
+			data.materialParams = glm::vec4(material.m_fSpecularPower, 0.0f, 0.0f, 0.0f);
+			++count;
+		}
+		groupCount[group] = count - groupStart[group];
+	}
+
+	if (m_bGeometryDirty)
+	{
+		UploadGeometry();
+	}
+
+	GLintptr commandOffset = 0;
+	if (streamed)
+	{
+		stream->Flush(commandAllocation);
+		stream->Flush(drawDataAllocation);
+
+		commandOffset = commandAllocation.offset;
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, stream->GetBuffer());
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, stream->GetBuffer(), drawDataAllocation.offset, drawDataAllocation.size);
+	}
+	else
+	{
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_CommandBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, count * sizeof(DrawElementsIndirectCommand), m_arrCommands.data(), GL_STREAM_DRAW);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_DrawDataBuffer);
+		glBufferData(GL_SHADER_STORAGE_BUFFER, count * sizeof(DRAWDATA), m_arrDrawData.data(), GL_STREAM_DRAW);
+		glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_DrawDataBuffer);
+	}
+
+	// shared view-projection, model matrices come from the draw data
+	OpenGLRenderer::SetUniformMatrix4(program, "viewProjectionMatrix", renderer.GetProjectionMatrix() * renderer.GetViewMatrix());
+
+	// vertex attributes from the shared vertex buffer
+	const GLint position = glGetAttribLocation(program, "position");
+	const GLint normal = glGetAttribLocation(program, "normal");
+	const GLint uv = glGetAttribLocation(program, "uv");
+	const bool positionOnly = normal == -1 && uv == -1;
+	const GLsizei stride = positionOnly ? (GLsizei)sizeof(glm::vec3) : Geometry::VERTEX::GetStride();
+
+	glBindBuffer(GL_ARRAY_BUFFER, positionOnly ? m_PositionBuffer : m_VertexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndexBuffer);
+	glEnableVertexAttribArray(position);
+	glVertexAttribPointer(position, 3, GL_FLOAT, GL_FALSE, stride, (const void*)0);
+	if (!positionOnly)
+	{
+		glEnableVertexAttribArray(normal);
+		glVertexAttribPointer(normal, 3, GL_FLOAT, GL_FALSE, stride, (const void*)(sizeof(float) * 3));
+		glEnableVertexAttribArray(uv);
+		glVertexAttribPointer(uv, 2, GL_FLOAT, GL_FALSE, stride, (const void*)(sizeof(float) * 6));
+	}
+
+	const GLint drawOffsetLocation = glGetUniformLocation(program, "drawOffset");
+	for (size_t group = 0; group < 2; ++group)
+	{
+		if (groupCount[group])
+		{
+			// gl_DrawIDARB restarts from zero on every call
+			glUniform1i(drawOffsetLocation, (GLint)groupStart[group]);
+			glMultiDrawElementsIndirect(drawModes[group],
+				GL_UNSIGNED_INT,
+				(const void*)(commandOffset + groupStart[group] * sizeof(DrawElementsIndirectCommand)),
+				(GLsizei)groupCount[group],
+				0);
+			++m_uDrawCallCount;
+		}
+	}
+
+	// rest of the engine uses client side vertex arrays
+	glDisableVertexAttribArray(position);
+	if (!positionOnly)
+	{
+		glDisableVertexAttribArray(normal);
+		glDisableVertexAttribArray(uv);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
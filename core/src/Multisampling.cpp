@@ -0,0 +1,144 @@
+/**
+ * ============================================================================
+ *  Name        : Multisampling.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : multisampled offscreen target with explicit resolve
+ * ============================================================================
+**/
+
+#include "../include/Multisampling.h"
+#include <algorithm>
+
+
+Multisampling::Multisampling() :
+	m_iSamples(0),
+	m_vSize(0),
+	m_uFramebuffer(0),
+	m_uColor(0),
+	m_uDepth(0)
+{
+}
+
+
+Multisampling::~Multisampling()
+{
+	Release();
+}
+
+
+bool Multisampling::IsSupported()
+{
+	return glGenFramebuffers && glRenderbufferStorageMultisample && glBlitFramebuffer;
+}
+
+
+bool Multisampling::Create(int32_t samples)
+{
+	Release();
+	if (!IsSupported())
+	{
+		IApplication::Debug("Multisampling: multisampled framebuffers not supported\n");
+		return false;
+	}
+
+	GLint maxSamples = 0;
+	glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+	m_iSamples = std::min(samples, (int32_t)maxSamples);
+	if (m_iSamples < 2)
+	{
+		IApplication::Debug("Multisampling: " + std::to_string(samples) + " samples not supported\n");
+		return false;
+	}
+
+	glEnable(GL_MULTISAMPLE);
+	return true;
+}
+
+
+void Multisampling::Release()
+{
+	ReleaseTarget();
+	m_iSamples = 0;
+}
+
+
+bool Multisampling::CreateTarget(int32_t width, int32_t height)
+{
+	ReleaseTarget();
+
+	glGenRenderbuffers(1, &m_uColor);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_uColor);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_iSamples, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &m_uDepth);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_uDepth);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, m_iSamples, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_uFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uFramebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_uColor);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_uDepth);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_uDepth);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		IApplication::Debug("Multisampling: framebuffer is incomplete\n");
+		ReleaseTarget();
+		return false;
+	}
+
+	m_vSize = glm::ivec2(width, height);
+	return true;
+}
+
+
+void Multisampling::ReleaseTarget()
+{
+	if (m_uFramebuffer)
+	{
+		glDeleteFramebuffers(1, &m_uFramebuffer);
+		m_uFramebuffer = 0;
+	}
+	if (m_uDepth)
+	{
+		glDeleteRenderbuffers(1, &m_uDepth);
+		m_uDepth = 0;
+	}
+	if (m_uColor)
+	{
+		glDeleteRenderbuffers(1, &m_uColor);
+		m_uColor = 0;
+	}
+	m_vSize = glm::ivec2(0);
+}
+
+
+void Multisampling::BeginFrame(int32_t width, int32_t height)
+{
+	width = std::max(width, 1);
+	height = std::max(height, 1);
+	if (m_iSamples && m_vSize != glm::ivec2(width, height))
+	{
+		CreateTarget(width, height);
+	}
+	if (m_uFramebuffer)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_uFramebuffer);
+	}
+}
+
+
+void Multisampling::Resolve(GLuint framebuffer, const glm::ivec2& size)
+{
+	PROFILE_SCOPE("Multisampling::Resolve");
+
+	if (m_uFramebuffer)
+	{
+		// only color, nothing after the resolve tests depth
+		const glm::ivec2 area(glm::min(size, m_vSize));
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_uFramebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+		glBlitFramebuffer(0, 0, area.x, area.y, 0, 0, area.x, area.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
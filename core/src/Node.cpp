@@ -10,6 +10,7 @@
 
 Node::Node() :
 	m_mModel(1.0f),
+	m_mPreviousModel(1.0f),
 	m_pParent(nullptr),
 	m_vRotationAxis(0.0f, 0.0f, -1.0f),
 	m_fRotationAngle(0.0f),
@@ -21,6 +22,7 @@ Node::Node() :
 
 Node::Node(const std::string_view& name) :
 	m_mModel(1.0f),
+	m_mPreviousModel(1.0f),
 	m_pParent(nullptr),
 	m_vRotationAxis(0.0f, 0.0f, -1.0f),
 	m_fRotationAngle(0.0f),
@@ -49,6 +51,11 @@ void Node::AddNode(std::shared_ptr<Node> node)
 
 void Node::Update(float frametime)
 {
+	PROFILE_SCOPE("Node::Update");
+
+	// motion vectors compare against the matrix the last frame was drawn with
+	m_mPreviousModel = m_mModel;
+
 	// update position per velocity
 	auto pos = GetPos();
 	pos += m_vVelocity * frametime;
@@ -77,6 +84,8 @@ void Node::Update(float frametime)
 
 void Node::Render(IRenderer& renderer, GLuint program)
 {
+	PROFILE_SCOPE("Node::Render");
+
 	for (auto& node : m_arrNodes)
 	{
 		node->Render(renderer, program);
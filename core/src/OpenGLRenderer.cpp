@@ -7,6 +7,19 @@
 **/
 
 #include "../include/OpenGLRenderer.h"
+#include "../include/StreamBuffer.h"
+#include "../include/CompressedTexture.h"
+#include "../include/ImageKernels.h"
+#include "../include/ProgramCache.h"
+#include "../include/GpuProfiler.h"
+#include "../include/DeferredShading.h"
+#include "../include/DynamicResolution.h"
+#include "../include/PostProcess.h"
+#include "../include/Multisampling.h"
+#include "../include/Fxaa.h"
+#include "../include/FramePacer.h"
+#include <algorithm>
+#include <filesystem>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "../include/stb_image.h"
@@ -73,12 +86,45 @@ PFNGLDELETERENDERBUFFERSPROC glDeleteRenderbuffers = nullptr;
 PFNGLBINDFRAMEBUFFERPROC glBindFramebuffer = nullptr;
 PFNGLBINDRENDERBUFFERPROC glBindRenderbuffer = nullptr;
 PFNGLRENDERBUFFERSTORAGEPROC glRenderbufferStorage = nullptr;
+PFNGLRENDERBUFFERSTORAGEMULTISAMPLEPROC glRenderbufferStorageMultisample = nullptr;
 PFNGLFRAMEBUFFERTEXTURE2DPROC glFramebufferTexture2D = nullptr;
 PFNGLFRAMEBUFFERTEXTUREPROC glFramebufferTexture = nullptr;
 PFNGLFRAMEBUFFERRENDERBUFFERPROC glFramebufferRenderbuffer = nullptr;
 PFNGLCHECKFRAMEBUFFERSTATUSPROC glCheckFramebufferStatus = nullptr;
 PFNGLCLEARDEPTHFPROC glClearDepthf = nullptr;
 PFNGLGENERATEMIPMAPPROC glGenerateMipmap = nullptr;
+PFNGLBLITFRAMEBUFFERPROC glBlitFramebuffer = nullptr;
+PFNGLDRAWBUFFERSPROC glDrawBuffers = nullptr;
+
+// GL 3.0+ buffers and multi draw
+PFNGLGETSTRINGIPROC glGetStringi = nullptr;
+PFNGLBUFFERSUBDATAPROC glBufferSubData = nullptr;
+PFNGLBINDBUFFERBASEPROC glBindBufferBase = nullptr;
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glMultiDrawElementsIndirect = nullptr;
+PFNGLBINDBUFFERRANGEPROC glBindBufferRange = nullptr;
+
+// persistently mapped buffers and sync objects
+PFNGLBUFFERSTORAGEPROC glBufferStorage = nullptr;
+PFNGLMAPBUFFERRANGEPROC glMapBufferRange = nullptr;
+PFNGLUNMAPBUFFERPROC glUnmapBuffer = nullptr;
+PFNGLFENCESYNCPROC glFenceSync = nullptr;
+PFNGLCLIENTWAITSYNCPROC glClientWaitSync = nullptr;
+PFNGLDELETESYNCPROC glDeleteSync = nullptr;
+
+PFNGLGETPROGRAMBINARYPROC glGetProgramBinary = nullptr;
+PFNGLPROGRAMBINARYPROC glProgramBinary = nullptr;
+PFNGLPROGRAMPARAMETERIPROC glProgramParameteri = nullptr;
+
+PFNGLMAXSHADERCOMPILERTHREADSARBPROC glMaxShaderCompilerThreadsKHR = nullptr;
+
+PFNGLGENQUERIESPROC glGenQueries = nullptr;
+PFNGLDELETEQUERIESPROC glDeleteQueries = nullptr;
+PFNGLGETQUERYOBJECTIVPROC glGetQueryObjectiv = nullptr;
+PFNGLQUERYCOUNTERPROC glQueryCounter = nullptr;
+PFNGLGETQUERYOBJECTUI64VPROC glGetQueryObjectui64v = nullptr;
+PFNGLBEGINQUERYPROC glBeginQuery = nullptr;
+PFNGLENDQUERYPROC glEndQuery = nullptr;
+PFNGLGETQUERYOBJECTUIVPROC glGetQueryObjectuiv = nullptr;
 
 #if defined (_WINDOWS)
 #include "../include/GL/wglext.h"
@@ -87,6 +133,7 @@ PFNGLACTIVETEXTUREPROC glActiveTexture = nullptr;
 PFNGLCOMPRESSEDTEXIMAGE2D glCompressedTexImage2D = nullptr;
 PFNGLBLENDCOLORPROC glBlendColor = nullptr;
 PFNWGLCHOOSEPIXELFORMATARBPROC wglChoosePixelFormatARB = nullptr;
+PFNWGLSWAPINTERVALEXTPROC wglSwapIntervalEXT = nullptr;
 
 LRESULT CALLBACK InitWndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lParam)
 {
@@ -135,20 +182,57 @@ LRESULT CALLBACK InitWndProc(HWND hWnd, UINT message, WPARAM wParam, LPARAM lPar
 #include <X11/Xlib.h>
 #include <GL/glx.h>
 //#include <GL/glu.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+// headless contexts are created with egl, their functions are queried from egl
+static bool s_bEglContext = false;
+
+typedef void (*GLPROC)();
+static GLPROC GetProcAddressLinux(const GLubyte* name)
+{
+	return s_bEglContext ? (GLPROC)eglGetProcAddress((const char*)name) : (GLPROC)glXGetProcAddressARB(name);
+}
 #endif
 
 
 OpenGLRenderer::OpenGLRenderer() :
+	m_uFramebuffer(0),
+	m_uColorBuffer(0),
+	m_uDepthBuffer(0),
 	m_Context(nullptr)
 {
 	#if defined (_WINDOWS)
 	m_hRC = nullptr;
 	#endif
+	#if defined (_LINUX)
+	m_EglDisplay = nullptr;
+	m_EglSurface = nullptr;
+	#endif
 }
 
 
 OpenGLRenderer::~OpenGLRenderer()
 {
+	// release gl resources while the context is still alive
+	m_pStreamBuffer = nullptr;
+	m_pProgramCache = nullptr;
+	m_pGpuProfiler = nullptr;
+	m_pDeferredShading = nullptr;
+	m_pDynamicResolution = nullptr;
+	m_pFxaa = nullptr;
+	m_pPostProcess = nullptr;
+	m_pMultisampling = nullptr;
+	m_pFramePacer = nullptr;
+
+	if (m_uFramebuffer)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &m_uFramebuffer);
+		glDeleteRenderbuffers(1, &m_uColorBuffer);
+		glDeleteRenderbuffers(1, &m_uDepthBuffer);
+	}
+
 #if defined (_WINDOWS)
 	if (m_Context)
 	{
@@ -158,13 +242,31 @@ OpenGLRenderer::~OpenGLRenderer()
 		m_Context = nullptr;
 	}
 #endif
+
+#if defined (_LINUX)
+	if (m_EglDisplay)
+	{
+		eglMakeCurrent((EGLDisplay)m_EglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+		if (m_EglSurface)
+		{
+			eglDestroySurface((EGLDisplay)m_EglDisplay, (EGLSurface)m_EglSurface);
+		}
+		if (m_Context)
+		{
+			eglDestroyContext((EGLDisplay)m_EglDisplay, (EGLContext)m_Context);
+		}
+		eglTerminate((EGLDisplay)m_EglDisplay);
+		m_EglDisplay = nullptr;
+		m_EglSurface = nullptr;
+		m_Context = nullptr;
+		s_bEglContext = false;
+	}
+#endif
 }
 
 
 bool OpenGLRenderer::Create()
 {
-	const int32_t multisampleCount = 8;
-
 #if defined (_WINDOWS)
 	// create dummy window for initializing the wgl functions for pixel format
 	MSG msg = {0};
@@ -224,8 +326,6 @@ bool OpenGLRenderer::Create()
 			WGL_COLOR_BITS_ARB, 32,
 			WGL_DEPTH_BITS_ARB, 24,
 			WGL_STENCIL_BITS_ARB, 8,
-			WGL_SAMPLE_BUFFERS_ARB, GL_TRUE,
-			WGL_SAMPLES_ARB, multisampleCount,        // Number of samples
 			0
 		};
 
@@ -262,60 +362,78 @@ bool OpenGLRenderer::Create()
 #endif	// #if defined (_WINDOWS)
 
 #if defined (_LINUX)
-	int depthBufferBits = 24;
-	int stencilBufferBits = 8;
-	int doubleBufferedAttribList [] =
-	{
-		GLX_RGBA, GLX_DOUBLEBUFFER,
-		GLX_RED_SIZE, 4,
-		GLX_GREEN_SIZE, 4,
-		GLX_BLUE_SIZE, 4,
-		GLX_DEPTH_SIZE, depthBufferBits,
-		GLX_STENCIL_SIZE, stencilBufferBits,
-		None
-	};
+	if (IApplication::GetApp()->IsHeadless())
+	{
+		// no display, render with egl into an offscreen framebuffer of the app size
+		if (!CreateHeadlessContext())
+		{
+			return false;
+		}
+		InitFunctions();
+		if (!CreateFramebuffer(IApplication::GetApp()->GetWidth(), IApplication::GetApp()->GetHeight()))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		int depthBufferBits = 24;
+		int stencilBufferBits = 8;
+		int doubleBufferedAttribList [] =
+		{
+			GLX_RGBA, GLX_DOUBLEBUFFER,
+			GLX_RED_SIZE, 4,
+			GLX_GREEN_SIZE, 4,
+			GLX_BLUE_SIZE, 4,
+			GLX_DEPTH_SIZE, depthBufferBits,
+			GLX_STENCIL_SIZE, stencilBufferBits,
+			None
+		};
 
-	XVisualInfo* vi = nullptr;
+		XVisualInfo* vi = nullptr;
 
-	// Attempt to create a double buffered window
-	Display* display = IApplication::GetApp()->GetDisplay();
-	int screen = DefaultScreen(display);
+		// Attempt to create a double buffered window
+		Display* display = IApplication::GetApp()->GetDisplay();
+		int screen = DefaultScreen(display);
 
-    int n = 0;
-    //Get a framebuffer config using the default attributes
-    GLXFBConfig framebufferConfig = (*glXChooseFBConfig(display, screen, 0, &n));
-    if (!framebufferConfig)
-    {
-		IApplication::Debug("OpenGLRenderer: no framebufferconfig");
-    }
+		int n = 0;
+		//Get a framebuffer config using the default attributes
+		GLXFBConfig framebufferConfig = (*glXChooseFBConfig(display, screen, 0, &n));
+		if (!framebufferConfig)
+		{
+			IApplication::Debug("OpenGLRenderer: no framebufferconfig");
+		}
 
-	vi = glXChooseVisual(display, screen, doubleBufferedAttribList);
-	if (!vi)
-	{
-		IApplication::Debug("OpenGLRenderer: glXChooseVisual failed");
-	}
+		vi = glXChooseVisual(display, screen, doubleBufferedAttribList);
+		if (!vi)
+		{
+			IApplication::Debug("OpenGLRenderer: glXChooseVisual failed");
+		}
 
-	//IApplication::Debug("OpenGLRenderer: glXChooseVisual complete");
+		//IApplication::Debug("OpenGLRenderer: glXChooseVisual complete");
 
-	//	Create a GL 2.1 context
-	m_Context = glXCreateContext(display, vi, 0, GL_TRUE);
-	if (!m_Context)
-	{
-		IApplication::Debug("OpenGLRenderer: glXCreateContext failed");
-    	return false;
-	}
+		//	Create a GL 2.1 context
+		m_Context = glXCreateContext(display, vi, 0, GL_TRUE);
+		if (!m_Context)
+		{
+			IApplication::Debug("OpenGLRenderer: glXCreateContext failed");
+			return false;
+		}
 
-	//IApplication::Debug("OpenGLRenderer: glXCreateContext complete");
+		//IApplication::Debug("OpenGLRenderer: glXCreateContext complete");
 
-	glXMakeCurrent(display, (GLXDrawable)IApplication::GetApp()->GetWindow(), (GLXContext)m_Context);
-	InitFunctions();
+		glXMakeCurrent(display, (GLXDrawable)IApplication::GetApp()->GetWindow(), (GLXContext)m_Context);
+		InitFunctions();
+	}
 #endif
 
 	SetDefaultSettings();
 
-	if (multisampleCount)
+	// ring buffer for dynamic per frame data
+	m_pStreamBuffer = std::make_unique<StreamBuffer>();
+	if (!m_pStreamBuffer->Create(16 * 1024 * 1024, 3))
 	{
-		glEnable(GL_MULTISAMPLE);
+		m_pStreamBuffer = nullptr;
 	}
 
 	return true;
@@ -324,6 +442,43 @@ bool OpenGLRenderer::Create()
 
 void OpenGLRenderer::Flip()
 {
+	PROFILE_SCOPE("OpenGLRenderer::Flip");
+
+	// samples resolved, scaled frame to the window through the post effects, inside the gpu profiler frame
+	const glm::ivec2 windowSize(IApplication::GetApp()->GetWidth(), IApplication::GetApp()->GetHeight());
+	const GLuint sceneFramebuffer = m_pPostProcess && !m_pPostProcess->IsEmpty() ? m_pPostProcess->BeginFrame(windowSize) : 0;
+	const GLuint outputFramebuffer = sceneFramebuffer ? sceneFramebuffer : m_uFramebuffer;
+	if (m_pMultisampling)
+	{
+		GpuProfiler::SCOPE resolveScope(m_pGpuProfiler.get(), "resolve");
+		m_pMultisampling->Resolve(m_pDynamicResolution ? m_pDynamicResolution->GetFramebuffer() : outputFramebuffer, GetRenderSize());
+	}
+	if (m_pDynamicResolution)
+	{
+		GpuProfiler::SCOPE upscaleScope(m_pGpuProfiler.get(), "upscale");
+		m_pDynamicResolution->Present(*this, outputFramebuffer);
+	}
+	else if (sceneFramebuffer && !m_pMultisampling)
+	{
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, m_uFramebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, sceneFramebuffer);
+		glBlitFramebuffer(0, 0, windowSize.x, windowSize.y, 0, 0, windowSize.x, windowSize.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	}
+	if (sceneFramebuffer)
+	{
+		GpuProfiler::SCOPE postScope(m_pGpuProfiler.get(), "post");
+		m_pPostProcess->Render(*this, m_uFramebuffer);
+	}
+
+	if (m_pStreamBuffer)
+	{
+		m_pStreamBuffer->EndFrame();
+	}
+	if (m_pGpuProfiler)
+	{
+		m_pGpuProfiler->EndFrame();
+	}
+
 	glFlush();
 
 #if defined (_WINDOWS)
@@ -331,11 +486,37 @@ void OpenGLRenderer::Flip()
 #endif
 
 #if defined (_LINUX)
-    Display* display = IApplication::GetApp()->GetDisplay();
-    Window wnd = IApplication::GetApp()->GetWindow();
-	glXSwapBuffers(display, wnd);
+	// headless frames stay in the offscreen framebuffer
+	if (!m_EglDisplay)
+	{
+		Display* display = IApplication::GetApp()->GetDisplay();
+		Window wnd = IApplication::GetApp()->GetWindow();
+		glXSwapBuffers(display, wnd);
+	}
 #endif
 
+	if (m_pFramePacer)
+	{
+		m_pFramePacer->EndFrame();
+		m_pFramePacer->Wait();
+	}
+
+	if (m_pStreamBuffer)
+	{
+		m_pStreamBuffer->BeginFrame();
+	}
+	if (m_pGpuProfiler)
+	{
+		m_pGpuProfiler->BeginFrame();
+	}
+	if (m_pDynamicResolution)
+	{
+		m_pDynamicResolution->BeginFrame(IApplication::GetApp()->GetWidth(), IApplication::GetApp()->GetHeight());
+	}
+	if (m_pMultisampling)
+	{
+		BeginMultisampling();
+	}
 }
 
 
@@ -356,6 +537,20 @@ void OpenGLRenderer::SetViewport(const glm::ivec4& area)
 }
 
 
+void OpenGLRenderer::ReadPixels(std::vector<uint8_t>& pixels)
+{
+	const int32_t width = IApplication::GetApp()->GetWidth();
+	const int32_t height = IApplication::GetApp()->GetHeight();
+	pixels.resize((size_t)width * height * 4);
+
+	if (glBindFramebuffer)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_uFramebuffer);
+	}
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+}
+
+
 bool OpenGLRenderer::SetTexture(uint32_t program, uint32_t texture, int32_t slot, const std::string_view& uniformName)
 {
 	// helper function to set up the texture into the program
@@ -374,10 +569,46 @@ bool OpenGLRenderer::SetTexture(uint32_t program, uint32_t texture, int32_t slot
 }
 
 
-GLuint OpenGLRenderer::CreateTexture(const std::string_view& filename)
+GLuint OpenGLRenderer::CreateTexture(const std::string_view& filename, const TEXTUREPARAMS& params)
 {
+	PROFILE_SCOPE("OpenGLRenderer::CreateTexture");
+
 	GLuint textureHandle = 0;
 
+	// pre-compressed container
+	const std::string_view btxExtension(".btx");
+	if (filename.size() > btxExtension.size() &&
+		filename.compare(filename.size() - btxExtension.size(), btxExtension.size(), btxExtension) == 0)
+	{
+		CompressedTexture texture;
+		if (!texture.Load(filename))
+		{
+			IApplication::Debug("Failed to load image");
+			IApplication::Debug(filename.data());
+			return 0;
+		}
+		return CreateTexture(texture, params);
+	}
+
+	// use the cached compressed version of the image when available
+	const bool compress = params.compression && CompressedTexture::IsFormatSupported(params.compression);
+	const std::string cacheFilename = std::string(filename) + ".btx";
+	if (compress)
+	{
+		// cache is rebuilt when the image was modified after the cache was written
+		std::error_code imageError;
+		std::error_code cacheError;
+		const auto imageTime = std::filesystem::last_write_time(std::filesystem::path(filename), imageError);
+		const auto cacheTime = std::filesystem::last_write_time(std::filesystem::path(cacheFilename), cacheError);
+		const bool stale = !imageError && !cacheError && imageTime > cacheTime;
+
+		CompressedTexture texture;
+		if (!stale && texture.Load(cacheFilename) && texture.GetFormat() == params.compression)
+		{
+			return CreateTexture(texture, params);
+		}
+	}
+
 	int32_t textureWidth = 0;
 	int32_t textureHeight = 0;
 	int32_t bpp = 0;
@@ -392,15 +623,23 @@ GLuint OpenGLRenderer::CreateTexture(const std::string_view& filename)
 
 	// premultiply the alpha for faster blending
 	const int32_t imgdatabytes = textureWidth * textureHeight * 4;
-	for (int32_t i = 0; i < imgdatabytes; i += 4)
+	ImageKernels::PremultiplyAlpha(imgdata, textureWidth, textureHeight);
+
+	if (compress)
 	{
-		const int32_t alpha = imgdata[i + 3];
-		if (alpha != 255)
+		CompressedTexture texture;
+		const bool created = texture.Create(imgdata, textureWidth, textureHeight, params.compression, params.mipmaps ? params.maxLevel : 0);
+		stbi_image_free(imgdata);
+		if (!created)
+		{
+			return 0;
+		}
+
+		if (!texture.Save(cacheFilename))
 		{
-			imgdata[i] = imgdata[i] * alpha / 255;
-			imgdata[i + 1] = imgdata[i + 1] * alpha / 255;
-			imgdata[i + 2] = imgdata[i + 2] * alpha / 255;
+			IApplication::Debug("Failed to write texture cache " + cacheFilename + "\n");
 		}
+		return CreateTexture(texture, params);
 	}
 
 	GLint internalFormat = GL_RGBA;
@@ -422,21 +661,123 @@ GLuint OpenGLRenderer::CreateTexture(const std::string_view& filename)
 		GL_UNSIGNED_BYTE,
 		imgdata);
 
-	delete[] imgdata;
+	// number of levels down to 1x1, limited by the requested max level
+	int32_t maxLevel = 0;
+	if (params.mipmaps)
+	{
+		for (int32_t size = std::max(textureWidth, textureHeight); size > 1; size >>= 1)
+		{
+			++maxLevel;
+		}
+		maxLevel = std::min(maxLevel, std::max(params.maxLevel, 0));
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, maxLevel);
+
+	if (maxLevel > 0)
+	{
+		if (glGenerateMipmap)
+		{
+			glGenerateMipmap(GL_TEXTURE_2D);
+		}
+		else
+		{
+			// box filter the premultiplied image level by level
+			int32_t width = textureWidth;
+			int32_t height = textureHeight;
+			std::vector<uint8_t> level(imgdata, imgdata + imgdatabytes);
+			std::vector<uint8_t> next;
+			for (int32_t i = 1; i <= maxLevel; ++i)
+			{
+				ImageKernels::DownsampleBox(level.data(), width, height, next);
+				width = std::max(width >> 1, 1);
+				height = std::max(height >> 1, 1);
+				glTexImage2D(GL_TEXTURE_2D, i, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, next.data());
+				level.swap(next);
+			}
+		}
+	}
+
+	stbi_image_free(imgdata);
 
 	err = glGetError();
 
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	SetTextureParams(params, maxLevel);
+
+	return textureHandle;
+}
+
+
+GLuint OpenGLRenderer::CreateTexture(const CompressedTexture& texture, const TEXTUREPARAMS& params)
+{
+	PROFILE_SCOPE("OpenGLRenderer::CreateCompressedTexture");
+
+	if (texture.IsEmpty())
+	{
+		return 0;
+	}
+
+	GLuint textureHandle = 0;
+	glGenTextures(1, &textureHandle);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, textureHandle);
+
+	const int32_t levelCount = params.mipmaps ? std::min(texture.GetLevelCount(), std::max(params.maxLevel, 0) + 1) : 1;
+	for (int32_t i = 0; i < levelCount; ++i)
+	{
+		const auto& level = texture.GetLevel(i);
+		glCompressedTexImage2D(GL_TEXTURE_2D,
+			i,
+			texture.GetFormat(),
+			std::max(texture.GetWidth() >> i, 1),
+			std::max(texture.GetHeight() >> i, 1),
+			0,
+			(GLsizei)level.size(),
+			level.data());
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+	SetTextureParams(params, levelCount - 1);
 
 	return textureHandle;
 }
 
 
+void OpenGLRenderer::SetTextureParams(const TEXTUREPARAMS& params, int32_t maxLevel)
+{
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, maxLevel > 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, params.wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, params.wrap);
+
+	const float anisotropy = std::min(params.anisotropy, GetMaxAnisotropy());
+	if (anisotropy > 1.0f)
+	{
+		glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, anisotropy);
+	}
+}
+
+
+float OpenGLRenderer::GetMaxAnisotropy()
+{
+	static float maxAnisotropy = 0.0f;
+	if (maxAnisotropy == 0.0f)
+	{
+		maxAnisotropy = 1.0f;
+		if (HasExtension("GL_EXT_texture_filter_anisotropic") ||
+			HasExtension("GL_ARB_texture_filter_anisotropic"))
+		{
+			glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxAnisotropy);
+		}
+	}
+	return maxAnisotropy;
+}
+
+
 GLuint OpenGLRenderer::CreateVertexShader(const char* vertexShader)
 {
+	PROFILE_SCOPE("OpenGLRenderer::CreateVertexShader");
+
 	// Create the vertex shader object
 	GLuint shaderHandle = glCreateShader(GL_VERTEX_SHADER);
 
@@ -476,6 +817,8 @@ GLuint OpenGLRenderer::CreateVertexShaderFromFile(const std::string_view& filena
 
 GLuint OpenGLRenderer::CreateFragmentShader(const char* fragmentShader)
 {
+	PROFILE_SCOPE("OpenGLRenderer::CreateFragmentShader");
+
 	// Create the fragment shader object
 	GLuint shaderHandle = glCreateShader(GL_FRAGMENT_SHADER);
 
@@ -514,12 +857,18 @@ GLuint OpenGLRenderer::CreateFragmentShaderFromFile(const std::string_view& file
 }
 
 
-GLuint OpenGLRenderer::CreateProgram(GLuint vertexShader, GLuint fragmentShader)
+GLuint OpenGLRenderer::CreateProgram(GLuint vertexShader, GLuint fragmentShader, bool retrievable)
 {
+	PROFILE_SCOPE("OpenGLRenderer::CreateProgram");
+
 	// Create the shader program
 	GLuint programHandle = glCreateProgram();
 	glAttachShader(programHandle, fragmentShader);
 	glAttachShader(programHandle, vertexShader);
+	if (retrievable && glProgramParameteri)
+	{
+		glProgramParameteri(programHandle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
 	glLinkProgram(programHandle);
 
 	GLint linked = 0;
@@ -537,6 +886,345 @@ GLuint OpenGLRenderer::CreateProgram(GLuint vertexShader, GLuint fragmentShader)
 }
 
 
+GLuint OpenGLRenderer::CreateProgramFromSource(const std::string_view& vertexShader, const std::string_view& fragmentShader, const std::string_view& defines)
+{
+	PROFILE_SCOPE("OpenGLRenderer::CreateProgramFromSource");
+
+	uint64_t key = 0;
+	if (m_pProgramCache)
+	{
+		key = m_pProgramCache->GetKey(vertexShader, fragmentShader, defines);
+		const GLuint program = m_pProgramCache->Load(key);
+		if (program)
+		{
+			return program;
+		}
+		m_pProgramCache->CountMiss();
+	}
+
+	const std::string vertexSource = InsertDefines(vertexShader, defines);
+	const std::string fragmentSource = InsertDefines(fragmentShader, defines);
+	const GLuint vs = CreateVertexShader(vertexSource.c_str());
+	const GLuint fs = CreateFragmentShader(fragmentSource.c_str());
+
+	GLuint program = 0;
+	if (vs && fs)
+	{
+		program = CreateProgram(vs, fs, m_pProgramCache != nullptr);
+	}
+
+	// linked program does not need the shader objects
+	if (program)
+	{
+		glDetachShader(program, vs);
+		glDetachShader(program, fs);
+	}
+	glDeleteShader(vs);
+	glDeleteShader(fs);
+
+	if (program && m_pProgramCache)
+	{
+		m_pProgramCache->Store(key, program);
+	}
+	return program;
+}
+
+
+GLuint OpenGLRenderer::CreateProgramFromFiles(const std::string_view& vertexShaderFile, const std::string_view& fragmentShaderFile, const std::string_view& defines)
+{
+	const std::string vertexShader = LoadTextFile(vertexShaderFile);
+	const std::string fragmentShader = LoadTextFile(fragmentShaderFile);
+	if (vertexShader.empty() || fragmentShader.empty())
+	{
+		IApplication::Debug("Failed to load shader " + std::string(vertexShader.empty() ? vertexShaderFile : fragmentShaderFile) + "\n");
+		return 0;
+	}
+	return CreateProgramFromSource(vertexShader, fragmentShader, defines);
+}
+
+
+bool OpenGLRenderer::SetProgramCacheDirectory(const std::string_view& directory)
+{
+	m_pProgramCache = nullptr;
+	if (directory.empty())
+	{
+		return false;
+	}
+
+	m_pProgramCache = std::make_unique<ProgramCache>();
+	if (!m_pProgramCache->Create(directory))
+	{
+		m_pProgramCache = nullptr;
+		return false;
+	}
+	return true;
+}
+
+
+bool OpenGLRenderer::SetGpuProfiling(bool enable)
+{
+	m_pGpuProfiler = nullptr;
+	if (!enable)
+	{
+		return false;
+	}
+
+	m_pGpuProfiler = std::make_unique<GpuProfiler>();
+	if (!m_pGpuProfiler->Create())
+	{
+		m_pGpuProfiler = nullptr;
+		return false;
+	}
+
+	// first frame starts now, later ones at Flip
+	m_pGpuProfiler->BeginFrame();
+	return true;
+}
+
+
+bool OpenGLRenderer::SetDynamicResolution(bool enable)
+{
+	m_pDynamicResolution = nullptr;
+	if (!enable)
+	{
+		if (glBindFramebuffer)
+		{
+			glBindFramebuffer(GL_FRAMEBUFFER, m_uFramebuffer);
+		}
+		glViewport(0, 0, IApplication::GetApp()->GetWidth(), IApplication::GetApp()->GetHeight());
+		if (m_pMultisampling)
+		{
+			BeginMultisampling();
+		}
+		return false;
+	}
+
+	m_pDynamicResolution = std::make_unique<DynamicResolution>();
+	if (!m_pDynamicResolution->Create(*this))
+	{
+		m_pDynamicResolution = nullptr;
+		return false;
+	}
+
+	// first frame starts now, later ones at Flip
+	m_pDynamicResolution->BeginFrame(IApplication::GetApp()->GetWidth(), IApplication::GetApp()->GetHeight());
+	if (m_pMultisampling)
+	{
+		BeginMultisampling();
+	}
+	return true;
+}
+
+
+bool OpenGLRenderer::SetPostProcessing(bool enable)
+{
+	// the anti-aliasing effect goes with the chain
+	if (m_pFxaa)
+	{
+		m_pFxaa = nullptr;
+		m_eAntialiasing = ANTIALIASING_OFF;
+	}
+	m_pPostProcess = nullptr;
+	if (!enable)
+	{
+		return false;
+	}
+
+	m_pPostProcess = std::make_unique<PostProcess>();
+	if (!m_pPostProcess->Create(*this))
+	{
+		m_pPostProcess = nullptr;
+		return false;
+	}
+	return true;
+}
+
+
+bool OpenGLRenderer::SetFramePacing(bool enable)
+{
+	m_pFramePacer = nullptr;
+	if (!enable)
+	{
+		return false;
+	}
+
+	m_pFramePacer = std::make_unique<FramePacer>();
+	if (!m_pFramePacer->Create())
+	{
+		m_pFramePacer = nullptr;
+		return false;
+	}
+	return true;
+}
+
+
+bool OpenGLRenderer::SetSwapInterval(int32_t interval)
+{
+#if defined (_WINDOWS)
+	if (wglSwapIntervalEXT && wglSwapIntervalEXT(interval))
+	{
+		return true;
+	}
+#endif
+
+#if defined (_LINUX)
+	// the headless pbuffer or surfaceless context is never presented
+	if (!m_EglDisplay)
+	{
+		static PFNGLXSWAPINTERVALEXTPROC glXSwapIntervalEXT = (PFNGLXSWAPINTERVALEXTPROC)glXGetProcAddressARB((const GLubyte*)"glXSwapIntervalEXT");
+		Display* display = IApplication::GetApp()->GetDisplay();
+		const char* extensions = glXQueryExtensionsString(display, DefaultScreen(display));
+		if (glXSwapIntervalEXT && extensions && strstr(extensions, "GLX_EXT_swap_control"))
+		{
+			glXSwapIntervalEXT(display, IApplication::GetApp()->GetWindow(), interval);
+			return true;
+		}
+	}
+#endif
+
+	IApplication::Debug("OpenGLRenderer: swap interval " + std::to_string(interval) + " not supported\n");
+	return false;
+}
+
+
+bool OpenGLRenderer::SetAntialiasing(ANTIALIASING mode)
+{
+	if (m_pFxaa)
+	{
+		m_pPostProcess->Remove(m_pFxaa);
+		m_pFxaa = nullptr;
+	}
+	if (m_pMultisampling)
+	{
+		m_pMultisampling = nullptr;
+		glBindFramebuffer(GL_FRAMEBUFFER, GetDefaultFramebuffer());
+	}
+	m_eAntialiasing = ANTIALIASING_OFF;
+
+	if (mode >= ANTIALIASING_MSAA2 && mode <= ANTIALIASING_MSAA8)
+	{
+		m_pMultisampling = std::make_unique<Multisampling>();
+		if (!m_pMultisampling->Create(2 << (mode - ANTIALIASING_MSAA2)))
+		{
+			m_pMultisampling = nullptr;
+			return false;
+		}
+		BeginMultisampling();
+	}
+	else if (mode == ANTIALIASING_POST)
+	{
+		// last in the chain, it filters the frame as displayed
+		if (!m_pPostProcess && !SetPostProcessing(true))
+		{
+			return false;
+		}
+		m_pFxaa = std::make_shared<Fxaa>();
+		if (!m_pPostProcess->Add(*this, m_pFxaa))
+		{
+			m_pFxaa = nullptr;
+			return false;
+		}
+	}
+
+	m_eAntialiasing = mode;
+	return true;
+}
+
+
+void OpenGLRenderer::BeginMultisampling()
+{
+	// the samples resolve into the target the frame would otherwise be rendered to
+	const glm::ivec2 size(m_pDynamicResolution ? m_pDynamicResolution->GetTargetSize() :
+		glm::ivec2(IApplication::GetApp()->GetWidth(), IApplication::GetApp()->GetHeight()));
+	m_pMultisampling->BeginFrame(size.x, size.y);
+}
+
+
+glm::ivec2 OpenGLRenderer::GetRenderSize() const
+{
+	if (m_pDynamicResolution)
+	{
+		return m_pDynamicResolution->GetRenderSize();
+	}
+	return glm::ivec2(IApplication::GetApp()->GetWidth(), IApplication::GetApp()->GetHeight());
+}
+
+
+GLuint OpenGLRenderer::GetDefaultFramebuffer() const
+{
+	if (m_pMultisampling && m_pMultisampling->GetFramebuffer())
+	{
+		return m_pMultisampling->GetFramebuffer();
+	}
+	return m_pDynamicResolution ? m_pDynamicResolution->GetFramebuffer() : m_uFramebuffer;
+}
+
+
+bool OpenGLRenderer::SetRenderPath(RENDERPATH path)
+{
+	m_eRenderPath = RENDERPATH_FORWARD;
+	if (path != RENDERPATH_DEFERRED)
+	{
+		m_pDeferredShading = nullptr;
+		return path == RENDERPATH_FORWARD;
+	}
+
+	if (!m_pDeferredShading)
+	{
+		m_pDeferredShading = std::make_unique<DeferredShading>();
+		if (!m_pDeferredShading->Create(*this))
+		{
+			m_pDeferredShading = nullptr;
+			return false;
+		}
+	}
+	m_eRenderPath = RENDERPATH_DEFERRED;
+	return true;
+}
+
+
+std::string OpenGLRenderer::InsertDefines(const std::string_view& source, const std::string_view& defines)
+{
+	if (defines.empty())
+	{
+		return std::string(source);
+	}
+
+	// #version must stay the first directive of the shader
+	size_t pos = 0;
+	const size_t version = source.find("#version");
+	if (version != std::string_view::npos)
+	{
+		const size_t lineEnd = source.find('\n', version);
+		pos = lineEnd == std::string_view::npos ? source.size() : lineEnd + 1;
+	}
+
+	std::string result;
+	result.reserve(source.size() + defines.size() + 1);
+	result.append(source.substr(0, pos));
+	if (pos && result.back() != '\n')
+	{
+		result += '\n';
+	}
+	result.append(defines);
+	if (defines.back() != '\n')
+	{
+		result += '\n';
+	}
+	result.append(source.substr(pos));
+	return result;
+}
+
+
+std::string OpenGLRenderer::LoadTextFile(const std::string_view& filename)
+{
+	std::ifstream f(std::string(filename), std::ios::binary);
+	return std::string(
+		(std::istreambuf_iterator<char>(f)),
+		(std::istreambuf_iterator<char>()));
+}
+
+
 void OpenGLRenderer::PrintShaderError(GLuint shader)
 {
 	GLint infologLength = 0;
@@ -573,6 +1261,176 @@ void OpenGLRenderer::PrintProgramError(GLuint program)
 
 
 
+int32_t OpenGLRenderer::GetVersion()
+{
+	// version string is "major.minor[.release] [vendor info]"
+	const char* version = (const char*)glGetString(GL_VERSION);
+	int32_t major = 0;
+	int32_t minor = 0;
+	if (version)
+	{
+		sscanf(version, "%d.%d", &major, &minor);
+	}
+	return major * 10 + minor;
+}
+
+
+bool OpenGLRenderer::HasExtension(const std::string_view& name)
+{
+	if (glGetStringi)
+	{
+		GLint count = 0;
+		glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+		for (GLint i = 0; i < count; ++i)
+		{
+			const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+			if (extension && name == extension)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// legacy context, look from the space separated extension string
+	const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+	if (!extensions)
+	{
+		return false;
+	}
+
+	const std::string_view all(extensions);
+	size_t pos = all.find(name);
+	while (pos != std::string_view::npos)
+	{
+		const size_t end = pos + name.size();
+		if ((pos == 0 || all[pos - 1] == ' ') && (end == all.size() || all[end] == ' '))
+		{
+			return true;
+		}
+		pos = all.find(name, end);
+	}
+	return false;
+}
+
+
+bool OpenGLRenderer::CreateFramebuffer(int32_t width, int32_t height)
+{
+	if (!glGenFramebuffers || !glGenRenderbuffers)
+	{
+		IApplication::Debug("OpenGLRenderer: framebuffer objects not supported\n");
+		return false;
+	}
+
+	glGenRenderbuffers(1, &m_uColorBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_uColorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+	glGenRenderbuffers(1, &m_uDepthBuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_uDepthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glGenFramebuffers(1, &m_uFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uFramebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_uColorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_uDepthBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_uDepthBuffer);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		IApplication::Debug("OpenGLRenderer: offscreen framebuffer is incomplete\n");
+		return false;
+	}
+
+	// framebuffer stays bound, everything drawn to the "screen" goes into it
+	glViewport(0, 0, width, height);
+	return true;
+}
+
+
+#if defined (_LINUX)
+bool OpenGLRenderer::CreateHeadlessContext()
+{
+	// prefer the surfaceless platform, it does not need a display server or a gpu
+	EGLDisplay display = EGL_NO_DISPLAY;
+	const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+	auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if (clientExtensions && strstr(clientExtensions, "EGL_MESA_platform_surfaceless") && getPlatformDisplay)
+	{
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+	}
+	if (display == EGL_NO_DISPLAY)
+	{
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+
+	EGLint major = 0;
+	EGLint minor = 0;
+	if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor))
+	{
+		IApplication::Debug("OpenGLRenderer: eglInitialize failed\n");
+		return false;
+	}
+	m_EglDisplay = display;
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		IApplication::Debug("OpenGLRenderer: desktop OpenGL not available through egl\n");
+		return false;
+	}
+
+	const EGLint configAttribList[] =
+	{
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_NONE
+	};
+	EGLConfig config = nullptr;
+	EGLint configCount = 0;
+	if (!eglChooseConfig(display, configAttribList, &config, 1, &configCount) || configCount == 0)
+	{
+		IApplication::Debug("OpenGLRenderer: eglChooseConfig failed\n");
+		return false;
+	}
+
+	// default attributes give a compatibility context like glXCreateContext
+	m_Context = eglCreateContext(display, config, EGL_NO_CONTEXT, nullptr);
+	if (!m_Context)
+	{
+		IApplication::Debug("OpenGLRenderer: eglCreateContext failed\n");
+		return false;
+	}
+
+	// drawing goes to the framebuffer object, a surface is only needed when the driver requires one
+	const char* displayExtensions = eglQueryString(display, EGL_EXTENSIONS);
+	if (!displayExtensions || !strstr(displayExtensions, "EGL_KHR_surfaceless_context"))
+	{
+		const EGLint pbufferAttribList[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		m_EglSurface = eglCreatePbufferSurface(display, config, pbufferAttribList);
+		if (!m_EglSurface)
+		{
+			IApplication::Debug("OpenGLRenderer: eglCreatePbufferSurface failed\n");
+			return false;
+		}
+	}
+
+	const EGLSurface surface = m_EglSurface ? (EGLSurface)m_EglSurface : EGL_NO_SURFACE;
+	if (!eglMakeCurrent(display, surface, surface, (EGLContext)m_Context))
+	{
+		IApplication::Debug("OpenGLRenderer: eglMakeCurrent failed\n");
+		return false;
+	}
+
+	s_bEglContext = true;
+	IApplication::Debug(std::string("OpenGLRenderer: headless ") + (const char*)glGetString(GL_RENDERER) + "\n");
+	return true;
+}
+#endif
+
+
 bool OpenGLRenderer::SetDefaultSettings()
 {
 #ifdef _DEBUG
@@ -618,7 +1476,7 @@ bool OpenGLRenderer::InitFunctions()
 	#define GL_GETPROCADDRESS_PARAM_TYPE const char*
 	#endif
 	#if defined (_LINUX)
-	#define GL_GETPROCADDRESS glXGetProcAddressARB
+	#define GL_GETPROCADDRESS GetProcAddressLinux
 	#define GL_GETPROCADDRESS_PARAM_TYPE const GLubyte*
 	#endif
 
@@ -628,6 +1486,7 @@ bool OpenGLRenderer::InitFunctions()
 	glCompressedTexImage2D		= (PFNGLCOMPRESSEDTEXIMAGE2D		) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glCompressedTexImage2D");
 	glBlendColor			= (PFNGLBLENDCOLORPROC)GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glBlendColor");
 	wglChoosePixelFormatARB = (PFNWGLCHOOSEPIXELFORMATARBPROC)wglGetProcAddress("wglChoosePixelFormatARB");
+	wglSwapIntervalEXT = (PFNWGLSWAPINTERVALEXTPROC)wglGetProcAddress("wglSwapIntervalEXT");
 	#endif
 
 	glBlendEquationSeparate = (PFNGLBLENDEQUATIONSEPARATEPROC)GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glBlendEquationSeparate");
@@ -696,12 +1555,52 @@ bool OpenGLRenderer::InitFunctions()
 	glBindFramebuffer			= (PFNGLBINDFRAMEBUFFERPROC			) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glBindFramebuffer");
 	glBindRenderbuffer			= (PFNGLBINDRENDERBUFFERPROC		) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glBindRenderbuffer");
 	glRenderbufferStorage		= (PFNGLRENDERBUFFERSTORAGEPROC		) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glRenderbufferStorage");
+	glRenderbufferStorageMultisample = (PFNGLRENDERBUFFERSTORAGEMULTISAMPLEPROC) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glRenderbufferStorageMultisample");
 	glFramebufferTexture2D		= (PFNGLFRAMEBUFFERTEXTURE2DPROC	) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glFramebufferTexture2D");
 	glFramebufferTexture		= (PFNGLFRAMEBUFFERTEXTUREPROC		) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glFramebufferTexture");
 	glFramebufferRenderbuffer	= (PFNGLFRAMEBUFFERRENDERBUFFERPROC ) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glFramebufferRenderbuffer");
 	glCheckFramebufferStatus	= (PFNGLCHECKFRAMEBUFFERSTATUSPROC	) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glCheckFramebufferStatus");
 	glClearDepthf				= (PFNGLCLEARDEPTHFPROC				) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glClearDepthf");
 	glGenerateMipmap			= (PFNGLGENERATEMIPMAPPROC			) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glGenerateMipmap");
+	glBlitFramebuffer			= (PFNGLBLITFRAMEBUFFERPROC			) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glBlitFramebuffer");
+	glDrawBuffers				= (PFNGLDRAWBUFFERSPROC				) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glDrawBuffers");
+
+	// GL 3.0+ buffers and multi draw, these are optional and may be null on older drivers
+	glGetStringi				= (PFNGLGETSTRINGIPROC				) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glGetStringi");
+	glBufferSubData				= (PFNGLBUFFERSUBDATAPROC			) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glBufferSubData");
+	glBindBufferBase			= (PFNGLBINDBUFFERBASEPROC			) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glBindBufferBase");
+	glMultiDrawElementsIndirect	= (PFNGLMULTIDRAWELEMENTSINDIRECTPROC) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glMultiDrawElementsIndirect");
+	glBindBufferRange			= (PFNGLBINDBUFFERRANGEPROC			) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glBindBufferRange");
+
+	// persistently mapped buffers and sync objects
+	glBufferStorage				= (PFNGLBUFFERSTORAGEPROC			) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glBufferStorage");
+	glMapBufferRange			= (PFNGLMAPBUFFERRANGEPROC			) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glMapBufferRange");
+	glUnmapBuffer				= (PFNGLUNMAPBUFFERPROC				) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glUnmapBuffer");
+	glFenceSync					= (PFNGLFENCESYNCPROC				) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glFenceSync");
+	glClientWaitSync			= (PFNGLCLIENTWAITSYNCPROC			) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glClientWaitSync");
+	glDeleteSync				= (PFNGLDELETESYNCPROC				) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glDeleteSync");
+
+	// program binaries
+	glGetProgramBinary			= (PFNGLGETPROGRAMBINARYPROC		) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glGetProgramBinary");
+	glProgramBinary				= (PFNGLPROGRAMBINARYPROC			) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glProgramBinary");
+	glProgramParameteri			= (PFNGLPROGRAMPARAMETERIPROC		) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glProgramParameteri");
+
+	// parallel shader compile, KHR and ARB entry points are interchangeable
+	glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSARBPROC) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glMaxShaderCompilerThreadsKHR");
+	if (!glMaxShaderCompilerThreadsKHR)
+	{
+		glMaxShaderCompilerThreadsKHR = (PFNGLMAXSHADERCOMPILERTHREADSARBPROC) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glMaxShaderCompilerThreadsARB");
+	}
+
+	// queries and timers
+	glGenQueries				= (PFNGLGENQUERIESPROC				) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glGenQueries");
+	glDeleteQueries				= (PFNGLDELETEQUERIESPROC			) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glDeleteQueries");
+	glGetQueryObjectiv			= (PFNGLGETQUERYOBJECTIVPROC		) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glGetQueryObjectiv");
+	glQueryCounter				= (PFNGLQUERYCOUNTERPROC			) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glQueryCounter");
+	glGetQueryObjectui64v		= (PFNGLGETQUERYOBJECTUI64VPROC		) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glGetQueryObjectui64v");
+	glBeginQuery				= (PFNGLBEGINQUERYPROC				) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glBeginQuery");
+	glEndQuery					= (PFNGLENDQUERYPROC				) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glEndQuery");
+	glGetQueryObjectuiv			= (PFNGLGETQUERYOBJECTUIVPROC		) GL_GETPROCADDRESS((GL_GETPROCADDRESS_PARAM_TYPE)"glGetQueryObjectuiv");
 
 	// check that functions were loaded properly
 	if (!glCreateProgram)
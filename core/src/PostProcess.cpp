@@ -0,0 +1,237 @@
+/**
+ * ============================================================================
+ *  Name        : PostProcess.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : chain of full screen effects run on the finished frame
+ * ============================================================================
+**/
+
+#include "../include/PostProcess.h"
+#include "../include/GpuProfiler.h"
+#include <algorithm>
+#include <string>
+
+
+static const char* s_pVertexShader =
+	"attribute vec2 position;\n"
+	"varying vec2 outUv;\n"
+	"void main(void)\n"
+	"{\n"
+	"	outUv = position * 0.5 + 0.5;\n"
+	"	gl_Position = vec4(position, 0.0, 1.0);\n"
+	"}\n";
+
+static const char* s_pCopyFragmentShader =
+	"uniform sampler2D source;\n"
+	"uniform vec2 sourceScale;\n"
+	"uniform vec2 sourceMax;\n"
+	"varying vec2 outUv;\n"
+	"void main(void)\n"
+	"{\n"
+	"	gl_FragColor = vec4(texture2D(source, min(outUv * sourceScale, sourceMax)).rgb, 1.0);\n"
+	"}\n";
+
+// format of the frame the chain starts from
+static constexpr GLenum SCENE_FORMAT = GL_RGBA8;
+
+
+PostProcess::PostProcess() :
+	m_uCopyProgram(0),
+	m_pScene(nullptr),
+	m_vSize(0)
+{
+}
+
+
+PostProcess::~PostProcess()
+{
+	Release();
+}
+
+
+bool PostProcess::IsSupported()
+{
+	return RenderTargetPool::IsSupported();
+}
+
+
+bool PostProcess::Create(OpenGLRenderer& renderer)
+{
+	Release();
+	if (!IsSupported())
+	{
+		IApplication::Debug("PostProcess: framebuffer objects not supported\n");
+		return false;
+	}
+
+	m_uCopyProgram = renderer.CreateProgramFromSource(s_pVertexShader, s_pCopyFragmentShader);
+	return m_uCopyProgram != 0;
+}
+
+
+void PostProcess::Release()
+{
+	for (auto& effect : m_arrEffects)
+	{
+		effect->Release();
+	}
+	m_arrEffects.clear();
+
+	m_Pool.Recycle(m_pScene);
+	m_pScene = nullptr;
+	m_Pool.Release();
+
+	if (m_uCopyProgram)
+	{
+		glDeleteProgram(m_uCopyProgram);
+		m_uCopyProgram = 0;
+	}
+}
+
+
+bool PostProcess::Add(OpenGLRenderer& renderer, const std::shared_ptr<PostEffect>& effect)
+{
+	// output of the last effect, formats are resolved along the chain
+	GLenum format = SCENE_FORMAT;
+	for (const auto& it : m_arrEffects)
+	{
+		const GLenum output = it->GetFormats().output;
+		format = output ? output : format;
+	}
+
+	const PostEffect::FORMATS formats = effect->GetFormats();
+	if (formats.input && formats.input != format)
+	{
+		IApplication::Debug("PostProcess: " + std::string(effect->GetName()) + " can not read the output of the previous effect\n");
+		return false;
+	}
+	if (formats.scale <= 0.0f || !effect->Create(renderer))
+	{
+		return false;
+	}
+
+	m_arrEffects.push_back(effect);
+	return true;
+}
+
+
+void PostProcess::Remove(const std::shared_ptr<PostEffect>& effect)
+{
+	auto it = std::find(m_arrEffects.begin(), m_arrEffects.end(), effect);
+	if (it != m_arrEffects.end())
+	{
+		(*it)->Release();
+		m_arrEffects.erase(it);
+	}
+}
+
+
+GLuint PostProcess::BeginFrame(const glm::ivec2& size)
+{
+	m_Pool.Recycle(m_pScene);
+	m_vSize = glm::max(size, glm::ivec2(1));
+	m_pScene = m_Pool.Acquire(RenderTargetPool::DESC(m_vSize, SCENE_FORMAT));
+	if (!m_pScene)
+	{
+		return 0;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_pScene->framebuffer);
+	glViewport(0, 0, m_vSize.x, m_vSize.y);
+	return m_pScene->framebuffer;
+}
+
+
+void PostProcess::Render(OpenGLRenderer& renderer, GLuint framebuffer)
+{
+	PROFILE_SCOPE("PostProcess::Render");
+
+	if (!m_pScene)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glViewport(0, 0, m_vSize.x, m_vSize.y);
+		return;
+	}
+
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_CULL_FACE);
+
+	// the window as a target, only the last effect may write it
+	RenderTargetPool::TARGET window{};
+	window.desc = RenderTargetPool::DESC(m_vSize);
+	window.allocatedSize = m_vSize;
+	window.framebuffer = framebuffer;
+
+	RenderTargetPool::TARGET* input = m_pScene;
+	m_pScene = nullptr;
+	for (size_t i = 0; i < m_arrEffects.size(); ++i)
+	{
+		PostEffect& effect = *m_arrEffects[i];
+		const PostEffect::FORMATS formats = effect.GetFormats();
+		const RenderTargetPool::DESC desc(glm::max(glm::ivec2(glm::vec2(input->desc.size) * formats.scale + 0.5f), glm::ivec2(1)),
+			formats.output ? formats.output : input->desc.format);
+
+		RenderTargetPool::TARGET* output = &window;
+		if (i + 1 < m_arrEffects.size() || desc.size != m_vSize)
+		{
+			output = m_Pool.Acquire(desc);
+			if (!output)
+			{
+				break;
+			}
+		}
+
+		GpuProfiler::SCOPE effectScope(renderer.GetGpuProfiler(), effect.GetName());
+		glBindFramebuffer(GL_FRAMEBUFFER, output->framebuffer);
+		glViewport(0, 0, output->desc.size.x, output->desc.size.y);
+		effect.Render(renderer, *this, *input, *output);
+
+		// nothing reads the input again, the next acquire may alias it
+		m_Pool.Recycle(input);
+		input = output;
+	}
+
+	// chain ended at another size or failed, copy what it has
+	if (input != &window)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+		glViewport(0, 0, m_vSize.x, m_vSize.y);
+		glUseProgram(m_uCopyProgram);
+		SetInput(renderer, m_uCopyProgram, "source", *input, 0);
+		DrawFullscreen(m_uCopyProgram);
+		m_Pool.Recycle(input);
+	}
+
+	glEnable(GL_CULL_FACE);
+	glEnable(GL_DEPTH_TEST);
+	m_Pool.EndFrame();
+}
+
+
+const char* PostProcess::GetVertexShader()
+{
+	return s_pVertexShader;
+}
+
+
+void PostProcess::SetInput(OpenGLRenderer& renderer, GLuint program, const char* name, const RenderTargetPool::TARGET& target, int32_t slot)
+{
+	const std::string uniform(name);
+	renderer.SetTexture(program, target.texture, slot, uniform);
+	OpenGLRenderer::SetUniformVec2(program, (uniform + "Scale").c_str(), target.GetUvScale());
+	OpenGLRenderer::SetUniformVec2(program, (uniform + "Max").c_str(), target.GetUvMax());
+	OpenGLRenderer::SetUniformVec2(program, (uniform + "Texel").c_str(), 1.0f / glm::vec2(target.allocatedSize));
+	glActiveTexture(GL_TEXTURE0);
+}
+
+
+void PostProcess::DrawFullscreen(GLuint program)
+{
+	static const float triangle[6] = { -1.0f, -1.0f, 3.0f, -1.0f, -1.0f, 3.0f };
+	const GLint position = glGetAttribLocation(program, "position");
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glEnableVertexAttribArray(position);
+	glVertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, 0, triangle);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glDisableVertexAttribArray(position);
+}
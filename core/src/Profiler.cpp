@@ -0,0 +1,315 @@
+/**
+ * ============================================================================
+ *  Name        : Profiler.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : hierarchical cpu profiler
+ * ============================================================================
+**/
+
+#include "../include/Profiler.h"
+#include "../include/IApplication.h"
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <mutex>
+
+
+namespace
+{
+	// events per thread between two frame boundaries, must be a power of two
+	constexpr uint64_t THREADBUFFER_CAPACITY = 1 << 16;
+
+	// single producer ring buffer, only the owning thread writes and only the
+	// frame boundary reads. Buffers outlive their threads so events are not lost
+	struct THREADBUFFER
+	{
+		std::vector<Profiler::EVENT>	events;
+		std::atomic<uint64_t>			writeIndex;
+		uint64_t						readIndex;
+		uint32_t						thread;
+		std::string						name;
+	};
+
+	struct FRAME
+	{
+		uint32_t						thread;			// thread delimiting the frames
+		uint64_t						begin;
+		uint64_t						end;
+		std::vector<Profiler::EVENT>	events;
+	};
+
+	struct STATE
+	{
+		std::mutex									mutex;			// guards thread registration and names
+		std::vector<std::unique_ptr<THREADBUFFER>>	threads;
+		std::deque<FRAME>							frames;
+		std::map<std::string_view, Profiler::SUMMARY>	summaries;
+		std::vector<Profiler::SUMMARY>				summary;
+		uint64_t									frameBegin = 0;
+		uint32_t									frameThread = 0;
+		uint64_t									droppedEvents = 0;
+		uint32_t									frameHistory = 300;
+	};
+
+	STATE& GetState()
+	{
+		static STATE state;
+		return state;
+	}
+
+	thread_local THREADBUFFER* s_pThreadBuffer = nullptr;
+
+	THREADBUFFER& GetThreadBuffer()
+	{
+		if (!s_pThreadBuffer)
+		{
+			auto buffer = std::make_unique<THREADBUFFER>();
+			buffer->events.resize(THREADBUFFER_CAPACITY);
+			buffer->writeIndex = 0;
+			buffer->readIndex = 0;
+
+			// registration is the only locked step, once per thread
+			STATE& state = GetState();
+			std::lock_guard<std::mutex> lock(state.mutex);
+			buffer->thread = (uint32_t)state.threads.size();
+			buffer->name = "thread " + std::to_string(buffer->thread);
+			s_pThreadBuffer = buffer.get();
+			state.threads.push_back(std::move(buffer));
+		}
+		return *s_pThreadBuffer;
+	}
+
+	std::string EscapeJson(const std::string_view& str)
+	{
+		std::string escaped;
+		escaped.reserve(str.size());
+		for (char c : str)
+		{
+			if (c == '"' || c == '\\')
+			{
+				escaped += '\\';
+			}
+			escaped += c;
+		}
+		return escaped;
+	}
+}
+
+
+std::atomic<bool> Profiler::s_bEnabled(true);
+thread_local uint32_t Profiler::s_uDepth = 0;
+
+
+void Profiler::Record(const char* name, uint64_t begin, uint64_t end, uint32_t depth)
+{
+	THREADBUFFER& buffer = GetThreadBuffer();
+	const uint64_t index = buffer.writeIndex.load(std::memory_order_relaxed);
+	buffer.events[index & (THREADBUFFER_CAPACITY - 1)] = { name, begin, end, depth, buffer.thread };
+	buffer.writeIndex.store(index + 1, std::memory_order_release);
+}
+
+
+void Profiler::BeginFrame()
+{
+	STATE& state = GetState();
+	state.frameThread = GetThreadBuffer().thread;
+	state.frameBegin = Timer::GetTicks();
+}
+
+
+void Profiler::EndFrame()
+{
+	STATE& state = GetState();
+	FRAME frame;
+	frame.thread = state.frameThread;
+	frame.begin = state.frameBegin;
+	frame.end = Timer::GetTicks();
+
+	{
+		std::lock_guard<std::mutex> lock(state.mutex);
+		for (auto& buffer : state.threads)
+		{
+			const uint64_t write = buffer->writeIndex.load(std::memory_order_acquire);
+			uint64_t read = buffer->readIndex;
+			if (write - read > THREADBUFFER_CAPACITY)
+			{
+				state.droppedEvents += write - read - THREADBUFFER_CAPACITY;
+				read = write - THREADBUFFER_CAPACITY;
+			}
+			for (; read < write; ++read)
+			{
+				frame.events.push_back(buffer->events[read & (THREADBUFFER_CAPACITY - 1)]);
+			}
+			buffer->readIndex = write;
+		}
+	}
+
+	// per name totals, names of scopes that did not run this frame decay towards zero
+	for (auto& it : state.summaries)
+	{
+		it.second.calls = 0;
+		it.second.milliseconds = 0.0;
+	}
+	const double millisecondsPerTick = Timer::GetSecondsPerTick() * 1000.0;
+	for (const auto& event : frame.events)
+	{
+		SUMMARY& summary = state.summaries[event.name];
+		summary.name = event.name;
+		++summary.calls;
+		summary.milliseconds += (event.end - event.begin) * millisecondsPerTick;
+	}
+
+	constexpr double averageWeight = 0.05;
+	state.summary.clear();
+	for (auto& it : state.summaries)
+	{
+		SUMMARY& summary = it.second;
+		summary.averageMilliseconds += (summary.milliseconds - summary.averageMilliseconds) * averageWeight;
+		state.summary.push_back(summary);
+	}
+	std::sort(state.summary.begin(), state.summary.end(), [](const SUMMARY& a, const SUMMARY& b)
+	{
+		return a.averageMilliseconds > b.averageMilliseconds;
+	});
+
+	state.frames.push_back(std::move(frame));
+	while (state.frames.size() > state.frameHistory)
+	{
+		state.frames.pop_front();
+	}
+}
+
+
+void Profiler::SetEnabled(bool enabled)
+{
+	s_bEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+
+void Profiler::SetThreadName(const std::string_view& name)
+{
+	THREADBUFFER& buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(GetState().mutex);
+	buffer.name = name;
+}
+
+
+void Profiler::SetFrameHistory(uint32_t frames)
+{
+	STATE& state = GetState();
+	state.frameHistory = std::max(frames, 1u);
+	while (state.frames.size() > state.frameHistory)
+	{
+		state.frames.pop_front();
+	}
+}
+
+
+const std::vector<Profiler::SUMMARY>& Profiler::GetSummary()
+{
+	return GetState().summary;
+}
+
+
+uint64_t Profiler::GetDroppedEvents()
+{
+	return GetState().droppedEvents;
+}
+
+
+std::string Profiler::GetChromeTrace()
+{
+	STATE& state = GetState();
+	std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	if (state.frames.empty())
+	{
+		return json + "]}\n";
+	}
+
+	// timestamps in microseconds from the first kept frame
+	uint64_t origin = state.frames.front().begin;
+	for (const auto& frame : state.frames)
+	{
+		for (const auto& event : frame.events)
+		{
+			origin = std::min(origin, event.begin);
+		}
+	}
+	const double microsecondsPerTick = Timer::GetSecondsPerTick() * 1000000.0;
+
+	char line[512];
+	{
+		std::lock_guard<std::mutex> lock(state.mutex);
+		for (const auto& buffer : state.threads)
+		{
+			snprintf(line, sizeof(line), "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"%s\"}},\n",
+				buffer->thread,
+				EscapeJson(buffer->name).c_str());
+			json += line;
+		}
+	}
+
+	uint64_t frameIndex = 0;
+	for (const auto& frame : state.frames)
+	{
+		snprintf(line, sizeof(line), "{\"name\":\"Frame %llu\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n",
+			(unsigned long long)frameIndex++,
+			frame.thread,
+			(frame.begin - origin) * microsecondsPerTick,
+			(frame.end - frame.begin) * microsecondsPerTick);
+		json += line;
+
+		for (const auto& event : frame.events)
+		{
+			snprintf(line, sizeof(line), "{\"name\":\"%s\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f},\n",
+				EscapeJson(event.name).c_str(),
+				event.thread,
+				(event.begin - origin) * microsecondsPerTick,
+				(event.end - event.begin) * microsecondsPerTick);
+			json += line;
+		}
+	}
+
+	// no trailing comma
+	json.resize(json.size() - 2);
+	json += "\n]}\n";
+	return json;
+}
+
+
+bool Profiler::ExportChromeTrace(const std::string_view& filename)
+{
+	std::ofstream f(std::string(filename), std::ios::binary);
+	if (!f)
+	{
+		return false;
+	}
+	const std::string json = GetChromeTrace();
+	f.write(json.data(), json.size());
+	return (bool)f;
+}
+
+
+void Profiler::PrintSummary()
+{
+	for (const auto& summary : GetState().summary)
+	{
+		char line[256];
+		snprintf(line, sizeof(line), "%-40.*s %6u calls %9.3f ms  avg %9.3f ms\n",
+			(int)summary.name.size(), summary.name.data(),
+			summary.calls,
+			summary.milliseconds,
+			summary.averageMilliseconds);
+		IApplication::Debug(line);
+	}
+}
+
+
+void Profiler::Clear()
+{
+	STATE& state = GetState();
+	state.frames.clear();
+	state.summaries.clear();
+	state.summary.clear();
+	state.droppedEvents = 0;
+}
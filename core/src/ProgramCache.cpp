@@ -0,0 +1,219 @@
+/**
+ * ============================================================================
+ *  Name        : ProgramCache.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : on disk cache of linked program binaries
+ * ============================================================================
+**/
+
+#include "../include/ProgramCache.h"
+#include <cstring>
+#include <filesystem>
+
+
+ProgramCache::ProgramCache() :
+	m_uDriverHash(0),
+	m_Stats()
+{
+}
+
+
+ProgramCache::~ProgramCache()
+{
+}
+
+
+bool ProgramCache::IsSupported()
+{
+	if (!glGetProgramBinary || !glProgramBinary || !glProgramParameteri)
+	{
+		return false;
+	}
+	if (OpenGLRenderer::GetVersion() < 41 && !OpenGLRenderer::HasExtension("GL_ARB_get_program_binary"))
+	{
+		return false;
+	}
+
+	// some drivers expose the entry points without any binary format
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	return formatCount > 0;
+}
+
+
+bool ProgramCache::Create(const std::string_view& directory)
+{
+	m_strDirectory.clear();
+	m_Stats = STATS();
+
+	if (!IsSupported())
+	{
+		IApplication::Debug("ProgramCache: program binaries not supported\n");
+		return false;
+	}
+
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(directory), error);
+	if (!std::filesystem::is_directory(std::filesystem::path(directory), error))
+	{
+		IApplication::Debug("ProgramCache: failed to create directory " + std::string(directory) + "\n");
+		return false;
+	}
+	m_strDirectory = directory;
+
+	// binaries are only valid for the exact driver that produced them
+	uint64_t hash = Hash(nullptr, 0);
+	for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION, GL_SHADING_LANGUAGE_VERSION })
+	{
+		const char* str = (const char*)glGetString(name);
+		if (str)
+		{
+			hash = Hash(str, strlen(str) + 1, hash);
+		}
+	}
+	m_uDriverHash = hash;
+	return true;
+}
+
+
+uint64_t ProgramCache::GetKey(const std::string_view& vertexShader, const std::string_view& fragmentShader, const std::string_view& defines) const
+{
+	// lengths are hashed too so that moving text between the parts changes the key
+	const uint64_t sizes[3] = { vertexShader.size(), fragmentShader.size(), defines.size() };
+	uint64_t hash = Hash(&m_uDriverHash, sizeof(m_uDriverHash));
+	hash = Hash(sizes, sizeof(sizes), hash);
+	hash = Hash(vertexShader.data(), vertexShader.size(), hash);
+	hash = Hash(fragmentShader.data(), fragmentShader.size(), hash);
+	return Hash(defines.data(), defines.size(), hash);
+}
+
+
+GLuint ProgramCache::Load(uint64_t key)
+{
+	PROFILE_SCOPE("ProgramCache::Load");
+
+	if (m_strDirectory.empty())
+	{
+		return 0;
+	}
+
+	const std::string filename = GetFilename(key);
+	std::ifstream f(filename, std::ios::binary | std::ios::ate);
+	if (!f)
+	{
+		return 0;
+	}
+	const uint64_t fileSize = (uint64_t)f.tellg();
+	f.seekg(0);
+
+	// length is checked against the file before allocating, a truncated or corrupt entry is dropped
+	HEADER header;
+	std::vector<uint8_t> binary;
+	if (f.read((char*)&header, sizeof(header)) &&
+		header.magic == MAGIC &&
+		header.key == key &&
+		header.length &&
+		header.length <= fileSize - sizeof(header))
+	{
+		binary.resize(header.length);
+		f.read((char*)binary.data(), binary.size());
+	}
+	if (!f || binary.empty())
+	{
+		IApplication::Debug("ProgramCache: invalid cache file " + filename + "\n");
+		++m_Stats.rejected;
+		f.close();
+
+		std::error_code error;
+		std::filesystem::remove(std::filesystem::path(filename), error);
+		return 0;
+	}
+
+	// driver may still refuse the binary, e.g. after an update that did not change the version string
+	GLuint program = glCreateProgram();
+	glProgramBinary(program, header.format, binary.data(), (GLsizei)binary.size());
+
+	GLint linked = 0;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+	if (!linked)
+	{
+		glDeleteProgram(program);
+		++m_Stats.rejected;
+		return 0;
+	}
+
+	++m_Stats.hits;
+	return program;
+}
+
+
+bool ProgramCache::Store(uint64_t key, GLuint program)
+{
+	if (m_strDirectory.empty())
+	{
+		return false;
+	}
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+	{
+		return false;
+	}
+
+	HEADER header = { MAGIC, 0, 0, 0, key };
+	std::vector<uint8_t> binary(length);
+	GLsizei written = 0;
+	glGetProgramBinary(program, length, &written, &header.format, binary.data());
+	if (written <= 0)
+	{
+		return false;
+	}
+	header.length = (uint32_t)written;
+
+	std::ofstream f(GetFilename(key), std::ios::binary);
+	if (!f)
+	{
+		return false;
+	}
+	f.write((const char*)&header, sizeof(header));
+	f.write((const char*)binary.data(), written);
+	if (!f)
+	{
+		return false;
+	}
+
+	++m_Stats.writes;
+	return true;
+}
+
+
+void ProgramCache::PrintStats() const
+{
+	IApplication::Debug("ProgramCache: " +
+		std::to_string(m_Stats.hits) + " hits, " +
+		std::to_string(m_Stats.misses) + " misses, " +
+		std::to_string(m_Stats.rejected) + " rejected, " +
+		std::to_string(m_Stats.writes) + " writes\n");
+}
+
+
+uint64_t ProgramCache::Hash(const void* data, size_t size, uint64_t seed)
+{
+	const uint8_t* bytes = (const uint8_t*)data;
+	uint64_t hash = seed;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+
+std::string ProgramCache::GetFilename(uint64_t key) const
+{
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+	return (std::filesystem::path(m_strDirectory) / name).string();
+}
@@ -0,0 +1,216 @@
+/**
+ * ============================================================================
+ *  Name        : RenderTargetPool.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : transient color targets handed out by descriptor
+ * ============================================================================
+**/
+
+#include "../include/RenderTargetPool.h"
+
+
+RenderTargetPool::RenderTargetPool() :
+	m_uFrame(0),
+	m_uMaxIdleFrames(120),
+	m_uFrameAcquires(0),
+	m_uFrameAllocations(0),
+	m_Stats{}
+{
+}
+
+
+RenderTargetPool::~RenderTargetPool()
+{
+	Release();
+}
+
+
+bool RenderTargetPool::IsSupported()
+{
+	return glGenFramebuffers &&
+		(OpenGLRenderer::GetVersion() >= 30 || OpenGLRenderer::HasExtension("GL_ARB_framebuffer_object"));
+}
+
+
+void RenderTargetPool::Release()
+{
+	for (auto& target : m_arrTargets)
+	{
+		if (target->used)
+		{
+			IApplication::Debug("RenderTargetPool: target released while in use\n");
+		}
+		Delete(*target);
+	}
+	m_arrTargets.clear();
+	m_Stats.targets = 0;
+	m_Stats.bytes = 0;
+}
+
+
+RenderTargetPool::TARGET* RenderTargetPool::Acquire(const DESC& desc)
+{
+	++m_uFrameAcquires;
+
+	// most recently used free target first, it is the likeliest to still be in the caches
+	const glm::ivec2 allocatedSize(GetAllocatedSize(desc.size));
+	TARGET* found = nullptr;
+	for (auto& target : m_arrTargets)
+	{
+		if (!target->used && target->desc.format == desc.format && target->allocatedSize == allocatedSize &&
+			(!found || target->lastFrame > found->lastFrame))
+		{
+			found = target.get();
+		}
+	}
+
+	if (!found)
+	{
+		found = Create(desc);
+		if (!found)
+		{
+			return nullptr;
+		}
+	}
+	else if (found->desc.filter != desc.filter)
+	{
+		glBindTexture(GL_TEXTURE_2D, found->texture);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, desc.filter);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, desc.filter);
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+
+	found->desc = desc;
+	found->used = true;
+	found->lastFrame = m_uFrame;
+	return found;
+}
+
+
+void RenderTargetPool::Recycle(TARGET* target)
+{
+	if (target)
+	{
+		target->used = false;
+	}
+}
+
+
+void RenderTargetPool::EndFrame()
+{
+	// targets of a previous window size or an effect that was removed
+	for (size_t i = 0; i < m_arrTargets.size();)
+	{
+		TARGET& target = *m_arrTargets[i];
+		if (!target.used && m_uFrame - target.lastFrame > m_uMaxIdleFrames)
+		{
+			m_Stats.bytes -= (uint64_t)target.allocatedSize.x * target.allocatedSize.y * GetBytesPerPixel(target.desc.format);
+			Delete(target);
+			m_arrTargets[i] = std::move(m_arrTargets.back());
+			m_arrTargets.pop_back();
+			continue;
+		}
+		++i;
+	}
+
+	m_Stats.targets = (uint32_t)m_arrTargets.size();
+	m_Stats.frameAcquires = m_uFrameAcquires;
+	m_Stats.frameAllocations = m_uFrameAllocations;
+	m_uFrameAcquires = 0;
+	m_uFrameAllocations = 0;
+	++m_uFrame;
+}
+
+
+RenderTargetPool::TARGET* RenderTargetPool::Create(const DESC& desc)
+{
+	// pixel transfer format of the internal format, no data is uploaded
+	GLenum format = GL_RGBA;
+	GLenum type = GL_UNSIGNED_BYTE;
+	switch (desc.format)
+	{
+	case GL_RGBA16F:
+		type = GL_HALF_FLOAT;
+		break;
+	case GL_R11F_G11F_B10F:
+		format = GL_RGB;
+		type = GL_HALF_FLOAT;
+		break;
+	case GL_RG16F:
+		format = GL_RG;
+		type = GL_HALF_FLOAT;
+		break;
+	case GL_R8:
+		format = GL_RED;
+		break;
+	}
+
+	auto target = std::make_unique<TARGET>();
+	target->desc = desc;
+	target->allocatedSize = GetAllocatedSize(desc.size);
+	target->used = false;
+	target->lastFrame = m_uFrame;
+
+	glGenTextures(1, &target->texture);
+	glBindTexture(GL_TEXTURE_2D, target->texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, desc.format, target->allocatedSize.x, target->allocatedSize.y, 0, format, type, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, desc.filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, desc.filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenFramebuffers(1, &target->framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, target->framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target->texture, 0);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		IApplication::Debug("RenderTargetPool: framebuffer is incomplete\n");
+		Delete(*target);
+		return nullptr;
+	}
+
+	++m_uFrameAllocations;
+	++m_Stats.allocations;
+	m_Stats.bytes += (uint64_t)target->allocatedSize.x * target->allocatedSize.y * GetBytesPerPixel(desc.format);
+	m_arrTargets.push_back(std::move(target));
+	m_Stats.targets = (uint32_t)m_arrTargets.size();
+	return m_arrTargets.back().get();
+}
+
+
+void RenderTargetPool::Delete(TARGET& target)
+{
+	if (target.framebuffer)
+	{
+		glDeleteFramebuffers(1, &target.framebuffer);
+		target.framebuffer = 0;
+	}
+	if (target.texture)
+	{
+		glDeleteTextures(1, &target.texture);
+		target.texture = 0;
+	}
+}
+
+
+glm::ivec2 RenderTargetPool::GetAllocatedSize(const glm::ivec2& size)
+{
+	return (glm::max(size, glm::ivec2(1)) + (SIZE_GRANULARITY - 1)) / SIZE_GRANULARITY * SIZE_GRANULARITY;
+}
+
+
+uint32_t RenderTargetPool::GetBytesPerPixel(GLenum format)
+{
+	switch (format)
+	{
+	case GL_RGBA16F:
+		return 8;
+	case GL_RG16F:
+		return 4;
+	case GL_R8:
+		return 1;
+	default:
+		return 4;
+	}
+}
@@ -0,0 +1,462 @@
+/**
+ * ============================================================================
+ *  Name        : ResourceCache.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : deduplicating cache of textures, shaders and programs keyed
+ *                by normalized path and load options. Resources are shared
+ *                and reference counted, unused ones are evicted explicitly
+ *                or least recently used first when over the memory budget.
+ * ============================================================================
+**/
+
+#include "../include/ResourceCache.h"
+#include <algorithm>
+#include <cctype>
+
+
+ResourceCache::RESOURCE::~RESOURCE()
+{
+	switch (type)
+	{
+	case TYPE_TEXTURE:
+		glDeleteTextures(1, &handle);
+		break;
+	case TYPE_VERTEX_SHADER:
+	case TYPE_FRAGMENT_SHADER:
+		glDeleteShader(handle);
+		break;
+	case TYPE_PROGRAM:
+		glDeleteProgram(handle);
+		break;
+	}
+}
+
+
+ResourceCache::ResourceCache(OpenGLRenderer& renderer) :
+	m_Renderer(renderer),
+	m_Compiler(renderer),
+	m_pTextureStreamer(nullptr),
+	m_uAccessCounter(0),
+	m_uBudget(0)
+{
+}
+
+
+ResourceCache::~ResourceCache()
+{
+	m_arrStreaming.clear();
+	Clear();
+}
+
+
+std::string ResourceCache::NormalizePath(const std::string_view& path)
+{
+	std::string normalized(path);
+	std::replace(normalized.begin(), normalized.end(), '\\', '/');
+#if defined (_WINDOWS)
+	std::transform(normalized.begin(), normalized.end(), normalized.begin(), [](char c) { return (char)tolower((unsigned char)c); });
+#endif
+
+	// split into components, dropping "." and resolving ".." where possible
+	const bool absolute = !normalized.empty() && normalized[0] == '/';
+	std::vector<std::string> components;
+	size_t start = 0;
+	while (start <= normalized.size())
+	{
+		size_t end = normalized.find('/', start);
+		if (end == std::string::npos)
+		{
+			end = normalized.size();
+		}
+
+		const std::string component = normalized.substr(start, end - start);
+		if (component == "..")
+		{
+			if (!components.empty() && components.back() != "..")
+			{
+				components.pop_back();
+			}
+			else if (!absolute)
+			{
+				components.push_back(component);
+			}
+		}
+		else if (!component.empty() && component != ".")
+		{
+			components.push_back(component);
+		}
+		start = end + 1;
+	}
+
+	std::string result(absolute ? "/" : "");
+	for (size_t i = 0; i < components.size(); ++i)
+	{
+		result += (i ? "/" : "") + components[i];
+	}
+	return result;
+}
+
+
+void ResourceCache::SetTextureStreamer(TextureStreamer* streamer)
+{
+	m_pTextureStreamer = streamer;
+	if (!streamer)
+	{
+		m_arrStreaming.clear();
+	}
+}
+
+
+ResourceCache::HANDLE ResourceCache::GetTexture(const std::string_view& filename, const OpenGLRenderer::TEXTUREPARAMS& params)
+{
+	const std::string path = NormalizePath(filename);
+	const std::string key = "texture:" + path +
+		"|wrap=" + std::to_string(params.wrap) +
+		"|mips=" + std::to_string(params.mipmaps ? params.maxLevel : -1) +
+		"|aniso=" + std::to_string(params.anisotropy) +
+		"|compression=" + std::to_string(params.compression);
+
+	auto resource = Find(key);
+	if (!resource && m_pTextureStreamer && !params.compression)
+	{
+		// size is known once the streamer has uploaded all levels
+		const GLuint texture = m_pTextureStreamer->Load(path, params);
+		if (!texture)
+		{
+			return nullptr;
+		}
+
+		resource = Insert(std::make_shared<RESOURCE>(TYPE_TEXTURE, texture, key));
+		m_arrStreaming.push_back(resource);
+	}
+	else if (!resource)
+	{
+		const GLuint texture = m_Renderer.CreateTexture(path, params);
+		if (!texture)
+		{
+			return nullptr;
+		}
+
+		resource = std::make_shared<RESOURCE>(TYPE_TEXTURE, texture, key);
+		resource->vramBytes = GetTextureSize(texture);
+		resource = Insert(resource);
+	}
+	return resource;
+}
+
+
+ResourceCache::HANDLE ResourceCache::GetVertexShader(const std::string_view& filename)
+{
+	return GetShader(TYPE_VERTEX_SHADER, filename);
+}
+
+
+ResourceCache::HANDLE ResourceCache::GetFragmentShader(const std::string_view& filename)
+{
+	return GetShader(TYPE_FRAGMENT_SHADER, filename);
+}
+
+
+ResourceCache::HANDLE ResourceCache::GetShader(TYPE type, const std::string_view& filename)
+{
+	const std::string path = NormalizePath(filename);
+	const std::string key = (type == TYPE_VERTEX_SHADER ? "vertexshader:" : "fragmentshader:") + path;
+
+	auto resource = Find(key);
+	if (!resource)
+	{
+		const GLuint shader = (type == TYPE_VERTEX_SHADER) ?
+			m_Renderer.CreateVertexShaderFromFile(path) :
+			m_Renderer.CreateFragmentShaderFromFile(path);
+		if (!shader)
+		{
+			return nullptr;
+		}
+		resource = Insert(std::make_shared<RESOURCE>(type, shader, key));
+	}
+	return resource;
+}
+
+
+ResourceCache::HANDLE ResourceCache::GetProgram(const std::string_view& vertexShaderFile, const std::string_view& fragmentShaderFile, bool async, const std::string_view& defines)
+{
+	std::string key = "program:" + NormalizePath(vertexShaderFile) + "+" + NormalizePath(fragmentShaderFile);
+	if (!defines.empty())
+	{
+		// one line per define keeps the key printable
+		std::string definesKey(defines);
+		std::replace(definesKey.begin(), definesKey.end(), '\n', ';');
+		key += "|" + definesKey;
+	}
+
+	auto resource = Find(key);
+	if (resource && resource->IsPending() && !async)
+	{
+		// synchronous request for a program that is still compiling
+		m_Compiler.Finish();
+		Update();
+		return resource->handle ? resource : nullptr;
+	}
+
+	if (!resource && (async || !defines.empty()))
+	{
+		// the renderer only links plain files, variants with defines always go through the compiler
+		auto program = m_Compiler.SubmitFiles(NormalizePath(vertexShaderFile), NormalizePath(fragmentShaderFile), defines);
+		if (!async)
+		{
+			m_Compiler.Finish();
+		}
+		if (program->state == ShaderCompiler::STATE_FAILED)
+		{
+			return nullptr;
+		}
+
+		resource = Insert(std::make_shared<RESOURCE>(TYPE_PROGRAM, program->handle, key));
+		if (program->state != ShaderCompiler::STATE_READY)
+		{
+			resource->pending = program;
+			m_arrPending.push_back(resource);
+		}
+	}
+	else if (!resource)
+	{
+		// programs are linked straight from source so that the renderer program cache can skip compiling
+		const GLuint program = m_Renderer.CreateProgramFromFiles(NormalizePath(vertexShaderFile), NormalizePath(fragmentShaderFile));
+		if (!program)
+		{
+			return nullptr;
+		}
+
+		resource = Insert(std::make_shared<RESOURCE>(TYPE_PROGRAM, program, key));
+	}
+	return resource;
+}
+
+
+size_t ResourceCache::Update(float timeBudget)
+{
+	// streamed textures count against the budget once they are resident
+	bool resident = false;
+	for (auto it = m_arrStreaming.begin(); it != m_arrStreaming.end();)
+	{
+		if (m_pTextureStreamer->IsResident((*it)->handle))
+		{
+			(*it)->vramBytes = GetTextureSize((*it)->handle);
+			it = m_arrStreaming.erase(it);
+			resident = true;
+		}
+		else
+		{
+			++it;
+		}
+	}
+	if (resident)
+	{
+		Trim();
+	}
+
+	if (m_arrPending.empty())
+	{
+		return 0;
+	}
+
+	m_Compiler.Update(timeBudget);
+	for (auto it = m_arrPending.begin(); it != m_arrPending.end();)
+	{
+		RESOURCE& resource = **it;
+		const ShaderCompiler::STATE state = resource.pending->state;
+		if (state != ShaderCompiler::STATE_READY && state != ShaderCompiler::STATE_FAILED)
+		{
+			++it;
+			continue;
+		}
+
+		resource.handle = resource.pending->handle;
+		resource.pending = nullptr;
+
+		// failed program is dropped so that the next request tries again
+		if (state == ShaderCompiler::STATE_FAILED)
+		{
+			auto cached = m_mapResources.find(resource.key);
+			if (cached != m_mapResources.end() && cached->second == *it)
+			{
+				m_mapResources.erase(cached);
+			}
+		}
+		it = m_arrPending.erase(it);
+	}
+	return m_arrPending.size();
+}
+
+
+ResourceCache::HANDLE ResourceCache::Find(const std::string& key)
+{
+	auto it = m_mapResources.find(key);
+	if (it == m_mapResources.end())
+	{
+		return nullptr;
+	}
+
+	it->second->lastUsed = ++m_uAccessCounter;
+	return it->second;
+}
+
+
+ResourceCache::HANDLE ResourceCache::Insert(const HANDLE& resource)
+{
+	resource->lastUsed = ++m_uAccessCounter;
+	m_mapResources[resource->key] = resource;
+	Trim();
+	return resource;
+}
+
+
+void ResourceCache::Evict(const HANDLE& resource)
+{
+	if (resource)
+	{
+		auto it = m_mapResources.find(resource->key);
+		if (it != m_mapResources.end() && it->second == resource)
+		{
+			m_mapResources.erase(it);
+		}
+	}
+}
+
+
+size_t ResourceCache::EvictUnused()
+{
+	size_t evicted = 0;
+	for (auto it = m_mapResources.begin(); it != m_mapResources.end();)
+	{
+		if (it->second.use_count() == 1)
+		{
+			it = m_mapResources.erase(it);
+			++evicted;
+		}
+		else
+		{
+			++it;
+		}
+	}
+	return evicted;
+}
+
+
+void ResourceCache::SetBudget(size_t bytes)
+{
+	m_uBudget = bytes;
+	Trim();
+}
+
+
+void ResourceCache::Trim()
+{
+	if (!m_uBudget)
+	{
+		return;
+	}
+
+	size_t usage = GetVramUsage();
+	if (usage <= m_uBudget)
+	{
+		return;
+	}
+
+	// unused resources, least recently used first
+	std::vector<HANDLE> candidates;
+	for (const auto& it : m_mapResources)
+	{
+		if (it.second.use_count() == 1 && it.second->vramBytes)
+		{
+			candidates.push_back(it.second);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const HANDLE& a, const HANDLE& b) { return a->lastUsed < b->lastUsed; });
+
+	for (const auto& resource : candidates)
+	{
+		if (usage <= m_uBudget)
+		{
+			break;
+		}
+		usage -= resource->vramBytes;
+		m_mapResources.erase(resource->key);
+	}
+}
+
+
+void ResourceCache::Clear()
+{
+	m_mapResources.clear();
+}
+
+
+size_t ResourceCache::GetVramUsage() const
+{
+	size_t bytes = 0;
+	for (const auto& it : m_mapResources)
+	{
+		bytes += it.second->vramBytes;
+	}
+	return bytes;
+}
+
+
+void ResourceCache::PrintStats() const
+{
+	std::vector<HANDLE> resources;
+	for (const auto& it : m_mapResources)
+	{
+		resources.push_back(it.second);
+	}
+	std::sort(resources.begin(), resources.end(), [](const HANDLE& a, const HANDLE& b) { return a->vramBytes > b->vramBytes; });
+
+	IApplication::Debug("ResourceCache: " + std::to_string(resources.size()) + " resources, " +
+		std::to_string(GetVramUsage() / 1024) + " KB\n");
+	for (const auto& resource : resources)
+	{
+		// one reference is held by the cache and one by the local array
+		IApplication::Debug("  " + resource->key +
+			" refs " + std::to_string(resource.use_count() - 2) +
+			" " + std::to_string(resource->vramBytes / 1024) + " KB\n");
+	}
+}
+
+
+size_t ResourceCache::GetTextureSize(GLuint texture)
+{
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, texture);
+
+	GLint maxLevel = 0;
+	glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, &maxLevel);
+
+	size_t bytes = 0;
+	for (GLint level = 0; level <= maxLevel; ++level)
+	{
+		GLint width = 0;
+		GLint height = 0;
+		GLint compressed = GL_FALSE;
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_WIDTH, &width);
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_HEIGHT, &height);
+		if (!width || !height)
+		{
+			break;
+		}
+
+		glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED, &compressed);
+		if (compressed)
+		{
+			GLint size = 0;
+			glGetTexLevelParameteriv(GL_TEXTURE_2D, level, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
+			bytes += (size_t)size;
+		}
+		else
+		{
+			// textures are created as rgba8
+			bytes += (size_t)width * height * 4;
+		}
+	}
+	return bytes;
+}
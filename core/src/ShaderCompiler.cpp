@@ -0,0 +1,284 @@
+/**
+ * ============================================================================
+ *  Name        : ShaderCompiler.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : batch shader compiler polling completion status
+ * ============================================================================
+**/
+
+#include "../include/ShaderCompiler.h"
+#include "../include/ProgramCache.h"
+#include <algorithm>
+
+
+ShaderCompiler::ShaderCompiler(OpenGLRenderer& renderer) :
+	m_Renderer(renderer),
+	m_bParallel(IsParallelSupported()),
+	m_Stats()
+{
+}
+
+
+ShaderCompiler::~ShaderCompiler()
+{
+	Release();
+}
+
+
+bool ShaderCompiler::IsParallelSupported()
+{
+	return OpenGLRenderer::HasExtension("GL_KHR_parallel_shader_compile") ||
+		OpenGLRenderer::HasExtension("GL_ARB_parallel_shader_compile");
+}
+
+
+void ShaderCompiler::SetThreadCount(uint32_t count)
+{
+	if (glMaxShaderCompilerThreadsKHR && IsParallelSupported())
+	{
+		glMaxShaderCompilerThreadsKHR(count);
+	}
+}
+
+
+std::shared_ptr<ShaderCompiler::PROGRAM> ShaderCompiler::Submit(const std::string_view& vertexShader, const std::string_view& fragmentShader, const std::string_view& defines, const std::string_view& name)
+{
+	PROFILE_SCOPE("ShaderCompiler::Submit");
+
+	auto program = std::make_shared<PROGRAM>(name);
+	++m_Stats.submitted;
+
+	ProgramCache* cache = m_Renderer.GetProgramCache();
+	if (cache)
+	{
+		program->key = cache->GetKey(vertexShader, fragmentShader, defines);
+		program->handle = cache->Load(program->key);
+		if (program->handle)
+		{
+			program->state = STATE_READY;
+			++m_Stats.cached;
+			return program;
+		}
+		cache->CountMiss();
+	}
+
+	// only start the compiles, status is not queried until the program is linked
+	const std::string sources[2] = {
+		OpenGLRenderer::InsertDefines(vertexShader, defines),
+		OpenGLRenderer::InsertDefines(fragmentShader, defines) };
+	const GLenum types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+	GLuint shaders[2];
+	for (size_t i = 0; i < 2; ++i)
+	{
+		const char* source = sources[i].c_str();
+		shaders[i] = glCreateShader(types[i]);
+		glShaderSource(shaders[i], 1, &source, nullptr);
+		glCompileShader(shaders[i]);
+	}
+	program->vertexShader = shaders[0];
+	program->fragmentShader = shaders[1];
+
+	m_arrPending.push_back(program);
+	return program;
+}
+
+
+std::shared_ptr<ShaderCompiler::PROGRAM> ShaderCompiler::SubmitFiles(const std::string_view& vertexShaderFile, const std::string_view& fragmentShaderFile, const std::string_view& defines)
+{
+	const std::string name = std::string(vertexShaderFile) + "+" + std::string(fragmentShaderFile);
+	const std::string vertexShader = OpenGLRenderer::LoadTextFile(vertexShaderFile);
+	const std::string fragmentShader = OpenGLRenderer::LoadTextFile(fragmentShaderFile);
+	if (vertexShader.empty() || fragmentShader.empty())
+	{
+		IApplication::Debug("ShaderCompiler: failed to load " + name + "\n");
+
+		auto program = std::make_shared<PROGRAM>(name);
+		program->state = STATE_FAILED;
+		++m_Stats.submitted;
+		++m_Stats.failed;
+		return program;
+	}
+	return Submit(vertexShader, fragmentShader, defines, name);
+}
+
+
+size_t ShaderCompiler::Update(float timeBudget)
+{
+	PROFILE_SCOPE("ShaderCompiler::Update");
+
+	const uint64_t start = Timer::GetTicks();
+	const auto withinBudget = [start, timeBudget]()
+	{
+		return (Timer::GetTicks() - start) * Timer::GetSecondsPerTick() < timeBudget;
+	};
+
+	// link as soon as both shaders are compiled. Without parallel compile the
+	// status can not be polled, link right away and let the driver queue it.
+	// Some drivers link synchronously even with parallel compile, so links
+	// are limited by the budget too
+	bool linked = false;
+	for (auto& program : m_arrPending)
+	{
+		if (program->state == STATE_COMPILING &&
+			IsShaderComplete(program->vertexShader) &&
+			IsShaderComplete(program->fragmentShader) &&
+			(!linked || withinBudget()))
+		{
+			Link(*program);
+			linked = true;
+		}
+	}
+
+	bool finished = false;
+	for (auto& program : m_arrPending)
+	{
+		if (program->state != STATE_LINKING)
+		{
+			continue;
+		}
+
+		if (m_bParallel)
+		{
+			if (IsProgramComplete(program->handle))
+			{
+				Complete(*program);
+			}
+		}
+		else if (!finished || withinBudget())
+		{
+			// blocking query, but always make progress
+			Complete(*program);
+			finished = true;
+		}
+	}
+
+	RemoveFinished();
+	return m_arrPending.size();
+}
+
+
+void ShaderCompiler::Finish()
+{
+	for (auto& program : m_arrPending)
+	{
+		if (program->state == STATE_COMPILING)
+		{
+			Link(*program);
+		}
+	}
+	for (auto& program : m_arrPending)
+	{
+		Complete(*program);
+	}
+	RemoveFinished();
+}
+
+
+void ShaderCompiler::Release()
+{
+	for (auto& program : m_arrPending)
+	{
+		glDeleteShader(program->vertexShader);
+		glDeleteShader(program->fragmentShader);
+		if (program->handle)
+		{
+			glDeleteProgram(program->handle);
+		}
+		program->vertexShader = 0;
+		program->fragmentShader = 0;
+		program->handle = 0;
+		program->state = STATE_FAILED;
+	}
+	m_arrPending.clear();
+}
+
+
+bool ShaderCompiler::IsShaderComplete(GLuint shader) const
+{
+	if (!m_bParallel)
+	{
+		return true;
+	}
+
+	GLint complete = 0;
+	glGetShaderiv(shader, GL_COMPLETION_STATUS_KHR, &complete);
+	return complete != 0;
+}
+
+
+bool ShaderCompiler::IsProgramComplete(GLuint program) const
+{
+	GLint complete = 0;
+	glGetProgramiv(program, GL_COMPLETION_STATUS_KHR, &complete);
+	return complete != 0;
+}
+
+
+void ShaderCompiler::Link(PROGRAM& program)
+{
+	program.handle = glCreateProgram();
+	glAttachShader(program.handle, program.vertexShader);
+	glAttachShader(program.handle, program.fragmentShader);
+	if (m_Renderer.GetProgramCache())
+	{
+		glProgramParameteri(program.handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
+	glLinkProgram(program.handle);
+	program.state = STATE_LINKING;
+}
+
+
+void ShaderCompiler::Complete(PROGRAM& program)
+{
+	GLint linked = 0;
+	glGetProgramiv(program.handle, GL_LINK_STATUS, &linked);
+	if (!linked)
+	{
+		// find out which stage failed for the error message
+		IApplication::Debug("ShaderCompiler: failed to build " + program.name + "\n");
+		for (GLuint shader : { program.vertexShader, program.fragmentShader })
+		{
+			GLint compiled = 0;
+			glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+			if (!compiled)
+			{
+				m_Renderer.PrintShaderError(shader);
+			}
+		}
+		m_Renderer.PrintProgramError(program.handle);
+
+		glDeleteProgram(program.handle);
+		program.handle = 0;
+		program.state = STATE_FAILED;
+		++m_Stats.failed;
+	}
+	else
+	{
+		glDetachShader(program.handle, program.vertexShader);
+		glDetachShader(program.handle, program.fragmentShader);
+
+		ProgramCache* cache = m_Renderer.GetProgramCache();
+		if (cache)
+		{
+			cache->Store(program.key, program.handle);
+		}
+		program.state = STATE_READY;
+		++m_Stats.ready;
+	}
+
+	glDeleteShader(program.vertexShader);
+	glDeleteShader(program.fragmentShader);
+	program.vertexShader = 0;
+	program.fragmentShader = 0;
+}
+
+
+void ShaderCompiler::RemoveFinished()
+{
+	m_arrPending.erase(std::remove_if(m_arrPending.begin(), m_arrPending.end(),
+		[](const std::shared_ptr<PROGRAM>& program)
+		{
+			return program->state == STATE_READY || program->state == STATE_FAILED;
+		}),
+		m_arrPending.end());
+}
@@ -0,0 +1,192 @@
+/**
+ * ============================================================================
+ *  Name        : ShaderPermutations.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : specialized variants of a shader pair selected by feature key
+ * ============================================================================
+**/
+
+#include "../include/ShaderPermutations.h"
+#include "../include/Material.h"
+#include <sstream>
+
+
+ShaderPermutations::ShaderPermutations(ResourceCache& resources) :
+	m_Resources(resources),
+	m_uFeatureMask(0)
+{
+}
+
+
+ShaderPermutations::~ShaderPermutations()
+{
+	Release();
+}
+
+
+bool ShaderPermutations::Load(const std::string_view& vertexShaderFile, const std::string_view& fragmentShaderFile)
+{
+	Release();
+	m_mapFeatures.clear();
+	m_uFeatureMask = 0;
+
+	m_strName = std::string(vertexShaderFile) + "+" + std::string(fragmentShaderFile);
+	m_strVertexShaderFile.clear();
+	m_strFragmentShaderFile.clear();
+
+	// the sources are only read for their feature declarations, the cache compiles from the files
+	const std::string vertexShader = OpenGLRenderer::LoadTextFile(vertexShaderFile);
+	const std::string fragmentShader = OpenGLRenderer::LoadTextFile(fragmentShaderFile);
+	if (vertexShader.empty() || fragmentShader.empty())
+	{
+		IApplication::Debug("ShaderPermutations: failed to load " + m_strName + "\n");
+		return false;
+	}
+
+	ParseFeatures(vertexShader);
+	ParseFeatures(fragmentShader);
+	m_strVertexShaderFile = vertexShaderFile;
+	m_strFragmentShaderFile = fragmentShaderFile;
+	return true;
+}
+
+
+void ShaderPermutations::Release()
+{
+	m_mapPrograms.clear();
+}
+
+
+uint64_t ShaderPermutations::GetKey(const Material* material) const
+{
+	return material ? (material->GetFeatures() & m_uFeatureMask) : 0;
+}
+
+
+uint64_t ShaderPermutations::GetFeatureBit(const std::string_view& name) const
+{
+	auto it = m_mapFeatures.find(std::string(name));
+	return it != m_mapFeatures.end() ? it->second : 0;
+}
+
+
+std::string ShaderPermutations::GetDefines(uint64_t key) const
+{
+	std::string defines;
+	for (const auto& it : m_mapFeatures)
+	{
+		if (key & it.second)
+		{
+			defines += "#define " + it.first + " 1\n";
+		}
+	}
+	return defines;
+}
+
+
+GLuint ShaderPermutations::GetProgram(uint64_t key, bool wait)
+{
+	key &= m_uFeatureMask;
+
+	auto it = m_mapPrograms.find(key);
+	if (it == m_mapPrograms.end())
+	{
+		if (m_strVertexShaderFile.empty())
+		{
+			return 0;
+		}
+
+		// a failed permutation is kept as nullptr so that it is not rebuilt every frame
+		it = m_mapPrograms.emplace(key, m_Resources.GetProgram(m_strVertexShaderFile, m_strFragmentShaderFile, !wait, GetDefines(key))).first;
+	}
+	else if (wait && it->second && it->second->IsPending())
+	{
+		it->second = m_Resources.GetProgram(m_strVertexShaderFile, m_strFragmentShaderFile, false, GetDefines(key));
+	}
+	return it->second ? it->second->handle : 0;
+}
+
+
+ShaderCompiler::STATE ShaderPermutations::GetState(uint64_t key) const
+{
+	auto it = m_mapPrograms.find(key & m_uFeatureMask);
+	if (it == m_mapPrograms.end() || !it->second)
+	{
+		return ShaderCompiler::STATE_FAILED;
+	}
+	if (it->second->IsPending())
+	{
+		return it->second->pending->state;
+	}
+	return it->second->handle ? ShaderCompiler::STATE_READY : ShaderCompiler::STATE_FAILED;
+}
+
+
+void ShaderPermutations::Sort(const DrawQueue& queue, std::map<uint64_t, DrawQueue>& groups) const
+{
+	for (auto& it : groups)
+	{
+		it.second.Clear();
+	}
+
+	for (const auto& draw : queue.GetDraws())
+	{
+		groups[GetKey(draw.material)].Add(draw.geometry, draw.material, draw.worldMatrix, draw.previousWorldMatrix);
+	}
+}
+
+
+void ShaderPermutations::ParseFeatures(const std::string& source)
+{
+	std::istringstream stream(source);
+	std::string line;
+	while (std::getline(stream, line))
+	{
+		// "#pragma feature <name>", whitespace is allowed around the '#'
+		std::istringstream tokens(line);
+		std::string directive;
+		std::string pragma;
+		std::string name;
+		tokens >> directive;
+		if (directive == "#")
+		{
+			tokens >> directive;
+			directive = "#" + directive;
+		}
+		if (directive != "#pragma" || !(tokens >> pragma >> name) || pragma != "feature")
+		{
+			continue;
+		}
+		if (m_mapFeatures.count(name))
+		{
+			continue;
+		}
+
+		// material features keep their bit so material keys can be used as is
+		uint64_t bit = 0;
+		for (uint32_t i = 0; i < Material::FEATURE_COUNT; ++i)
+		{
+			if (name == Material::GetFeatureName(i))
+			{
+				bit = 1ULL << i;
+			}
+		}
+		if (!bit)
+		{
+			uint32_t index = 32;
+			while (index < 64 && (m_uFeatureMask & (1ULL << index)))
+			{
+				++index;
+			}
+			if (index == 64)
+			{
+				IApplication::Debug("ShaderPermutations: too many features in " + m_strName + "\n");
+				continue;
+			}
+			bit = 1ULL << index;
+		}
+
+		m_mapFeatures[name] = bit;
+		m_uFeatureMask |= bit;
+	}
+}
@@ -0,0 +1,407 @@
+/**
+ * ============================================================================
+ *  Name        : ShadowMap.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : cascaded shadow maps for the directional light
+ * ============================================================================
+**/
+
+#include "../include/ShadowMap.h"
+#include "../include/Geometry.h"
+#include "../include/GeometryNode.h"
+#include <algorithm>
+#include <cmath>
+
+
+// depth only, fragment output is ignored
+static const char* s_pDepthVertexShader =
+	"attribute vec3 position;\n"
+	"uniform mat4 modelViewProjectionMatrix;\n"
+	"void main(void)\n"
+	"{\n"
+	"	gl_Position = modelViewProjectionMatrix * vec4(position, 1.0);\n"
+	"}\n";
+
+static const char* s_pDepthFragmentShader =
+	"void main(void)\n"
+	"{\n"
+	"	gl_FragColor = vec4(1.0);\n"
+	"}\n";
+
+
+ShadowMap::ShadowMap() :
+	m_vAtlasSize(0),
+	m_vLightDirection(0.0f, -1.0f, 0.0f),
+	m_vDepthPlane(0.0f),
+	m_uProgram(0),
+	m_iPositionAttrib(-1),
+	m_uStaticFramebuffer(0),
+	m_uStaticDepth(0),
+	m_uFramebuffer(0),
+	m_uTexture(0),
+	m_Stats()
+{
+	for (auto& cascade : m_arrCascades)
+	{
+		cascade = {};
+	}
+}
+
+
+ShadowMap::~ShadowMap()
+{
+	Release();
+}
+
+
+bool ShadowMap::IsSupported()
+{
+	return glGenFramebuffers && glBlitFramebuffer &&
+		(OpenGLRenderer::GetVersion() >= 30 || OpenGLRenderer::HasExtension("GL_ARB_framebuffer_object"));
+}
+
+
+bool ShadowMap::Create(OpenGLRenderer& renderer, const SETTINGS& settings)
+{
+	Release();
+	if (!IsSupported())
+	{
+		IApplication::Debug("ShadowMap: framebuffer blits not supported\n");
+		return false;
+	}
+
+	m_Settings = settings;
+	m_Settings.cascades = glm::clamp(m_Settings.cascades, 1u, MAX_CASCADES);
+	m_Settings.resolution = std::max(m_Settings.resolution, 16u);
+	m_vAtlasSize = glm::ivec2(
+		std::min(m_Settings.cascades, 2u) * m_Settings.resolution,
+		(m_Settings.cascades + 1) / 2 * m_Settings.resolution);
+
+	m_uProgram = renderer.CreateProgramFromSource(s_pDepthVertexShader, s_pDepthFragmentShader);
+	if (!m_uProgram)
+	{
+		return false;
+	}
+	m_iPositionAttrib = glGetAttribLocation(m_uProgram, "position");
+
+	// cached static depth, only ever copied from
+	glGenRenderbuffers(1, &m_uStaticDepth);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_uStaticDepth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, m_vAtlasSize.x, m_vAtlasSize.y);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	// sampled atlas with hardware depth compare, linear filtering gives 2x2 pcf
+	glGenTextures(1, &m_uTexture);
+	glBindTexture(GL_TEXTURE_2D, m_uTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, m_vAtlasSize.x, m_vAtlasSize.y, 0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	GLuint framebuffers[2];
+	glGenFramebuffers(2, framebuffers);
+	m_uStaticFramebuffer = framebuffers[0];
+	m_uFramebuffer = framebuffers[1];
+
+	bool complete = true;
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uStaticFramebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_uStaticDepth);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	complete &= glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_uTexture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	complete &= glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, renderer.GetDefaultFramebuffer());
+
+	if (!complete)
+	{
+		IApplication::Debug("ShadowMap: incomplete framebuffer\n");
+		Release();
+		return false;
+	}
+
+	for (auto& cascade : m_arrCascades)
+	{
+		cascade.valid = false;
+	}
+	return true;
+}
+
+
+void ShadowMap::Release()
+{
+	if (m_uStaticFramebuffer)
+	{
+		const GLuint framebuffers[2] = { m_uStaticFramebuffer, m_uFramebuffer };
+		glDeleteFramebuffers(2, framebuffers);
+		m_uStaticFramebuffer = 0;
+		m_uFramebuffer = 0;
+	}
+	if (m_uStaticDepth)
+	{
+		glDeleteRenderbuffers(1, &m_uStaticDepth);
+		m_uStaticDepth = 0;
+	}
+	if (m_uTexture)
+	{
+		glDeleteTextures(1, &m_uTexture);
+		m_uTexture = 0;
+	}
+	if (m_uProgram)
+	{
+		glDeleteProgram(m_uProgram);
+		m_uProgram = 0;
+	}
+
+	m_StaticCasters.Clear();
+	m_DynamicCasters.Clear();
+}
+
+
+void ShadowMap::SetStaticCasters(const Node& root)
+{
+	m_StaticCasters.Clear();
+	CollectCasters(root, m_StaticCasters);
+
+	for (auto& cascade : m_arrCascades)
+	{
+		cascade.valid = false;
+	}
+}
+
+
+void ShadowMap::Update(const IRenderer& renderer, const glm::vec3& lightDirection)
+{
+	PROFILE_SCOPE("ShadowMap::Update");
+
+	m_vLightDirection = glm::normalize(lightDirection);
+
+	const glm::mat4& projection = renderer.GetProjectionMatrix();
+	const glm::vec2 depthRange(Frustum::GetDepthRange(projection));
+	const float nearPlane = depthRange.x;
+	const float farPlane = depthRange.y;
+	const float distance = std::min(m_Settings.distance, farPlane);
+
+	const glm::mat4 inverseView(glm::inverse(renderer.GetViewMatrix()));
+	const glm::vec3 forward(-glm::vec3(inverseView[2]));
+	m_vDepthPlane = glm::vec4(forward, -glm::dot(forward, glm::vec3(inverseView[3])));
+
+	float splitNear = nearPlane;
+	for (uint32_t i = 0; i < m_Settings.cascades; ++i)
+	{
+		const float t = (float)(i + 1) / m_Settings.cascades;
+		const float splitFar = glm::mix(
+			nearPlane + (distance - nearPlane) * t,
+			nearPlane * std::pow(distance / nearPlane, t),
+			m_Settings.splitLambda);
+
+		CASCADE& cascade = m_arrCascades[i];
+		cascade.splitFar = splitFar;
+
+		// bounding sphere of the slice, its size does not change when the camera turns
+		const glm::mat4 inverseProjection(glm::inverse(projection));
+		glm::vec3 corners[8];
+		glm::vec3 center(0.0f);
+		for (uint32_t corner = 0; corner < 8; ++corner)
+		{
+			const glm::vec4 ndc(corner & 1 ? 1.0f : -1.0f, corner & 2 ? 1.0f : -1.0f, -1.0f, 1.0f);
+			const glm::vec4 point(inverseProjection * ndc);
+			const glm::vec3 ray(glm::vec3(point) / -point.z);
+			corners[corner] = glm::vec3(inverseView * glm::vec4(ray * (corner & 4 ? splitFar : splitNear), 1.0f));
+			center += corners[corner] / 8.0f;
+		}
+		cascade.center = center;
+		cascade.radius = 0.0f;
+		for (const auto& corner : corners)
+		{
+			cascade.radius = std::max(cascade.radius, glm::length(corner - center));
+		}
+		splitNear = splitFar;
+
+		FitCascade(cascade, renderer, i);
+	}
+}
+
+
+void ShadowMap::FitCascade(CASCADE& cascade, const IRenderer& renderer, uint32_t index) const
+{
+	const glm::vec3 up(std::abs(m_vLightDirection.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f));
+	const glm::mat3 lightRotation(glm::lookAt(glm::vec3(0.0f), m_vLightDirection, up));
+
+	// cached static depth is reused while the slice stays inside the bounds it was drawn for
+	const glm::vec3 offset(glm::abs(lightRotation * (cascade.center - cascade.cachedCenter)));
+	if (cascade.valid &&
+		glm::dot(m_vLightDirection, cascade.cachedLightDirection) >= std::cos(m_Settings.lightAngle) &&
+		std::max(std::max(offset.x, offset.y), offset.z) + cascade.radius <= cascade.cachedRadius)
+	{
+		return;
+	}
+
+	// new bounds with some room to move, center snapped to whole texels so that redraws do not shimmer
+	cascade.valid = false;
+	cascade.cachedRadius = cascade.radius * (1.0f + m_Settings.cacheMargin);
+	cascade.cachedLightDirection = m_vLightDirection;
+	const float texelSize = 2.0f * cascade.cachedRadius / m_Settings.resolution;
+	glm::vec3 lightCenter(lightRotation * cascade.center);
+	lightCenter.x = std::floor(lightCenter.x / texelSize) * texelSize;
+	lightCenter.y = std::floor(lightCenter.y / texelSize) * texelSize;
+	cascade.cachedCenter = glm::transpose(lightRotation) * lightCenter;
+
+	const float radius = cascade.cachedRadius;
+	const glm::vec3 eye(cascade.cachedCenter - m_vLightDirection * (radius + m_Settings.casterDistance));
+	cascade.viewProjection =
+		glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius + m_Settings.casterDistance) *
+		glm::lookAt(eye, cascade.cachedCenter, up);
+
+	// place the cascade in its quarter of the atlas
+	const glm::ivec4 viewport(GetViewport(index));
+	const glm::vec2 atlasSize(m_vAtlasSize);
+	glm::mat4 atlas(1.0f);
+	atlas[0][0] = viewport.z / atlasSize.x;
+	atlas[1][1] = viewport.w / atlasSize.y;
+	atlas[3][0] = viewport.x / atlasSize.x;
+	atlas[3][1] = viewport.y / atlasSize.y;
+	cascade.shadowMatrix = atlas * renderer.GetShadowBiasMatrix() * cascade.viewProjection;
+}
+
+
+glm::ivec4 ShadowMap::GetViewport(uint32_t cascade) const
+{
+	const int32_t resolution = (int32_t)m_Settings.resolution;
+	return glm::ivec4((cascade % 2) * resolution, (cascade / 2) * resolution, resolution, resolution);
+}
+
+
+void ShadowMap::Render(OpenGLRenderer& renderer, const Node* dynamicRoot)
+{
+	PROFILE_SCOPE("ShadowMap::Render");
+
+	m_Stats = {};
+	if (!m_uProgram)
+	{
+		return;
+	}
+
+	m_DynamicCasters.Clear();
+	if (dynamicRoot)
+	{
+		CollectCasters(*dynamicRoot, m_DynamicCasters);
+	}
+
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	// positions come from client memory
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glUseProgram(m_uProgram);
+	glEnableVertexAttribArray(m_iPositionAttrib);
+	glEnable(GL_SCISSOR_TEST);
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(2.0f, 4.0f);
+
+	// static casters only for the cascades that moved out of their cached bounds
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uStaticFramebuffer);
+	for (uint32_t i = 0; i < m_Settings.cascades; ++i)
+	{
+		CASCADE& cascade = m_arrCascades[i];
+		if (!cascade.valid)
+		{
+			const glm::ivec4 area(GetViewport(i));
+			glViewport(area.x, area.y, area.z, area.w);
+			glScissor(area.x, area.y, area.z, area.w);
+			glClear(GL_DEPTH_BUFFER_BIT);
+			DrawCasters(renderer, m_StaticCasters, i, m_Stats.staticDraws);
+			cascade.valid = true;
+			++m_Stats.staticCascades;
+		}
+	}
+	glDisable(GL_SCISSOR_TEST);
+
+	// start the frame from the cached depth and add the moving casters
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_uStaticFramebuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_uFramebuffer);
+	glBlitFramebuffer(0, 0, m_vAtlasSize.x, m_vAtlasSize.y, 0, 0, m_vAtlasSize.x, m_vAtlasSize.y, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uFramebuffer);
+	for (uint32_t i = 0; i < m_Settings.cascades && !m_DynamicCasters.IsEmpty(); ++i)
+	{
+		const glm::ivec4 area(GetViewport(i));
+		glViewport(area.x, area.y, area.z, area.w);
+		DrawCasters(renderer, m_DynamicCasters, i, m_Stats.dynamicDraws);
+	}
+
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glDisableVertexAttribArray(m_iPositionAttrib);
+	glBindFramebuffer(GL_FRAMEBUFFER, renderer.GetDefaultFramebuffer());
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+
+void ShadowMap::DrawCasters(IRenderer& renderer, const DrawQueue& casters, uint32_t cascade, uint32_t& drawCount) const
+{
+	const glm::mat4& viewProjection = m_arrCascades[cascade].viewProjection;
+	Frustum frustum;
+	frustum.Set(viewProjection);
+
+	for (const auto& draw : casters.GetDraws())
+	{
+		const Geometry& geometry = *draw.geometry;
+		const glm::mat4& world = draw.worldMatrix;
+		if (!frustum.IsBoundsVisible(geometry.GetBoundsMin(), geometry.GetBoundsMax(), world))
+		{
+			continue;
+		}
+
+		glVertexAttribPointer(m_iPositionAttrib, 3, GL_FLOAT, GL_FALSE, Geometry::VERTEX::GetStride(), geometry.GetData());
+		OpenGLRenderer::SetUniformMatrix4(m_uProgram, "modelViewProjectionMatrix", viewProjection * world);
+		geometry.Draw(renderer);
+		++drawCount;
+	}
+}
+
+
+void ShadowMap::Bind(IRenderer& renderer, GLuint program, int32_t slot) const
+{
+	renderer.SetTexture(program, m_uTexture, slot, "shadowMap");
+	glActiveTexture(GL_TEXTURE0);
+
+	// unused cascades repeat the last one, fragments past the last split are unshadowed
+	glm::mat4 matrices[MAX_CASCADES];
+	glm::vec4 splits;
+	for (uint32_t i = 0; i < MAX_CASCADES; ++i)
+	{
+		const CASCADE& cascade = m_arrCascades[std::min(i, m_Settings.cascades - 1)];
+		matrices[i] = cascade.shadowMatrix;
+		splits[i] = cascade.splitFar;
+	}
+
+	const GLint location = glGetUniformLocation(program, "shadowMatrices");
+	if (location != -1)
+	{
+		glUniformMatrix4fv(location, MAX_CASCADES, GL_FALSE, &matrices[0][0][0]);
+	}
+	OpenGLRenderer::SetUniformVec4(program, "shadowSplits", splits);
+	OpenGLRenderer::SetUniformVec4(program, "shadowDepthPlane", m_vDepthPlane);
+}
+
+
+void ShadowMap::CollectCasters(const Node& node, DrawQueue& casters)
+{
+	const GeometryNode* geometryNode = dynamic_cast<const GeometryNode*>(&node);
+	if (geometryNode && geometryNode->GetGeometry() && geometryNode->GetGeometry()->GetVertexCount())
+	{
+		casters.Add(geometryNode->GetGeometry(), geometryNode->GetMaterial().get(), geometryNode->GetWorldMatrix());
+	}
+
+	for (const auto& child : node.GetNodes())
+	{
+		CollectCasters(*child, casters);
+	}
+}
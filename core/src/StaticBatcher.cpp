@@ -0,0 +1,181 @@
+/**
+ * ============================================================================
+ *  Name        : StaticBatcher.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : merges static geometry nodes sharing a material into
+ *                pre-transformed batches with 32 bit indices
+ * ============================================================================
+**/
+
+#include "../include/StaticBatcher.h"
+#include "../include/GeometryNode.h"
+#include "../include/Material.h"
+#include <typeinfo>
+
+
+StaticBatcher::STATS StaticBatcher::Batch(Node& root, size_t maxVerticesPerBatch)
+{
+	STATS stats = { 0, 0, 0, 0 };
+	BatchChildren(root, maxVerticesPerBatch, stats);
+
+	IApplication::Debug("StaticBatcher: " +
+		std::to_string(stats.drawsBefore) +
+		" draws merged into " +
+		std::to_string(stats.drawsAfter) +
+		" batches, " +
+		std::to_string(stats.vertexCount) +
+		" vertices, " +
+		std::to_string(stats.indexCount) +
+		" indices\n");
+	return stats;
+}
+
+
+bool StaticBatcher::IsStatic(const Node& node)
+{
+	// derived node types have their own behaviour, keep them as they are
+	if (typeid(node) != typeid(Node) && typeid(node) != typeid(GeometryNode))
+	{
+		return false;
+	}
+
+	if (node.GetVelocity() != glm::vec3(0.0f) || node.GetRotationSpeed() != 0.0f)
+	{
+		return false;
+	}
+
+	for (const auto& child : node.GetNodes())
+	{
+		if (!IsStatic(*child))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+
+void StaticBatcher::BatchChildren(Node& root, size_t maxVerticesPerBatch, STATS& stats)
+{
+	BATCHMAP batches;
+	std::vector<std::shared_ptr<Node>> kept;
+	for (auto& child : root.GetNodes())
+	{
+		if (IsStatic(*child))
+		{
+			// vertices end up in the space of the root
+			Collect(*child, child->GetMatrix(), maxVerticesPerBatch, batches, stats);
+		}
+		else
+		{
+			BatchChildren(*child, maxVerticesPerBatch, stats);
+			kept.push_back(child);
+		}
+	}
+
+	if (batches.empty())
+	{
+		return;
+	}
+
+	root.GetNodes().clear();
+	for (auto& child : kept)
+	{
+		root.AddNode(child);
+	}
+
+	for (auto& it : batches)
+	{
+		for (auto& batch : it.second)
+		{
+			stats.vertexCount += batch.vertices.size();
+			stats.indexCount += batch.indices.size();
+
+			auto geometry = std::make_shared<Geometry>();
+			geometry->SetData(std::move(batch.vertices), std::move(batch.indices), GL_TRIANGLES);
+
+			auto node = std::make_shared<GeometryNode>(geometry, it.first);
+			node->SetName("batch");
+			node->SetRadius(glm::length(geometry->GetBoundsMax() - geometry->GetBoundsMin()) * 0.5f);
+			root.AddNode(node);
+			++stats.drawsAfter;
+		}
+	}
+}
+
+
+void StaticBatcher::Collect(Node& node, const glm::mat4& matrix, size_t maxVerticesPerBatch, BATCHMAP& batches, STATS& stats)
+{
+	if (typeid(node) == typeid(GeometryNode))
+	{
+		const auto& geometryNode = static_cast<const GeometryNode&>(node);
+		const auto& geometry = geometryNode.GetGeometry();
+		if (geometry && geometry->GetVertexCount())
+		{
+			auto& list = batches[geometryNode.GetMaterial()];
+			if (list.empty() || list.back().vertices.size() + geometry->GetVertexCount() > maxVerticesPerBatch)
+			{
+				list.emplace_back();
+			}
+			Append(list.back(), *geometry, matrix);
+			++stats.drawsBefore;
+		}
+	}
+
+	for (auto& child : node.GetNodes())
+	{
+		Collect(*child, matrix * child->GetMatrix(), maxVerticesPerBatch, batches, stats);
+	}
+}
+
+
+void StaticBatcher::Append(BATCH& batch, const Geometry& geometry, const glm::mat4& matrix)
+{
+	const uint32_t base = (uint32_t)batch.vertices.size();
+
+	// normals are transformed like in the vertex shader
+	const glm::mat3 normalMatrix(matrix);
+	const Geometry::VERTEX* vertices = geometry.GetData();
+	for (size_t i = 0; i < geometry.GetVertexCount(); ++i)
+	{
+		const auto& v = vertices[i];
+		const glm::vec3 pos(matrix * glm::vec4(v.x, v.y, v.z, 1.0f));
+		const glm::vec3 normal(normalMatrix * glm::vec3(v.nx, v.ny, v.nz));
+		batch.vertices.emplace_back(pos, normal, v.tu, v.tv);
+	}
+
+	// non-indexed geometry uses sequential indices
+	const uint32_t* indices = geometry.GetIndices();
+	const uint32_t count = (uint32_t)(geometry.GetIndexCount() ? geometry.GetIndexCount() : geometry.GetVertexCount());
+	auto index = [&](uint32_t i) { return base + (geometry.GetIndexCount() ? indices[i] : i); };
+
+	if (geometry.GetDrawMode() == GL_TRIANGLE_STRIP)
+	{
+		// strips are converted into lists, every other triangle flips winding
+		for (uint32_t i = 2; i < count; ++i)
+		{
+			const uint32_t a = index(i - 2);
+			const uint32_t b = index(i - 1);
+			const uint32_t c = index(i);
+			if (a == b || b == c || a == c)
+			{
+				continue;
+			}
+			if (i & 1)
+			{
+				batch.indices.insert(batch.indices.end(), { b, a, c });
+			}
+			else
+			{
+				batch.indices.insert(batch.indices.end(), { a, b, c });
+			}
+		}
+	}
+	else
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			batch.indices.push_back(index(i));
+		}
+	}
+}
@@ -0,0 +1,181 @@
+/**
+ * ============================================================================
+ *  Name        : StreamBuffer.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : ring buffer allocator for dynamic per frame data. Uses a
+ *                persistently mapped buffer fenced per frame, falls back to
+ *                glBufferSubData uploads on drivers without buffer storage.
+ * ============================================================================
+**/
+
+#include "../include/StreamBuffer.h"
+#include <algorithm>
+
+
+StreamBuffer::StreamBuffer() :
+	m_Buffer(0),
+	m_pMapped(nullptr),
+	m_uRegionSize(0),
+	m_uFramesInFlight(0),
+	m_uRegion(0),
+	m_uHead(0),
+	m_Stats({})
+{
+}
+
+
+StreamBuffer::~StreamBuffer()
+{
+	Release();
+}
+
+
+bool StreamBuffer::IsPersistentMappingSupported()
+{
+	return glBufferStorage &&
+		glMapBufferRange &&
+		glFenceSync &&
+		(OpenGLRenderer::GetVersion() >= 44 || OpenGLRenderer::HasExtension("GL_ARB_buffer_storage"));
+}
+
+
+bool StreamBuffer::Create(size_t size, uint32_t framesInFlight)
+{
+	Release();
+
+	if (!framesInFlight || size < framesInFlight * 256)
+	{
+		return false;
+	}
+
+	m_uFramesInFlight = framesInFlight;
+	// keep region start offsets aligned for any buffer binding
+	m_uRegionSize = size / framesInFlight / 256 * 256;
+	m_arrFences.resize(framesInFlight, nullptr);
+
+	glGenBuffers(1, &m_Buffer);
+	glBindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+
+	if (IsPersistentMappingSupported())
+	{
+		// cpu writes go directly to the buffer, fences keep us from overwriting data gpu still reads
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_COPY_WRITE_BUFFER, m_uRegionSize * framesInFlight, nullptr, flags);
+		m_pMapped = (uint8_t*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, m_uRegionSize * framesInFlight, flags);
+	}
+
+	if (!m_pMapped)
+	{
+		// write into cpu shadow memory and upload on Flush
+		glBufferData(GL_COPY_WRITE_BUFFER, m_uRegionSize * framesInFlight, nullptr, GL_STREAM_DRAW);
+		m_arrShadow.resize(m_uRegionSize * framesInFlight);
+		IApplication::Debug("StreamBuffer: persistent mapping not supported, using buffer uploads\n");
+	}
+
+	glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	return true;
+}
+
+
+void StreamBuffer::Release()
+{
+	for (auto& fence : m_arrFences)
+	{
+		if (fence)
+		{
+			glDeleteSync(fence);
+		}
+	}
+	m_arrFences.clear();
+
+	if (m_Buffer)
+	{
+		if (m_pMapped)
+		{
+			glBindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+			glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+			glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+			m_pMapped = nullptr;
+		}
+		glDeleteBuffers(1, &m_Buffer);
+		m_Buffer = 0;
+	}
+	m_arrShadow.clear();
+
+	m_uRegionSize = 0;
+	m_uFramesInFlight = 0;
+	m_uRegion = 0;
+	m_uHead = 0;
+}
+
+
+StreamBuffer::ALLOCATION StreamBuffer::Allocate(size_t bytes, size_t alignment)
+{
+	ALLOCATION allocation = { nullptr, 0, 0 };
+
+	const size_t head = (m_uHead + alignment - 1) / alignment * alignment;
+	if (!m_Buffer || head + bytes > m_uRegionSize)
+	{
+		++m_Stats.failedAllocations;
+		return allocation;
+	}
+
+	allocation.offset = (GLintptr)(m_uRegion * m_uRegionSize + head);
+	allocation.size = (GLsizeiptr)bytes;
+	allocation.data = (m_pMapped ? m_pMapped : m_arrShadow.data()) + allocation.offset;
+	m_uHead = head + bytes;
+	return allocation;
+}
+
+
+void StreamBuffer::Flush(const ALLOCATION& allocation)
+{
+	if (!m_pMapped && allocation.data)
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, m_Buffer);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.offset, allocation.size, allocation.data);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+}
+
+
+void StreamBuffer::BeginFrame()
+{
+	if (!m_Buffer)
+	{
+		return;
+	}
+
+	m_Stats.bytesLastFrame = m_uHead;
+	m_Stats.peakBytesPerFrame = std::max(m_Stats.peakBytesPerFrame, m_uHead);
+	m_Stats.fenceWaitLastFrame = 0.0f;
+
+	m_uRegion = (m_uRegion + 1) % m_uFramesInFlight;
+	m_uHead = 0;
+
+	GLsync& fence = m_arrFences[m_uRegion];
+	if (fence)
+	{
+		// wait until gpu has consumed the region we are about to overwrite
+		const uint64_t start = Timer::GetTicks();
+		GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+		while (result == GL_TIMEOUT_EXPIRED)
+		{
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+		}
+		glDeleteSync(fence);
+		fence = nullptr;
+
+		m_Stats.fenceWaitLastFrame = (float)((double)(Timer::GetTicks() - start) * Timer::GetSecondsPerTick());
+		m_Stats.fenceWaitTotal += m_Stats.fenceWaitLastFrame;
+	}
+}
+
+
+void StreamBuffer::EndFrame()
+{
+	if (m_pMapped)
+	{
+		m_arrFences[m_uRegion] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+}
@@ -0,0 +1,402 @@
+/**
+ * ============================================================================
+ *  Name        : TemporalUpscaler.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : temporal reconstruction of the dynamic resolution frame
+ * ============================================================================
+**/
+
+#include "../include/TemporalUpscaler.h"
+#include "../include/Geometry.h"
+#include <algorithm>
+
+
+// motion in uv units from the previous to the current frame, rasterized with the jittered matrix
+static const char* s_pMotionVertexShader =
+	"attribute vec3 position;\n"
+	"uniform mat4 modelViewProjectionMatrix;\n"
+	"uniform mat4 currentMatrix;\n"
+	"uniform mat4 previousMatrix;\n"
+	"varying vec4 currentPosition;\n"
+	"varying vec4 previousPosition;\n"
+	"void main(void)\n"
+	"{\n"
+	"	currentPosition = currentMatrix * vec4(position, 1.0);\n"
+	"	previousPosition = previousMatrix * vec4(position, 1.0);\n"
+	"	gl_Position = modelViewProjectionMatrix * vec4(position, 1.0);\n"
+	"}\n";
+
+static const char* s_pMotionFragmentShader =
+	"varying vec4 currentPosition;\n"
+	"varying vec4 previousPosition;\n"
+	"void main(void)\n"
+	"{\n"
+	"	vec2 motion = (currentPosition.xy / currentPosition.w - previousPosition.xy / previousPosition.w) * 0.5;\n"
+	"	gl_FragColor = vec4(motion, 0.0, 0.0);\n"
+	"}\n";
+
+static const char* s_pResolveVertexShader =
+	"attribute vec2 position;\n"
+	"varying vec2 outUv;\n"
+	"void main(void)\n"
+	"{\n"
+	"	outUv = position * 0.5 + 0.5;\n"
+	"	gl_Position = vec4(position, 0.0, 1.0);\n"
+	"}\n";
+
+// outUv is the output pixel, the scene is sampled where the jittered frame rendered that point
+static const char* s_pResolveFragmentShader =
+	"uniform sampler2D scene;\n"
+	"uniform sampler2D motion;\n"
+	"uniform sampler2D history;\n"
+	"uniform vec2 renderScale;\n"
+	"uniform vec2 sceneTexel;\n"
+	"uniform vec2 sceneMax;\n"
+	"uniform vec2 jitter;\n"
+	"uniform mat4 reprojection;\n"
+	"uniform float feedback;\n"
+	"varying vec2 outUv;\n"
+	"void main(void)\n"
+	"{\n"
+	"	vec2 sceneUv = min(outUv * renderScale + jitter, sceneMax);\n"
+	"	vec3 current = texture2D(scene, sceneUv).rgb;\n"
+	"	vec3 neighbourMin = current;\n"
+	"	vec3 neighbourMax = current;\n"
+	"	for (int y = -1; y <= 1; ++y)\n"
+	"	{\n"
+	"		for (int x = -1; x <= 1; ++x)\n"
+	"		{\n"
+	"			vec3 neighbour = texture2D(scene, min(sceneUv + vec2(float(x), float(y)) * sceneTexel, sceneMax)).rgb;\n"
+	"			neighbourMin = min(neighbourMin, neighbour);\n"
+	"			neighbourMax = max(neighbourMax, neighbour);\n"
+	"		}\n"
+	"	}\n"
+	"	vec2 velocity = texture2D(motion, sceneUv).rg;\n"
+	"	if (velocity.x > 1000.0)\n"
+	"	{\n"
+	"		vec4 previous = reprojection * vec4(outUv * 2.0 - 1.0, 1.0, 1.0);\n"
+	"		velocity = outUv - (previous.xy / previous.w * 0.5 + 0.5);\n"
+	"	}\n"
+	"	vec2 historyUv = outUv - velocity;\n"
+	"	float weight = feedback;\n"
+	"	if (historyUv.x < 0.0 || historyUv.y < 0.0 || historyUv.x > 1.0 || historyUv.y > 1.0)\n"
+	"	{\n"
+	"		weight = 0.0;\n"
+	"	}\n"
+	"	vec3 previousColor = clamp(texture2D(history, historyUv).rgb, neighbourMin, neighbourMax);\n"
+	"	gl_FragColor = vec4(mix(current, previousColor, weight), 1.0);\n"
+	"}\n";
+
+// cleared motion, marks the pixels no draw covered
+static constexpr float MOTION_NONE = 65504.0f;
+
+
+TemporalUpscaler::TemporalUpscaler() :
+	m_uMotionProgram(0),
+	m_uResolveProgram(0),
+	m_uDepthBuffer(0),
+	m_vTargetSize(0),
+	m_vRenderSize(0),
+	m_vWindowSize(0),
+	m_uMotionFramebuffer(0),
+	m_uMotion(0),
+	m_arrHistoryFramebuffers{ 0, 0 },
+	m_arrHistory{ 0, 0 },
+	m_uHistoryIndex(0),
+	m_bHistoryValid(false),
+	m_bMotionValid(false),
+	m_fFeedback(0.9f),
+	m_uJitterIndex(0),
+	m_vJitter(0.0f),
+	m_mViewProjection(1.0f),
+	m_mPreviousViewProjection(1.0f)
+{
+}
+
+
+TemporalUpscaler::~TemporalUpscaler()
+{
+	Release();
+}
+
+
+bool TemporalUpscaler::IsSupported()
+{
+	return glGenFramebuffers && OpenGLRenderer::GetVersion() >= 30;
+}
+
+
+bool TemporalUpscaler::Create(OpenGLRenderer& renderer)
+{
+	Release();
+	if (!IsSupported())
+	{
+		IApplication::Debug("TemporalUpscaler: float render targets not supported\n");
+		return false;
+	}
+
+	m_uMotionProgram = renderer.CreateProgramFromSource(s_pMotionVertexShader, s_pMotionFragmentShader);
+	m_uResolveProgram = renderer.CreateProgramFromSource(s_pResolveVertexShader, s_pResolveFragmentShader);
+	if (!m_uMotionProgram || !m_uResolveProgram)
+	{
+		Release();
+		return false;
+	}
+	return true;
+}
+
+
+void TemporalUpscaler::Release()
+{
+	ReleaseTargets();
+	if (m_uMotionProgram)
+	{
+		glDeleteProgram(m_uMotionProgram);
+		m_uMotionProgram = 0;
+	}
+	if (m_uResolveProgram)
+	{
+		glDeleteProgram(m_uResolveProgram);
+		m_uResolveProgram = 0;
+	}
+	m_uDepthBuffer = 0;
+	m_vTargetSize = glm::ivec2(0);
+	m_vWindowSize = glm::ivec2(0);
+}
+
+
+bool TemporalUpscaler::CreateTargets()
+{
+	ReleaseTargets();
+
+	glGenTextures(1, &m_uMotion);
+	glBindTexture(GL_TEXTURE_2D, m_uMotion);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, m_vTargetSize.x, m_vTargetSize.y, 0, GL_RG, GL_HALF_FLOAT, nullptr);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+	glGenTextures(2, m_arrHistory);
+	for (GLuint history : m_arrHistory)
+	{
+		glBindTexture(GL_TEXTURE_2D, history);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_vWindowSize.x, m_vWindowSize.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// motion vectors are depth tested against the scene, the depth buffer is shared
+	bool complete = true;
+	glGenFramebuffers(1, &m_uMotionFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uMotionFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_uMotion, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, m_uDepthBuffer);
+	complete &= glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+	glGenFramebuffers(2, m_arrHistoryFramebuffers);
+	for (uint32_t i = 0; i < 2; ++i)
+	{
+		glBindFramebuffer(GL_FRAMEBUFFER, m_arrHistoryFramebuffers[i]);
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_arrHistory[i], 0);
+		complete &= glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	}
+
+	if (!complete)
+	{
+		IApplication::Debug("TemporalUpscaler: framebuffer is incomplete\n");
+		ReleaseTargets();
+		return false;
+	}
+	return true;
+}
+
+
+void TemporalUpscaler::ReleaseTargets()
+{
+	if (m_uMotionFramebuffer)
+	{
+		glDeleteFramebuffers(1, &m_uMotionFramebuffer);
+		glDeleteFramebuffers(2, m_arrHistoryFramebuffers);
+		m_uMotionFramebuffer = 0;
+		m_arrHistoryFramebuffers[0] = 0;
+		m_arrHistoryFramebuffers[1] = 0;
+	}
+	if (m_uMotion)
+	{
+		glDeleteTextures(1, &m_uMotion);
+		glDeleteTextures(2, m_arrHistory);
+		m_uMotion = 0;
+		m_arrHistory[0] = 0;
+		m_arrHistory[1] = 0;
+	}
+	m_bHistoryValid = false;
+}
+
+
+void TemporalUpscaler::BeginFrame(GLuint depthBuffer, const glm::ivec2& targetSize, const glm::ivec2& renderSize, const glm::ivec2& windowSize)
+{
+	// history is kept at window resolution, render size changes do not invalidate it
+	if (depthBuffer != m_uDepthBuffer || targetSize != m_vTargetSize || windowSize != m_vWindowSize)
+	{
+		m_uDepthBuffer = depthBuffer;
+		m_vTargetSize = targetSize;
+		m_vWindowSize = windowSize;
+		if (m_uDepthBuffer)
+		{
+			CreateTargets();
+		}
+		else
+		{
+			ReleaseTargets();
+		}
+	}
+	m_vRenderSize = renderSize;
+	m_bMotionValid = false;
+
+	// Halton (2, 3), more phases when each render pixel covers more output pixels
+	const float pixelRatio = (float)(windowSize.x * windowSize.y) / (float)std::max(renderSize.x * renderSize.y, 1);
+	const uint32_t phases = glm::clamp((uint32_t)(8.0f * pixelRatio + 0.5f), 8u, 64u);
+	m_uJitterIndex = m_uJitterIndex % phases + 1;
+	m_vJitter = glm::vec2(Halton(m_uJitterIndex, 2), Halton(m_uJitterIndex, 3)) - 0.5f;
+}
+
+
+void TemporalUpscaler::RenderMotionVectors(IRenderer& renderer, const DrawQueue& queue, const glm::mat4& projectionMatrix)
+{
+	PROFILE_SCOPE("TemporalUpscaler::RenderMotionVectors");
+
+	m_mViewProjection = projectionMatrix * renderer.GetViewMatrix();
+	if (!m_uMotionFramebuffer)
+	{
+		return;
+	}
+
+	// with MSAA the scene depth is in the multisampled target, resolve it into the shared depth buffer
+	const GLuint sceneFramebuffer = static_cast<OpenGLRenderer&>(renderer).GetDefaultFramebuffer();
+	GLint sampleBuffers = 0;
+	glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+	glGetIntegerv(GL_SAMPLE_BUFFERS, &sampleBuffers);
+	if (sampleBuffers)
+	{
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFramebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, m_uMotionFramebuffer);
+		glBlitFramebuffer(0, 0, m_vRenderSize.x, m_vRenderSize.y, 0, 0, m_vRenderSize.x, m_vRenderSize.y, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_uMotionFramebuffer);
+	glViewport(0, 0, m_vRenderSize.x, m_vRenderSize.y);
+	glClearColor(MOTION_NONE, MOTION_NONE, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+
+	if (!queue.IsEmpty())
+	{
+		// same surfaces as the scene, the offset keeps them from failing on rounding differences
+		glDepthFunc(GL_LEQUAL);
+		glDepthMask(GL_FALSE);
+		glEnable(GL_POLYGON_OFFSET_FILL);
+		glPolygonOffset(-1.0f, -1.0f);
+
+		const GLuint program = m_uMotionProgram;
+		glUseProgram(program);
+		const GLint position = glGetAttribLocation(program, "position");
+		const GLint modelViewProjectionLocation = glGetUniformLocation(program, "modelViewProjectionMatrix");
+		const GLint currentLocation = glGetUniformLocation(program, "currentMatrix");
+		const GLint previousLocation = glGetUniformLocation(program, "previousMatrix");
+		const glm::mat4 viewProjection(renderer.GetProjectionMatrix() * renderer.GetViewMatrix());
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glEnableVertexAttribArray(position);
+		for (const auto& draw : queue.GetDraws())
+		{
+			const Geometry& geometry = *draw.geometry;
+			glVertexAttribPointer(position, 3, GL_FLOAT, GL_FALSE, Geometry::VERTEX::GetStride(), geometry.GetData());
+
+			const glm::mat4 modelViewProjection(viewProjection * draw.worldMatrix);
+			const glm::mat4 current(m_mViewProjection * draw.worldMatrix);
+			const glm::mat4 previous(m_mPreviousViewProjection * draw.previousWorldMatrix);
+			glUniformMatrix4fv(modelViewProjectionLocation, 1, GL_FALSE, &modelViewProjection[0][0]);
+			glUniformMatrix4fv(currentLocation, 1, GL_FALSE, &current[0][0]);
+			glUniformMatrix4fv(previousLocation, 1, GL_FALSE, &previous[0][0]);
+			geometry.Draw(renderer);
+		}
+		glDisableVertexAttribArray(position);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+		glDisable(GL_POLYGON_OFFSET_FILL);
+		glDepthMask(GL_TRUE);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, sceneFramebuffer);
+	glViewport(0, 0, m_vRenderSize.x, m_vRenderSize.y);
+	m_bMotionValid = true;
+}
+
+
+GLuint TemporalUpscaler::Resolve(OpenGLRenderer& renderer, GLuint sceneTexture)
+{
+	PROFILE_SCOPE("TemporalUpscaler::Resolve");
+
+	if (!m_uMotionFramebuffer)
+	{
+		return 0;
+	}
+
+	// without motion vectors of this frame the history can not be reprojected
+	const bool history = m_bHistoryValid && m_bMotionValid;
+	const uint32_t current = m_uHistoryIndex;
+	const uint32_t previous = current ^ 1;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_arrHistoryFramebuffers[current]);
+	glViewport(0, 0, m_vWindowSize.x, m_vWindowSize.y);
+	glDisable(GL_DEPTH_TEST);
+	glDisable(GL_CULL_FACE);
+
+	const GLuint program = m_uResolveProgram;
+	glUseProgram(program);
+	renderer.SetTexture(program, sceneTexture, 0, "scene");
+	renderer.SetTexture(program, m_uMotion, 1, "motion");
+	renderer.SetTexture(program, m_arrHistory[previous], 2, "history");
+	glActiveTexture(GL_TEXTURE0);
+
+	const glm::vec2 targetSize(m_vTargetSize);
+	OpenGLRenderer::SetUniformVec2(program, "renderScale", glm::vec2(m_vRenderSize) / targetSize);
+	OpenGLRenderer::SetUniformVec2(program, "sceneTexel", 1.0f / targetSize);
+	OpenGLRenderer::SetUniformVec2(program, "sceneMax", (glm::vec2(m_vRenderSize) - 0.5f) / targetSize);
+	OpenGLRenderer::SetUniformVec2(program, "jitter", m_vJitter / targetSize);
+	OpenGLRenderer::SetUniformMatrix4(program, "reprojection", m_mPreviousViewProjection * glm::inverse(m_mViewProjection));
+	OpenGLRenderer::SetUniformFloat(program, "feedback", history ? m_fFeedback : 0.0f);
+
+	static const float triangle[6] = { -1.0f, -1.0f, 3.0f, -1.0f, -1.0f, 3.0f };
+	const GLint position = glGetAttribLocation(program, "position");
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glEnableVertexAttribArray(position);
+	glVertexAttribPointer(position, 2, GL_FLOAT, GL_FALSE, 0, triangle);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glDisableVertexAttribArray(position);
+
+	glEnable(GL_CULL_FACE);
+	glEnable(GL_DEPTH_TEST);
+
+	m_mPreviousViewProjection = m_mViewProjection;
+	m_bHistoryValid = m_bMotionValid;
+	m_uHistoryIndex = previous;
+	return m_arrHistory[current];
+}
+
+
+float TemporalUpscaler::Halton(uint32_t index, uint32_t base)
+{
+	float result = 0.0f;
+	float fraction = 1.0f / (float)base;
+	while (index)
+	{
+		result += (float)(index % base) * fraction;
+		index /= base;
+		fraction /= (float)base;
+	}
+	return result;
+}
@@ -0,0 +1,281 @@
+/**
+ * ============================================================================
+ *  Name        : TextureCompressor.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : cpu BC1 (DXT1) and BC3 (DXT5) block compression encoder,
+ *                SSE2 accelerated where available. Colors are fitted to the
+ *                inset bounding box of the block, which is fast and good
+ *                enough for load time compression.
+ * ============================================================================
+**/
+
+#include "../include/TextureCompressor.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTURECOMPRESSOR_SSE2
+#include <emmintrin.h>
+#endif
+
+
+namespace
+{
+	inline uint16_t ToRGB565(const uint8_t* color)
+	{
+		return (uint16_t)(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+	}
+
+	inline void FromRGB565(uint16_t color, uint8_t* dst)
+	{
+		const uint8_t r = (uint8_t)((color >> 11) & 31);
+		const uint8_t g = (uint8_t)((color >> 5) & 63);
+		const uint8_t b = (uint8_t)(color & 31);
+		dst[0] = (uint8_t)((r << 3) | (r >> 2));
+		dst[1] = (uint8_t)((g << 2) | (g >> 4));
+		dst[2] = (uint8_t)((b << 3) | (b >> 2));
+		dst[3] = 0;
+	}
+}
+
+
+bool TextureCompressor::IsSupportedFormat(GLenum format)
+{
+	return format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT || format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+}
+
+
+size_t TextureCompressor::GetBlockSize(GLenum format)
+{
+	return format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT ? 8 : 16;
+}
+
+
+size_t TextureCompressor::GetCompressedSize(int32_t width, int32_t height, GLenum format)
+{
+	const size_t blocksX = (size_t)std::max((width + 3) / 4, 1);
+	const size_t blocksY = (size_t)std::max((height + 3) / 4, 1);
+	return blocksX * blocksY * GetBlockSize(format);
+}
+
+
+bool TextureCompressor::Compress(const uint8_t* rgba, int32_t width, int32_t height, GLenum format, std::vector<uint8_t>& dst)
+{
+	if (!rgba || width <= 0 || height <= 0 || !IsSupportedFormat(format))
+	{
+		return false;
+	}
+
+	const size_t blockSize = GetBlockSize(format);
+	dst.resize(GetCompressedSize(width, height, format));
+	uint8_t* out = dst.data();
+
+	uint8_t block[64];
+	for (int32_t by = 0; by < height; by += 4)
+	{
+		for (int32_t bx = 0; bx < width; bx += 4)
+		{
+			// gather the block, clamping at the image edges
+			for (int32_t y = 0; y < 4; ++y)
+			{
+				const uint8_t* row = rgba + (size_t)std::min(by + y, height - 1) * width * 4;
+				for (int32_t x = 0; x < 4; ++x)
+				{
+					memcpy(block + (y * 4 + x) * 4, row + std::min(bx + x, width - 1) * 4, 4);
+				}
+			}
+
+			if (format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT)
+			{
+				EncodeBC1Block(block, out);
+			}
+			else
+			{
+				EncodeBC3Block(block, out);
+			}
+			out += blockSize;
+		}
+	}
+	return true;
+}
+
+
+void TextureCompressor::EncodeBC1Block(const uint8_t* block, uint8_t* dst)
+{
+	EncodeColorBlock(block, dst);
+}
+
+
+void TextureCompressor::EncodeBC3Block(const uint8_t* block, uint8_t* dst)
+{
+	EncodeAlphaBlock(block, dst);
+	EncodeColorBlock(block, dst + 8);
+}
+
+
+void TextureCompressor::EncodeColorBlock(const uint8_t* block, uint8_t* dst)
+{
+	// bounding box of the block colors
+	uint8_t minColor[4];
+	uint8_t maxColor[4];
+#if defined (TEXTURECOMPRESSOR_SSE2)
+	const __m128i* rows = (const __m128i*)block;
+	__m128i vmin = _mm_min_epu8(_mm_min_epu8(_mm_loadu_si128(rows), _mm_loadu_si128(rows + 1)),
+		_mm_min_epu8(_mm_loadu_si128(rows + 2), _mm_loadu_si128(rows + 3)));
+	__m128i vmax = _mm_max_epu8(_mm_max_epu8(_mm_loadu_si128(rows), _mm_loadu_si128(rows + 1)),
+		_mm_max_epu8(_mm_loadu_si128(rows + 2), _mm_loadu_si128(rows + 3)));
+	vmin = _mm_min_epu8(vmin, _mm_srli_si128(vmin, 8));
+	vmin = _mm_min_epu8(vmin, _mm_srli_si128(vmin, 4));
+	vmax = _mm_max_epu8(vmax, _mm_srli_si128(vmax, 8));
+	vmax = _mm_max_epu8(vmax, _mm_srli_si128(vmax, 4));
+	const uint32_t packedMin = (uint32_t)_mm_cvtsi128_si32(vmin);
+	const uint32_t packedMax = (uint32_t)_mm_cvtsi128_si32(vmax);
+	memcpy(minColor, &packedMin, 4);
+	memcpy(maxColor, &packedMax, 4);
+#else
+	memcpy(minColor, block, 4);
+	memcpy(maxColor, block, 4);
+	for (int32_t i = 1; i < 16; ++i)
+	{
+		for (int32_t c = 0; c < 3; ++c)
+		{
+			minColor[c] = std::min(minColor[c], block[i * 4 + c]);
+			maxColor[c] = std::max(maxColor[c], block[i * 4 + c]);
+		}
+	}
+#endif
+
+	// inset the box by 1/16 to reduce the error of the interpolated colors
+	for (int32_t c = 0; c < 3; ++c)
+	{
+		const uint8_t inset = (uint8_t)((maxColor[c] - minColor[c]) >> 4);
+		minColor[c] = (uint8_t)(minColor[c] + inset);
+		maxColor[c] = (uint8_t)(maxColor[c] - inset);
+	}
+
+	// max >= min on every channel, so color0 >= color1 and four color mode is used
+	const uint16_t color0 = ToRGB565(maxColor);
+	const uint16_t color1 = ToRGB565(minColor);
+	dst[0] = (uint8_t)(color0 & 0xff);
+	dst[1] = (uint8_t)(color0 >> 8);
+	dst[2] = (uint8_t)(color1 & 0xff);
+	dst[3] = (uint8_t)(color1 >> 8);
+
+	uint32_t indices = 0;
+	if (color0 != color1)
+	{
+		uint8_t palette[4][4];
+		FromRGB565(color0, palette[0]);
+		FromRGB565(color1, palette[1]);
+		for (int32_t c = 0; c < 3; ++c)
+		{
+			palette[2][c] = (uint8_t)((2 * palette[0][c] + palette[1][c]) / 3);
+			palette[3][c] = (uint8_t)((palette[0][c] + 2 * palette[1][c]) / 3);
+		}
+		palette[2][3] = 0;
+		palette[3][3] = 0;
+
+#if defined (TEXTURECOMPRESSOR_SSE2)
+		// squared distance of four pixels to each palette color, alpha masked out
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i rgbMask = _mm_set1_epi32(0x00ffffff);
+		__m128i paletteColors[4];
+		for (int32_t k = 0; k < 4; ++k)
+		{
+			uint32_t packed;
+			memcpy(&packed, palette[k], 4);
+			paletteColors[k] = _mm_unpacklo_epi8(_mm_set1_epi32((int)packed), zero);
+		}
+
+		for (int32_t row = 0; row < 4; ++row)
+		{
+			const __m128i pixels = _mm_and_si128(_mm_loadu_si128(rows + row), rgbMask);
+			const __m128i lo = _mm_unpacklo_epi8(pixels, zero);
+			const __m128i hi = _mm_unpackhi_epi8(pixels, zero);
+
+			__m128i bestDistance = _mm_set1_epi32(0x7fffffff);
+			__m128i bestIndex = zero;
+			for (int32_t k = 0; k < 4; ++k)
+			{
+				const __m128i dlo = _mm_sub_epi16(lo, paletteColors[k]);
+				const __m128i dhi = _mm_sub_epi16(hi, paletteColors[k]);
+				__m128i slo = _mm_madd_epi16(dlo, dlo);
+				__m128i shi = _mm_madd_epi16(dhi, dhi);
+				slo = _mm_add_epi32(slo, _mm_srli_epi64(slo, 32));
+				shi = _mm_add_epi32(shi, _mm_srli_epi64(shi, 32));
+				const __m128i distance = _mm_castps_si128(_mm_shuffle_ps(_mm_castsi128_ps(slo), _mm_castsi128_ps(shi), _MM_SHUFFLE(2, 0, 2, 0)));
+
+				const __m128i closer = _mm_cmplt_epi32(distance, bestDistance);
+				bestDistance = _mm_or_si128(_mm_and_si128(closer, distance), _mm_andnot_si128(closer, bestDistance));
+				bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(k)), _mm_andnot_si128(closer, bestIndex));
+			}
+
+			uint32_t rowIndices[4];
+			_mm_storeu_si128((__m128i*)rowIndices, bestIndex);
+			for (int32_t x = 0; x < 4; ++x)
+			{
+				indices |= rowIndices[x] << ((row * 4 + x) * 2);
+			}
+		}
+#else
+		for (int32_t i = 0; i < 16; ++i)
+		{
+			const uint8_t* pixel = block + i * 4;
+			int32_t bestDistance = 0x7fffffff;
+			uint32_t bestIndex = 0;
+			for (uint32_t k = 0; k < 4; ++k)
+			{
+				const int32_t dr = pixel[0] - palette[k][0];
+				const int32_t dg = pixel[1] - palette[k][1];
+				const int32_t db = pixel[2] - palette[k][2];
+				const int32_t distance = dr * dr + dg * dg + db * db;
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = k;
+				}
+			}
+			indices |= bestIndex << (i * 2);
+		}
+#endif
+	}
+
+	dst[4] = (uint8_t)(indices & 0xff);
+	dst[5] = (uint8_t)((indices >> 8) & 0xff);
+	dst[6] = (uint8_t)((indices >> 16) & 0xff);
+	dst[7] = (uint8_t)(indices >> 24);
+}
+
+
+void TextureCompressor::EncodeAlphaBlock(const uint8_t* block, uint8_t* dst)
+{
+	uint8_t minAlpha = block[3];
+	uint8_t maxAlpha = block[3];
+	for (int32_t i = 1; i < 16; ++i)
+	{
+		minAlpha = std::min(minAlpha, block[i * 4 + 3]);
+		maxAlpha = std::max(maxAlpha, block[i * 4 + 3]);
+	}
+
+	// alpha0 > alpha1 selects the eight value ramp
+	dst[0] = maxAlpha;
+	dst[1] = minAlpha;
+
+	uint64_t indices = 0;
+	if (maxAlpha != minAlpha)
+	{
+		// position on the ramp from min (0) to max (7), remapped to the block index order
+		static constexpr uint64_t rampToIndex[8] = { 1, 7, 6, 5, 4, 3, 2, 0 };
+		const int32_t range = maxAlpha - minAlpha;
+		for (int32_t i = 0; i < 16; ++i)
+		{
+			const int32_t ramp = ((block[i * 4 + 3] - minAlpha) * 7 + range / 2) / range;
+			indices |= rampToIndex[ramp] << (i * 3);
+		}
+	}
+
+	for (int32_t i = 0; i < 6; ++i)
+	{
+		dst[2 + i] = (uint8_t)((indices >> (i * 8)) & 0xff);
+	}
+}
@@ -0,0 +1,307 @@
+/**
+ * ============================================================================
+ *  Name        : TextureStreamer.cpp
+ *  Part of     : Simple OpenGL graphics engine framework
+ *  Description : asynchronous texture loader. Worker threads decode images and
+ *                build mip chains, the GL thread uploads them coarse levels
+ *                first through a pool of pixel buffer objects, limited by a
+ *                per frame byte budget.
+ * ============================================================================
+**/
+
+#include "../include/TextureStreamer.h"
+#include "../include/stb_image.h"
+#include "../include/ImageKernels.h"
+#include <algorithm>
+#include <cstring>
+
+
+TextureStreamer::TextureStreamer() :
+	m_bQuit(false),
+	m_uNextPixelBuffer(0),
+	m_uUploadBudget(0),
+	m_Stats({ 0, 0, 0, 0, 0 })
+{
+}
+
+
+TextureStreamer::~TextureStreamer()
+{
+	Release();
+}
+
+
+bool TextureStreamer::Create(uint32_t workerCount, size_t uploadBudget, uint32_t pboCount)
+{
+	Release();
+
+	m_uUploadBudget = std::max(uploadBudget, (size_t)1);
+	m_Stats = { 0, 0, 0, 0, 0 };
+
+	// pixel buffers need map buffer range, otherwise upload straight from cpu memory
+	if (glMapBufferRange && glUnmapBuffer && pboCount)
+	{
+		m_arrPixelBuffers.resize(pboCount);
+		glGenBuffers((GLsizei)pboCount, m_arrPixelBuffers.data());
+	}
+
+	m_bQuit = false;
+	for (uint32_t i = 0; i < std::max(workerCount, 1u); ++i)
+	{
+		m_arrWorkers.emplace_back(&TextureStreamer::WorkerThread, this);
+	}
+	return true;
+}
+
+
+void TextureStreamer::Release()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_bQuit = true;
+	}
+	m_Condition.notify_all();
+	for (auto& worker : m_arrWorkers)
+	{
+		worker.join();
+	}
+	m_arrWorkers.clear();
+
+	m_arrDecodeQueue.clear();
+	m_arrUploadQueue.clear();
+	m_arrPending.clear();
+	m_pCurrentUpload = nullptr;
+
+	if (!m_arrPixelBuffers.empty())
+	{
+		glDeleteBuffers((GLsizei)m_arrPixelBuffers.size(), m_arrPixelBuffers.data());
+		m_arrPixelBuffers.clear();
+	}
+	m_uNextPixelBuffer = 0;
+}
+
+
+GLuint TextureStreamer::Load(const std::string_view& filename, const OpenGLRenderer::TEXTUREPARAMS& params)
+{
+	if (m_arrWorkers.empty())
+	{
+		return 0;
+	}
+
+	// placeholder until the first real level is uploaded
+	static constexpr uint8_t placeholder[4] = { 128, 128, 128, 255 };
+	GLuint textureHandle = 0;
+	glGenTextures(1, &textureHandle);
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, textureHandle);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+	OpenGLRenderer::SetTextureParams(params, 0);
+
+	auto job = std::make_shared<JOB>();
+	job->texture = textureHandle;
+	job->filename = filename;
+	job->params = params;
+	job->uploadLevel = -1;
+	job->uploadRow = 0;
+	job->failed = false;
+
+	m_arrPending.push_back(textureHandle);
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_arrDecodeQueue.push_back(job);
+	}
+	m_Condition.notify_one();
+
+	return textureHandle;
+}
+
+
+void TextureStreamer::Update()
+{
+	PROFILE_SCOPE("TextureStreamer::Update");
+
+	m_Stats.bytesUploadedLastFrame = 0;
+
+	size_t budget = m_uUploadBudget;
+	while (budget > 0)
+	{
+		if (!m_pCurrentUpload)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_arrUploadQueue.empty())
+			{
+				break;
+			}
+			m_pCurrentUpload = m_arrUploadQueue.front();
+			m_arrUploadQueue.pop_front();
+		}
+
+		JOB& job = *m_pCurrentUpload;
+		if (!job.failed)
+		{
+			const size_t bytes = UploadRows(job, budget);
+			budget -= std::min(bytes, budget);
+			m_Stats.bytesUploadedLastFrame += bytes;
+			m_Stats.bytesUploadedTotal += bytes;
+		}
+
+		if (job.failed || job.uploadLevel < 0)
+		{
+			(job.failed ? m_Stats.failedTextures : m_Stats.residentTextures)++;
+			m_arrPending.erase(std::remove(m_arrPending.begin(), m_arrPending.end(), job.texture), m_arrPending.end());
+			m_pCurrentUpload = nullptr;
+		}
+	}
+
+	m_Stats.pendingTextures = (uint32_t)m_arrPending.size();
+}
+
+
+bool TextureStreamer::IsResident(GLuint texture) const
+{
+	return texture && std::find(m_arrPending.begin(), m_arrPending.end(), texture) == m_arrPending.end();
+}
+
+
+bool TextureStreamer::IsIdle() const
+{
+	return m_arrPending.empty();
+}
+
+
+void TextureStreamer::WorkerThread()
+{
+	PROFILE_THREAD_NAME("TextureStreamer");
+
+	for (;;)
+	{
+		std::shared_ptr<JOB> job;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Condition.wait(lock, [this]() { return m_bQuit || !m_arrDecodeQueue.empty(); });
+			if (m_bQuit)
+			{
+				return;
+			}
+			job = m_arrDecodeQueue.front();
+			m_arrDecodeQueue.pop_front();
+		}
+
+		{
+			PROFILE_SCOPE("TextureStreamer::Decode");
+			Decode(*job);
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_arrUploadQueue.push_back(job);
+	}
+}
+
+
+void TextureStreamer::Decode(JOB& job)
+{
+	int32_t width = 0;
+	int32_t height = 0;
+	int32_t bpp = 0;
+	uint8_t* imgdata = stbi_load(job.filename.c_str(), &width, &height, &bpp, STBI_rgb_alpha);
+	if (!imgdata || !width || !height)
+	{
+		IApplication::Debug("TextureStreamer: failed to load image " + job.filename + "\n");
+		stbi_image_free(imgdata);
+		job.failed = true;
+		return;
+	}
+
+	ImageKernels::PremultiplyAlpha(imgdata, width, height);
+
+	job.levels.emplace_back();
+	job.levels.back().width = width;
+	job.levels.back().height = height;
+	job.levels.back().pixels.assign(imgdata, imgdata + (size_t)width * height * 4);
+	stbi_image_free(imgdata);
+
+	// cpu mip chain, uploaded from the coarsest level
+	const int32_t maxLevel = job.params.mipmaps ? std::max(job.params.maxLevel, 0) : 0;
+	while ((int32_t)job.levels.size() <= maxLevel && (width > 1 || height > 1))
+	{
+		LEVEL next;
+		ImageKernels::DownsampleBox(job.levels.back().pixels.data(), width, height, next.pixels);
+		width = std::max(width >> 1, 1);
+		height = std::max(height >> 1, 1);
+		next.width = width;
+		next.height = height;
+		job.levels.push_back(std::move(next));
+	}
+
+	job.uploadLevel = (int32_t)job.levels.size() - 1;
+	job.uploadRow = 0;
+}
+
+
+size_t TextureStreamer::UploadRows(JOB& job, size_t budget)
+{
+	LEVEL& level = job.levels[job.uploadLevel];
+	const int32_t coarsestLevel = (int32_t)job.levels.size() - 1;
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, job.texture);
+	if (job.uploadRow == 0)
+	{
+		// allocate the level, it is outside the sampled range until complete
+		glTexImage2D(GL_TEXTURE_2D, job.uploadLevel, GL_RGBA, level.width, level.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	}
+
+	// at least one row per call so large levels always progress. Without mipmaps
+	// the only level replaces the placeholder, so it goes up in one piece
+	const size_t rowBytes = (size_t)level.width * 4;
+	const int32_t rows = coarsestLevel == 0 ?
+		level.height :
+		(int32_t)std::min((size_t)(level.height - job.uploadRow), std::max(budget / rowBytes, (size_t)1));
+	const size_t bytes = rows * rowBytes;
+	const uint8_t* src = level.pixels.data() + job.uploadRow * rowBytes;
+
+	void* mapped = nullptr;
+	if (!m_arrPixelBuffers.empty())
+	{
+		// orphan the buffer so the driver never waits for the previous upload from it
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_arrPixelBuffers[m_uNextPixelBuffer]);
+		m_uNextPixelBuffer = (m_uNextPixelBuffer + 1) % m_arrPixelBuffers.size();
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+		mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+		if (mapped)
+		{
+			memcpy(mapped, src, bytes);
+			glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+			src = nullptr;
+		}
+		else
+		{
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		}
+	}
+
+	glTexSubImage2D(GL_TEXTURE_2D, job.uploadLevel, 0, job.uploadRow, level.width, rows, GL_RGBA, GL_UNSIGNED_BYTE, src);
+	if (mapped)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	job.uploadRow += rows;
+	if (job.uploadRow == level.height)
+	{
+		// level complete, extend the sampled range down to it
+		if (job.uploadLevel == coarsestLevel)
+		{
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, coarsestLevel);
+			OpenGLRenderer::SetTextureParams(job.params, coarsestLevel);
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, job.uploadLevel);
+
+		std::vector<uint8_t>().swap(level.pixels);
+		--job.uploadLevel;
+		job.uploadRow = 0;
+	}
+
+	return bytes;
+}
@@ -84,3 +84,19 @@ uint64_t Timer::GetTicks()
 	return ret;
 }
 
+
+double Timer::GetSecondsPerTick()
+{
+	#if defined (_WINDOWS)
+	static const double secondsPerTick = []()
+	{
+		uint64_t rate;
+		::QueryPerformanceFrequency((LARGE_INTEGER*)&rate);
+		return 1.0 / (double)rate;
+	}();
+	return secondsPerTick;
+
+	#else
+	return 1.0 / 1000000000.0;
+	#endif
+}
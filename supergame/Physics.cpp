@@ -18,6 +18,8 @@ Physics::Physics()
 
 void Physics::Update(float frametime)
 {
+	PROFILE_SCOPE("Physics::Update");
+
 	if (m_pDynamicsWorld)
 	{
 		m_pDynamicsWorld->stepSimulation(frametime);
@@ -2,10 +2,8 @@
 
 
 TheApp::TheApp() :
-	m_uVertexShader(0),
-	m_uFragmentShader(0),
-	m_uProgram(0),
-	m_uTexture(0)
+	m_vCameraAngles(0.0f),
+	m_vDragPoint(0.0f)
 {
 	RandSeed();
 }
@@ -14,15 +12,115 @@ TheApp::TheApp() :
 bool TheApp::OnCreate()
 {
 	auto renderer = GetOpenGLRenderer();
-	m_uVertexShader = renderer->CreateVertexShaderFromFile("phongshader.vert");
-	m_uFragmentShader = renderer->CreateFragmentShaderFromFile("phongshader.frag");
-	m_uProgram = renderer->CreateProgram(m_uVertexShader, m_uFragmentShader);
-	m_uTexture = renderer->CreateTexture("earth.jpg");
-	if (!m_uVertexShader || !m_uFragmentShader || !m_uProgram || !m_uTexture)
+
+	// linked program binaries are reused across runs
+	renderer->SetProgramCacheDirectory("shadercache");
+
+	// time the render passes on the gpu, results are written out on exit
+	renderer->SetGpuProfiling(true);
+
+	// render resolution follows the gpu frame time to stay within the frame budget
+	renderer->SetDynamicResolution(true);
+
+	// around 56% of the window pixels at most, the jittered frames are reconstructed to full resolution
+	DynamicResolution* dynamicResolution = renderer->GetDynamicResolution();
+	if (dynamicResolution && dynamicResolution->SetTemporalUpscaling(*renderer, true))
+	{
+		DynamicResolution::SETTINGS settings(dynamicResolution->GetSettings());
+		settings.maxScale = 0.75f;
+		dynamicResolution->SetSettings(settings);
+	}
+
+	// post effects on the full resolution frame, their targets come from a shared pool
+	if (renderer->SetPostProcessing(true))
+	{
+		renderer->GetPostProcess()->Add(*renderer, std::make_shared<Bloom>());
+	}
+
+	// the cpu runs at most one frame ahead of the gpu, the camera reads the mouse once more before drawing
+	if (renderer->SetFramePacing(true))
+	{
+		FramePacer::SETTINGS settings;
+		settings.maxFramesInFlight = 2;
+		settings.lateLatch = true;
+		renderer->GetFramePacer()->SetSettings(settings);
+		renderer->GetFramePacer()->SetLateLatch([this]() { UpdateCamera(); });
+	}
+	if (!IsHeadless())
+	{
+		renderer->SetSwapInterval(1);
+	}
+
+	// shader permutations compile in the background on the driver threads, drawing starts once they are ready
+	ShaderCompiler::SetThreadCount(0xFFFFFFFF);
+	m_pResources = std::make_unique<ResourceCache>(*renderer);
+	m_pShaders = std::make_unique<ShaderPermutations>(*m_pResources);
+
+	// texture is decoded in the background, placeholder is shown until it is uploaded
+	m_TextureStreamer.Create();
+	m_pResources->SetTextureStreamer(&m_TextureStreamer);
+	m_pTexture = m_pResources->GetTexture("earth.jpg");
+	if (!m_pShaders->Load("phongshader.vert", "phongshader.frag") || !m_pTexture)
 	{
 		return false;
 	}
 
+	// use multi draw indirect when the driver supports it
+	m_pMultiDraw = std::make_unique<MultiDrawIndirect>();
+	if (m_pMultiDraw->Create())
+	{
+		m_pMultiDrawShaders = std::make_unique<ShaderPermutations>(*m_pResources);
+		if (!m_pMultiDrawShaders->Load("phongshader_mdi.vert", "phongshader_mdi.frag"))
+		{
+			m_pMultiDrawShaders = nullptr;
+		}
+	}
+	if (!m_pMultiDrawShaders)
+	{
+		m_pMultiDraw = nullptr;
+	}
+
+	// lay down depth first so that the phong shader runs once per visible sample
+	m_pDepthPrepass = std::make_unique<DepthPrepass>();
+	if (!m_pDepthPrepass->Create(*renderer, m_pMultiDraw != nullptr))
+	{
+		m_pDepthPrepass = nullptr;
+	}
+
+	// point lights orbiting through the scene, shared by the forward and the deferred path
+	m_arrLights.resize(1000);
+	m_arrLightSpeeds.resize(m_arrLights.size());
+	for (size_t i = 0; i < m_arrLights.size(); ++i)
+	{
+		m_arrLights[i].position = glm::vec3(glm::linearRand(-7.0f, 7.0f),
+			glm::linearRand(-7.0f, 7.0f),
+			glm::linearRand(-7.0f, 7.0f));
+		m_arrLights[i].radius = glm::linearRand(1.0f, 2.0f);
+		m_arrLights[i].color = glm::linearRand(glm::vec3(0.2f), glm::vec3(1.0f));
+		m_arrLights[i].intensity = 0.3f;
+		m_arrLightSpeeds[i] = glm::linearRand(-1.0f, 1.0f);
+	}
+
+	// forward path shades them per cluster in the multi draw shaders
+	if (m_pMultiDraw && ClusteredLighting::IsSupported())
+	{
+		m_pLights = std::make_unique<ClusteredLighting>();
+		if (!m_pLights->Create())
+		{
+			m_pLights = nullptr;
+		}
+	}
+
+	// shadows of the directional light
+	if (m_pMultiDraw && ShadowMap::IsSupported())
+	{
+		m_pShadows = std::make_unique<ShadowMap>();
+		if (!m_pShadows->Create(*renderer))
+		{
+			m_pShadows = nullptr;
+		}
+	}
+
 	// start the physics
 	m_pPhysics = std::make_shared<Physics>();
 
@@ -41,6 +139,10 @@ bool TheApp::OnCreate()
 	//m_pMaterial->m_cDiffuse = glm::vec4(0.0f, 1.0f, 0.0f, 1.0f);
 	//m_pMaterial->m_cEmissive = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f);
 
+	// start compiling the permutation the material selects
+	ShaderPermutations& shaders = m_pMultiDraw ? *m_pMultiDrawShaders : *m_pShaders;
+	shaders.GetProgram(shaders.GetKey(m_pMaterial.get()) | GetSceneFeatures(shaders));
+
 
 	// build the scenegraph
 	m_pSceneRoot = std::make_unique<Node>();
@@ -55,9 +157,35 @@ bool TheApp::OnCreate()
 
 	m_pSceneRoot->AddNode(camera);
 
+	// static floor and pillars
+	m_pBoxGeometry = std::make_shared<Geometry>();
+	m_pBoxGeometry->GenCube(glm::vec3(1.0f));
+
+	m_pStaticNodes = std::make_shared<Node>();
+	m_pSceneRoot->AddNode(m_pStaticNodes);
+
+	auto floor = std::make_shared<GeometryNode>(m_pBoxGeometry, m_pMaterial);
+	floor->SetMatrix(glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -7.0f, 0.0f)), glm::vec3(40.0f, 0.5f, 40.0f)));
+	m_pStaticNodes->AddNode(floor);
+	for (size_t i = 0; i < 4; ++i)
+	{
+		const glm::vec3 pos(i & 1 ? 8.0f : -8.0f, -3.0f, i & 2 ? 8.0f : -8.0f);
+		auto pillar = std::make_shared<GeometryNode>(m_pBoxGeometry, m_pMaterial);
+		pillar->SetMatrix(glm::scale(glm::translate(glm::mat4(1.0f), pos), glm::vec3(1.0f, 8.0f, 1.0f)));
+		m_pStaticNodes->AddNode(pillar);
+	}
+
+	// floor and pillars share the material, merge them into one draw. The batcher logs the draw counts
+	StaticBatcher::Batch(*m_pStaticNodes);
 
+	if (m_pShadows)
+	{
+		m_pShadows->SetStaticCasters(*m_pStaticNodes);
+	}
 
 	// create the scene of Geometry Objects
+	m_pDynamicNodes = std::make_shared<Node>();
+	m_pSceneRoot->AddNode(m_pDynamicNodes);
 	for (size_t i = 0; i < 125; ++i)
 	{
 		auto node = std::make_shared<GeometryNode>(m_pGeometry, m_pMaterial);
@@ -69,12 +197,12 @@ bool TheApp::OnCreate()
 		node->SetRotationAxis(glm::vec3(0.0f, 1.0f, 0.0f));
 		node->SetRotationSpeed(glm::linearRand(-1.0f, 1.0f));
 
-		m_pSceneRoot->AddNode(node);
+		m_pDynamicNodes->AddNode(node);
 	}
 
-	//m_pSceneRoot->SetVelocity(glm::vec3(0.0f, 0.0f, 5.0f));
-	m_pSceneRoot->SetRotationAxis(glm::vec3(0.0f, 1.0f, 0.0f));
-	m_pSceneRoot->SetRotationSpeed(0.1f);
+	//m_pDynamicNodes->SetVelocity(glm::vec3(0.0f, 0.0f, 5.0f));
+	m_pDynamicNodes->SetRotationAxis(glm::vec3(0.0f, 1.0f, 0.0f));
+	m_pDynamicNodes->SetRotationSpeed(0.1f);
 
 	return true;
 }
@@ -83,11 +211,45 @@ bool TheApp::OnCreate()
 void TheApp::OnDestroy()
 {
 	m_pSceneRoot = nullptr;
+	m_pStaticNodes = nullptr;
+	m_pDynamicNodes = nullptr;
+	m_pShadows = nullptr;
+	m_pLights = nullptr;
+	m_pMultiDraw = nullptr;
+	m_pDepthPrepass = nullptr;
+
+	m_mapPermutationQueues.clear();
+	m_pMultiDrawShaders = nullptr;
+	m_pShaders = nullptr;
+	m_pTexture = nullptr;
+
+	m_TextureStreamer.Release();
+	if (m_pResources)
+	{
+		m_pResources->PrintStats();
+		m_pResources = nullptr;
+	}
+
+	if (GetOpenGLRenderer()->GetProgramCache())
+	{
+		GetOpenGLRenderer()->GetProgramCache()->PrintStats();
+	}
+	if (GetOpenGLRenderer()->GetGpuProfiler())
+	{
+		GetOpenGLRenderer()->GetGpuProfiler()->PrintTimings();
+		GetOpenGLRenderer()->GetGpuProfiler()->Export("timings.json");
+	}
 
-	glDeleteTextures(1, &m_uTexture);
-	glDeleteProgram(m_uProgram);
-	glDeleteShader(m_uFragmentShader);
-	glDeleteShader(m_uVertexShader);
+	if (GetOpenGLRenderer()->GetFramePacer())
+	{
+		const FramePacer::STATS& stats = GetOpenGLRenderer()->GetFramePacer()->GetStats();
+		Debug("frame pacing: cpu waited " + std::to_string(stats.waitAverage * 1000.0f) + " ms per frame on average, " +
+			std::to_string(stats.waitMax * 1000.0f) + " ms at most, " + std::to_string(stats.waitTotal) + " s in " +
+			std::to_string(stats.frames) + " frames\n");
+	}
+
+	Profiler::PrintSummary();
+	Profiler::ExportChromeTrace("trace.json");
 }
 
 
@@ -101,35 +263,244 @@ void TheApp::OnUpdate(float frametime)
 	{
 		m_pPhysics->Update(frametime);
 	}
+	UpdateCamera();
+	for (size_t i = 0; i < m_arrLights.size(); ++i)
+	{
+		const glm::mat4 rotation(glm::rotate(glm::mat4(1.0f), m_arrLightSpeeds[i] * frametime, glm::vec3(0.0f, 1.0f, 0.0f)));
+		m_arrLights[i].position = glm::vec3(rotation * glm::vec4(m_arrLights[i].position, 1.0f));
+	}
 }
 
 
 void TheApp::OnDraw(IRenderer& renderer)
 {
+	GpuProfiler* profiler = GetOpenGLRenderer()->GetGpuProfiler();
+	{
+		GpuProfiler::SCOPE uploadScope(profiler, "texture upload");
+		m_TextureStreamer.Update();
+	}
+	m_pResources->Update();
+
 	renderer.Clear(0.2f, 0.2f, 0.2f, 1.0f);
 
-	// render our geometry
-	glUseProgram(m_uProgram);
+	if (!m_pSceneRoot)
+	{
+		return;
+	}
+
+	// setup the camera matrices before rendering, jittered inside the pixel for the temporal upscaler
+	auto* camera = static_cast<CameraNode*>(m_pSceneRoot->FindNode("camera"));
+	TemporalUpscaler* upscaler = GetTemporalUpscaler();
+	if (upscaler)
+	{
+		camera->SetJitter(upscaler->GetJitter(), GetOpenGLRenderer()->GetRenderSize());
+	}
+	renderer.SetViewMatrix(camera->GetViewMatrix());
+	renderer.SetProjectionMatrix(camera->GetProjectionMatrix());
+
+	const glm::vec3 lightDirection(glm::normalize(glm::vec3(-1.0f, -2.0f, -1.0f)));
+	DeferredShading* deferred = GetOpenGLRenderer()->GetDeferredShading();
+	if (deferred)
+	{
+		DrawDeferred(renderer, *deferred, lightDirection);
+
+		// moving objects are drawn with their previous matrices against the G-buffer depth
+		if (upscaler)
+		{
+			GpuProfiler::SCOPE motionScope(profiler, "motion vectors");
+			deferred->CopyDepth(*GetOpenGLRenderer());
+			upscaler->RenderMotionVectors(renderer, m_DrawQueue, camera->GetUnjitteredProjectionMatrix());
+		}
+		m_DrawQueue.Clear();
+		return;
+	}
+
+	if (m_pLights)
+	{
+		m_pLights->GetLights() = m_arrLights;
+		const glm::ivec2 renderSize(GetOpenGLRenderer()->GetRenderSize());
+		m_pLights->Update(renderer, renderSize.x, renderSize.y);
+	}
+	if (m_pShadows)
+	{
+		GpuProfiler::SCOPE shadowScope(profiler, "shadows");
+		m_pShadows->Update(renderer, lightDirection);
+		m_pShadows->Render(*GetOpenGLRenderer(), m_pDynamicNodes.get());
+	}
+
+	GpuProfiler::SCOPE sceneScope(profiler, "scene");
+
+	// record the scene and group the draws by the shader permutation their material selects
+	ShaderPermutations& shaders = m_pMultiDraw ? *m_pMultiDrawShaders : *m_pShaders;
+	const uint64_t sceneFeatures = GetSceneFeatures(shaders);
+	renderer.SetDrawQueue(&m_DrawQueue);
+	m_pSceneRoot->Render(renderer, 0);
+	renderer.SetDrawQueue(nullptr);
+
+	// nearest first, hidden fragments fail the depth test before they are shaded
+	m_DrawQueue.SortFrontToBack(renderer.GetViewMatrix());
+	if (m_pDepthPrepass)
+	{
+		GpuProfiler::SCOPE prepassScope(profiler, "prepass");
+		m_pDepthPrepass->Render(renderer, m_DrawQueue, m_pMultiDraw.get());
+	}
+	shaders.Sort(m_DrawQueue, m_mapPermutationQueues);
 
-	const glm::vec3 lightDirection(glm::normalize(glm::vec3(-1.0f, 0.0f, -1.0f)));
 	const glm::vec3 cameraPos(-renderer.GetViewMatrix()[3]);
-	OpenGLRenderer::SetUniformVec3(m_uProgram, "lightDirection", lightDirection);
-	OpenGLRenderer::SetUniformVec3(m_uProgram, "cameraPosition", cameraPos);
 
-	renderer.SetTexture(m_uProgram, m_uTexture, 0, "texture01");
+	if (m_pDepthPrepass)
+	{
+		m_pDepthPrepass->BeginMainPass();
+	}
 
-	// setup the camera matrices before rendering
-	const auto* camera = static_cast<CameraNode*>(m_pSceneRoot->FindNode("camera"));
-	renderer.SetViewMatrix(camera->GetViewMatrix());
-	renderer.SetProjectionMatrix(camera->GetProjectionMatrix());
+	bool multiDrawFailed = false;
+	for (const auto& it : m_mapPermutationQueues)
+	{
+		if (it.second.IsEmpty())
+		{
+			continue;
+		}
 
-	if (m_pSceneRoot)
+		GLuint program = shaders.GetProgram(it.first | sceneFeatures);
+		if (!program && shaders.GetState(it.first | sceneFeatures) == ShaderCompiler::STATE_FAILED)
+		{
+			if (m_pMultiDraw)
+			{
+				multiDrawFailed = true;
+				continue;
+			}
+
+			// draw with the base permutation, without the material features that failed to build
+			program = shaders.GetProgram(sceneFeatures);
+			if (!program && shaders.GetState(sceneFeatures) == ShaderCompiler::STATE_FAILED)
+			{
+				Debug("TheApp: failed to build shaders\n");
+				Close();
+				break;
+			}
+		}
+
+		// permutation is skipped until it has compiled
+		if (!program)
+		{
+			continue;
+		}
+
+		// render our geometry
+		GpuProfiler::SCOPE groupScope(profiler, "permutation " + std::to_string(it.first));
+		glUseProgram(program);
+		OpenGLRenderer::SetUniformVec3(program, "lightDirection", lightDirection);
+		OpenGLRenderer::SetUniformVec3(program, "cameraPosition", cameraPos);
+		renderer.SetTexture(program, m_pTexture->handle, 0, "texture01");
+		if (m_pLights)
+		{
+			m_pLights->Bind(program);
+		}
+		if (m_pShadows)
+		{
+			m_pShadows->Bind(renderer, program, 1);
+		}
+
+		if (m_pMultiDraw)
+		{
+			m_pMultiDraw->Submit(renderer, it.second, program);
+		}
+		else
+		{
+			for (const auto& draw : it.second.GetDraws())
+			{
+				DrawQueue::DrawImmediate(renderer, program, draw);
+			}
+		}
+	}
+
+	if (m_pDepthPrepass)
+	{
+		m_pDepthPrepass->EndMainPass();
+	}
+
+	if (upscaler)
 	{
-		m_pSceneRoot->Render(renderer, m_uProgram);
+		GpuProfiler::SCOPE motionScope(profiler, "motion vectors");
+		upscaler->RenderMotionVectors(renderer, m_DrawQueue, camera->GetUnjitteredProjectionMatrix());
+	}
+	m_DrawQueue.Clear();
+
+	// multi draw falls back to the per draw path if its shaders fail to build
+	if (multiDrawFailed)
+	{
+		m_pShadows = nullptr;
+		m_pLights = nullptr;
+		m_pMultiDraw = nullptr;
+		m_pMultiDrawShaders = nullptr;
 	}
 }
 
 
+void TheApp::DrawDeferred(IRenderer& renderer, DeferredShading& deferred, const glm::vec3& lightDirection)
+{
+	GpuProfiler* profiler = GetOpenGLRenderer()->GetGpuProfiler();
+	GpuProfiler::SCOPE sceneScope(profiler, "deferred");
+
+	// materials go to the G-buffer with the same uniforms as in the forward path
+	renderer.SetDrawQueue(&m_DrawQueue);
+	m_pSceneRoot->Render(renderer, 0);
+	renderer.SetDrawQueue(nullptr);
+	const glm::ivec2 renderSize(GetOpenGLRenderer()->GetRenderSize());
+	if (deferred.BeginGeometryPass(renderSize.x, renderSize.y, glm::vec4(0.2f, 0.2f, 0.2f, 1.0f)))
+	{
+		GpuProfiler::SCOPE geometryScope(profiler, "geometry");
+		const GLuint program = deferred.GetGeometryProgram();
+		glUseProgram(program);
+		renderer.SetTexture(program, m_pTexture->handle, 0, "texture01");
+		for (const auto& draw : m_DrawQueue.GetDraws())
+		{
+			DrawQueue::DrawImmediate(renderer, program, draw);
+		}
+	}
+
+	{
+		GpuProfiler::SCOPE lightScope(profiler, "lights");
+		deferred.RenderLights(renderer, lightDirection, m_arrLights);
+	}
+	deferred.Resolve(*GetOpenGLRenderer());
+}
+
+
+void TheApp::UpdateCamera()
+{
+	auto camera = m_pSceneRoot ? static_cast<CameraNode*>(m_pSceneRoot->FindNode("camera")) : nullptr;
+	if (camera)
+	{
+		const glm::mat4 orbit(glm::rotate(glm::mat4(1.0f), -m_vCameraAngles.x, glm::vec3(0.0f, 1.0f, 0.0f)) *
+			glm::rotate(glm::mat4(1.0f), -m_vCameraAngles.y, glm::vec3(1.0f, 0.0f, 0.0f)));
+		camera->LookAt(glm::vec3(orbit * glm::vec4(0.0f, 0.0f, 15.0f, 1.0f)), glm::vec3(0.0f));
+	}
+}
+
+
+TemporalUpscaler* TheApp::GetTemporalUpscaler()
+{
+	DynamicResolution* dynamicResolution = GetOpenGLRenderer()->GetDynamicResolution();
+	return dynamicResolution ? dynamicResolution->GetTemporalUpscaler() : nullptr;
+}
+
+
+uint64_t TheApp::GetSceneFeatures(const ShaderPermutations& shaders) const
+{
+	uint64_t features = 0;
+	if (m_pLights)
+	{
+		features |= shaders.GetFeatureBit("CLUSTERED_LIGHTS");
+	}
+	if (m_pShadows)
+	{
+		features |= shaders.GetFeatureBit("SHADOWS");
+	}
+	return features;
+}
+
+
 bool TheApp::OnKeyDown(uint32_t keyCode)
 {
 	if (keyCode == KEY_ESC)
@@ -138,9 +509,60 @@ bool TheApp::OnKeyDown(uint32_t keyCode)
 		return true;
 	}
 
+	// switch between forward and deferred shading, as a level with heavy overdraw would
+	if (keyCode == KEY_SPACE)
+	{
+		IRenderer& renderer = *GetRenderer();
+		const bool deferred = renderer.GetRenderPath() == IRenderer::RENDERPATH_FORWARD &&
+			renderer.SetRenderPath(IRenderer::RENDERPATH_DEFERRED);
+		if (!deferred)
+		{
+			renderer.SetRenderPath(IRenderer::RENDERPATH_FORWARD);
+		}
+		Debug(deferred ? "deferred shading\n" : "forward shading\n");
+		return true;
+	}
+
+	// toggle the depth pre-pass, compare the sample counts and the gpu time of both settings
+	if (keyCode == KEY_P && m_pDepthPrepass)
+	{
+		const DepthPrepass::STATS& stats = m_pDepthPrepass->GetStats();
+		Debug("depth pre-pass " + std::string(m_pDepthPrepass->IsEnabled() ? "on" : "off") +
+			": " + std::to_string(stats.shadedSamples) + " samples shaded, " +
+			std::to_string(stats.shadedPerSample) + " per screen sample, overdraw saved " +
+			std::to_string(stats.overdraw) + "\n");
+		m_pDepthPrepass->SetEnabled(!m_pDepthPrepass->IsEnabled());
+		return true;
+	}
+
+	// cycle the anti-aliasing modes, the temporal upscaler smooths edges already so it starts off
+	if (keyCode == KEY_A)
+	{
+		static const char* s_pModeNames[] = { "off", "msaa 2x", "msaa 4x", "msaa 8x", "post" };
+		IRenderer& renderer = *GetRenderer();
+		const IRenderer::ANTIALIASING mode = renderer.GetAntialiasing();
+		const GpuProfiler* profiler = GetOpenGLRenderer()->GetGpuProfiler();
+		if (profiler)
+		{
+			const auto it = profiler->GetTimings().find("frame");
+			if (it != profiler->GetTimings().end())
+			{
+				Debug("anti-aliasing " + std::string(s_pModeNames[mode]) + ": " + std::to_string(it->second.gpuAverage) + " ms gpu frame\n");
+			}
+		}
+
+		const IRenderer::ANTIALIASING next = (IRenderer::ANTIALIASING)((mode + 1) % (IRenderer::ANTIALIASING_POST + 1));
+		if (!renderer.SetAntialiasing(next))
+		{
+			Debug("anti-aliasing " + std::string(s_pModeNames[next]) + " not supported\n");
+		}
+		return true;
+	}
+
 	return false;
 }
 
+
 void TheApp::OnScreenSizeChanged(uint32_t widthPixels, uint32_t heightPixels)
 {
 	if (m_pSceneRoot)
@@ -166,6 +588,11 @@ bool TheApp::OnMouseBegin(int32_t buttonIndex, const glm::vec2& point)
 		std::to_string((int)point.y) +
 		"\r\n");
 	*/
+	if (buttonIndex == 0)
+	{
+		m_vDragPoint = point;
+		return true;
+	}
 	return false;
 }
 
@@ -180,6 +607,13 @@ bool TheApp::OnMouseDrag(int32_t buttonIndex, const glm::vec2& point)
 		std::to_string((int)point.y) +
 		"\r\n");
 	*/
+	if (buttonIndex == 0)
+	{
+		m_vCameraAngles += (point - m_vDragPoint) * 0.005f;
+		m_vCameraAngles.y = glm::clamp(m_vCameraAngles.y, -1.4f, 1.4f);
+		m_vDragPoint = point;
+		return true;
+	}
 	return false;
 }
 
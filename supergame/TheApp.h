@@ -3,7 +3,24 @@
 #include "../core/include/Geometry.h"
 #include "../core/include/Material.h"
 #include "../core/include/GeometryNode.h"
+#include "../core/include/StaticBatcher.h"
 #include "../core/include/CameraNode.h"
+#include "../core/include/DrawQueue.h"
+#include "../core/include/MultiDrawIndirect.h"
+#include "../core/include/TextureStreamer.h"
+#include "../core/include/ResourceCache.h"
+#include "../core/include/ShaderPermutations.h"
+#include "../core/include/ProgramCache.h"
+#include "../core/include/GpuProfiler.h"
+#include "../core/include/ClusteredLighting.h"
+#include "../core/include/ShadowMap.h"
+#include "../core/include/DeferredShading.h"
+#include "../core/include/DepthPrepass.h"
+#include "../core/include/DynamicResolution.h"
+#include "../core/include/TemporalUpscaler.h"
+#include "../core/include/PostProcess.h"
+#include "../core/include/Bloom.h"
+#include "../core/include/FramePacer.h"
 
 // physics
 #include "Physics.h"
@@ -28,19 +45,56 @@ private:
 	bool OnMouseDrag(int32_t buttonIndex, const glm::vec2& point) override;
 	bool OnMouseEnd(int32_t buttonIndex, const glm::vec2& point) override;
 
+	// G-buffer pass, light pass and resolve of the deferred path
+	void DrawDeferred(IRenderer& renderer, DeferredShading& deferred, const glm::vec3& lightDirection);
+
+	// orbit the camera around the scene by the mouse drag so far, latched again right before drawing
+	void UpdateCamera();
+
+	// upscaler of the dynamic resolution target, nullptr when temporal upscaling is off
+	TemporalUpscaler* GetTemporalUpscaler();
+
+	// permutation bits of the lighting features enabled for the whole scene
+	uint64_t GetSceneFeatures(const ShaderPermutations& shaders) const;
+
 	OpenGLRenderer* GetOpenGLRenderer() { return static_cast<OpenGLRenderer*>(GetRenderer()); }
 
 
-	GLuint						m_uVertexShader;
-	GLuint						m_uFragmentShader;
-	GLuint						m_uProgram;
+	// textures and shader permutations are shared and released through the cache
+	std::unique_ptr<ResourceCache>		m_pResources;
+	std::unique_ptr<ShaderPermutations>	m_pShaders;
+	std::map<uint64_t, DrawQueue>		m_mapPermutationQueues;
+
+	ResourceCache::HANDLE		m_pTexture;
+
+	// camera orbit of the left mouse button drag, yaw and pitch in radians
+	glm::vec2					m_vCameraAngles;
+	glm::vec2					m_vDragPoint;
+	TextureStreamer				m_TextureStreamer;
+
+	// multi draw indirect path, null when not supported
+	std::unique_ptr<ShaderPermutations>	m_pMultiDrawShaders;
+	std::unique_ptr<MultiDrawIndirect>	m_pMultiDraw;
+	DrawQueue					m_DrawQueue;
+
+	// depth only pass before the shaded forward pass, null when its programs fail
+	std::unique_ptr<DepthPrepass>	m_pDepthPrepass;
+
+	// point lights, clustered in the multi draw path, null when not supported
+	std::vector<ClusteredLighting::LIGHT>	m_arrLights;
+	std::vector<float>			m_arrLightSpeeds;
+	std::unique_ptr<ClusteredLighting>	m_pLights;
 
-	GLuint						m_uTexture;
+	// cascaded shadows of the multi draw path, null when not supported
+	std::unique_ptr<ShadowMap>	m_pShadows;
 
 	std::shared_ptr<Geometry>	m_pGeometry;
 	std::shared_ptr<Material>	m_pMaterial;
+	std::shared_ptr<Geometry>	m_pBoxGeometry;
 
 	std::unique_ptr<Node>		m_pSceneRoot;
+	std::shared_ptr<Node>		m_pStaticNodes;		// never move, their shadows are cached
+	std::shared_ptr<Node>		m_pDynamicNodes;
 
 	std::shared_ptr<Physics>	m_pPhysics;
 };
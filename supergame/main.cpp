@@ -1,6 +1,6 @@
-
 #include "TheApp.h"
 
+#if defined (_WINDOWS)
 int APIENTRY WinMain(HINSTANCE hInst, HINSTANCE hPrevInst, LPSTR pCmdLine, int nShowCmd)
 {
 	auto app = std::make_unique<TheApp>();
@@ -13,5 +13,41 @@ int APIENTRY WinMain(HINSTANCE hInst, HINSTANCE hPrevInst, LPSTR pCmdLine, int n
 	app->Run();
 	return 0;
 }
+#endif
 
+#if defined (_LINUX)
+int main(int argc, char** argv)
+{
+	// --headless [frames] renders offscreen with a fixed timestep and writes the last frame to headless.tga
+	IApplication::HEADLESSPARAMS headless;
+	bool isHeadless = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		if (std::string_view(argv[i]) == "--headless")
+		{
+			isHeadless = true;
+			headless.readback = true;
+			if (i + 1 < argc && atoi(argv[i + 1]) > 0)
+			{
+				headless.frameCount = (uint32_t)atoi(argv[++i]);
+			}
+		}
+	}
 
+	auto app = std::make_unique<TheApp>();
+	const bool created = isHeadless ? app->Create(1280, 720, headless) : app->Create(1280, 720, "SUPERGAME");
+	if (!created)
+	{
+		IApplication::Debug("APP START FAILED!\n");
+		return 1;
+	}
+
+	app->Run();
+	if (isHeadless && !app->SaveReadback("headless.tga"))
+	{
+		IApplication::Debug("failed to write headless.tga\n");
+		return 1;
+	}
+	return 0;
+}
+#endif
@@ -1,10 +1,18 @@
+// optional features, compiled in only for materials that use them
+#pragma feature SPECULAR
+#pragma feature EMISSIVE
+
 uniform sampler2D texture01;
 
 uniform vec4 materialAmbient;
 uniform vec4 materialDiffuse;
+#ifdef SPECULAR
 uniform vec4 materialSpecular;
-uniform vec4 materialEmissive;
 uniform float specularPower;
+#endif
+#ifdef EMISSIVE
+uniform vec4 materialEmissive;
+#endif
 
 uniform vec3 lightDirection;
 uniform vec3 cameraPosition;
@@ -19,18 +27,19 @@ void main(void)
     float diffuseFactor = dot(normal, -lightDirection);
     vec4 diffuseColor = texture2D(texture01, outUv) * materialDiffuse * diffuseFactor;
 
-    if (specularPower > 0.9)
-    {
-        vec3 surfaceToCamera = normalize(cameraPosition - eyespacePosition);
-        float specularFactor = dot(surfaceToCamera, reflect(lightDirection, normal));
-        specularFactor = pow(max(0.0, specularFactor), specularPower);
-        vec4 specularColor = materialSpecular * specularFactor * diffuseFactor;
-
-        gl_FragColor = materialAmbient + diffuseColor + materialEmissive + specularColor;
-    }
-    else
-    {
-        gl_FragColor = materialAmbient + diffuseColor + materialEmissive;
-    }
+    vec4 color = materialAmbient + diffuseColor;
+
+#ifdef EMISSIVE
+    color += materialEmissive;
+#endif
+
+#ifdef SPECULAR
+    vec3 surfaceToCamera = normalize(cameraPosition - eyespacePosition);
+    float specularFactor = dot(surfaceToCamera, reflect(lightDirection, normal));
+    specularFactor = pow(max(0.0, specularFactor), specularPower);
+    color += materialSpecular * specularFactor * diffuseFactor;
+#endif
+
+    gl_FragColor = color;
 }
 
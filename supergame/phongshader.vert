@@ -1,3 +1,5 @@
+#version 120
+
 attribute vec3 position;
 attribute vec3 normal;
 attribute vec2 uv;
@@ -9,6 +11,9 @@ varying vec2 outUv;
 varying vec3 eyespacePosition;
 varying vec3 eyespaceNormal;
 
+// depth must match the depth pre-pass exactly
+invariant gl_Position;
+
 void main(void)
 {
 	outUv = uv;
@@ -0,0 +1,137 @@
+#version 430
+
+// optional features, compiled in only for materials that use them
+#pragma feature SPECULAR
+#pragma feature EMISSIVE
+#pragma feature CLUSTERED_LIGHTS
+#pragma feature SHADOWS
+
+struct DrawData
+{
+	mat4 modelMatrix;
+	vec4 materialAmbient;
+	vec4 materialDiffuse;
+	vec4 materialSpecular;
+	vec4 materialEmissive;
+	vec4 materialParams;
+};
+
+layout(std430, binding = 0) readonly buffer DrawDataBuffer
+{
+	DrawData draws[];
+};
+
+#ifdef CLUSTERED_LIGHTS
+struct PointLight
+{
+	vec4 positionRadius;
+	vec4 color;
+};
+
+layout(std430, binding = 1) readonly buffer PointLightBuffer
+{
+	PointLight pointLights[];
+};
+
+// offset and count into the light index list per cluster
+layout(std430, binding = 2) readonly buffer ClusterBuffer
+{
+	uint clusters[];
+};
+
+layout(std430, binding = 3) readonly buffer LightIndexBuffer
+{
+	uint lightIndices[];
+};
+
+uniform mat4 clusterViewMatrix;
+uniform vec4 clusterParams;		// slice scale, slice bias, tiles per pixel x, tiles per pixel y
+uniform vec4 clusterGrid;		// tiles x, tiles y, slices
+#endif
+
+#ifdef SHADOWS
+uniform sampler2DShadow shadowMap;
+uniform mat4 shadowMatrices[4];	// world to atlas coordinates per cascade
+uniform vec4 shadowSplits;		// view depth where each cascade ends
+uniform vec4 shadowDepthPlane;	// camera forward plane
+
+float GetShadow(vec3 position)
+{
+    float depth = dot(shadowDepthPlane.xyz, position) + shadowDepthPlane.w;
+    int cascade = int(dot(vec4(greaterThan(vec4(depth), shadowSplits)), vec4(1.0)));
+    if (cascade > 3)
+    {
+        return 1.0;
+    }
+    return texture(shadowMap, (shadowMatrices[cascade] * vec4(position, 1.0)).xyz);
+}
+#endif
+
+uniform sampler2D texture01;
+
+uniform vec3 lightDirection;
+uniform vec3 cameraPosition;
+
+in vec2 outUv;
+in vec3 eyespacePosition;
+in vec3 eyespaceNormal;
+flat in int drawIndex;
+
+out vec4 fragColor;
+
+void main(void)
+{
+    vec4 materialAmbient = draws[drawIndex].materialAmbient;
+    vec4 materialDiffuse = draws[drawIndex].materialDiffuse;
+
+    vec3 normal = normalize(eyespaceNormal);
+    float diffuseFactor = dot(normal, -lightDirection);
+#ifdef SHADOWS
+    diffuseFactor = max(diffuseFactor, 0.0) * GetShadow(eyespacePosition);
+#endif
+    vec4 diffuseColor = texture(texture01, outUv) * materialDiffuse * diffuseFactor;
+
+    vec4 color = materialAmbient + diffuseColor;
+
+#ifdef EMISSIVE
+    color += draws[drawIndex].materialEmissive;
+#endif
+
+#ifdef SPECULAR
+    float specularPower = draws[drawIndex].materialParams.x;
+    vec3 surfaceToCamera = normalize(cameraPosition - eyespacePosition);
+    float specularFactor = dot(surfaceToCamera, reflect(lightDirection, normal));
+    specularFactor = pow(max(0.0, specularFactor), specularPower);
+    color += draws[drawIndex].materialSpecular * specularFactor * diffuseFactor;
+#endif
+
+#ifdef CLUSTERED_LIGHTS
+    // only the lights assigned to the cluster of this fragment
+    float viewDepth = -(clusterViewMatrix * vec4(eyespacePosition, 1.0)).z;
+    ivec3 grid = ivec3(clusterGrid.xyz);
+    ivec3 cell = ivec3(gl_FragCoord.xy * clusterParams.zw, log(viewDepth) * clusterParams.x + clusterParams.y);
+    cell = clamp(cell, ivec3(0), grid - 1);
+    int cluster = (cell.z * grid.y + cell.y) * grid.x + cell.x;
+    uint lightOffset = clusters[cluster * 2];
+    uint lightCount = clusters[cluster * 2 + 1];
+
+    vec4 texel = texture(texture01, outUv);
+    for (uint i = 0u; i < lightCount; ++i)
+    {
+        PointLight light = pointLights[lightIndices[lightOffset + i]];
+        vec3 toLight = light.positionRadius.xyz - eyespacePosition;
+        float distance = length(toLight);
+        float falloff = clamp(1.0 - (distance * distance) / (light.positionRadius.w * light.positionRadius.w), 0.0, 1.0);
+        falloff *= falloff;
+        vec3 lightDir = toLight / max(distance, 0.0001);
+        float lightDiffuse = max(dot(normal, lightDir), 0.0);
+        color += texel * materialDiffuse * light.color * (lightDiffuse * falloff);
+#ifdef SPECULAR
+        float lightSpecular = pow(max(0.0, dot(surfaceToCamera, reflect(-lightDir, normal))), specularPower);
+        color += draws[drawIndex].materialSpecular * light.color * (lightSpecular * lightDiffuse * falloff);
+#endif
+    }
+#endif
+
+    fragColor = color;
+}
@@ -0,0 +1,44 @@
+#version 430
+#extension GL_ARB_shader_draw_parameters : require
+
+struct DrawData
+{
+	mat4 modelMatrix;
+	vec4 materialAmbient;
+	vec4 materialDiffuse;
+	vec4 materialSpecular;
+	vec4 materialEmissive;
+	vec4 materialParams;
+};
+
+layout(std430, binding = 0) readonly buffer DrawDataBuffer
+{
+	DrawData draws[];
+};
+
+in vec3 position;
+in vec3 normal;
+in vec2 uv;
+
+uniform mat4 viewProjectionMatrix;
+uniform int drawOffset;
+
+out vec2 outUv;
+out vec3 eyespacePosition;
+out vec3 eyespaceNormal;
+flat out int drawIndex;
+
+// depth pre-pass computes the same position, main pass tests it with GL_EQUAL
+invariant gl_Position;
+
+void main(void)
+{
+	drawIndex = drawOffset + gl_DrawIDARB;
+	mat4 modelMatrix = draws[drawIndex].modelMatrix;
+
+	outUv = uv;
+	vec4 worldPosition = modelMatrix * vec4(position, 1.0);
+	eyespacePosition = worldPosition.xyz;
+	eyespaceNormal = (modelMatrix * vec4(normal, 0.0)).xyz;
+	gl_Position = viewProjectionMatrix * worldPosition;
+}